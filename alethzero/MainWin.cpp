@@ -1297,7 +1297,7 @@ void Main::refreshCache()
 	f(s.memBlockHashes + s.memTransactionAddresses, "hashes");
 	t += ", ";
 	f(s.memDetails, "family");
-	t += ")";
+	t += QString(") %1% hits").arg(int(s.total().hitRatio() * 100));
 	ui->cacheUsage->setText(t);
 }
 
@@ -1652,7 +1652,7 @@ void Main::on_debugCurrent_triggered()
 		if (!item->data(Qt::UserRole + 1).isNull())
 		{
 			unsigned txi = item->data(Qt::UserRole + 1).toInt();
-			bytes t = ethereum()->blockChain().transaction(h, txi);
+			bytes t = ethereum()->blockChain().transaction(h, txi).toBytes();
 			State s(ethereum()->state(txi, h));
 			Executive e(s, ethereum()->blockChain());
 			Debugger dw(this, this);
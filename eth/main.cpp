@@ -49,6 +49,7 @@
 #if ETH_JSONRPC || !ETH_TRUE
 #include <libweb3jsonrpc/AccountHolder.h>
 #include <libweb3jsonrpc/WebThreeStubServer.h>
+#include <libweb3jsonrpc/BatchServerConnector.h>
 #include <jsonrpccpp/server/connectors/httpserver.h>
 #include <jsonrpccpp/client/connectors/httpclient.h>
 #endif
@@ -123,6 +124,7 @@ void help()
 #if ETH_JSONRPC || !ETH_TRUE
 		<< "    -j,--json-rpc  Enable JSON-RPC server (default: off)." << endl
 		<< "    --json-rpc-port <n>  Specify JSON-RPC server port (implies '-j', default: " << SensibleHttpPort << ")." << endl
+		<< "    --json-rpc-batch-threads <n>  Run read-only calls of JSON-RPC batches on n threads (default: number of cores)." << endl
 #endif
 		<< "    -K,--kill  First kill the blockchain." << endl
 		<< "    -R,--rebuild  Rebuild the blockchain from the existing database." << endl
@@ -147,6 +149,11 @@ void help()
 		<< "    --opencl-platform <n>  When mining using -G/--opencl use OpenCL platform n (default: 0)." << endl
 		<< "    --opencl-device <n>  When mining using -G/--opencl use OpenCL device n (default: 0)." << endl
 		<< "    -t, --mining-threads <n> Limit number of CPU/GPU miners to n (default: use everything available on selected platform)" << endl
+		<< "    --cpu-kernel <single/interleaved>  Have each CPU miner hash one nonce at a time, or " << ETHASH_LANES << " with their DAG reads interleaved (default: interleaved)." << endl
+		<< "    --hugepages <on/off>  Keep the DAG in huge pages when mining, to spare the TLB (default: off)." << endl
+		<< "    --numa <on/off>  On NUMA machines, pin CPU miners across the nodes and give each node its own copy of the DAG (default: on)." << endl
+		<< "    --work-server <port>  Push work to remote miners (ethminer -F tcp://<host>:<port>) connecting on the given port." << endl
+		<< "    --work-server-ip <ip>  Listen for remote miners on the given IP; it's unauthenticated, so keep it private (default: 127.0.0.1)." << endl
 		<< endl
 		<< "Client networking:" << endl
 		<< "    --client-name <name>  Add a name to your client's version string (default: blank)." << endl
@@ -159,6 +166,7 @@ void help()
 		<< "    --port <port>  Connect to remote port (default: 30303)." << endl
 		<< "    --network-id <n> Only connect to other hosts with this network id (default:0)." << endl
 		<< "    --upnp <on/off>  Use UPnP for NAT (default: on)." << endl
+		<< "    --network-threads <n>  Use given number of threads for network I/O (default: half the hardware threads, at least 2)." << endl
 		<< endl
 		<< "Client structured logging:" << endl
 		<< "    --structured-logging  Enable structured logging (default output to stdout)." << endl
@@ -170,12 +178,13 @@ void help()
 		<< "    -F,--farm <url>  Put into mining farm mode with the work server at URL. Use with -G/--opencl." << endl
 		<< "    --farm-recheck <n>  Leave n ms between checks for changed work (default: 500)." << endl
 #endif
+		<< "    -F,--farm tcp://<host>:<port>  Put into mining farm mode, having work pushed by the eth --work-server at host:port." << endl
 		<< endl
 		<< "Ethash verify mode:" << endl
 		<< "    -w,--check-pow <headerHash> <seedHash> <difficulty> <nonce>  Check PoW credentials for validity." << endl
 		<< endl
 		<< "Benchmarking mode:" << endl
-		<< "    -M,--benchmark  Benchmark for mining and exit; use with --cpu and --opencl." << endl
+		<< "    -M,--benchmark  Benchmark for mining and exit; use with --cpu and --opencl. With --cpu, compares the CPU kernels." << endl
 		<< "    --benchmark-warmup <seconds>  Set the duration of warmup for the benchmark tests (default: 3)." << endl
 		<< "    --benchmark-trial <seconds>  Set the duration for each trial for the benchmark tests (default: 3)." << endl
 		<< "    --benchmark-trials <n>  Set the duration of warmup for the benchmark tests (default: 5)." << endl
@@ -185,6 +194,7 @@ void help()
 		<< endl
 		<< "DAG creation mode:" << endl
 		<< "    -D,--create-dag <this/next/number>  Create the DAG in preparation for mining on given block and exit." << endl
+		<< "    --dag-threads <n>  Generate DAGs with n threads (default: " << EthashAux::generationThreads() << ")." << endl
 		<< endl
 		<< "Import/export modes:" << endl
 		<< "    -I,--import <file>  Import file as a concatenated series of blocks and exit." << endl
@@ -195,6 +205,8 @@ void help()
 		<< endl
 		<< "General Options:" << endl
 		<< "    -d,--db-path <path>  Load database from path (default: " << getDataDir() << ")" << endl
+		<< "    --cache-budget <cache>=<MB>  Limit an in-memory chain cache to MB megabytes; cache is one of blocks, headers," << endl
+		<< "        bodyhashes, details, logblooms, receipts, txaddresses, blockhashes or blocksblooms. May be given several times." << endl
 #if ETH_EVMJIT || !ETH_TRUE
 		<< "    -J,--jit  Enable EVM JIT (default: off)." << endl
 #endif
@@ -313,38 +325,69 @@ void doBenchmark(MinerType _m, bool _phoneHome, unsigned _warmupDuration = 15, u
 	genesis.difficulty = u256(1) << 63;
 	genesis.noteDirty();
 	f.setWork(genesis);
-	if (_m == MinerType::CPU)
-		f.startCPU();
-	else if (_m == MinerType::GPU)
-		f.startGPU();
 
-	map<uint64_t, MiningProgress> results;
-	uint64_t mean = 0;
+	auto trials = [&]()
+	{
+		map<uint64_t, MiningProgress> results;
+		uint64_t mean = 0;
+		uint64_t innerMean = 0;
+		for (unsigned i = 0; i <= _trials; ++i)
+		{
+			if (!i)
+				cout << "Warming up..." << endl;
+			else
+				cout << "Trial " << i << "... " << flush;
+			this_thread::sleep_for(chrono::seconds(i ? _trialDuration : _warmupDuration));
+
+			auto mp = f.miningProgress();
+			f.resetMiningProgress();
+			if (!i)
+				continue;
+			auto rate = mp.rate();
+
+			cout << rate;
+			if (mp.nodeHashes.size() > 1)
+				for (auto const& n: mp.nodeHashes)
+					cout << " (node " << n.first << ": " << mp.nodeRate(n.first) << ")";
+			cout << endl;
+			results[rate] = mp;
+			mean += rate;
+			if (i > 1 && i < 5)
+				innerMean += rate;
+		}
+		f.stop();
+		innerMean /= (_trials - 2);
+		cout << "min/mean/max: " << results.begin()->second.rate() << "/" << (mean / _trials) << "/" << results.rbegin()->second.rate() << " H/s" << endl;
+		cout << "inner mean: " << innerMean << " H/s" << endl;
+		return innerMean;
+	};
+
 	uint64_t innerMean = 0;
-	for (unsigned i = 0; i <= _trials; ++i)
+	if (_m == MinerType::CPU)
 	{
-		if (!i)
-			cout << "Warming up..." << endl;
-		else
-			cout << "Trial " << i << "... " << flush;
-		this_thread::sleep_for(chrono::seconds(i ? _trialDuration : _warmupDuration));
-
-		auto mp = f.miningProgress();
-		f.resetMiningProgress();
-		if (!i)
-			continue;
-		auto rate = mp.rate();
-
-		cout << rate << endl;
-		results[rate] = mp;
-		mean += rate;
-		if (i > 1 && i < 5)
-			innerMean += rate;
+		// Compare the chosen kernel against the other one; the chosen one's result is what gets reported.
+		using Kernel = ProofOfWork::CPUMiner::Kernel;
+		Kernel chosen = ProofOfWork::CPUMiner::kernel();
+		map<Kernel, uint64_t> rates;
+		for (Kernel k: { Kernel::Single, Kernel::Interleaved })
+		{
+			cout << "CPU kernel: " << ProofOfWork::CPUMiner::kernelName(k) << endl;
+			ProofOfWork::CPUMiner::setKernel(k);
+			// stop() drops the work, so it's given again for each run.
+			f.setWork(genesis);
+			f.startCPU();
+			rates[k] = trials();
+		}
+		ProofOfWork::CPUMiner::setKernel(chosen);
+		innerMean = rates[chosen];
+		if (rates[Kernel::Single])
+			cout << "interleaved/single: " << (double)rates[Kernel::Interleaved] / rates[Kernel::Single] << "x" << endl;
+	}
+	else if (_m == MinerType::GPU)
+	{
+		f.startGPU();
+		innerMean = trials();
 	}
-	f.stop();
-	innerMean /= (_trials - 2);
-	cout << "min/mean/max: " << results.begin()->second.rate() << "/" << (mean / _trials) << "/" << results.rbegin()->second.rate() << " H/s" << endl;
-	cout << "inner mean: " << innerMean << " H/s" << endl;
 
 	(void)_phoneHome;
 #if ETH_JSONRPC || !ETH_TRUE
@@ -370,8 +413,41 @@ void doBenchmark(MinerType _m, bool _phoneHome, unsigned _warmupDuration = 15, u
 struct HappyChannel: public LogChannel  { static const char* name() { return ":-D"; } static const int verbosity = 1; };
 struct SadChannel: public LogChannel { static const char* name() { return ":-("; } static const int verbosity = 1; };
 
+/// Mines on work pushed by a WorkServer at @a _remote ("tcp://host:port"), reconnecting whenever the connection drops.
+void doPushFarm(MinerType _m, string const& _remote)
+{
+	string hostPort = _remote.substr(6);
+	auto colon = hostPort.rfind(':');
+	string host = hostPort.substr(0, colon);
+	unsigned short port = colon == string::npos ? 0 : (unsigned short)atoi(hostPort.substr(colon + 1).c_str());
+
+	GenericFarm<Ethash> f;
+	while (true)
+	{
+		try
+		{
+			WorkClient client(host, port, boost::asio::ip::host_name());
+			cnote << "Connected to work server at" << _remote;
+			if (_m == MinerType::CPU)
+				f.startCPU();
+			else if (_m == MinerType::GPU)
+				f.startGPU();
+			client.run(f);
+		}
+		catch (...)
+		{
+		}
+		f.stop();
+		for (auto i = 3; --i; this_thread::sleep_for(chrono::seconds(1)))
+			cerr << "Lost work server. Reconnecting in " << i << "... \r";
+		cerr << endl;
+	}
+}
+
 void doFarm(MinerType _m, string const& _remote, unsigned _recheckPeriod)
 {
+	if (_remote.substr(0, 6) == "tcp://")
+		doPushFarm(_m, _remote);
 	(void)_m;
 	(void)_remote;
 	(void)_recheckPeriod;
@@ -536,6 +612,7 @@ int main(int argc, char** argv)
 	bool interactive = false;
 #if ETH_JSONRPC
 	int jsonrpc = -1;
+	unsigned jsonrpcBatchThreads = thread::hardware_concurrency();
 #endif
 	bool upnp = true;
 	WithExisting killChain = WithExisting::Trust;
@@ -545,12 +622,15 @@ int main(int argc, char** argv)
 	string clientName;
 	string listenIP;
 	unsigned short listenPort = 30303;
+	unsigned short workServerPort = 0;
+	string workServerIP = "127.0.0.1";
 	string publicIP;
 	string remoteHost;
 	unsigned short remotePort = 30303;
 	unsigned peers = 5;
 	bool bootstrap = false;
 	unsigned networkId = 0;
+	unsigned networkThreads = 0;
 
 	/// Mining params
 	unsigned mining = 0;
@@ -786,6 +866,49 @@ int main(int argc, char** argv)
 			}
 		else if (arg == "-C" || arg == "--cpu")
 			minerType = MinerType::CPU;
+		else if (arg == "--cpu-kernel" && i + 1 < argc)
+		{
+			string m = boost::to_lower_copy(string(argv[++i]));
+			if (m == "single")
+				ProofOfWork::CPUMiner::setKernel(ProofOfWork::CPUMiner::Kernel::Single);
+			else if (m == "interleaved")
+				ProofOfWork::CPUMiner::setKernel(ProofOfWork::CPUMiner::Kernel::Interleaved);
+			else
+			{
+				cerr << "Bad " << arg << " option: " << m << endl;
+				return -1;
+			}
+		}
+		else if (arg == "--work-server" && i + 1 < argc)
+			workServerPort = (unsigned short)atoi(argv[++i]);
+		else if (arg == "--work-server-ip" && i + 1 < argc)
+			workServerIP = argv[++i];
+		else if (arg == "--numa" && i + 1 < argc)
+		{
+			string m = argv[++i];
+			if (isTrue(m))
+				ProofOfWork::CPUMiner::setNuma(true);
+			else if (isFalse(m))
+				ProofOfWork::CPUMiner::setNuma(false);
+			else
+			{
+				cerr << "Bad " << arg << " option: " << m << endl;
+				return -1;
+			}
+		}
+		else if (arg == "--hugepages" && i + 1 < argc)
+		{
+			string m = argv[++i];
+			if (isTrue(m))
+				EthashAux::setHugePages(true);
+			else if (isFalse(m))
+				EthashAux::setHugePages(false);
+			else
+			{
+				cerr << "Bad " << arg << " option: " << m << endl;
+				return -1;
+			}
+		}
 		else if (arg == "-G" || arg == "--opencl")
 			minerType = MinerType::GPU;
 		/*<< "    -s,--import-secret <secret>  Import a secret key into the key store and use as the default." << endl
@@ -819,6 +942,48 @@ int main(int argc, char** argv)
 		}
 		else if ((arg == "-d" || arg == "--path" || arg == "--db-path") && i + 1 < argc)
 			dbPath = argv[++i];
+		else if (arg == "--cache-budget" && i + 1 < argc)
+		{
+			string m = boost::to_lower_copy(string(argv[++i]));
+			auto eq = m.find('=');
+			CacheBudgets b = Defaults::cacheBudgets();
+			map<string, size_t*> caches = {
+				{ "blocks", &b.blocks },
+				{ "headers", &b.headers },
+				{ "bodyhashes", &b.bodyHashes },
+				{ "details", &b.details },
+				{ "logblooms", &b.logBlooms },
+				{ "receipts", &b.receipts },
+				{ "txaddresses", &b.transactionAddresses },
+				{ "blockhashes", &b.blockHashes },
+				{ "blocksblooms", &b.blocksBlooms }
+			};
+			try
+			{
+				if (eq == string::npos || !caches.count(m.substr(0, eq)))
+					throw invalid_argument(m);
+				*caches[m.substr(0, eq)] = stoul(m.substr(eq + 1)) * 1024 * 1024;
+				Defaults::setCacheBudgets(b);
+			}
+			catch (...)
+			{
+				cerr << "Bad " << arg << " option: " << m << endl;
+				return -1;
+			}
+		}
+		else if (arg == "--dag-threads" && i + 1 < argc)
+		{
+			string m = argv[++i];
+			try
+			{
+				EthashAux::setGenerationThreads(stol(m));
+			}
+			catch (...)
+			{
+				cerr << "Bad " << arg << " option: " << m << endl;
+				return -1;
+			}
+		}
 		else if ((arg == "-D" || arg == "--create-dag") && i + 1 < argc)
 		{
 			string m = boost::to_lower_copy(string(argv[++i]));
@@ -961,6 +1126,8 @@ int main(int argc, char** argv)
 			jsonrpc = jsonrpc == -1 ? SensibleHttpPort : jsonrpc;
 		else if (arg == "--json-rpc-port" && i + 1 < argc)
 			jsonrpc = atoi(argv[++i]);
+		else if (arg == "--json-rpc-batch-threads" && i + 1 < argc)
+			jsonrpcBatchThreads = atoi(argv[++i]);
 #endif
 #if ETH_JSCONSOLE
 		else if (arg == "--console")
@@ -970,6 +1137,8 @@ int main(int argc, char** argv)
 			g_logVerbosity = atoi(argv[++i]);
 		else if ((arg == "-x" || arg == "--peers") && i + 1 < argc)
 			peers = atoi(argv[++i]);
+		else if (arg == "--network-threads" && i + 1 < argc)
+			networkThreads = atoi(argv[++i]);
 		else if ((arg == "-o" || arg == "--mode") && i + 1 < argc)
 		{
 			string m = argv[++i];
@@ -1061,6 +1230,7 @@ int main(int argc, char** argv)
 	StructuredLogger::get().initialize(structuredLogging, structuredLoggingFormat, structuredLoggingURL);
 	VMFactory::setKind(jit ? VMKind::JIT : VMKind::Interpreter);
 	auto netPrefs = publicIP.empty() ? NetworkPreferences(listenIP ,listenPort, upnp) : NetworkPreferences(publicIP, listenIP ,listenPort, upnp);
+	netPrefs.ioThreads = networkThreads;
 	auto nodesState = contents((dbPath.size() ? dbPath : getDataDir()) + "/network.rlp");
 	std::string clientImplString = "++eth/" + clientName + "v" + dev::Version + "/" DEV_QUOTED(ETH_BUILD_TYPE) "/" DEV_QUOTED(ETH_BUILD_PLATFORM) + (jit ? "/JIT" : "");
 	dev::WebThreeDirect web3(
@@ -1184,6 +1354,8 @@ int main(int argc, char** argv)
 		c->setTurboMining(minerType == MinerType::GPU);
 		c->setAddress(beneficiary);
 		c->setNetworkId(networkId);
+		if (workServerPort)
+			c->startWorkServer(workServerPort, workServerIP);
 	}
 
 	cout << "Transaction Signer: " << signingKey << endl;
@@ -1202,8 +1374,11 @@ int main(int argc, char** argv)
 	unique_ptr<jsonrpc::AbstractServerConnector> jsonrpcConnector;
 	if (jsonrpc > -1)
 	{
-		jsonrpcConnector = unique_ptr<jsonrpc::AbstractServerConnector>(new jsonrpc::HttpServer(jsonrpc, "", "", SensibleHttpThreads));
+		auto batchConnector = new BatchServerConnector(new jsonrpc::HttpServer(jsonrpc, "", "", SensibleHttpThreads));
+		jsonrpcConnector = unique_ptr<jsonrpc::AbstractServerConnector>(batchConnector);
 		jsonrpcServer = shared_ptr<WebThreeStubServer>(new WebThreeStubServer(*jsonrpcConnector.get(), web3, make_shared<SimpleAccountHolder>([&](){return web3.ethereum();}, getAccountPassword, keyManager), vector<KeyPair>()));
+		jsonrpcServer->setBatchWorkers(jsonrpcBatchThreads);
+		batchConnector->setServer(jsonrpcServer.get());
 		jsonrpcServer->StartListening();
 	}
 #endif
@@ -1346,8 +1521,11 @@ int main(int argc, char** argv)
 			{
 				if (jsonrpc < 0)
 					jsonrpc = SensibleHttpPort;
-				jsonrpcConnector = unique_ptr<jsonrpc::AbstractServerConnector>(new jsonrpc::HttpServer(jsonrpc, "", "", SensibleHttpThreads));
+				auto batchConnector = new BatchServerConnector(new jsonrpc::HttpServer(jsonrpc, "", "", SensibleHttpThreads));
+				jsonrpcConnector = unique_ptr<jsonrpc::AbstractServerConnector>(batchConnector);
 				jsonrpcServer = shared_ptr<WebThreeStubServer>(new WebThreeStubServer(*jsonrpcConnector.get(), web3, make_shared<SimpleAccountHolder>([&](){return web3.ethereum();}, getAccountPassword, keyManager), vector<KeyPair>()));
+				jsonrpcServer->setBatchWorkers(jsonrpcBatchThreads);
+				batchConnector->setServer(jsonrpcServer.get());
 				jsonrpcServer->StartListening();
 			}
 			else if (cmd == "jsonstop")
@@ -76,9 +76,10 @@ void help()
 		<< "Work farming mode:" << endl
 		<< "    -F,--farm <url>  Put into mining farm mode with the work server at URL (default: http://127.0.0.1:8080)" << endl
 		<< "    --farm-recheck <n>  Leave n ms between checks for changed work (default: 500)." << endl
+		<< "    -F,--farm tcp://<host>:<port>  Instead have work pushed by the eth --work-server at host:port, submitting solutions as they're found." << endl
 #endif
 		<< "Benchmarking mode:" << endl
-		<< "    -M,--benchmark  Benchmark for mining and exit; use with --cpu and --opencl." << endl
+		<< "    -M,--benchmark  Benchmark for mining and exit; use with --cpu and --opencl. With --cpu, compares the CPU kernels." << endl
 		<< "    --benchmark-warmup <seconds>  Set the duration of warmup for the benchmark tests (default: 3)." << endl
 		<< "    --benchmark-trial <seconds>  Set the duration for each trial for the benchmark tests (default: 3)." << endl
 		<< "    --benchmark-trials <n>  Set the duration of warmup for the benchmark tests (default: 5)." << endl
@@ -87,12 +88,16 @@ void help()
 #endif
 		<< "DAG creation mode:" << endl
 		<< "    -D,--create-dag <number>  Create the DAG in preparation for mining on given block and exit." << endl
+		<< "    --dag-threads <n>  Generate DAGs with n threads (default: " << EthashAux::generationThreads() << ")." << endl
 		<< "General Options:" << endl
 		<< "    -C,--cpu  When mining, use the CPU." << endl
 		<< "    -G,--opencl  When mining use the GPU via OpenCL." << endl
 		<< "    --opencl-platform <n>  When mining using -G/--opencl use OpenCL platform n (default: 0)." << endl
 		<< "    --opencl-device <n>  When mining using -G/--opencl use OpenCL device n (default: 0)." << endl
 		<< "    -t, --mining-threads <n> Limit number of CPU/GPU miners to n (default: use everything available on selected platform)" << endl
+		<< "    --cpu-kernel <single/interleaved>  Have each CPU miner hash one nonce at a time, or " << ETHASH_LANES << " with their DAG reads interleaved (default: interleaved)." << endl
+		<< "    --hugepages <on/off>  Keep the DAG in huge pages when mining, to spare the TLB (default: off)." << endl
+		<< "    --numa <on/off>  On NUMA machines, pin CPU miners across the nodes and give each node its own copy of the DAG (default: on)." << endl
 		<< "    -v,--verbosity <0 - 9>  Set the log verbosity from 0 to 9 (default: 8)." << endl
 		<< "    -V,--version  Show the version and exit." << endl
 		<< "    -h,--help  Show this help message and exit." << endl
@@ -159,38 +164,69 @@ void doBenchmark(MinerType _m, bool _phoneHome, unsigned _warmupDuration = 15, u
 	genesis.difficulty = u256(1) << 63;
 	genesis.noteDirty();
 	f.setWork(genesis);
-	if (_m == MinerType::CPU)
-		f.startCPU();
-	else if (_m == MinerType::GPU)
-		f.startGPU();
 
-	map<uint64_t, MiningProgress> results;
-	uint64_t mean = 0;
+	auto trials = [&]()
+	{
+		map<uint64_t, MiningProgress> results;
+		uint64_t mean = 0;
+		uint64_t innerMean = 0;
+		for (unsigned i = 0; i <= _trials; ++i)
+		{
+			if (!i)
+				cout << "Warming up..." << endl;
+			else
+				cout << "Trial " << i << "... " << flush;
+			this_thread::sleep_for(chrono::seconds(i ? _trialDuration : _warmupDuration));
+
+			auto mp = f.miningProgress();
+			f.resetMiningProgress();
+			if (!i)
+				continue;
+			auto rate = mp.rate();
+
+			cout << rate;
+			if (mp.nodeHashes.size() > 1)
+				for (auto const& n: mp.nodeHashes)
+					cout << " (node " << n.first << ": " << mp.nodeRate(n.first) << ")";
+			cout << endl;
+			results[rate] = mp;
+			mean += rate;
+			if (i > 1 && i < 5)
+				innerMean += rate;
+		}
+		f.stop();
+		innerMean /= (_trials - 2);
+		cout << "min/mean/max: " << results.begin()->second.rate() << "/" << (mean / _trials) << "/" << results.rbegin()->second.rate() << " H/s" << endl;
+		cout << "inner mean: " << innerMean << " H/s" << endl;
+		return innerMean;
+	};
+
 	uint64_t innerMean = 0;
-	for (unsigned i = 0; i <= _trials; ++i)
+	if (_m == MinerType::CPU)
 	{
-		if (!i)
-			cout << "Warming up..." << endl;
-		else
-			cout << "Trial " << i << "... " << flush;
-		this_thread::sleep_for(chrono::seconds(i ? _trialDuration : _warmupDuration));
-
-		auto mp = f.miningProgress();
-		f.resetMiningProgress();
-		if (!i)
-			continue;
-		auto rate = mp.rate();
-
-		cout << rate << endl;
-		results[rate] = mp;
-		mean += rate;
-		if (i > 1 && i < 5)
-			innerMean += rate;
+		// Compare the chosen kernel against the other one; the chosen one's result is what gets reported.
+		using Kernel = ProofOfWork::CPUMiner::Kernel;
+		Kernel chosen = ProofOfWork::CPUMiner::kernel();
+		map<Kernel, uint64_t> rates;
+		for (Kernel k: { Kernel::Single, Kernel::Interleaved })
+		{
+			cout << "CPU kernel: " << ProofOfWork::CPUMiner::kernelName(k) << endl;
+			ProofOfWork::CPUMiner::setKernel(k);
+			// stop() drops the work, so it's given again for each run.
+			f.setWork(genesis);
+			f.startCPU();
+			rates[k] = trials();
+		}
+		ProofOfWork::CPUMiner::setKernel(chosen);
+		innerMean = rates[chosen];
+		if (rates[Kernel::Single])
+			cout << "interleaved/single: " << (double)rates[Kernel::Interleaved] / rates[Kernel::Single] << "x" << endl;
+	}
+	else if (_m == MinerType::GPU)
+	{
+		f.startGPU();
+		innerMean = trials();
 	}
-	f.stop();
-	innerMean /= (_trials - 2);
-	cout << "min/mean/max: " << results.begin()->second.rate() << "/" << (mean / _trials) << "/" << results.rbegin()->second.rate() << " H/s" << endl;
-	cout << "inner mean: " << innerMean << " H/s" << endl;
 
 	(void)_phoneHome;
 #if ETH_JSONRPC || !ETH_TRUE
@@ -216,8 +252,41 @@ void doBenchmark(MinerType _m, bool _phoneHome, unsigned _warmupDuration = 15, u
 struct HappyChannel: public LogChannel  { static const char* name() { return ":-D"; } static const int verbosity = 1; };
 struct SadChannel: public LogChannel { static const char* name() { return ":-("; } static const int verbosity = 1; };
 
+/// Mines on work pushed by a WorkServer at @a _remote ("tcp://host:port"), reconnecting whenever the connection drops.
+void doPushFarm(MinerType _m, string const& _remote)
+{
+	string hostPort = _remote.substr(6);
+	auto colon = hostPort.rfind(':');
+	string host = hostPort.substr(0, colon);
+	unsigned short port = colon == string::npos ? 0 : (unsigned short)atoi(hostPort.substr(colon + 1).c_str());
+
+	GenericFarm<Ethash> f;
+	while (true)
+	{
+		try
+		{
+			WorkClient client(host, port, boost::asio::ip::host_name());
+			cnote << "Connected to work server at" << _remote;
+			if (_m == MinerType::CPU)
+				f.startCPU();
+			else if (_m == MinerType::GPU)
+				f.startGPU();
+			client.run(f);
+		}
+		catch (...)
+		{
+		}
+		f.stop();
+		for (auto i = 3; --i; this_thread::sleep_for(chrono::seconds(1)))
+			cerr << "Lost work server. Reconnecting in " << i << "... \r";
+		cerr << endl;
+	}
+}
+
 void doFarm(MinerType _m, string const& _remote, unsigned _recheckPeriod)
 {
+	if (_remote.substr(0, 6) == "tcp://")
+		doPushFarm(_m, _remote);
 	(void)_m;
 	(void)_remote;
 	(void)_recheckPeriod;
@@ -397,8 +466,60 @@ int main(int argc, char** argv)
 			}
 		else if (arg == "-C" || arg == "--cpu")
 			minerType = MinerType::CPU;
+		else if (arg == "--cpu-kernel" && i + 1 < argc)
+		{
+			string m = boost::to_lower_copy(string(argv[++i]));
+			if (m == "single")
+				ProofOfWork::CPUMiner::setKernel(ProofOfWork::CPUMiner::Kernel::Single);
+			else if (m == "interleaved")
+				ProofOfWork::CPUMiner::setKernel(ProofOfWork::CPUMiner::Kernel::Interleaved);
+			else
+			{
+				cerr << "Bad " << arg << " option: " << m << endl;
+				return -1;
+			}
+		}
+		else if (arg == "--numa" && i + 1 < argc)
+		{
+			string m = argv[++i];
+			if (isTrue(m))
+				ProofOfWork::CPUMiner::setNuma(true);
+			else if (isFalse(m))
+				ProofOfWork::CPUMiner::setNuma(false);
+			else
+			{
+				cerr << "Bad " << arg << " option: " << m << endl;
+				return -1;
+			}
+		}
+		else if (arg == "--hugepages" && i + 1 < argc)
+		{
+			string m = argv[++i];
+			if (isTrue(m))
+				EthashAux::setHugePages(true);
+			else if (isFalse(m))
+				EthashAux::setHugePages(false);
+			else
+			{
+				cerr << "Bad " << arg << " option: " << m << endl;
+				return -1;
+			}
+		}
 		else if (arg == "-G" || arg == "--opencl")
 			minerType = MinerType::GPU;
+		else if (arg == "--dag-threads" && i + 1 < argc)
+		{
+			string m = argv[++i];
+			try
+			{
+				EthashAux::setGenerationThreads(stol(m));
+			}
+			catch (...)
+			{
+				cerr << "Bad " << arg << " option: " << m << endl;
+				return -1;
+			}
+		}
 		else if ((arg == "-D" || arg == "--create-dag") && i + 1 < argc)
 		{
 			string m = boost::to_lower_copy(string(argv[++i]));
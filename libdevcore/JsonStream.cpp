@@ -0,0 +1,163 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file JsonStream.cpp
+ * @date 2015
+ */
+
+#include "JsonStream.h"
+
+#include <cassert>
+using namespace std;
+using namespace dev;
+
+namespace
+{
+
+/// The two lower-case hex digits of every byte value, laid out back to back.
+struct HexTable
+{
+	HexTable()
+	{
+		static char const c_digits[] = "0123456789abcdef";
+		for (unsigned i = 0; i < 256; ++i)
+		{
+			pairs[i * 2] = c_digits[i >> 4];
+			pairs[i * 2 + 1] = c_digits[i & 15];
+		}
+	}
+	char pairs[512];
+};
+
+HexTable const c_hexTable;
+
+}
+
+void JsonStream::separate()
+{
+	if (m_afterKey)
+		m_afterKey = false;
+	else if (!m_first.empty())
+	{
+		if (!m_first.back())
+			m_out += ',';
+		m_first.back() = false;
+	}
+}
+
+JsonStream& JsonStream::key(char const* _k)
+{
+	assert(!m_first.empty() && !m_afterKey);
+	separate();
+	m_out += '"';
+	m_out += _k;
+	m_out += "\":";
+	m_afterKey = true;
+	return *this;
+}
+
+JsonStream& JsonStream::value(uint64_t _n)
+{
+	separate();
+	char buf[20];
+	unsigned i = sizeof(buf);
+	do
+		buf[--i] = '0' + _n % 10;
+	while (_n /= 10);
+	m_out.append(buf + i, sizeof(buf) - i);
+	return *this;
+}
+
+JsonStream& JsonStream::value(string const& _s)
+{
+	separate();
+	m_out += '"';
+	for (char c: _s)
+		switch (c)
+		{
+		case '"': m_out += "\\\""; break;
+		case '\\': m_out += "\\\\"; break;
+		case '\b': m_out += "\\b"; break;
+		case '\f': m_out += "\\f"; break;
+		case '\n': m_out += "\\n"; break;
+		case '\r': m_out += "\\r"; break;
+		case '\t': m_out += "\\t"; break;
+		default:
+			if ((unsigned char)c < 0x20)
+			{
+				m_out += "\\u00";
+				m_out.append(c_hexTable.pairs + (unsigned char)c * 2, 2);
+			}
+			else
+				m_out += c;
+		}
+	m_out += '"';
+	return *this;
+}
+
+void JsonStream::appendHex(bytesConstRef _b)
+{
+	size_t start = m_out.size();
+	m_out.resize(start + _b.size() * 2);
+	char* o = &m_out[start];
+	for (byte b: _b)
+	{
+		*o++ = c_hexTable.pairs[b * 2];
+		*o++ = c_hexTable.pairs[b * 2 + 1];
+	}
+}
+
+JsonStream& JsonStream::hex(bytesConstRef _b)
+{
+	separate();
+	m_out += "\"0x";
+	appendHex(_b);
+	m_out += '"';
+	return *this;
+}
+
+JsonStream& JsonStream::quantity(u256 const& _n)
+{
+	return quantity(h256(_n).ref());
+}
+
+JsonStream& JsonStream::quantity(uint64_t _n)
+{
+	byte be[8];
+	for (unsigned i = 8; i--; _n >>= 8)
+		be[i] = (byte)_n;
+	return quantity(bytesConstRef(be, 8));
+}
+
+JsonStream& JsonStream::quantity(bytesConstRef _be)
+{
+	unsigned zeroes = 0;
+	while (zeroes < _be.size() && !_be[zeroes])
+		++zeroes;
+	separate();
+	m_out += "\"0x";
+	if (zeroes == _be.size())
+		m_out += '0';
+	else
+	{
+		// The leading byte loses its high nibble if that is zero.
+		if (_be[zeroes] < 16)
+			m_out += c_hexTable.pairs[_be[zeroes++] * 2 + 1];
+		appendHex(_be.cropped(zeroes));
+	}
+	m_out += '"';
+	return *this;
+}
@@ -0,0 +1,99 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file JsonStream.h
+ * @date 2015
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "FixedHash.h"
+
+namespace dev
+{
+
+/**
+ * @brief Writes compact JSON text straight into a reusable buffer, without building a document tree.
+ * Values are written in the order given; the caller is responsible for well-formedness, which is
+ * only checked in debug builds. Hex encodings match those of toJS().
+ */
+class JsonStream
+{
+public:
+	JsonStream() { m_out.reserve(4096); }
+
+	/// A position in the stream to which it may later be rewound.
+	struct Mark
+	{
+		size_t size;
+		std::vector<bool> first;
+		bool afterKey;
+	};
+
+	/// Empties the buffer, keeping its capacity, so the stream may be reused.
+	void clear() { m_out.clear(); m_first.clear(); m_afterKey = false; }
+
+	/// @returns the current position, for discarding anything written after it with rewind().
+	Mark mark() const { return Mark{m_out.size(), m_first, m_afterKey}; }
+	/// Discards everything written since @a _m was taken.
+	void rewind(Mark const& _m) { m_out.resize(_m.size); m_first = _m.first; m_afterKey = _m.afterKey; }
+
+	JsonStream& beginObject() { separate(); m_out += '{'; m_first.push_back(true); return *this; }
+	JsonStream& endObject() { m_first.pop_back(); m_out += '}'; return *this; }
+	JsonStream& beginArray() { separate(); m_out += '['; m_first.push_back(true); return *this; }
+	JsonStream& endArray() { m_first.pop_back(); m_out += ']'; return *this; }
+
+	/// Writes the key for the next value of an object. @a _k must not need escaping.
+	JsonStream& key(char const* _k);
+
+	JsonStream& null() { separate(); m_out += "null"; return *this; }
+	JsonStream& value(bool _b) { separate(); m_out += _b ? "true" : "false"; return *this; }
+	JsonStream& value(uint64_t _n);
+	JsonStream& value(unsigned _n) { return value(uint64_t(_n)); }
+	/// Writes a quoted, escaped string.
+	JsonStream& value(std::string const& _s);
+	JsonStream& value(char const* _s) { return value(std::string(_s)); }
+
+	/// Writes "0x" followed by every byte of @a _b in hex, as toJS(bytes) does.
+	JsonStream& hex(bytesConstRef _b);
+	template <unsigned N> JsonStream& hex(FixedHash<N> const& _h) { return hex(_h.ref()); }
+
+	/// Writes "0x" followed by the minimal hex representation of @a _n ("0x0" for zero), as toJS(u256) does.
+	JsonStream& quantity(u256 const& _n);
+	JsonStream& quantity(uint64_t _n);
+
+	/// Writes already-serialised JSON text verbatim as the next value.
+	JsonStream& raw(std::string const& _json) { separate(); m_out += _json; return *this; }
+
+	std::string const& str() const { return m_out; }
+	size_t size() const { return m_out.size(); }
+
+private:
+	/// Emits the comma needed before a value or key, if any.
+	void separate();
+	/// Appends the hex digits of @a _b.
+	void appendHex(bytesConstRef _b);
+	/// Writes the big-endian number @a _be as a quantity.
+	JsonStream& quantity(bytesConstRef _be);
+
+	std::string m_out;
+	std::vector<bool> m_first;		///< For each open container, whether nothing has yet been written into it.
+	bool m_afterKey = false;
+};
+
+}
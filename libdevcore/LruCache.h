@@ -0,0 +1,245 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file LruCache.h
+ * @date 2015
+ */
+
+#pragma once
+
+#include <list>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include "Guards.h"
+
+namespace dev
+{
+
+/// Usage statistics of a cache.
+struct CacheStats
+{
+	size_t bytes = 0;
+	size_t entries = 0;
+	size_t budget = 0;
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t evictions = 0;
+
+	/// @returns the proportion of lookups which were hits, or 0 if there have been none.
+	double hitRatio() const { return hits + misses ? double(hits) / (hits + misses) : 0; }
+
+	CacheStats& operator+=(CacheStats const& _s) { bytes += _s.bytes; entries += _s.entries; budget += _s.budget; hits += _s.hits; misses += _s.misses; evictions += _s.evictions; return *this; }
+};
+
+/**
+ * @brief A thread-safe, size-accounted LRU cache.
+ * Entries are spread over a number of independently locked shards, each of which holds an equal
+ * part of the byte budget and evicts its least recently used entries whenever an insertion takes it
+ * over budget. No operation ever locks more than one shard.
+ * @threadsafe
+ */
+template <class Key, class Value, class Hash = std::hash<Key>>
+class ShardedLruCache
+{
+public:
+	/// Gives the number of bytes accounted to an entry (not including c_entryOverhead).
+	using Sizer = std::function<size_t(Value const&)>;
+
+	/// Accounted bookkeeping cost per entry on top of the value's own size.
+	static const size_t c_entryOverhead = sizeof(Key) + 64;
+
+	ShardedLruCache(size_t _budget, Sizer const& _sizer, unsigned _shards = 16):
+		m_shards(std::max(1u, _shards)), m_sizer(_sizer)
+	{
+		setBudget(_budget);
+	}
+
+	/// Sets the byte budget, evicting as necessary to meet it.
+	void setBudget(size_t _budget)
+	{
+		for (Shard& s: m_shards)
+		{
+			Guard l(s.x);
+			s.budget = _budget / m_shards.size();
+			evict(s, s.lru.end());
+		}
+	}
+
+	/// Looks up @a _k, marking it as most recently used and counting a hit or miss.
+	/// @returns true and sets @a o_v iff it was found.
+	bool get(Key const& _k, Value& o_v) const
+	{
+		Shard& s = shard(_k);
+		Guard l(s.x);
+		auto it = s.index.find(_k);
+		if (it == s.index.end())
+		{
+			++s.misses;
+			return false;
+		}
+		++s.hits;
+		s.lru.splice(s.lru.begin(), s.lru, it->second);
+		o_v = it->second->value;
+		return true;
+	}
+
+	/// @returns true iff @a _k is cached. Neither counts as a lookup nor touches recency.
+	bool contains(Key const& _k) const
+	{
+		Shard& s = shard(_k);
+		Guard l(s.x);
+		return s.index.count(_k);
+	}
+
+	/// Inserts or replaces the entry for @a _k as the most recently used one.
+	void insert(Key const& _k, Value const& _v)
+	{
+		Shard& s = shard(_k);
+		Guard l(s.x);
+		evict(s, place(s, _k, _v));
+	}
+
+	/// Applies @a _f to the entry for @a _k under the shard's lock, first caching @a _default
+	/// for it if it's absent. This makes read-modify-write of an entry atomic.
+	/// @returns a copy of the updated value.
+	template <class F> Value update(Key const& _k, Value const& _default, F const& _f)
+	{
+		Shard& s = shard(_k);
+		Guard l(s.x);
+		auto it = s.index.find(_k);
+		auto e = it == s.index.end() ? place(s, _k, _default) : it->second;
+		if (e != s.lru.begin())
+			s.lru.splice(s.lru.begin(), s.lru, e);
+		_f(e->value);
+		s.bytes -= e->size;
+		e->size = m_sizer(e->value) + c_entryOverhead;
+		s.bytes += e->size;
+		Value ret = e->value;
+		evict(s, e);
+		return ret;
+	}
+
+	void erase(Key const& _k)
+	{
+		Shard& s = shard(_k);
+		Guard l(s.x);
+		auto it = s.index.find(_k);
+		if (it != s.index.end())
+		{
+			s.bytes -= it->second->size;
+			s.lru.erase(it->second);
+			s.index.erase(it);
+		}
+	}
+
+	/// Drops all entries. Statistics are kept.
+	void clear()
+	{
+		for (Shard& s: m_shards)
+		{
+			Guard l(s.x);
+			s.lru.clear();
+			s.index.clear();
+			s.bytes = 0;
+		}
+	}
+
+	CacheStats stats() const
+	{
+		CacheStats ret;
+		for (Shard& s: m_shards)
+		{
+			Guard l(s.x);
+			ret.bytes += s.bytes;
+			ret.entries += s.index.size();
+			ret.budget += s.budget;
+			ret.hits += s.hits;
+			ret.misses += s.misses;
+			ret.evictions += s.evictions;
+		}
+		return ret;
+	}
+
+private:
+	struct Entry
+	{
+		Key key;
+		Value value;
+		size_t size;
+	};
+	using EntryList = std::list<Entry>;
+
+	struct Shard
+	{
+		Mutex x;
+		EntryList lru;		///< Most recently used first.
+		std::unordered_map<Key, typename EntryList::iterator, Hash> index;
+		size_t bytes = 0;
+		size_t budget = 0;
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0;
+	};
+
+	Shard& shard(Key const& _k) const
+	{
+		size_t h = Hash()(_k);
+		return m_shards[(h ^ (h >> 21) ^ (h >> 42)) % m_shards.size()];
+	}
+
+	/// Puts (@a _k, @a _v) at the front of @a _s's list. Must hold @a _s.x.
+	typename EntryList::iterator place(Shard& _s, Key const& _k, Value const& _v) const
+	{
+		size_t size = m_sizer(_v) + c_entryOverhead;
+		auto it = _s.index.find(_k);
+		if (it != _s.index.end())
+		{
+			_s.bytes -= it->second->size;
+			it->second->value = _v;
+			it->second->size = size;
+			_s.lru.splice(_s.lru.begin(), _s.lru, it->second);
+		}
+		else
+		{
+			_s.lru.push_front(Entry{_k, _v, size});
+			_s.index[_k] = _s.lru.begin();
+		}
+		_s.bytes += size;
+		return _s.lru.begin();
+	}
+
+	/// Drops least recently used entries of @a _s until it is within budget, never dropping @a _keep. Must hold @a _s.x.
+	void evict(Shard& _s, typename EntryList::iterator _keep) const
+	{
+		while (_s.bytes > _s.budget && !_s.lru.empty())
+		{
+			auto victim = std::prev(_s.lru.end());
+			if (victim == _keep)
+				break;
+			_s.bytes -= victim->size;
+			_s.index.erase(victim->key);
+			_s.lru.erase(victim);
+			++_s.evictions;
+		}
+	}
+
+	mutable std::vector<Shard> m_shards;
+	Sizer m_sizer;
+};
+
+}
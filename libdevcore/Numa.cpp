@@ -0,0 +1,114 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file Numa.cpp
+ * @date 2015
+ */
+
+#include "Numa.h"
+
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+using namespace std;
+using namespace dev;
+
+vector<unsigned> dev::parseCpuList(string const& _s)
+{
+	vector<unsigned> ret;
+	istringstream in(_s);
+	string range;
+	while (getline(in, range, ','))
+	{
+		unsigned first;
+		unsigned last;
+		char dash;
+		istringstream r(range);
+		if (!(r >> first))
+			continue;
+		if (!(r >> dash >> last) || dash != '-')
+			last = first;
+		for (unsigned c = first; c <= last; ++c)
+		{
+			ret.push_back(c);
+			if (c == last)
+				break;
+		}
+	}
+	return ret;
+}
+
+namespace
+{
+
+vector<NumaNode> readNumaNodes()
+{
+	vector<NumaNode> ret;
+#ifdef __linux__
+	namespace fs = boost::filesystem;
+	boost::system::error_code ec;
+	for (fs::directory_iterator it("/sys/devices/system/node", ec), end; !ec && it != end; it.increment(ec))
+	{
+		string name = it->path().filename().string();
+		if (name.compare(0, 4, "node") || name.size() == 4 || name.find_first_not_of("0123456789", 4) != string::npos)
+			continue;
+		ifstream f((it->path() / "cpulist").string());
+		string list;
+		if (!getline(f, list))
+			continue;
+		NumaNode n{(unsigned)stoul(name.substr(4)), parseCpuList(list)};
+		if (!n.cpus.empty())
+			ret.push_back(n);
+	}
+	sort(ret.begin(), ret.end(), [](NumaNode const& a, NumaNode const& b) { return a.id < b.id; });
+#endif
+	if (ret.empty())
+	{
+		ret.push_back(NumaNode{0, {}});
+		for (unsigned c = 0; c < max(1u, thread::hardware_concurrency()); ++c)
+			ret[0].cpus.push_back(c);
+	}
+	return ret;
+}
+
+}
+
+vector<NumaNode> const& dev::numaNodes()
+{
+	static const vector<NumaNode> s_nodes = readNumaNodes();
+	return s_nodes;
+}
+
+bool dev::pinThisThread(unsigned _cpu)
+{
+#ifdef __linux__
+	if (_cpu >= CPU_SETSIZE)
+		return false;
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(_cpu, &set);
+	return !pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+	(void)_cpu;
+	return false;
+#endif
+}
@@ -0,0 +1,47 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file Numa.h
+ * @date 2015
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace dev
+{
+
+/// A NUMA node: a set of CPUs sharing local memory.
+struct NumaNode
+{
+	unsigned id;
+	std::vector<unsigned> cpus;
+};
+
+/// @returns the machine's NUMA nodes, read once from /sys/devices/system/node. Where there's no such
+/// information (or not Linux), a single node 0 holding all CPUs.
+std::vector<NumaNode> const& numaNodes();
+
+/// Parses a kernel CPU list such as "0-7,16-23" into the CPUs it names, in order. Malformed and backwards ranges are skipped.
+std::vector<unsigned> parseCpuList(std::string const& _s);
+
+/// Restricts the calling thread to run only on @a _cpu. Memory it first touches from then on is placed
+/// on that CPU's node. @returns false if the platform doesn't support it or it failed.
+bool pinThisThread(unsigned _cpu);
+
+}
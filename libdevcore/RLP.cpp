@@ -266,6 +266,16 @@ RLPStream& RLPStream::appendList(bytesConstRef _rlp)
 	return *this;
 }
 
+RLPStream& RLPStream::appendListHeader(size_t _payloadSize)
+{
+	if (_payloadSize < c_rlpListImmLenCount)
+		m_out.push_back((byte)(_payloadSize + c_rlpListStart));
+	else
+		pushCount(_payloadSize, c_rlpListIndLenZero);
+	noteAppended();
+	return *this;
+}
+
 RLPStream& RLPStream::append(bytesConstRef _s, bool _compact)
 {
 	unsigned s = _s.size();
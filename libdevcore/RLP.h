@@ -371,6 +371,10 @@ public:
 	RLPStream& appendList(bytes const& _rlp) { return appendList(&_rlp); }
 	RLPStream& appendList(RLPStream const& _s) { return appendList(&_s.out()); }
 
+	/// Appends just the header of a list whose items, @a _payloadSize bytes of them once encoded, the caller
+	/// will put after this stream's output itself (e.g. gathering them from elsewhere into one packet).
+	RLPStream& appendListHeader(size_t _payloadSize);
+
 	/// Appends raw (pre-serialised) RLP data. Use with caution.
 	RLPStream& appendRaw(bytesConstRef _rlp, unsigned _itemCount = 1);
 	RLPStream& appendRaw(bytes const& _rlp, unsigned _itemCount = 1) { return appendRaw(&_rlp, _itemCount); }
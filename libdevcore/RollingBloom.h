@@ -0,0 +1,82 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file RollingBloom.h
+ * @date 2015
+ */
+
+#pragma once
+
+#include <bitset>
+#include <cstring>
+#include "FixedHash.h"
+
+namespace dev
+{
+
+/**
+ * @brief A fixed-size, probabilistic set of recently inserted hashes which forgets old ones by itself.
+ * Insertions go into the current of two bloom filters; once it has taken @a Generation of them, it becomes the
+ * old filter and the previous old one is dropped. So the last @a Generation hashes inserted are always
+ * found, older ones may be forgotten and, rarely, a hash never inserted is found too.
+ * The bits tested come straight from the hash, which must therefore be (as sha3 is) uniformly distributed.
+ */
+template <unsigned Bits = 16384, unsigned Generation = 1024>
+class RollingBloom
+{
+public:
+	template <unsigned N> void insert(FixedHash<N> const& _h)
+	{
+		if (m_inserted == Generation)
+		{
+			m_old = m_current;
+			m_current.reset();
+			m_inserted = 0;
+		}
+		for (unsigned i = 0; i < c_probes; ++i)
+			m_current.set(bit(_h, i));
+		++m_inserted;
+	}
+
+	template <unsigned N> bool contains(FixedHash<N> const& _h) const { return has(m_current, _h) || has(m_old, _h); }
+
+	void clear() { m_current.reset(); m_old.reset(); m_inserted = 0; }
+
+private:
+	static const unsigned c_probes = 3;
+
+	template <unsigned N> static unsigned bit(FixedHash<N> const& _h, unsigned _i)
+	{
+		static_assert(N >= 4 * c_probes, "Hash too small for RollingBloom");
+		uint32_t w;
+		std::memcpy(&w, _h.data() + 4 * _i, 4);
+		return w % Bits;
+	}
+
+	template <unsigned N> static bool has(std::bitset<Bits> const& _f, FixedHash<N> const& _h)
+	{
+		for (unsigned i = 0; i < c_probes; ++i)
+			if (!_f.test(bit(_h, i)))
+				return false;
+		return true;
+	}
+
+	std::bitset<Bits> m_current;
+	std::bitset<Bits> m_old;
+	unsigned m_inserted = 0;
+};
+
+}
@@ -0,0 +1,61 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file SharedBytes.h
+ * @date 2015
+ */
+
+#pragma once
+
+#include <memory>
+#include "Common.h"
+
+namespace dev
+{
+
+/// An immutable, reference-counted byte buffer.
+using SharedBytes = std::shared_ptr<bytes const>;
+
+/**
+ * @brief A view of part of a SharedBytes which keeps the whole buffer alive while it's held.
+ * Lets data received in one buffer (e.g. a network frame) be handed on and kept without copying.
+ */
+class SharedBytesRef
+{
+public:
+	SharedBytesRef() = default;
+	/// Views @a _ref, which must lie within @a _owner.
+	SharedBytesRef(SharedBytes const& _owner, bytesConstRef _ref): m_owner(_owner), m_ref(_ref) {}
+	/// Copies @a _data into a buffer of its own.
+	explicit SharedBytesRef(bytesConstRef _data): m_owner(std::make_shared<bytes const>(_data.toBytes())), m_ref(m_owner.get()) {}
+	/// Takes over @a _data as a buffer of its own.
+	explicit SharedBytesRef(bytes&& _data): m_owner(std::make_shared<bytes const>(std::move(_data))), m_ref(m_owner.get()) {}
+
+	bytesConstRef ref() const { return m_ref; }
+	size_t size() const { return m_ref.size(); }
+	bool empty() const { return m_ref.empty(); }
+	bytes toBytes() const { return m_ref.toBytes(); }
+
+	/// @returns a view of the same data which keeps no more than it alive: this, if it views all of its buffer, or else a copy.
+	/// For data that's to be held for a while and may have come from a much larger buffer.
+	SharedBytesRef compacted() const { return m_owner && m_owner->size() == m_ref.size() ? *this : SharedBytesRef(m_ref); }
+
+private:
+	SharedBytes m_owner;
+	bytesConstRef m_ref;
+};
+
+}
@@ -0,0 +1,134 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file ThreadPool.cpp
+ * @date 2015
+ */
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <exception>
+#include "Log.h"
+using namespace std;
+using namespace dev;
+
+ThreadPool::ThreadPool(unsigned _threads, string const& _name):
+	m_name(_name)
+{
+	_threads = max(1u, _threads);
+	for (unsigned i = 0; i < _threads; ++i)
+		m_threads.push_back(thread([=](){ workLoop(i); }));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		unique_lock<Mutex> l(x_queue);
+		m_stopping = true;
+	}
+	m_signal.notify_all();
+	for (auto& t: m_threads)
+		t.join();
+}
+
+void ThreadPool::post(Task const& _t)
+{
+	{
+		unique_lock<Mutex> l(x_queue);
+		m_queue.push_back(_t);
+	}
+	m_signal.notify_one();
+}
+
+bool ThreadPool::isPoolThread() const
+{
+	auto id = this_thread::get_id();
+	for (auto const& t: m_threads)
+		if (t.get_id() == id)
+			return true;
+	return false;
+}
+
+void ThreadPool::run(vector<Task> const& _ts)
+{
+	if (_ts.empty())
+		return;
+
+	Mutex x_done;
+	exception_ptr firstException;
+	auto runOne = [&](Task const& _t)
+	{
+		try
+		{
+			_t();
+		}
+		catch (...)
+		{
+			unique_lock<Mutex> l(x_done);
+			if (!firstException)
+				firstException = current_exception();
+		}
+	};
+
+	if (_ts.size() == 1 || isPoolThread())
+		for (auto const& t: _ts)
+			runOne(t);
+	else
+	{
+		condition_variable done;
+		size_t remaining = _ts.size();
+		for (auto const& t: _ts)
+			post([&, t]()
+			{
+				runOne(t);
+				unique_lock<Mutex> l(x_done);
+				if (!--remaining)
+					done.notify_all();
+			});
+
+		unique_lock<Mutex> l(x_done);
+		done.wait(l, [&](){ return !remaining; });
+	}
+
+	if (firstException)
+		rethrow_exception(firstException);
+}
+
+void ThreadPool::workLoop(unsigned _index)
+{
+	setThreadName(m_name + toString(_index));
+	while (true)
+	{
+		Task t;
+		{
+			unique_lock<Mutex> l(x_queue);
+			m_signal.wait(l, [&](){ return m_stopping || !m_queue.empty(); });
+			if (m_queue.empty())
+				return;
+			t = move(m_queue.front());
+			m_queue.pop_front();
+		}
+		try
+		{
+			t();
+		}
+		catch (...)
+		{
+			cwarn << "Unhandled exception in" << m_name << "task:" << boost::current_exception_diagnostic_information();
+		}
+	}
+}
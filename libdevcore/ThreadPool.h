@@ -0,0 +1,79 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file ThreadPool.h
+ * @date 2015
+ */
+
+#pragma once
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <condition_variable>
+#include "Guards.h"
+
+namespace dev
+{
+
+/**
+ * @brief A fixed-size set of threads draining a shared FIFO of tasks.
+ * Anything escaping a task given to post() is logged and swallowed, so such tasks should not throw; run() instead
+ * hands the first exception from its tasks back to its caller.
+ */
+class ThreadPool
+{
+public:
+	using Task = std::function<void()>;
+
+	/// Starts @a _threads threads (at least one), each named @a _name with its index appended.
+	explicit ThreadPool(unsigned _threads = std::thread::hardware_concurrency(), std::string const& _name = "pool");
+	~ThreadPool();
+
+	ThreadPool(ThreadPool const&) = delete;
+	ThreadPool& operator=(ThreadPool const&) = delete;
+
+	/// Queues @a _t for execution on some pool thread.
+	void post(Task const& _t);
+
+	/// Runs all of @a _ts on the pool and blocks until every one of them has finished, even if some throw.
+	/// If any did, the first exception thrown is then rethrown here.
+	/// If called from one of the pool's own threads, the tasks are run inline to avoid deadlock.
+	void run(std::vector<Task> const& _ts);
+
+	/// @returns the number of threads in the pool.
+	unsigned size() const { return m_threads.size(); }
+
+	/// @returns the number of tasks waiting to be picked up.
+	size_t pending() const { Guard l(x_queue); return m_queue.size(); }
+
+	/// @returns true if the calling thread belongs to this pool.
+	bool isPoolThread() const;
+
+private:
+	void workLoop(unsigned _index);
+
+	std::vector<std::thread> m_threads;
+	mutable Mutex x_queue;						///< Protects m_queue and m_stopping.
+	std::condition_variable m_signal;			///< Signalled when a task is posted or the pool stops.
+	std::deque<Task> m_queue;
+	bool m_stopping = false;
+	std::string m_name;
+};
+
+}
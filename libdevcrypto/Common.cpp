@@ -26,6 +26,7 @@
 #include <thread>
 #include <mutex>
 #include <libdevcore/Guards.h>
+#include <secp256k1/secp256k1.h>
 #include "SHA3.h"
 #include "FileSystem.h"
 #include "CryptoPP.h"
@@ -156,19 +157,65 @@ bytes dev::decryptSymNoAuth(h128 const& _k, h128 const& _iv, bytesConstRef _ciph
 	}
 }
 
+namespace
+{
+
+/// Sets up libsecp256k1's tables exactly once; after that its functions hold no locks and share no mutable state.
+void startSecp256k1()
+{
+	static bool const s_started = (secp256k1_start(), true);
+	(void)s_started;
+}
+
+/// Appends @a _x as a minimal DER INTEGER.
+void appendDerInteger(bytes& io_der, bytesConstRef _x)
+{
+	while (_x.size() > 1 && !_x[0] && !(_x[1] & 0x80))
+		_x = _x.cropped(1);
+	bool pad = _x[0] & 0x80;
+	io_der.push_back(0x02);
+	io_der.push_back(byte(_x.size() + pad));
+	if (pad)
+		io_der.push_back(0);
+	io_der.insert(io_der.end(), _x.begin(), _x.end());
+}
+
+}
+
 Public dev::recover(Signature const& _sig, h256 const& _message)
 {
-	return s_secp256k1.recover(_sig, _message.ref());
+	startSecp256k1();
+	byte pubkey[65];
+	int pubkeylen = sizeof(pubkey);
+	if (_sig[64] > 3 || !secp256k1_ecdsa_recover_compact(_message.data(), h256::size, _sig.data(), pubkey, &pubkeylen, 0, _sig[64]) || pubkeylen != 65)
+		return Public();
+	return Public(pubkey + 1, Public::ConstructFromPointer);
 }
 
 Signature dev::sign(Secret const& _k, h256 const& _hash)
 {
-	return s_secp256k1.sign(_k, _hash);
+	startSecp256k1();
+	Signature ret;
+	h256 nonce = kdf(_k, _hash);
+	int recid = 0;
+	// Nonces outside the group order, and the vanishingly rare r >= n (recovery ids 2 and 3, which v can't carry), are retried.
+	while (!secp256k1_ecdsa_sign_compact(_hash.data(), h256::size, ret.data(), _k.data(), nonce.data(), &recid) || recid > 1)
+		nonce = sha3(nonce);
+	ret[64] = byte(recid);
+	return ret;
 }
 
 bool dev::verify(Public const& _p, Signature const& _s, h256 const& _hash)
 {
-	return s_secp256k1.verify(_p, _s, _hash.ref(), true);
+	startSecp256k1();
+	// Plain ECDSA verification: unlike recover() it doesn't depend on the recovery id in _s[64].
+	bytes der;
+	appendDerInteger(der, bytesConstRef(_s.data(), 32));
+	appendDerInteger(der, bytesConstRef(_s.data() + 32, 32));
+	der.insert(der.begin(), {0x30, byte(der.size())});
+	byte pubkey[65] = {0x04};
+	memcpy(pubkey + 1, _p.data(), Public::size);
+	return secp256k1_ecdsa_verify(_hash.data(), h256::size, der.data(), int(der.size()), pubkey, sizeof(pubkey)) == 1;
 }
 
 bytes dev::pbkdf2(string const& _pass, bytes const& _salt, unsigned _iterations, unsigned _dkLen)
@@ -21,6 +21,9 @@
 
 #include "SHA3.h"
 
+#include <numeric>
+#include <algorithm>
+
 #include <libdevcore/RLP.h>
 #include "CryptoPP.h"
 using namespace std;
@@ -97,6 +100,280 @@ void sha3mac(bytesConstRef _secret, bytesConstRef _plain, bytesRef _output)
 	ctx.Final(_output.data());
 }
 
+namespace
+{
+
+uint64_t const c_roundConstants[24] =
+{
+	0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL, 0x8000000080008000ULL,
+	0x000000000000808bULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+	0x000000000000008aULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+	0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+	0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800aULL, 0x800000008000000aULL,
+	0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+// Four-way hashing needs vector subscripting, the target attribute and __builtin_cpu_supports: GCC 4.8 or clang 3.8.
+#if (defined(__clang__) && (__clang_major__ > 3 || (__clang_major__ == 3 && __clang_minor__ >= 8))) || (!defined(__clang__) && defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 8)))
+#define ETH_SHA3_VECTOR 1
+#else
+#define ETH_SHA3_VECTOR 0
+#endif
+
+#if defined(__GNUC__)
+#define ETH_SHA3_INLINE inline __attribute__((always_inline))
+#if !defined(__clang__)
+// Lanes are passed by reference, but rol() still returns them by value; being always inlined, it never does so through
+// the AVX calling convention this would otherwise warn of.
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+#else
+#define ETH_SHA3_INLINE inline
+#endif
+
+template <class Lane> ETH_SHA3_INLINE Lane rol(Lane const& _x, unsigned _s) { return (_x << _s) | (_x >> (64 - _s)); }
+
+/// The Keccak-f[1600] permutation, applied to as many states at once as Lane holds 64-bit words.
+/// Always inlined so that each caller gets a copy built for its own instruction set.
+template <class Lane> ETH_SHA3_INLINE void keccakf(Lane* _a)
+{
+	Lane c[5];
+	Lane d[5];
+	Lane b[25];
+	for (unsigned round = 0; round < 24; ++round)
+	{
+		// Theta
+		c[0] = _a[0] ^ _a[5] ^ _a[10] ^ _a[15] ^ _a[20];
+		c[1] = _a[1] ^ _a[6] ^ _a[11] ^ _a[16] ^ _a[21];
+		c[2] = _a[2] ^ _a[7] ^ _a[12] ^ _a[17] ^ _a[22];
+		c[3] = _a[3] ^ _a[8] ^ _a[13] ^ _a[18] ^ _a[23];
+		c[4] = _a[4] ^ _a[9] ^ _a[14] ^ _a[19] ^ _a[24];
+		d[0] = c[4] ^ rol(c[1], 1);
+		d[1] = c[0] ^ rol(c[2], 1);
+		d[2] = c[1] ^ rol(c[3], 1);
+		d[3] = c[2] ^ rol(c[4], 1);
+		d[4] = c[3] ^ rol(c[0], 1);
+		// Rho and pi
+		b[0] = _a[0] ^ d[0];
+		b[1] = rol(_a[6] ^ d[1], 44);
+		b[2] = rol(_a[12] ^ d[2], 43);
+		b[3] = rol(_a[18] ^ d[3], 21);
+		b[4] = rol(_a[24] ^ d[4], 14);
+		b[5] = rol(_a[3] ^ d[3], 28);
+		b[6] = rol(_a[9] ^ d[4], 20);
+		b[7] = rol(_a[10] ^ d[0], 3);
+		b[8] = rol(_a[16] ^ d[1], 45);
+		b[9] = rol(_a[22] ^ d[2], 61);
+		b[10] = rol(_a[1] ^ d[1], 1);
+		b[11] = rol(_a[7] ^ d[2], 6);
+		b[12] = rol(_a[13] ^ d[3], 25);
+		b[13] = rol(_a[19] ^ d[4], 8);
+		b[14] = rol(_a[20] ^ d[0], 18);
+		b[15] = rol(_a[4] ^ d[4], 27);
+		b[16] = rol(_a[5] ^ d[0], 36);
+		b[17] = rol(_a[11] ^ d[1], 10);
+		b[18] = rol(_a[17] ^ d[2], 15);
+		b[19] = rol(_a[23] ^ d[3], 56);
+		b[20] = rol(_a[2] ^ d[2], 62);
+		b[21] = rol(_a[8] ^ d[3], 55);
+		b[22] = rol(_a[14] ^ d[4], 39);
+		b[23] = rol(_a[15] ^ d[0], 41);
+		b[24] = rol(_a[21] ^ d[1], 2);
+		// Chi
+		_a[0] = b[0] ^ (~b[1] & b[2]);
+		_a[1] = b[1] ^ (~b[2] & b[3]);
+		_a[2] = b[2] ^ (~b[3] & b[4]);
+		_a[3] = b[3] ^ (~b[4] & b[0]);
+		_a[4] = b[4] ^ (~b[0] & b[1]);
+		_a[5] = b[5] ^ (~b[6] & b[7]);
+		_a[6] = b[6] ^ (~b[7] & b[8]);
+		_a[7] = b[7] ^ (~b[8] & b[9]);
+		_a[8] = b[8] ^ (~b[9] & b[5]);
+		_a[9] = b[9] ^ (~b[5] & b[6]);
+		_a[10] = b[10] ^ (~b[11] & b[12]);
+		_a[11] = b[11] ^ (~b[12] & b[13]);
+		_a[12] = b[12] ^ (~b[13] & b[14]);
+		_a[13] = b[13] ^ (~b[14] & b[10]);
+		_a[14] = b[14] ^ (~b[10] & b[11]);
+		_a[15] = b[15] ^ (~b[16] & b[17]);
+		_a[16] = b[16] ^ (~b[17] & b[18]);
+		_a[17] = b[17] ^ (~b[18] & b[19]);
+		_a[18] = b[18] ^ (~b[19] & b[15]);
+		_a[19] = b[19] ^ (~b[15] & b[16]);
+		_a[20] = b[20] ^ (~b[21] & b[22]);
+		_a[21] = b[21] ^ (~b[22] & b[23]);
+		_a[22] = b[22] ^ (~b[23] & b[24]);
+		_a[23] = b[23] ^ (~b[24] & b[20]);
+		_a[24] = b[24] ^ (~b[20] & b[21]);
+		// Iota
+		_a[0] ^= c_roundConstants[round];
+	}
+}
+
+/// Keccak lanes are little-endian.
+inline uint64_t loadLane(byte const* _p)
+{
+	uint64_t ret = 0;
+	for (unsigned i = 8; i--;)
+		ret = (ret << 8) | _p[i];
+	return ret;
+}
+
+inline void storeLane(uint64_t _l, byte* _p)
+{
+	for (unsigned i = 0; i < 8; ++i, _l >>= 8)
+		_p[i] = (byte)_l;
+}
+
+unsigned const c_rate = 136;				///< Bytes absorbed per Keccak-256 block.
+unsigned const c_rateLanes = c_rate / 8;
+
+/// @returns the number of blocks @a _size bytes of input take once padded (padding always adds at least a byte).
+inline size_t paddedBlocks(size_t _size) { return _size / c_rate + 1; }
+
+/// Reads the @a _block'th block of @a _input, padding it if it's the last one.
+void loadBlock(bytesConstRef _input, size_t _block, uint64_t* o_lanes)
+{
+	size_t offset = _block * c_rate;
+	size_t n = min<size_t>(c_rate, _input.size() - offset);
+	if (n == c_rate)
+	{
+		for (unsigned i = 0; i < c_rateLanes; ++i)
+			o_lanes[i] = loadLane(_input.data() + offset + 8 * i);
+		return;
+	}
+	byte last[c_rate] = {};
+	if (n)
+		memcpy(last, _input.data() + offset, n);
+	last[n] |= 0x01;
+	last[c_rate - 1] |= 0x80;
+	for (unsigned i = 0; i < c_rateLanes; ++i)
+		o_lanes[i] = loadLane(last + 8 * i);
+}
+
+h256 keccak256(bytesConstRef _input)
+{
+	uint64_t a[25] = {};
+	uint64_t block[c_rateLanes];
+	for (size_t b = 0, blocks = paddedBlocks(_input.size()); b < blocks; ++b)
+	{
+		loadBlock(_input, b, block);
+		for (unsigned i = 0; i < c_rateLanes; ++i)
+			a[i] ^= block[i];
+		keccakf(a);
+	}
+	h256 ret;
+	for (unsigned i = 0; i < 4; ++i)
+		storeLane(a[i], ret.data() + 8 * i);
+	return ret;
+}
+
+#if ETH_SHA3_VECTOR
+
+/// Four Keccak lanes, one from each of four states; with AVX2 one permutation step handles them all in a register.
+typedef uint64_t Lanes4 __attribute__((vector_size(32)));
+unsigned const c_ways = 4;
+
+void keccakf4Generic(Lanes4* _a) { keccakf(_a); }
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) void keccakf4Avx2(Lanes4* _a) { keccakf(_a); }
+bool haveAvx2() { static bool const s_ret = (__builtin_cpu_init(), __builtin_cpu_supports("avx2")); return s_ret; }
+#else
+void keccakf4Avx2(Lanes4* _a) { keccakf(_a); }
+bool haveAvx2() { return false; }
+#endif
+
+/// Hashes four inputs in lock-step. A lane whose input is used up has its hash read off and then just rides along.
+void keccak256x4(bytesConstRef const* _inputs, h256* o_outputs)
+{
+	Lanes4 a[25] = {};
+	size_t blocks[c_ways];
+	size_t most = 0;
+	for (unsigned w = 0; w < c_ways; ++w)
+		most = max(most, blocks[w] = paddedBlocks(_inputs[w].size()));
+	uint64_t block[c_rateLanes];
+	for (size_t b = 0; b < most; ++b)
+	{
+		for (unsigned w = 0; w < c_ways; ++w)
+			if (b < blocks[w])
+			{
+				loadBlock(_inputs[w], b, block);
+				for (unsigned i = 0; i < c_rateLanes; ++i)
+					a[i][w] ^= block[i];
+			}
+		if (haveAvx2())
+			keccakf4Avx2(a);
+		else
+			keccakf4Generic(a);
+		for (unsigned w = 0; w < c_ways; ++w)
+			if (b + 1 == blocks[w])
+				for (unsigned i = 0; i < 4; ++i)
+					storeLane(a[i][w], o_outputs[w].data() + 8 * i);
+	}
+}
+
+#endif
+
+}
+
+FixedPrefixSHA3::FixedPrefixSHA3(h256 const& _prefix)
+{
+	m_state.fill(0);
+	for (unsigned i = 0; i < 4; ++i)
+		m_state[i] = loadLane(_prefix.data() + 8 * i);
+	// Keccak padding of a 64-byte message in the 136-byte block: 0x01 straight after it, 0x80 in the block's last byte.
+	m_state[8] = 0x01;
+	m_state[16] = 0x8000000000000000ULL;
+}
+
+h256 FixedPrefixSHA3::operator()(h256 const& _suffix) const
+{
+	std::array<uint64_t, 25> a = m_state;
+	for (unsigned i = 0; i < 4; ++i)
+		a[4 + i] = loadLane(_suffix.data() + 8 * i);
+	keccakf(a.data());
+	h256 ret;
+	for (unsigned i = 0; i < 4; ++i)
+		storeLane(a[i], ret.data() + 8 * i);
+	return ret;
+}
+
+void sha3Batch(vector_ref<bytesConstRef const> _inputs, vector_ref<h256> o_outputs)
+{
+	assert(o_outputs.size() >= _inputs.size());
+	size_t i = 0;
+#if ETH_SHA3_VECTOR
+	if (_inputs.size() >= c_ways)
+	{
+		// Hash inputs of similar length together so lanes seldom idle.
+		vector<size_t> order(_inputs.size());
+		iota(order.begin(), order.end(), 0);
+		sort(order.begin(), order.end(), [&](size_t _a, size_t _b) { return _inputs[_a].size() < _inputs[_b].size(); });
+		bytesConstRef in[c_ways];
+		h256 out[c_ways];
+		for (; i + c_ways <= order.size(); i += c_ways)
+		{
+			for (unsigned w = 0; w < c_ways; ++w)
+				in[w] = _inputs[order[i + w]];
+			keccak256x4(in, out);
+			for (unsigned w = 0; w < c_ways; ++w)
+				o_outputs[order[i + w]] = out[w];
+		}
+		for (; i < order.size(); ++i)
+			o_outputs[order[i]] = keccak256(_inputs[order[i]]);
+	}
+#endif
+	for (; i < _inputs.size(); ++i)
+		o_outputs[i] = keccak256(_inputs[i]);
+}
+
+h256s sha3Batch(vector<bytesConstRef> const& _inputs)
+{
+	h256s ret(_inputs.size());
+	sha3Batch(&_inputs, &ret);
+	return ret;
+}
+
 bytes aesDecrypt(bytesConstRef _ivCipher, std::string const& _password, unsigned _rounds, bytesConstRef _salt)
 {
 	bytes pw = asBytes(_password);
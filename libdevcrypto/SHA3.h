@@ -23,6 +23,7 @@
 
 #pragma once
 
+#include <array>
 #include <string>
 #include <libdevcore/FixedHash.h>
 #include <libdevcore/vector_ref.h>
@@ -62,6 +63,31 @@ void sha3mac(bytesConstRef _secret, bytesConstRef _plain, bytesRef _output);
 /// Calculate SHA3-256 hash of the given input (presented as a FixedHash), returns a 256-bit hash.
 template<unsigned N> inline h256 sha3(FixedHash<N> const& _input) { return sha3(_input.ref()); }
 
+/// Calculate the SHA3-256 hashes of all of @a _inputs at once into the corresponding elements of @a o_outputs,
+/// which must be at least as long. Inputs are hashed four at a time by a SIMD Keccak (AVX2 where the CPU has it),
+/// which makes this much quicker than separate sha3() calls for many small inputs.
+void sha3Batch(vector_ref<bytesConstRef const> _inputs, vector_ref<h256> o_outputs);
+
+/// Calculate the SHA3-256 hashes of all of @a _inputs at once.
+h256s sha3Batch(std::vector<bytesConstRef> const& _inputs);
+
+/**
+ * @brief SHA3-256 of 64-byte inputs whose first 32 bytes are always the same, as in proofs of work.
+ * The input fits a single Keccak block, so the padded state is prepared once from the prefix and hashing each
+ * second half costs just one scalar Keccak-f permutation, with nothing allocated. Gives exactly sha3() of the concatenation.
+ */
+class FixedPrefixSHA3
+{
+public:
+	explicit FixedPrefixSHA3(h256 const& _prefix);
+
+	/// @returns sha3(_prefix ++ _suffix).
+	h256 operator()(h256 const& _suffix) const;
+
+private:
+	std::array<uint64_t, 25> m_state;	///< Keccak state with the prefix and padding absorbed and the suffix lanes zero.
+};
+
 extern h256 EmptySHA3;
 
 extern h256 EmptyListSHA3;
@@ -325,6 +325,9 @@ public:
 	void insert(KeyType _k, bytesConstRef _value) { Generic::insert(bytesConstRef((byte const*)&_k, sizeof(KeyType)), _value); }
 	void insert(KeyType _k, bytes const& _value) { insert(_k, bytesConstRef(&_value)); }
 	void remove(KeyType _k) { Generic::remove(bytesConstRef((byte const*)&_k, sizeof(KeyType))); }
+	/// As insert() and remove() for hashed tries, given @a _hashedKey, which must be sha3(_k); e.g. from sha3Batch().
+	void insertHashed(KeyType _k, h256 const& _hashedKey, bytesConstRef _value) { Generic::insertHashed(bytesConstRef((byte const*)&_k, sizeof(KeyType)), _hashedKey, _value); }
+	void removeHashed(KeyType _k, h256 const& _hashedKey) { Generic::removeHashed(bytesConstRef((byte const*)&_k, sizeof(KeyType)), _hashedKey); }
 
 	class iterator: public Generic::iterator
 	{
@@ -384,6 +387,9 @@ public:
 	bool contains(bytesConstRef _key) { return Super::contains(sha3(_key)); }
 	void insert(bytesConstRef _key, bytesConstRef _value) { Super::insert(sha3(_key), _value); }
 	void remove(bytesConstRef _key) { Super::remove(sha3(_key)); }
+	/// As insert() and remove(), given @a _hashedKey, which must be sha3(_key).
+	void insertHashed(bytesConstRef, h256 const& _hashedKey, bytesConstRef _value) { Super::insert(_hashedKey, _value); }
+	void removeHashed(bytesConstRef, h256 const& _hashedKey) { Super::remove(_hashedKey); }
 
 	// empty from the PoV of the iterator interface; still need a basic iterator impl though.
 	class iterator
@@ -437,6 +443,8 @@ public:
 
 	void insert(bytesConstRef _key, bytesConstRef _value) { Super::insert(_key, _value); m_secure.insert(_key, _value); syncRoot(); }
 	void remove(bytesConstRef _key) { Super::remove(_key); m_secure.remove(_key); syncRoot(); }
+	void insertHashed(bytesConstRef _key, h256 const& _hashedKey, bytesConstRef _value) { Super::insert(_key, _value); m_secure.insertHashed(_key, _hashedKey, _value); syncRoot(); }
+	void removeHashed(bytesConstRef _key, h256 const& _hashedKey) { Super::remove(_key); m_secure.removeHashed(_key, _hashedKey); syncRoot(); }
 
 	h256Hash leftOvers(std::ostream* = nullptr) const { return h256Hash{}; }
 	bool check(bool) const { return m_secure.check(false) && Super::check(false); }
@@ -39,6 +39,12 @@
 #define ETHASH_ACCESSES 64
 #define ETHASH_DAG_MAGIC_NUM_SIZE 8
 #define ETHASH_DAG_MAGIC_NUM 0xFEE1DEADBADDCAFE
+// A DAG file whose generation is under way has this in the upper half of its magic number and the
+// number of leading items already written in the lower half.
+#define ETHASH_DAG_PARTIAL_MAGIC_NUM 0xDA6DA6A000000000
+#define ETHASH_DAG_PARTIAL_MAGIC_MASK 0xFFFFFFFF00000000
+// Number of chunks a DAG is generated in; progress is checkpointed after each.
+#define ETHASH_DAG_CHUNKS 100
 
 #ifdef __cplusplus
 extern "C" {
@@ -60,6 +66,16 @@ typedef struct ethash_light* ethash_light_t;
 struct ethash_full;
 typedef struct ethash_full* ethash_full_t;
 typedef int(*ethash_callback_t)(unsigned);
+/**
+ * Computes the DAG items [begin, end) into @a data, the start of the full data.
+ * Called once per chunk with @a user as given to @ref ethash_full_new_chunked().
+ * Should return false iff generation has to be abandoned.
+ */
+typedef bool(*ethash_generator_t)(void* user, void* data, uint32_t begin, uint32_t end, ethash_light_t light);
+/**
+ * Writes DAG item @a index into @a o_item; see @ref ethash_light_compute_with().
+ */
+typedef void(*ethash_item_source_t)(void* user, uint32_t index, ethash_light_t light, void* o_item);
 
 typedef struct ethash_return_value {
 	ethash_h256_t result;
@@ -93,6 +109,20 @@ ethash_return_value_t ethash_light_compute(
 	ethash_h256_t const header_hash,
 	uint64_t nonce
 );
+/**
+ * As @ref ethash_light_compute(), but each DAG item the hash needs is got from @a source,
+ * which may look it up in a cache of items computed earlier instead of computing it afresh.
+ *
+ * @param source         Writes DAG item @a index (ETHASH_HASH_BYTES bytes) to @a o_item.
+ * @param user           Passed through to @a source.
+ */
+ethash_return_value_t ethash_light_compute_with(
+	ethash_light_t light,
+	ethash_h256_t const header_hash,
+	uint64_t nonce,
+	ethash_item_source_t source,
+	void* user
+);
 
 /**
  * Allocate and initialize a new ethash_full handler
@@ -110,6 +140,28 @@ ethash_return_value_t ethash_light_compute(
  */
 ethash_full_t ethash_full_new(ethash_light_t light, ethash_callback_t callback);
 
+/**
+ * As @ref ethash_full_new(), but each chunk of the DAG is computed by @a generator,
+ * which may split it over several threads (items are independent of one another).
+ * After each chunk the DAG file records how far it got, so if generation is
+ * interrupted the next call for the same epoch resumes from there.
+ *
+ * @param generator     Computes chunks; NULL computes them on the calling thread.
+ * @param user          Passed through to @a generator.
+ */
+ethash_full_t ethash_full_new_chunked(
+	ethash_light_t light,
+	ethash_callback_t callback,
+	ethash_generator_t generator,
+	void* user
+);
+
+/**
+ * Computes the DAG items [begin, end) into @a data, the start of the full data.
+ * Safe to call concurrently for disjoint ranges.
+ */
+void ethash_compute_full_range(void* data, uint32_t begin, uint32_t end, ethash_light_t light);
+
 /**
  * Frees a previously allocated ethash_full handler
  * @param full    The light handler to free
@@ -128,6 +180,46 @@ ethash_return_value_t ethash_full_compute(
 	ethash_h256_t const header_hash,
 	uint64_t nonce
 );
+/// The most nonces ethash_full_compute_lanes() takes at once.
+#define ETHASH_LANES 4
+
+/**
+ * Calculate the full client data for up to ETHASH_LANES nonces at once. Their DAG reads are
+ * interleaved so one nonce's memory latency overlaps the others', and the mixing uses AVX2
+ * where the CPU has it.
+ *
+ * @param nonces         The @a count nonces to hash
+ * @param count          How many nonces; at most ETHASH_LANES
+ * @param ret            Receives the @a count results, in the order of @a nonces
+ * @return               false if @a count is too big or the DAG is malformed
+ */
+bool ethash_full_compute_lanes(
+	ethash_full_t full,
+	ethash_h256_t const header_hash,
+	uint64_t const* nonces,
+	unsigned count,
+	ethash_return_value_t* ret
+);
+
+/**
+ * Move the full DAG into anonymous memory backed by huge pages: explicit ones if enough are
+ * reserved, transparent ones otherwise. This cuts the TLB misses of random DAG reads. Call it
+ * before the DAG is shared with other threads.
+ *
+ * @return               true if the DAG is now in huge-page-backed memory. Always false on
+ *                       platforms other than Linux.
+ */
+bool ethash_full_use_hugepages(ethash_full_t full);
+
+/**
+ * Make a copy of the full DAG in anonymous memory, huge-page-backed if @a hugepages. The pages are
+ * first touched by the calling thread, so on a NUMA machine they are placed on the node it runs on;
+ * pin the thread to that node before calling. The copy has no file and is freed with ethash_full_delete().
+ *
+ * @return               The new handle, or NULL on failure. Always NULL on platforms other than Linux.
+ */
+ethash_full_t ethash_full_replicate(ethash_full_t full, bool hugepages);
+
 /**
  * Get a pointer to the full DAG data
  */
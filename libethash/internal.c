@@ -25,6 +25,9 @@
 #include <stddef.h>
 #include <errno.h>
 #include <math.h>
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
 #include "mmap.h"
 #include "ethash.h"
 #include "fnv.h"
@@ -171,23 +174,85 @@ bool ethash_compute_full_data(
 	return true;
 }
 
-static bool ethash_hash(
-	ethash_return_value_t* ret,
-	node const* full_nodes,
-	ethash_light_t const light,
+void ethash_compute_full_range(void* data, uint32_t begin, uint32_t end, ethash_light_t light)
+{
+	node* full_nodes = data;
+	for (uint32_t n = begin; n < end; ++n) {
+		ethash_calculate_dag_item(&(full_nodes[n]), n, light);
+	}
+}
+
+static bool ethash_generate_on_caller(void* user, void* data, uint32_t begin, uint32_t end, ethash_light_t light)
+{
+	(void)user;
+	ethash_compute_full_range(data, begin, end, light);
+	return true;
+}
+
+/// Writes the mapped file pages holding @a size bytes at @a addr out to the file.
+static bool ethash_sync_range(void* addr, size_t size)
+{
+#if defined(_WIN32)
+	return msync(addr, size, MS_SYNC) == 0;
+#else
+	// msync wants a page-aligned start
+	uintptr_t const page = (uintptr_t)sysconf(_SC_PAGESIZE);
+	uintptr_t const start = (uintptr_t)addr / page * page;
+	return msync((void*)start, (size_t)((uintptr_t)addr + size - start), MS_SYNC) == 0;
+#endif
+}
+
+bool ethash_compute_full_data_chunked(
+	uint64_t* magic_num,
+	void* mem,
 	uint64_t full_size,
-	ethash_h256_t const header_hash,
-	uint64_t const nonce
+	ethash_light_t const light,
+	ethash_callback_t callback,
+	ethash_generator_t generator,
+	void* user
 )
 {
-	if (full_size % MIX_WORDS != 0) {
+	if (full_size % (sizeof(uint32_t) * MIX_WORDS) != 0 ||
+		(full_size % sizeof(node)) != 0) {
 		return false;
 	}
+	uint32_t const max_n = (uint32_t)(full_size / sizeof(node));
+	uint32_t const chunk = max_n / ETHASH_DAG_CHUNKS + 1;
+	uint32_t n = 0;
+	if ((*magic_num & ETHASH_DAG_PARTIAL_MAGIC_MASK) == ETHASH_DAG_PARTIAL_MAGIC_NUM &&
+		(uint32_t)*magic_num <= max_n) {
+		// an earlier generation got this far before being interrupted
+		n = (uint32_t)*magic_num;
+	}
+	if (!generator) {
+		generator = ethash_generate_on_caller;
+	}
+	while (n < max_n) {
+		if (callback && callback((unsigned)((uint64_t)n * 100 / max_n)) != 0) {
+			return false;
+		}
+		uint32_t const end = max_n - n > chunk ? n + chunk : max_n;
+		if (!generator(user, mem, n, end, light)) {
+			return false;
+		}
+		// the chunk has to be in the file before a checkpoint that says so; otherwise a crash could
+		// leave the checkpoint on disk ahead of the data and a resume would skip nodes never written
+		if (!ethash_sync_range((node*)mem + n, (size_t)(end - n) * sizeof(node))) {
+			return false;
+		}
+		n = end;
+		// the header is mapped along with the data, so this checkpoint lands in the file
+		*magic_num = ETHASH_DAG_PARTIAL_MAGIC_NUM | n;
+	}
+	return true;
+}
 
+/// Seeds s_mix[0] from the header hash and nonce and replicates it across the mix in s_mix[1..MIX_NODES]
+static void ethash_hash_seed(node* s_mix, ethash_h256_t const* header_hash, uint64_t const nonce)
+{
 	// pack hash and nonce together into first 40 bytes of s_mix
 	assert(sizeof(node) * 8 == 512);
-	node s_mix[MIX_NODES + 1];
-	memcpy(s_mix[0].bytes, &header_hash, 32);
+	memcpy(s_mix[0].bytes, header_hash, 32);
 	fix_endian64(s_mix[0].double_words[4], nonce);
 
 	// compute sha3-512 hash and replicate across mix
@@ -198,6 +263,45 @@ static bool ethash_hash(
 	for (uint32_t w = 0; w != MIX_WORDS; ++w) {
 		mix->words[w] = s_mix[0].words[w % NODE_WORDS];
 	}
+}
+
+/// Compresses the mix in s_mix[1..MIX_NODES] and produces the final hash
+static void ethash_hash_finish(ethash_return_value_t* ret, node* s_mix)
+{
+	node* const mix = s_mix + 1;
+	// compress mix
+	for (uint32_t w = 0; w != MIX_WORDS; w += 4) {
+		uint32_t reduction = mix->words[w + 0];
+		reduction = reduction * FNV_PRIME ^ mix->words[w + 1];
+		reduction = reduction * FNV_PRIME ^ mix->words[w + 2];
+		reduction = reduction * FNV_PRIME ^ mix->words[w + 3];
+		mix->words[w / 4] = reduction;
+	}
+
+	fix_endian_arr32(mix->words, MIX_WORDS / 4);
+	memcpy(&ret->mix_hash, mix->bytes, 32);
+	// final Keccak hash
+	SHA3_256(&ret->result, s_mix->bytes, 64 + 32); // Keccak-256(s + compressed_mix)
+}
+
+static bool ethash_hash(
+	ethash_return_value_t* ret,
+	node const* full_nodes,
+	ethash_light_t const light,
+	ethash_item_source_t source,
+	void* user,
+	uint64_t full_size,
+	ethash_h256_t const header_hash,
+	uint64_t const nonce
+)
+{
+	if (full_size % MIX_WORDS != 0) {
+		return false;
+	}
+
+	node s_mix[MIX_NODES + 1];
+	ethash_hash_seed(s_mix, &header_hash, nonce);
+	node* const mix = s_mix + 1;
 
 	unsigned const page_size = sizeof(uint32_t) * MIX_WORDS;
 	unsigned const num_full_pages = (unsigned) (full_size / page_size);
@@ -207,10 +311,13 @@ static bool ethash_hash(
 
 		for (unsigned n = 0; n != MIX_NODES; ++n) {
 			node const* dag_node;
+			node tmp_node;
 			if (full_nodes) {
 				dag_node = &full_nodes[MIX_NODES * index + n];
+			} else if (source) {
+				source(user, index * MIX_NODES + n, light, &tmp_node);
+				dag_node = &tmp_node;
 			} else {
-				node tmp_node;
 				ethash_calculate_dag_item(&tmp_node, index * MIX_NODES + n, light);
 				dag_node = &tmp_node;
 			}
@@ -238,19 +345,115 @@ static bool ethash_hash(
 
 	}
 
-	// compress mix
-	for (uint32_t w = 0; w != MIX_WORDS; w += 4) {
-		uint32_t reduction = mix->words[w + 0];
-		reduction = reduction * FNV_PRIME ^ mix->words[w + 1];
-		reduction = reduction * FNV_PRIME ^ mix->words[w + 2];
-		reduction = reduction * FNV_PRIME ^ mix->words[w + 3];
-		mix->words[w / 4] = reduction;
+	ethash_hash_finish(ret, s_mix);
+	return true;
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ETHASH_LANES_AVX2 1
+#define ETHASH_ALWAYS_INLINE inline __attribute__((always_inline))
+#define ETHASH_PREFETCH(p) __builtin_prefetch((p))
+typedef uint32_t ethash_v8u32 __attribute__((vector_size(32)));
+#else
+#define ETHASH_ALWAYS_INLINE inline
+#define ETHASH_PREFETCH(p) ((void)(p))
+#endif
+
+/// Mixes one DAG page (MIX_NODES nodes) into a mix
+static ETHASH_ALWAYS_INLINE void ethash_mix_page(node* mix, node const* page)
+{
+#if ETHASH_LANES_AVX2
+	for (unsigned v = 0; v != MIX_WORDS / 8; ++v) {
+		ethash_v8u32 m;
+		ethash_v8u32 d;
+		memcpy(&m, mix->words + v * 8, sizeof(m));
+		memcpy(&d, page->words + v * 8, sizeof(d));
+		m = (m * FNV_PRIME) ^ d;
+		memcpy(mix->words + v * 8, &m, sizeof(m));
+	}
+#else
+	for (unsigned w = 0; w != MIX_WORDS; ++w) {
+		mix->words[w] = fnv_hash(mix->words[w], page->words[w]);
 	}
+#endif
+}
 
-	fix_endian_arr32(mix->words, MIX_WORDS / 4);
-	memcpy(&ret->mix_hash, mix->bytes, 32);
-	// final Keccak hash
-	SHA3_256(&ret->result, s_mix->bytes, 64 + 32); // Keccak-256(s + compressed_mix)
+/// The access loop of ethash_hash over count lanes at once: each round, the pages needed by all lanes are
+/// prefetched before any is mixed, so their fetches overlap.
+static ETHASH_ALWAYS_INLINE void ethash_hash_lanes_loop(
+	node s_mix[][MIX_NODES + 1],
+	node const* full_nodes,
+	unsigned num_full_pages,
+	unsigned count
+)
+{
+	for (unsigned i = 0; i != ETHASH_ACCESSES; ++i) {
+		node const* pages[ETHASH_LANES];
+		for (unsigned l = 0; l != count; ++l) {
+			uint32_t const index = fnv_hash(s_mix[l][0].words[0] ^ i, s_mix[l][1].words[i % MIX_WORDS]) % num_full_pages;
+			pages[l] = &full_nodes[MIX_NODES * index];
+			ETHASH_PREFETCH(pages[l]);
+			ETHASH_PREFETCH(pages[l] + 1);
+		}
+		for (unsigned l = 0; l != count; ++l) {
+			ethash_mix_page(&s_mix[l][1], pages[l]);
+		}
+	}
+}
+
+static void ethash_hash_lanes_generic(node s_mix[][MIX_NODES + 1], node const* full_nodes, unsigned num_full_pages, unsigned count)
+{
+	ethash_hash_lanes_loop(s_mix, full_nodes, num_full_pages, count);
+}
+
+#if ETHASH_LANES_AVX2
+__attribute__((target("avx2")))
+static void ethash_hash_lanes_avx2(node s_mix[][MIX_NODES + 1], node const* full_nodes, unsigned num_full_pages, unsigned count)
+{
+	ethash_hash_lanes_loop(s_mix, full_nodes, num_full_pages, count);
+}
+
+static bool ethash_have_avx2(void)
+{
+	static int have = -1;
+	if (have < 0) {
+		__builtin_cpu_init();
+		have = __builtin_cpu_supports("avx2") ? 1 : 0;
+	}
+	return have;
+}
+#endif
+
+bool ethash_full_compute_lanes(
+	ethash_full_t full,
+	ethash_h256_t const header_hash,
+	uint64_t const* nonces,
+	unsigned count,
+	ethash_return_value_t* ret
+)
+{
+	if (count > ETHASH_LANES || full->file_size % MIX_WORDS != 0) {
+		return false;
+	}
+	node s_mix[ETHASH_LANES][MIX_NODES + 1];
+	for (unsigned l = 0; l != count; ++l) {
+		ethash_hash_seed(s_mix[l], &header_hash, nonces[l]);
+	}
+
+	unsigned const num_full_pages = (unsigned) (full->file_size / (sizeof(uint32_t) * MIX_WORDS));
+#if ETHASH_LANES_AVX2
+	if (ethash_have_avx2()) {
+		ethash_hash_lanes_avx2(s_mix, full->data, num_full_pages, count);
+	} else
+#endif
+	{
+		ethash_hash_lanes_generic(s_mix, full->data, num_full_pages, count);
+	}
+
+	for (unsigned l = 0; l != count; ++l) {
+		ret[l].success = true;
+		ethash_hash_finish(&ret[l], s_mix[l]);
+	}
 	return true;
 }
 
@@ -344,7 +547,7 @@ ethash_return_value_t ethash_light_compute_internal(
 {
   	ethash_return_value_t ret;
 	ret.success = true;
-	if (!ethash_hash(&ret, NULL, light, full_size, header_hash, nonce)) {
+	if (!ethash_hash(&ret, NULL, light, NULL, NULL, full_size, header_hash, nonce)) {
 		ret.success = false;
 	}
 	return ret;
@@ -360,6 +563,23 @@ ethash_return_value_t ethash_light_compute(
 	return ethash_light_compute_internal(light, full_size, header_hash, nonce);
 }
 
+ethash_return_value_t ethash_light_compute_with(
+	ethash_light_t light,
+	ethash_h256_t const header_hash,
+	uint64_t nonce,
+	ethash_item_source_t source,
+	void* user
+)
+{
+	ethash_return_value_t ret;
+	ret.success = true;
+	uint64_t full_size = ethash_get_datasize(light->block_number);
+	if (!ethash_hash(&ret, NULL, light, source, user, full_size, header_hash, nonce)) {
+		ret.success = false;
+	}
+	return ret;
+}
+
 static bool ethash_mmap(struct ethash_full* ret, FILE* f)
 {
 	int fd;
@@ -388,7 +608,9 @@ ethash_full_t ethash_full_new_internal(
 	ethash_h256_t const seed_hash,
 	uint64_t full_size,
 	ethash_light_t const light,
-	ethash_callback_t callback
+	ethash_callback_t callback,
+	ethash_generator_t generator,
+	void* user
 )
 {
 	struct ethash_full* ret;
@@ -413,13 +635,15 @@ ethash_full_t ethash_full_new_internal(
 		}
 		// fallthrough to the mismatch case here, DO NOT go through match
 	case ETHASH_IO_MEMO_MISMATCH:
+	case ETHASH_IO_MEMO_PARTIAL:
 		if (!ethash_mmap(ret, f)) {
 			goto fail_close_file;
 		}
 		break;
 	}
 
-	if (!ethash_compute_full_data(ret->data, full_size, light, callback)) {
+	uint64_t* header = (uint64_t*)((char*)ret->data - ETHASH_DAG_MAGIC_NUM_SIZE);
+	if (!ethash_compute_full_data_chunked(header, ret->data, full_size, light, callback, generator, user)) {
 		goto fail_free_full_data;
 	}
 
@@ -436,7 +660,7 @@ ethash_full_t ethash_full_new_internal(
 
 fail_free_full_data:
 	// could check that munmap(..) == 0 but even if it did not can't really do anything here
-	munmap(ret->data, (size_t)full_size);
+	munmap((char*)ret->data - ETHASH_DAG_MAGIC_NUM_SIZE, (size_t)full_size + ETHASH_DAG_MAGIC_NUM_SIZE);
 fail_close_file:
 	fclose(ret->file);
 fail_free_full:
@@ -445,6 +669,16 @@ fail_free_full:
 }
 
 ethash_full_t ethash_full_new(ethash_light_t light, ethash_callback_t callback)
+{
+	return ethash_full_new_chunked(light, callback, NULL, NULL);
+}
+
+ethash_full_t ethash_full_new_chunked(
+	ethash_light_t light,
+	ethash_callback_t callback,
+	ethash_generator_t generator,
+	void* user
+)
 {
 	char strbuf[256];
 	if (!ethash_get_default_dirname(strbuf, 256)) {
@@ -452,13 +686,110 @@ ethash_full_t ethash_full_new(ethash_light_t light, ethash_callback_t callback)
 	}
 	uint64_t full_size = ethash_get_datasize(light->block_number);
 	ethash_h256_t seedhash = ethash_get_seedhash(light->block_number);
-	return ethash_full_new_internal(strbuf, seedhash, full_size, light, callback);
+	return ethash_full_new_internal(strbuf, seedhash, full_size, light, callback, generator, user);
+}
+
+#if defined(__linux__)
+/// Maps @a size bytes of anonymous memory in huge pages: explicit ones if the administrator has reserved
+/// enough, otherwise transparent ones. Sets @a o_mapped to the size to unmap later.
+static void* ethash_alloc_huge(size_t size, size_t* o_mapped)
+{
+	size_t const huge_page = 2 * 1024 * 1024;
+	size = (size + huge_page - 1) / huge_page * huge_page;
+	*o_mapped = size;
+#if defined(MAP_HUGETLB)
+	void* huge = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (huge != MAP_FAILED) {
+		return huge;
+	}
+#endif
+	// transparent huge pages need 2MB-aligned memory to be of use
+	char* p = mmap(NULL, size + huge_page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED) {
+		return NULL;
+	}
+	char* aligned = (char*)(((uintptr_t)p + huge_page - 1) / huge_page * huge_page);
+	if (aligned != p) {
+		munmap(p, (size_t)(aligned - p));
+	}
+	if (aligned + size != p + size + huge_page) {
+		munmap(aligned + size, (size_t)(p + huge_page - aligned));
+	}
+#if defined(MADV_HUGEPAGE)
+	madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+	return aligned;
+}
+#endif
+
+bool ethash_full_use_hugepages(ethash_full_t full)
+{
+#if defined(__linux__)
+	if (full->huge) {
+		return true;
+	}
+	size_t mapped;
+	void* huge = ethash_alloc_huge((size_t)full->file_size, &mapped);
+	if (!huge) {
+		return false;
+	}
+	memcpy(huge, full->data, (size_t)full->file_size);
+	// the file mapping is no longer needed; the file itself stays open as with any other DAG
+	munmap((char*)full->data - ETHASH_DAG_MAGIC_NUM_SIZE, (size_t)full->file_size + ETHASH_DAG_MAGIC_NUM_SIZE);
+	full->data = huge;
+	full->huge = huge;
+	full->huge_size = mapped;
+	return true;
+#else
+	(void)full;
+	return false;
+#endif
+}
+
+ethash_full_t ethash_full_replicate(ethash_full_t full, bool hugepages)
+{
+#if defined(__linux__)
+	struct ethash_full* ret = calloc(sizeof(*ret), 1);
+	if (!ret) {
+		return NULL;
+	}
+	if (hugepages) {
+		ret->huge = ethash_alloc_huge((size_t)full->file_size, &ret->huge_size);
+	} else {
+		ret->huge_size = (size_t)full->file_size;
+		ret->huge = mmap(NULL, ret->huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (ret->huge == MAP_FAILED) {
+			ret->huge = NULL;
+		}
+	}
+	if (!ret->huge) {
+		free(ret);
+		return NULL;
+	}
+	// the copy is the first touch of these pages, so the kernel places them on the calling thread's node
+	memcpy(ret->huge, full->data, (size_t)full->file_size);
+	ret->data = ret->huge;
+	ret->file_size = full->file_size;
+	return ret;
+#else
+	(void)full;
+	(void)hugepages;
+	return NULL;
+#endif
 }
 
 void ethash_full_delete(ethash_full_t full)
 {
+	if (full->huge) {
+		munmap(full->huge, full->huge_size);
+		if (full->file) {
+			fclose(full->file);
+		}
+		free(full);
+		return;
+	}
 	// could check that munmap(..) == 0 but even if it did not can't really do anything here
-	munmap(full->data, (size_t)full->file_size);
+	munmap((char*)full->data - ETHASH_DAG_MAGIC_NUM_SIZE, (size_t)full->file_size + ETHASH_DAG_MAGIC_NUM_SIZE);
 	if (full->file) {
 		fclose(full->file);
 	}
@@ -477,6 +808,8 @@ ethash_return_value_t ethash_full_compute(
 		&ret,
 		(node const*)full->data,
 		NULL,
+		NULL,
+		NULL,
 		full->file_size,
 		header_hash,
 		nonce)) {
@@ -106,6 +106,8 @@ struct ethash_full {
 	FILE* file;
 	uint64_t file_size;
 	node* data;
+	void* huge;          // anonymous copy of the DAG (in huge pages, if asked for), if made; data then points into it
+	size_t huge_size;
 };
 
 /**
@@ -122,6 +124,8 @@ struct ethash_full {
  *                       It accepts an unsigned with which a progress of DAG calculation
  *                       can be displayed. If all goes well the callback should return 0.
  *                       If a non-zero value is returned then DAG generation will stop.
+ * @param generator      Computes each chunk of the DAG. Check @ref ethash_full_new_chunked() for details.
+ * @param user           Passed through to @a generator.
  * @return               Newly allocated ethash_full handler or NULL in case of
  *                       ERRNOMEM or invalid parameters used for @ref ethash_compute_full_data()
  */
@@ -130,7 +134,9 @@ ethash_full_t ethash_full_new_internal(
 	ethash_h256_t const seed_hash,
 	uint64_t full_size,
 	ethash_light_t const light,
-	ethash_callback_t callback
+	ethash_callback_t callback,
+	ethash_generator_t generator,
+	void* user
 );
 
 void ethash_calculate_dag_item(
@@ -152,7 +158,8 @@ uint64_t ethash_get_cachesize(uint64_t const block_number);
 /**
  * Compute the memory data for a full node's memory
  *
- * @param mem         A pointer to an ethash full's memory
+ * @param mem         A pointer to an ethash full's memory, mapped from its file; each chunk is
+ *                    synced to the file before its checkpoint is written
  * @param full_size   The size of the full data in bytes
  * @param cache       A cache object to use in the calculation
  * @param callback    The callback function. Check @ref ethash_full_new() for details.
@@ -165,6 +172,29 @@ bool ethash_compute_full_data(
 	ethash_callback_t callback
 );
 
+/**
+ * Compute the memory data for a full node's memory in chunks, resuming an interrupted generation
+ *
+ * @param magic_num   The DAG file's magic number slot. It is read to see whether a previous
+ *                    generation got part way, and updated with progress after each chunk.
+ * @param mem         A pointer to an ethash full's memory
+ * @param full_size   The size of the full data in bytes
+ * @param light       A cache object to use in the calculation
+ * @param callback    The callback function. Check @ref ethash_full_new() for details.
+ * @param generator   Computes each chunk, or NULL to compute them on the calling thread.
+ * @param user        Passed through to @a generator.
+ * @return            true if all went fine and false for invalid parameters or an abort
+ */
+bool ethash_compute_full_data_chunked(
+	uint64_t* magic_num,
+	void* mem,
+	uint64_t full_size,
+	ethash_light_t const light,
+	ethash_callback_t callback,
+	ethash_generator_t generator,
+	void* user
+);
+
 #ifdef __cplusplus
 }
 #endif
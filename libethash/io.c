@@ -67,6 +67,10 @@ enum ethash_io_rc ethash_io_prepare(
 				ret = ETHASH_IO_MEMO_SIZE_MISMATCH;
 				goto free_memo;
 			}
+			if ((magic_num & ETHASH_DAG_PARTIAL_MAGIC_MASK) == ETHASH_DAG_PARTIAL_MAGIC_NUM) {
+				ret = ETHASH_IO_MEMO_PARTIAL;
+				goto set_file;
+			}
 			if (magic_num != ETHASH_DAG_MAGIC_NUM) {
 				fclose(f);
 				ret = ETHASH_IO_MEMO_SIZE_MISMATCH;
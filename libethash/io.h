@@ -46,6 +46,7 @@ enum ethash_io_rc {
 	ETHASH_IO_MEMO_SIZE_MISMATCH, ///< DAG with revision/hash match, but file size was wrong.
 	ETHASH_IO_MEMO_MISMATCH,      ///< The DAG file did not exist or there was revision/hash mismatch
 	ETHASH_IO_MEMO_MATCH,         ///< DAG file existed and revision/hash matched. No need to do anything
+	ETHASH_IO_MEMO_PARTIAL,       ///< DAG file of the right size exists but its generation was interrupted
 };
 
 // small hack for windows. I don't feel I should use va_args and forward just
@@ -92,7 +92,9 @@ enum class ImportResult
 	AlreadyInChain,
 	AlreadyKnown,
 	Malformed,
-	BadChain
+	BadChain,
+	Underpriced,	///< Paid no more than whatever it would have displaced.
+	Overloaded		///< Turned away unexamined as too much already awaits examination.
 };
 
 struct ImportRequirements
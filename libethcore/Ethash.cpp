@@ -33,6 +33,8 @@
 #include <libdevcore/Log.h>
 #include <libdevcore/Common.h>
 #include <libdevcore/CommonIO.h>
+#include <libdevcore/Numa.h>
+#include <libdevcore/ThreadPool.h>
 #include <libdevcrypto/CryptoPP.h>
 #include <libdevcrypto/FileSystem.h>
 #include <libethash/ethash.h>
@@ -122,7 +124,52 @@ bool Ethash::verify(BlockInfo const& _header)
 	return slow;
 }
 
+vector<bool> Ethash::verify(vector<BlockInfo> const& _headers)
+{
+	static ThreadPool s_pool(max(1u, std::thread::hardware_concurrency()), "pow");
+
+	// Taking the headers epoch by epoch means only one light cache is needed at a time, and lets the
+	// headers of an epoch reuse one another's DAG items.
+	vector<size_t> order(_headers.size());
+	for (size_t i = 0; i < order.size(); ++i)
+		order[i] = i;
+	stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return _headers[a].number / ETHASH_EPOCH_LENGTH < _headers[b].number / ETHASH_EPOCH_LENGTH; });
+
+	vector<char> valid(_headers.size(), false);	// Not vector<bool>, as the threads write to it concurrently.
+	for (size_t begin = 0; begin < order.size();)
+	{
+		u256 epoch = _headers[order[begin]].number / ETHASH_EPOCH_LENGTH;
+		size_t end = begin;
+		vector<ThreadPool::Task> tasks;
+		for (; end < order.size() && _headers[order[end]].number / ETHASH_EPOCH_LENGTH == epoch; ++end)
+			if (preVerify(_headers[order[end]]))
+			{
+				size_t i = order[end];
+				tasks.push_back([&, i]()
+				{
+					try
+					{
+						valid[i] = verify(_headers[i]);
+					}
+					catch (...) {}
+				});
+			}
+		if (tasks.size() > 1)
+		{
+			// Make the light cache up front rather than having every task wait on the one making it.
+			EthashAux::light((uint64_t)epoch * ETHASH_EPOCH_LENGTH);
+			s_pool.run(tasks);
+		}
+		else if (tasks.size())
+			tasks[0]();
+		begin = end;
+	}
+	return vector<bool>(valid.begin(), valid.end());
+}
+
 unsigned Ethash::CPUMiner::s_numInstances = 0;
+std::atomic<Ethash::CPUMiner::Kernel> Ethash::CPUMiner::s_kernel{Ethash::CPUMiner::Kernel::Interleaved};
+std::atomic<bool> Ethash::CPUMiner::s_numa{true};
 
 void Ethash::CPUMiner::workLoop()
 {
@@ -134,8 +181,46 @@ void Ethash::CPUMiner::workLoop()
 
 	WorkPackage w = work();
 
-	auto dag = EthashAux::full(EthashAux::number(w.seedHash));
+	// Miner i goes to node i % nodes, taking that node's CPUs in turn.
+	auto const& nodes = numaNodes();
+	int node = -1;
+	if (s_numa && nodes.size() > 1)
+	{
+		NumaNode const& n = nodes[index() % nodes.size()];
+		if (pinThisThread(n.cpus[index() / nodes.size() % n.cpus.size()]))
+			node = n.id;
+	}
+	setNumaNode(node);
+
+	auto dag = node >= 0 ? EthashAux::nodeFull(EthashAux::number(w.seedHash), node) : EthashAux::full(EthashAux::number(w.seedHash));
 	h256 boundary = w.boundary;
+
+	if (s_kernel == Kernel::Interleaved)
+	{
+		unsigned hashCount = 0;
+		for (; !shouldStop(); tryNonce += ETHASH_LANES)
+		{
+			uint64_t nonces[ETHASH_LANES];
+			ethash_return_value results[ETHASH_LANES];
+			for (unsigned l = 0; l < ETHASH_LANES; ++l)
+				nonces[l] = tryNonce + l;
+			ethash_full_compute_lanes(dag->full, *(ethash_h256_t*)w.headerHash.data(), nonces, ETHASH_LANES, results);
+			for (unsigned l = 0; l < ETHASH_LANES; ++l)
+				if (h256((uint8_t*)&results[l].result, h256::ConstructFromPointer) <= boundary && submitProof(Solution{(Nonce)(u64)nonces[l], h256((uint8_t*)&results[l].mix_hash, h256::ConstructFromPointer)}))
+				{
+					accumulateHashes(hashCount + ETHASH_LANES);
+					return;
+				}
+			if ((hashCount += ETHASH_LANES) >= 1000)
+			{
+				accumulateHashes(hashCount);
+				hashCount = 0;
+			}
+		}
+		accumulateHashes(hashCount);
+		return;
+	}
+
 	unsigned hashCount = 1;
 	for (; !shouldStop(); tryNonce++, hashCount++)
 	{
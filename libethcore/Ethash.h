@@ -23,6 +23,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <thread>
 #include <cstdint>
@@ -75,6 +76,9 @@ public:
 	static unsigned revision();
 	static void prep(BlockInfo const& _header, std::function<int(unsigned)> const& _f = std::function<int(unsigned)>());
 	static bool verify(BlockInfo const& _header);
+	/// Verifies many headers at once, in parallel, evaluating those of each epoch together so they share its light
+	/// cache and computed DAG items. @returns whether each of @a _headers is valid, in the same order.
+	static std::vector<bool> verify(std::vector<BlockInfo> const& _headers);
 	static bool preVerify(BlockInfo const& _header);
 	static WorkPackage package(BlockInfo const& _header);
 	static void assignResult(Solution const& _r, BlockInfo& _header) { _header.nonce = _r.nonce; _header.mixHash = _r.mixHash; }
@@ -83,6 +87,13 @@ public:
 	class CPUMiner: public Miner, Worker
 	{
 	public:
+		/// How each thread searches: one nonce at a time, or several with their DAG reads interleaved.
+		enum class Kernel
+		{
+			Single,
+			Interleaved
+		};
+
 		CPUMiner(ConstructionInfo const& _ci): Miner(_ci), Worker("miner" + toString(index())) {}
 
 		static unsigned instances() { return s_numInstances > 0 ? s_numInstances : std::thread::hardware_concurrency(); }
@@ -90,6 +101,13 @@ public:
 		static void setDefaultPlatform(unsigned) {}
 		static void setDefaultDevice(unsigned) {}
 		static void setNumInstances(unsigned _instances) { s_numInstances = std::min<unsigned>(_instances, std::thread::hardware_concurrency()); }
+		/// Sets the kernel used by miners started from now on. Defaults to Kernel::Interleaved.
+		static void setKernel(Kernel _k) { s_kernel = _k; }
+		static Kernel kernel() { return s_kernel; }
+		static std::string kernelName(Kernel _k) { return _k == Kernel::Single ? "single" : "interleaved"; }
+		/// Sets whether, on machines with several NUMA nodes, miners started from now on are each pinned to a CPU
+		/// (spread evenly over the nodes) and mine on their node's own copy of the DAG. Defaults to true.
+		static void setNuma(bool _on) { s_numa = _on; }
 	protected:
 		void kickOff() override
 		{
@@ -102,6 +120,8 @@ public:
 	private:
 		void workLoop() override;
 		static unsigned s_numInstances;
+		static std::atomic<Kernel> s_kernel;
+		static std::atomic<bool> s_numa;
 	};
 
 #if ETH_ETHASHCL || !ETH_TRUE
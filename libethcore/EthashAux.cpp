@@ -30,6 +30,8 @@
 #include <libdevcore/Common.h>
 #include <libdevcore/Guards.h>
 #include <libdevcore/Log.h>
+#include <libdevcore/Numa.h>
+#include <libdevcore/ThreadPool.h>
 #include <libdevcrypto/CryptoPP.h>
 #include <libdevcrypto/SHA3.h>
 #include <libdevcrypto/FileSystem.h>
@@ -45,8 +47,17 @@ const char* DAGChannel::name() { return EthGreen "DAG"; }
 
 EthashAux* dev::eth::EthashAux::s_this = nullptr;
 
+EthashAux::EthashAux():
+	m_items(c_defaultItemCacheBudget, [](h512 const&) { return (size_t)h512::size; })
+{
+}
+
 EthashAux::~EthashAux()
 {
+	// Generation is checkpointed, so the pre-generator can stop part way and pick up where it left off next time.
+	m_stopping = true;
+	if (m_pregenerator && m_pregenerator->joinable())
+		m_pregenerator->join();
 }
 
 uint64_t EthashAux::cacheSize(BlockInfo const& _header)
@@ -103,6 +114,43 @@ void EthashAux::killCache(h256 const& _s)
 {
 	RecursiveGuard l(x_lights);
 	m_lights.erase(_s);
+	m_lightsUsed.erase(_s);
+}
+
+void EthashAux::setLightBudget(size_t _bytes)
+{
+	RecursiveGuard l(get()->x_lights);
+	get()->m_lightBudget = _bytes;
+	h256 newest;
+	uint64_t newestUsed = 0;
+	for (auto const& i: get()->m_lightsUsed)
+		if (i.second >= newestUsed)
+			tie(newest, newestUsed) = i;
+	get()->evictLights(newest);
+}
+
+void EthashAux::evictLights(h256 const& _keep)
+{
+	size_t total = 0;
+	for (auto const& i: m_lights)
+		total += i.second->size;
+	while (total > m_lightBudget && m_lights.size() > 1)
+	{
+		auto victim = m_lightsUsed.end();
+		for (auto it = m_lightsUsed.begin(); it != m_lightsUsed.end(); ++it)
+			if (it->first != _keep && (victim == m_lightsUsed.end() || it->second < victim->second))
+				victim = it;
+		if (victim == m_lightsUsed.end())
+			break;
+		// Anyone still holding the LightType keeps it alive; we just stop caching it.
+		auto light = m_lights.find(victim->first);
+		if (light != m_lights.end())
+		{
+			total -= light->second->size;
+			m_lights.erase(light);
+		}
+		m_lightsUsed.erase(victim);
+	}
 }
 
 EthashAux::LightType EthashAux::light(BlockInfo const& _header)
@@ -114,8 +162,15 @@ EthashAux::LightType EthashAux::light(uint64_t _blockNumber)
 {
 	RecursiveGuard l(get()->x_lights);
 	h256 seedHash = EthashAux::seedHash(_blockNumber);
-	LightType ret = get()->m_lights[seedHash];
-	return ret ? ret : (get()->m_lights[seedHash] = make_shared<LightAllocation>(_blockNumber));
+	auto it = get()->m_lights.find(seedHash);
+	LightType ret = it != get()->m_lights.end() ? it->second : make_shared<LightAllocation>(_blockNumber);
+	get()->m_lightsUsed[seedHash] = ++get()->m_lightTick;
+	if (it == get()->m_lights.end())
+	{
+		get()->m_lights[seedHash] = ret;
+		get()->evictLights(seedHash);
+	}
+	return ret;
 }
 
 EthashAux::LightAllocation::LightAllocation(uint64_t _blockNumber)
@@ -134,14 +189,73 @@ bytesConstRef EthashAux::LightAllocation::data() const
 	return bytesConstRef((byte const*)light->cache, size);
 }
 
-EthashAux::FullAllocation::FullAllocation(ethash_light_t _light, ethash_callback_t _cb)
+namespace
+{
+
+/// What a light evaluation needs to look DAG items up in, and add them to, EthashAux's item cache.
+struct ItemSource
+{
+	ShardedLruCache<uint64_t, h512>& cache;
+	uint64_t epoch;
+};
+
+/// Called by libethash for each DAG item a light evaluation needs; computes it only if it's not cached already.
+void cachedDAGItem(void* _user, uint32_t _index, ethash_light_t _light, void* o_item)
+{
+	ItemSource& s = *static_cast<ItemSource*>(_user);
+	uint64_t key = (s.epoch << 32) | _index;
+	h512 item;
+	if (!s.cache.get(key, item))
+	{
+		ethash_calculate_dag_item((node*)item.data(), _index, _light);
+		s.cache.insert(key, item);
+	}
+	memcpy(o_item, item.data(), h512::size);
+}
+
+struct DAGGeneration
+{
+	DAGGeneration(unsigned _threads, std::function<int(unsigned)> const& _progress, uint32_t _items): pool(_threads, "dag"), progress(_progress), items(_items) {}
+
+	ThreadPool pool;
+	std::function<int(unsigned)> progress;
+	uint32_t items;
+};
+
+/// Called by libethash for each chunk of a DAG; splits it evenly over the threads of the DAGGeneration in @a _user.
+bool generateDAGChunk(void* _user, void* _data, uint32_t _begin, uint32_t _end, ethash_light_t _light)
 {
-	full = ethash_full_new(_light, _cb);
+	DAGGeneration& g = *static_cast<DAGGeneration*>(_user);
+	unsigned percent = (uint64_t)_begin * 100 / g.items;
+	clog(DAGChannel) << "Generating DAG file. Progress: " << toString(percent) << "%";
+	if (g.progress && g.progress(percent))
+		return false;
+
+	vector<ThreadPool::Task> tasks;
+	uint32_t step = (_end - _begin + g.pool.size() - 1) / g.pool.size();
+	for (uint32_t b = _begin; b < _end; b += step)
+	{
+		uint32_t e = min(_end, b + step);
+		tasks.push_back([=]() { ethash_compute_full_range(_data, b, e, _light); });
+	}
+	g.pool.run(tasks);
+	return true;
+}
+
+}
+
+EthashAux::FullAllocation::FullAllocation(ethash_light_t _light, std::function<int(unsigned)> const& _progress, unsigned _threads, bool _hugePages)
+{
+	DAGGeneration g(_threads, _progress, uint32_t(ethash_get_datasize(_light->block_number) / ETHASH_HASH_BYTES));
+	full = ethash_full_new_chunked(_light, nullptr, generateDAGChunk, &g);
+	if (full && _hugePages && !ethash_full_use_hugepages(full))
+		clog(DAGChannel) << "Couldn't move the DAG into huge pages; using the file mapping.";
 }
 
 EthashAux::FullAllocation::~FullAllocation()
 {
-	ethash_full_delete(full);
+	if (full)
+		ethash_full_delete(full);
 }
 
 bytesConstRef EthashAux::FullAllocation::data() const
@@ -149,36 +263,116 @@ bytesConstRef EthashAux::FullAllocation::data() const
 	return bytesConstRef((byte const*)ethash_full_dag(full), size());
 }
 
-static std::function<int(unsigned)> s_dagCallback;
-static int dagCallbackShim(unsigned _p)
+EthashAux::FullType EthashAux::full(uint64_t _blockNumber, function<int(unsigned)> const& _f)
 {
-	clog(DAGChannel) << "Generating DAG file. Progress: " << toString(_p) << "%";
-	return s_dagCallback ? s_dagCallback(_p) : 0;
+	FullType ret = get()->loadFull(_blockNumber, _f, get()->m_generationThreads);
+	DEV_GUARDED(get()->x_fulls)
+		get()->m_lastUsedFull = ret;
+	get()->pregenerateAfter(_blockNumber);
+	return ret;
 }
 
-EthashAux::FullType EthashAux::full(uint64_t _blockNumber, function<int(unsigned)> const& _f)
+EthashAux::FullType EthashAux::loadFull(uint64_t _blockNumber, function<int(unsigned)> const& _f, unsigned _threads, bool _hugePages)
 {
 	auto l = light(_blockNumber);
 	h256 seedHash = EthashAux::seedHash(_blockNumber);
 	FullType ret;
-
-	DEV_GUARDED(get()->x_fulls)
-		if ((ret = get()->m_fulls[seedHash].lock()))
-		{
-			get()->m_lastUsedFull = ret;
+	{
+		unique_lock<Mutex> lock(x_fulls);
+		m_fullsChanged.wait(lock, [&]() { return !m_generatingFulls.count(seedHash); });
+		if ((ret = m_fulls[seedHash].lock()))
 			return ret;
-		}
+		m_generatingFulls.insert(seedHash);
+	}
 
-	s_dagCallback = _f;
 	cnote << "Loading from libethash...";
-	ret = make_shared<FullAllocation>(l->light, dagCallbackShim);
+	try
+	{
+		// With several NUMA nodes the miners each get a huge-page copy on their own node from nodeFull(), so this
+		// one stays in the file mapping, whose clean pages the kernel may drop, rather than being one more copy.
+		ret = make_shared<FullAllocation>(l->light, _f, _threads, _hugePages && m_hugePages && numaNodes().size() < 2);
+	}
+	catch (...)
+	{
+		DEV_GUARDED(x_fulls)
+			m_generatingFulls.erase(seedHash);
+		m_fullsChanged.notify_all();
+		throw;
+	}
 	cnote << "Done loading.";
 
-	DEV_GUARDED(get()->x_fulls)
-		get()->m_fulls[seedHash] = get()->m_lastUsedFull = ret;
+	DEV_GUARDED(x_fulls)
+	{
+		m_fulls[seedHash] = ret;
+		m_generatingFulls.erase(seedHash);
+	}
+	m_fullsChanged.notify_all();
+	return ret;
+}
+
+EthashAux::FullType EthashAux::nodeFull(uint64_t _blockNumber, unsigned _node)
+{
+	FullType master = full(_blockNumber);
+	if (numaNodes().size() < 2)
+		return master;
+
+	EthashAux* a = get();
+	h256 seedHash = EthashAux::seedHash(_blockNumber);
+	{
+		unique_lock<Mutex> lock(a->x_fulls);
+		a->m_fullsChanged.wait(lock, [&]() { return !a->m_replicating.count(_node); });
+		auto it = a->m_nodeFulls.find(_node);
+		if (it != a->m_nodeFulls.end() && it->second.first == seedHash)
+			return it->second.second;
+		a->m_replicating.insert(_node);
+	}
+
+	FullType ret = master;
+	if (ethash_full_t copy = ethash_full_replicate(master->full, a->m_hugePages))
+	{
+		ret = make_shared<FullAllocation>(copy);
+		clog(DAGChannel) << "Copied DAG to NUMA node" << _node;
+	}
+	else
+		clog(DAGChannel) << "Couldn't copy DAG to NUMA node" << _node << "; sharing the one DAG.";
+
+	DEV_GUARDED(a->x_fulls)
+	{
+		// Replacing the previous epoch's copy frees it once the miners using it have moved on.
+		a->m_nodeFulls[_node] = make_pair(seedHash, ret);
+		a->m_replicating.erase(_node);
+	}
+	a->m_fullsChanged.notify_all();
 	return ret;
 }
 
+void EthashAux::pregenerateAfter(uint64_t _blockNumber)
+{
+	uint64_t next = (_blockNumber / ETHASH_EPOCH_LENGTH + 1) * ETHASH_EPOCH_LENGTH;
+	if (next - _blockNumber > c_pregenerationLead || next >= ETHASH_EPOCH_LENGTH * 2048)
+		return;
+
+	Guard l(x_fulls);
+	if (m_pregenerating || m_pregeneratedNumber == next)
+		return;
+	if (m_pregenerator)
+		m_pregenerator->join();
+	m_pregenerating = true;
+	m_pregeneratedNumber = next;
+	m_pregenerator.reset(new thread([=]()
+	{
+		setThreadName("dagpre");
+		cnote << "Pre-generating DAG for epoch beginning #" << next;
+		// One thread, to leave the cores to mining; all that's wanted is the file, so the allocation is dropped at once.
+		if (loadFull(next, [this](unsigned) { return m_stopping ? 1 : 0; }, 1, false)->full)
+			cnote << "DAG for epoch beginning #" << next << "is ready";
+		else
+			cnote << "Pre-generation of DAG for epoch beginning #" << next << "stopped; it will resume from where it got to.";
+		DEV_GUARDED(x_fulls)
+			m_pregenerating = false;
+	}));
+}
+
 unsigned EthashAux::computeFull(uint64_t _blockNumber)
 {
 	Guard l(get()->x_fulls);
@@ -215,7 +409,8 @@ Ethash::Result EthashAux::FullAllocation::compute(h256 const& _headerHash, Nonce
 
 Ethash::Result EthashAux::LightAllocation::compute(h256 const& _headerHash, Nonce const& _nonce) const
 {
-	ethash_return_value r = ethash_light_compute(light, *(ethash_h256_t*)_headerHash.data(), (uint64_t)(u64)_nonce);
+	ItemSource source{EthashAux::get()->m_items, light->block_number / ETHASH_EPOCH_LENGTH};
+	ethash_return_value r = ethash_light_compute_with(light, *(ethash_h256_t*)_headerHash.data(), (uint64_t)(u64)_nonce, cachedDAGItem, &source);
 	if (!r.success)
 		BOOST_THROW_EXCEPTION(DAGCreationFailure());
 	return Ethash::Result{h256((uint8_t*)&r.result, h256::ConstructFromPointer), h256((uint8_t*)&r.mix_hash, h256::ConstructFromPointer)};
@@ -229,7 +424,14 @@ Ethash::Result EthashAux::eval(BlockInfo const& _header, Nonce const& _nonce)
 Ethash::Result EthashAux::eval(uint64_t _blockNumber, h256 const& _headerHash, Nonce const& _nonce)
 {
 	h256 seedHash = EthashAux::seedHash(_blockNumber);
-	if (FullType dag = get()->m_fulls[seedHash].lock())
+	FullType dag;
+	DEV_GUARDED(get()->x_fulls)
+	{
+		auto it = get()->m_fulls.find(seedHash);
+		if (it != get()->m_fulls.end())
+			dag = it->second.lock();
+	}
+	if (dag)
 		return dag->compute(_headerHash, _nonce);
 	return EthashAux::get()->light(_blockNumber)->compute(_headerHash, _nonce);
 }
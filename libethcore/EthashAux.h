@@ -19,9 +19,13 @@
  * @date 2014
  */
 
+#include <map>
+#include <set>
+#include <atomic>
 #include <condition_variable>
 #include <libethash/ethash.h>
 #include <libdevcore/Worker.h>
+#include <libdevcore/LruCache.h>
 #include "Ethash.h"
 
 namespace dev
@@ -50,7 +54,12 @@ public:
 
 	struct FullAllocation
 	{
-		FullAllocation(ethash_light_t _light, ethash_callback_t _cb);
+		/// Loads the DAG file, generating (or finishing generating) it first if need be with @a _threads threads.
+		/// @a _progress is given the percentage done every so often; returning non-zero from it abandons generation.
+		/// If @a _hugePages, the DAG is then moved into huge-page-backed memory where the platform allows.
+		FullAllocation(ethash_light_t _light, std::function<int(unsigned)> const& _progress, unsigned _threads, bool _hugePages);
+		/// Takes ownership of @a _full.
+		explicit FullAllocation(ethash_full_t _full): full(_full) {}
 		~FullAllocation();
 		Ethash::Result compute(h256 const& _headerHash, Nonce const& _nonce) const;
 		bytesConstRef data() const;
@@ -68,27 +77,75 @@ public:
 	static LightType light(BlockInfo const& _header);
 	static LightType light(uint64_t _blockNumber);
 
+	/// Sets how many bytes of light caches are kept around; the least recently used are dropped to stay within it,
+	/// though the one most recently asked for is always kept.
+	static void setLightBudget(size_t _bytes);
+	/// Sets how many bytes of DAG items computed by light evaluations are kept for reuse by later ones.
+	static void setItemCacheBudget(size_t _bytes) { get()->m_items.setBudget(_bytes); }
+	static CacheStats itemCacheStats() { return get()->m_items.stats(); }
+
+	static const size_t c_defaultLightBudget = 64 * 1024 * 1024;
+	static const size_t c_defaultItemCacheBudget = 64 * 1024 * 1024;
+
 	static const uint64_t NotGenerating = (uint64_t)-1;
 	/// Kicks off generation of DAG for @a _blocknumber and @returns false or @returns true if ready.
 	static unsigned computeFull(uint64_t _blockNumber);
 	/// Information on the generation progress.
 	static std::pair<uint64_t, unsigned> fullGeneratingProgress() { return std::make_pair(get()->m_generatingFullNumber, get()->m_fullProgress); }
 	/// Kicks off generation of DAG for @a _blocknumber and blocks until ready; @returns result.
+	/// Once @a _blockNumber is within c_pregenerationLead blocks of the next epoch, that epoch's DAG file is
+	/// generated in the background too.
 	static FullType full(uint64_t _blockNumber, std::function<int(unsigned)> const& _f = std::function<int(unsigned)>());
 
+	/// As full(), but @returns a copy of the DAG in the memory of NUMA node @a _node, making it if there isn't one
+	/// for this epoch yet. The copy is made by the calling thread, which must be pinned to a CPU of @a _node for the
+	/// memory to be placed there. On single-node machines, or if no copy can be made, @returns the shared DAG.
+	/// On machines with several nodes the shared DAG is left in its file mapping, so the copies are the only
+	/// anonymous huge-page DAGs.
+	static FullType nodeFull(uint64_t _blockNumber, unsigned _node);
+
+	/// Sets the number of threads used to generate a DAG in the foreground. Defaults to the number of cores.
+	static void setGenerationThreads(unsigned _threads) { get()->m_generationThreads = std::max(1u, _threads); }
+	static unsigned generationThreads() { return get()->m_generationThreads; }
+
+	/// Sets whether DAGs loaded from now on, and the per-node copies from nodeFull(), are kept in huge pages,
+	/// which makes mining's random reads of them cheaper on the TLB. Defaults to false: huge pages can't be
+	/// swapped and may be reserved for other uses, so the node operator must opt in.
+	static void setHugePages(bool _on) { get()->m_hugePages = _on; }
+
+	/// How many blocks ahead of an epoch change its DAG starts being generated.
+	static const unsigned c_pregenerationLead = ETHASH_EPOCH_LENGTH / 10;
+
 	static Ethash::Result eval(BlockInfo const& _header) { return eval(_header, _header.nonce); }
 	static Ethash::Result eval(BlockInfo const& _header, Nonce const& _nonce);
 	static Ethash::Result eval(uint64_t _blockNumber, h256 const& _headerHash, Nonce const& _nonce);
 
 private:
-	EthashAux() {}
+	EthashAux();
 
 	void killCache(h256 const& _s);
 
+	/// Drops least recently used light caches, other than that of @a _keep, until within m_lightBudget. Must hold x_lights.
+	void evictLights(h256 const& _keep);
+
+	/// Gets the DAG for @a _blockNumber, generating it with @a _threads threads if need be. Only one thread
+	/// generates any given DAG; others asking for it meanwhile wait and then share the result.
+	/// @a _hugePages is false when only the file is wanted, so there's no point copying the DAG into huge pages.
+	FullType loadFull(uint64_t _blockNumber, std::function<int(unsigned)> const& _f, unsigned _threads, bool _hugePages = true);
+
+	/// Starts generating the next epoch's DAG file in the background if @a _blockNumber is close enough to it.
+	void pregenerateAfter(uint64_t _blockNumber);
+
 	static EthashAux* s_this;
 
 	RecursiveMutex x_lights;
 	std::unordered_map<h256, std::shared_ptr<LightAllocation>> m_lights;
+	std::unordered_map<h256, uint64_t> m_lightsUsed;	///< When each of m_lights was last asked for, by m_lightTick.
+	uint64_t m_lightTick = 0;
+	size_t m_lightBudget = c_defaultLightBudget;
+
+	/// DAG items computed by light evaluations, keyed by epoch (upper 32 bits) and item index.
+	ShardedLruCache<uint64_t, h512> m_items;
 
 	Mutex x_fulls;
 	std::condition_variable m_fullsChanged;
@@ -97,6 +154,15 @@ private:
 	std::unique_ptr<std::thread> m_fullGenerator;
 	uint64_t m_generatingFullNumber = NotGenerating;
 	unsigned m_fullProgress;
+	h256Hash m_generatingFulls;						///< Seed hashes of DAGs being generated right now.
+	std::unique_ptr<std::thread> m_pregenerator;
+	uint64_t m_pregeneratedNumber = NotGenerating;	///< First block of the epoch last pre-generated.
+	bool m_pregenerating = false;
+	std::atomic<bool> m_stopping{false};			///< Set on destruction to abandon pre-generation.
+	std::atomic<unsigned> m_generationThreads{std::max(1u, std::thread::hardware_concurrency())};
+	std::atomic<bool> m_hugePages{false};
+	std::map<unsigned, std::pair<h256, FullType>> m_nodeFulls;	///< Each NUMA node's copy of the DAG, with its seed hash.
+	std::set<unsigned> m_replicating;								///< NUMA nodes whose copy is being made right now.
 
 	Mutex x_epochs;
 	std::unordered_map<h256, unsigned> m_epochs;
@@ -23,6 +23,7 @@
 
 #include <thread>
 #include <list>
+#include <map>
 #include <atomic>
 #include <boost/timer.hpp>
 #include <libdevcore/Common.h>
@@ -44,7 +45,9 @@ struct MiningProgress
 //	MiningProgress& operator+=(MiningProgress const& _mp) { hashes += _mp.hashes; ms = std::max(ms, _mp.ms); return *this; }
 	uint64_t hashes = 0;		///< Total number of hashes computed.
 	uint64_t ms = 0;			///< Total number of milliseconds of mining thus far.
+	std::map<unsigned, uint64_t> nodeHashes;	///< Hashes computed by miners pinned to each NUMA node; empty if none are.
 	uint64_t rate() const { return hashes * 1000 / ms; }
+	uint64_t nodeRate(unsigned _node) const { auto it = nodeHashes.find(_node); return it == nodeHashes.end() ? 0 : it->second * 1000 / ms; }
 };
 
 struct MineInfo: public MiningProgress {};
@@ -52,6 +55,9 @@ struct MineInfo: public MiningProgress {};
 inline std::ostream& operator<<(std::ostream& _out, MiningProgress _p)
 {
 	_out << _p.rate() << " H/s = " <<  _p.hashes << " hashes / " << (double(_p.ms) / 1000) << " s";
+	if (_p.nodeHashes.size() > 1)
+		for (auto const& n: _p.nodeHashes)
+			_out << "; node " << n.first << ": " << _p.nodeRate(n.first) << " H/s";
 	return _out;
 }
 
@@ -125,6 +131,9 @@ public:
 
 	unsigned index() const { return m_index; }
 
+	/// @returns the NUMA node this miner's thread is pinned to, or -1 if it isn't pinned.
+	int numaNode() const { return m_numaNode; }
+
 protected:
 
 	// REQUIRED TO BE REIMPLEMENTED BY A SUBCLASS:
@@ -164,9 +173,12 @@ protected:
 
 	void accumulateHashes(unsigned _n) { m_hashCount += _n; }
 
+	void setNumaNode(int _node) { m_numaNode = _node; }
+
 private:
 	FarmFace* m_farm = nullptr;
 	unsigned m_index;
+	std::atomic<int> m_numaNode{-1};
 
 	uint64_t m_hashCount = 0;
 
@@ -96,36 +96,24 @@ ldb::Slice dev::eth::toSlice(h256 const& _h, unsigned _sub)
 #endif
 }
 
-#if ETH_DEBUG
-static const chrono::system_clock::duration c_collectionDuration = chrono::seconds(15);
-static const unsigned c_collectionQueueSize = 2;
-static const unsigned c_maxCacheSize = 1024 * 1024 * 1;
-static const unsigned c_minCacheSize = 1;
-#else
-
-/// Duration between flushes.
-static const chrono::system_clock::duration c_collectionDuration = chrono::seconds(60);
-
-/// Length of death row (total time in cache is multiple of this and collection duration).
-static const unsigned c_collectionQueueSize = 20;
-
-/// Max size, above which we start forcing cache reduction.
-static const unsigned c_maxCacheSize = 1024 * 1024 * 64;
-
-/// Min size, below which we don't bother flushing it.
-static const unsigned c_minCacheSize = 1024 * 1024 * 32;
-
-#endif
-
-BlockChain::BlockChain(bytes const& _genesisBlock, std::string _path, WithExisting _we, ProgressCallback const& _p)
+/// Accounted size of cache entries whose footprint doesn't vary.
+template <class T> static size_t fixedSize(T const&) { return sizeof(T); }
+
+BlockChain::BlockChain(bytes const& _genesisBlock, std::string _path, WithExisting _we, ProgressCallback const& _p):
+	m_blocks(Defaults::cacheBudgets().blocks, [](SharedBytes const& _b) { return _b->size(); }),
+	m_headers(Defaults::cacheBudgets().headers, [](SharedBytes const& _b) { return _b->size(); }),
+	m_bodyHashes(Defaults::cacheBudgets().bodyHashes, [](BlockBodyHashes const& _h) { return sizeof(BlockBodyHashes) + (_h.transactions.size() + _h.uncles.size()) * sizeof(h256); }),
+	m_details(Defaults::cacheBudgets().details, [](BlockDetails const& _d) { return sizeof(BlockDetails) + _d.children.size() * sizeof(h256); }),
+	m_logBlooms(Defaults::cacheBudgets().logBlooms, [](BlockLogBlooms const& _b) { return _b.blooms.size() * sizeof(LogBloom); }),
+	m_receipts(Defaults::cacheBudgets().receipts, [](BlockReceipts const& _r) { return _r.size; }),
+	m_transactionAddresses(Defaults::cacheBudgets().transactionAddresses, fixedSize<TransactionAddress>),
+	m_blockHashes(Defaults::cacheBudgets().blockHashes, fixedSize<BlockHash>),
+	m_blocksBlooms(Defaults::cacheBudgets().blocksBlooms, fixedSize<BlocksBlooms>)
 {
-	// initialise deathrow.
-	m_cacheUsage.resize(c_collectionQueueSize);
-	m_lastCollection = chrono::system_clock::now();
-
 	// Initialise with the genesis as the last block on the longest chain.
-	m_genesisBlock = _genesisBlock;
-	m_genesisHash = sha3(RLP(m_genesisBlock)[0].data());
+	m_genesisBlock = make_shared<bytes const>(_genesisBlock);
+	m_genesisHeader = make_shared<bytes const>(RLP(_genesisBlock)[0].data().toBytes());
+	m_genesisHash = sha3(*m_genesisHeader);
 
 	open(_path, _we);
 	if (_we == WithExisting::Verify)
@@ -145,6 +133,7 @@ void BlockChain::open(std::string const& _path, WithExisting _we)
 	{
 		boost::filesystem::remove_all(path + "/blocks");
 		boost::filesystem::remove_all(path + "/details");
+		boost::filesystem::remove_all(path + "/canon");
 	}
 
 	ldb::Options o;
@@ -168,8 +157,9 @@ void BlockChain::open(std::string const& _path, WithExisting _we)
 	if (_we != WithExisting::Verify && !details(m_genesisHash))
 	{
 		// Insert details of genesis block.
-		m_details[m_genesisHash] = BlockDetails(0, c_genesisDifficulty, h256(), {});
-		auto r = m_details[m_genesisHash].rlp();
+		BlockDetails gd(0, c_genesisDifficulty, h256(), {});
+		m_details.insert(m_genesisHash, gd);
+		auto r = gd.rlp();
 		m_extrasDB->Put(m_writeOptions, toSlice(m_genesisHash, ExtraDetails), (ldb::Slice)dev::ref(r));
 	}
 
@@ -182,6 +172,7 @@ void BlockChain::open(std::string const& _path, WithExisting _we)
 	m_extrasDB->Get(m_readOptions, ldb::Slice("best"), &l);
 	m_lastBlockHash = l.empty() ? m_genesisHash : *(h256*)l.data();
 	m_lastBlockNumber = number(m_lastBlockHash);
+	loadCanon(path);
 
 	cnote << "Opened blockchain DB. Latest: " << currentHash();
 }
@@ -195,6 +186,62 @@ void BlockChain::close()
 	m_lastBlockNumber = 0;
 	m_details.clear();
 	m_blocks.clear();
+	DEV_WRITE_GUARDED(x_canon)
+	{
+		m_canon.clear();
+		m_canonFile.close();
+	}
+}
+
+void BlockChain::loadCanon(std::string const& _path)
+{
+	WriteGuard l(x_canon);
+	m_canonPath = _path + "/canon";
+	m_canonFile.close();
+
+	// The file is a flat array of 32-byte hashes; anything past the best block is left over from a shorter reorg.
+	bytes d = contents(m_canonPath);
+	m_canon.resize(min<size_t>(d.size() / h256::size, m_lastBlockNumber + 1));
+	if (!m_canon.empty())
+		memcpy(m_canon.data(), d.data(), m_canon.size() * h256::size);
+
+	// Changes are written after "best" and lowest number first, so if the best block's entry matches then
+	// so does everything before it.
+	if (m_canon.size() != m_lastBlockNumber + 1 || m_canon.front() != m_genesisHash || m_canon.back() != m_lastBlockHash)
+	{
+		cnote << "Rebuilding canonical chain index from" << m_lastBlockNumber << "blocks";
+		m_canon.resize(m_lastBlockNumber + 1);
+		h256 h = m_lastBlockHash;
+		for (unsigned n = m_lastBlockNumber; n > 0; --n, h = details(h).parent)
+			m_canon[n] = h;
+		m_canon[0] = m_genesisHash;
+		writeFile(m_canonPath, bytesConstRef(m_canon.data()->data(), m_canon.size() * h256::size));
+	}
+	m_canonFile.open(m_canonPath, ios::in | ios::out | ios::binary);
+}
+
+unsigned BlockChain::noteCanon(unsigned _number, vector<pair<unsigned, h256>> const& _fresh)
+{
+	WriteGuard l(x_canon);
+	m_canon.resize(_number + 1);
+	unsigned ret = _number;
+	for (auto const& f: _fresh)
+	{
+		m_canon[f.first] = f.second;
+		ret = min(ret, f.first);
+	}
+	return ret;
+}
+
+void BlockChain::writeCanon(unsigned _from)
+{
+	WriteGuard l(x_canon);
+	if (m_canonFile.is_open() && _from < m_canon.size())
+	{
+		m_canonFile.seekp(_from * h256::size);
+		m_canonFile.write((char const*)m_canon[_from].data(), (m_canon.size() - _from) * h256::size);
+		m_canonFile.flush();
+	}
 }
 
 #define IGNORE_EXCEPTIONS(X) try { X; } catch (...) {}
@@ -230,13 +277,14 @@ void BlockChain::rebuild(std::string const& _path, std::function<void(unsigned,
 	m_transactionAddresses.clear();
 	m_blockHashes.clear();
 	m_blocksBlooms.clear();
-	m_lastLastHashes.clear();
 	m_lastBlockHash = genesisHash();
 	m_lastBlockNumber = 0;
+	writeCanon(noteCanon(0, {{0, m_genesisHash}}));
 
-	m_details[m_lastBlockHash].totalDifficulty = c_genesisDifficulty;
+	BlockDetails gd(0, c_genesisDifficulty, h256(), {});
+	m_details.insert(m_lastBlockHash, gd);
 
-	m_extrasDB->Put(m_writeOptions, toSlice(m_lastBlockHash, ExtraDetails), (ldb::Slice)dev::ref(m_details[m_lastBlockHash].rlp()));
+	m_extrasDB->Put(m_writeOptions, toSlice(m_lastBlockHash, ExtraDetails), (ldb::Slice)dev::ref(gd.rlp()));
 
 	h256 lastHash = m_lastBlockHash;
 	boost::timer t;
@@ -249,7 +297,7 @@ void BlockChain::rebuild(std::string const& _path, std::function<void(unsigned,
 		}
 		try
 		{
-			bytes b = block(queryExtras<BlockHash, ExtraBlockHash>(h256(u256(d)), m_blockHashes, x_blockHashes, NullBlockHash, oldExtrasDB).value);
+			bytes b = block(queryExtras<BlockHash, ExtraBlockHash>(h256(u256(d)), m_blockHashes, NullBlockHash, oldExtrasDB).value);
 
 			BlockInfo bi(b);
 			ProofOfWork::prep(bi);
@@ -291,32 +339,53 @@ bool contains(T const& _t, V const& _v)
 
 LastHashes BlockChain::lastHashes(unsigned _n) const
 {
-	Guard l(x_lastLastHashes);
-	if (m_lastLastHashesNumber != _n || m_lastLastHashes.empty())
-	{
-		m_lastLastHashes.resize(256);
-		for (unsigned i = 0; i < 256; ++i)
-			m_lastLastHashes[i] = _n >= i ? numberHash(_n - i) : h256();
-		m_lastLastHashesNumber = _n;
-	}
-	return m_lastLastHashes;
+	LastHashes ret(256);
+	ReadGuard l(x_canon);
+	for (unsigned i = 0; i < 256 && i <= _n; ++i)
+		if (_n - i < m_canon.size())
+			ret[i] = m_canon[_n - i];
+	return ret;
 }
 
 tuple<h256s, h256s, bool> BlockChain::sync(BlockQueue& _bq, OverlayDB const& _stateDB, unsigned _max)
 {
 //	_bq.tick(*this);
 
-	vector<bytes> blocks;
+	vector<SharedBytesRef> blocks;
 	_bq.drain(blocks, _max);
 
+	// Check the proofs-of-work of the whole lot in one go, since that parallelises; blocks that fail (or whose
+	// headers can't be read) are left for import() to check again and reject with the usual diagnostics.
+	vector<BlockInfo> headers;
+	vector<size_t> headerBlocks;
+	for (size_t i = 0; i < blocks.size(); ++i)
+		try
+		{
+			BlockInfo bi(blocks[i].ref());
+			if (bi.parentHash)
+			{
+				headers.push_back(bi);
+				headerBlocks.push_back(i);
+			}
+		}
+		catch (...) {}
+	vector<bool> powValid(blocks.size(), false);
+	vector<bool> headerValid = ProofOfWork::verify(headers);
+	for (size_t i = 0; i < headers.size(); ++i)
+		powValid[headerBlocks[i]] = headerValid[i];
+
 	h256s fresh;
 	h256s dead;
 	h256s badBlocks;
-	for (auto const& block: blocks)
+	for (size_t i = 0; i < blocks.size(); ++i)
 	{
+		auto const& block = blocks[i];
+		ImportRequirements::value ir = ImportRequirements::Default;
+		if (powValid[i])
+			ir &= ~ImportRequirements::ValidNonce;
 		try
 		{
-			auto r = import(block, _stateDB);
+			auto r = import(block.ref(), _stateDB, ir);
 			fresh += r.first;
 			dead += r.second;
 		}
@@ -325,14 +394,14 @@ tuple<h256s, h256s, bool> BlockChain::sync(BlockQueue& _bq, OverlayDB const& _st
 			cwarn << "ODD: Import queue contains block with unknown parent." << LogTag::Error << boost::current_exception_diagnostic_information();
 			// NOTE: don't reimport since the queue should guarantee everything in the right order.
 			// Can't continue - chain bad.
-			badBlocks.push_back(BlockInfo::headerHash(block));
+			badBlocks.push_back(BlockInfo::headerHash(block.ref()));
 		}
 		catch (Exception const& _e)
 		{
 			cnote << "Exception while importing block. Someone (Jeff? That you?) seems to be giving us dodgy blocks!" << LogTag::Error << diagnostic_information(_e);
 			// NOTE: don't reimport since the queue should guarantee everything in the right order.
 			// Can't continue - chain  bad.
-			badBlocks.push_back(BlockInfo::headerHash(block));
+			badBlocks.push_back(BlockInfo::headerHash(block.ref()));
 		}
 	}
 	return make_tuple(fresh, dead, _bq.doneDrain(badBlocks));
@@ -362,7 +431,7 @@ pair<ImportResult, ImportRoute> BlockChain::attemptImport(bytes const& _block, O
 	}
 }
 
-ImportRoute BlockChain::import(bytes const& _block, OverlayDB const& _db, ImportRequirements::value _ir)
+ImportRoute BlockChain::import(bytesConstRef _block, OverlayDB const& _db, ImportRequirements::value _ir)
 {
 	//@tidy This is a behemoth of a method - could do to be split into a few smaller ones.
 
@@ -388,8 +457,8 @@ ImportRoute BlockChain::import(bytes const& _block, OverlayDB const& _db, Import
 		if (!blockRLP.isList())
 			BOOST_THROW_EXCEPTION(InvalidBlockFormat() << errinfo_comment("block header needs to be a list") << BadFieldError(0, blockRLP.data().toString()));
 
-		bi.populate(&_block);
-		bi.verifyInternals(&_block);
+		bi.populate(_block);
+		bi.verifyInternals(_block);
 	}
 #if ETH_CATCH
 	catch (Exception const& _e)
@@ -446,8 +515,19 @@ ImportRoute BlockChain::import(bytes const& _block, OverlayDB const& _db, Import
 
 	ldb::WriteBatch blocksBatch;
 	ldb::WriteBatch extrasBatch;
+	BlockBodyHashes newBodyHashes;
+	{
+		RLP blockRLP(_block);
+		vector<bytesConstRef> txs;
+		for (auto const& t: blockRLP[1])
+			txs.push_back(t.data());
+		newBodyHashes.transactions = sha3Batch(txs);
+		for (auto const& u: blockRLP[2])
+			newBodyHashes.uncles.push_back(sha3(u.data()));
+	}
 	h256 newLastBlockHash = currentHash();
 	unsigned newLastBlockNumber = number();
+	vector<pair<unsigned, h256>> newCanon;
 
 	u256 td;
 #if ETH_CATCH
@@ -457,7 +537,7 @@ ImportRoute BlockChain::import(bytes const& _block, OverlayDB const& _db, Import
 		// Check transactions are valid and that they result in a state equivalent to our state_root.
 		// Get total difficulty increase and update state, checking it.
 		State s(_db);
-		auto tdIncrease = s.enactOn(&_block, bi, *this, _ir);
+		auto tdIncrease = s.enactOn(_block, bi, *this, _ir);
 
 		BlockLogBlooms blb;
 		BlockReceipts br;
@@ -488,27 +568,23 @@ ImportRoute BlockChain::import(bytes const& _block, OverlayDB const& _db, Import
 
 		// All ok - insert into DB
 
-		// ensure parent is cached for later addition.
-		// TODO: this is a bit horrible would be better refactored into an enveloping UpgradableGuard
-		// together with an "ensureCachedWithUpdatableLock(l)" method.
-		// This is safe in practice since the caches don't get flushed nearly often enough to be
-		// done here.
-		details(bi.parentHash);
-		DEV_WRITE_GUARDED(x_details)
-			m_details[bi.parentHash].children.push_back(bi.hash());
+		// Add ourselves to the parent's children; the update is atomic with respect to the cache,
+		// and we keep the result to write out since the entry may be evicted before then.
+		BlockDetails parentDetails = m_details.update(bi.parentHash, details(bi.parentHash), [&](BlockDetails& _d) { _d.children.push_back(bi.hash()); });
 
 #if ETH_TIMED_IMPORTS || !ETH_TRUE
 		collation = t.elapsed();
 		t.restart();
 #endif
 
-		blocksBatch.Put(toSlice(bi.hash()), (ldb::Slice)ref(_block));
-		DEV_READ_GUARDED(x_details)
-			extrasBatch.Put(toSlice(bi.parentHash, ExtraDetails), (ldb::Slice)dev::ref(m_details[bi.parentHash].rlp()));
+		blocksBatch.Put(toSlice(bi.hash()), (ldb::Slice)_block);
+		extrasBatch.Put(toSlice(bi.parentHash, ExtraDetails), (ldb::Slice)dev::ref(parentDetails.rlp()));
 
 		extrasBatch.Put(toSlice(bi.hash(), ExtraDetails), (ldb::Slice)dev::ref(BlockDetails((unsigned)pd.number + 1, td, bi.parentHash, {}).rlp()));
 		extrasBatch.Put(toSlice(bi.hash(), ExtraLogBlooms), (ldb::Slice)dev::ref(blb.rlp()));
 		extrasBatch.Put(toSlice(bi.hash(), ExtraReceipts), (ldb::Slice)dev::ref(br.rlp()));
+		extrasBatch.Put(toSlice(bi.hash(), ExtraHeader), (ldb::Slice)RLP(_block)[0].data());
+		extrasBatch.Put(toSlice(bi.hash(), ExtraBodyHashes), (ldb::Slice)dev::ref(newBodyHashes.rlp()));
 
 #if ETH_TIMED_IMPORTS || !ETH_TRUE
 		writing = t.elapsed();
@@ -568,42 +644,35 @@ ImportRoute BlockChain::import(bytes const& _block, OverlayDB const& _db, Import
 			if (*i == bi.hash())
 				tbi = bi;
 			else
-				tbi = BlockInfo(block(*i));
+				tbi = info(*i);
+			newCanon.push_back(make_pair((unsigned)tbi.number, tbi.hash()));
 
 			// Collate logs into blooms.
-			h256s alteredBlooms;
+			vector<pair<h256, BlocksBlooms>> alteredBlooms;
 			{
 				LogBloom blockBloom = tbi.logBloom;
 				blockBloom.shiftBloom<3>(sha3(tbi.coinbaseAddress.ref()));
 
-				// Pre-memoize everything we need before locking x_blocksBlooms
-				for (unsigned level = 0, index = (unsigned)tbi.number; level < c_bloomIndexLevels; level++, index /= c_bloomIndexSize)
-					blocksBlooms(chunkId(level, index / c_bloomIndexSize));
-
-				WriteGuard l(x_blocksBlooms);
 				for (unsigned level = 0, index = (unsigned)tbi.number; level < c_bloomIndexLevels; level++, index /= c_bloomIndexSize)
 				{
 					unsigned i = index / c_bloomIndexSize;
 					unsigned o = index % c_bloomIndexSize;
-					alteredBlooms.push_back(chunkId(level, i));
-					m_blocksBlooms[alteredBlooms.back()].blooms[o] |= blockBloom;
+					h256 id = chunkId(level, i);
+					alteredBlooms.push_back(make_pair(id, m_blocksBlooms.update(id, blocksBlooms(id), [&](BlocksBlooms& _b) { _b.blooms[o] |= blockBloom; })));
 				}
 			}
-			// Collate transaction hashes and remember who they were.
-			h256s newTransactionAddresses;
+			// Remember where each transaction is.
 			{
-				bytes blockBytes;
-				RLP blockRLP(*i == bi.hash() ? _block : (blockBytes = block(*i)));
+				h256s txs = *i == bi.hash() ? newBodyHashes.transactions : transactionHashes(*i);
 				TransactionAddress ta;
 				ta.blockHash = tbi.hash();
-				for (ta.index = 0; ta.index < blockRLP[1].itemCount(); ++ta.index)
-					extrasBatch.Put(toSlice(sha3(blockRLP[1][ta.index].data()), ExtraTransactionAddress), (ldb::Slice)dev::ref(ta.rlp()));
+				for (ta.index = 0; ta.index < txs.size(); ++ta.index)
+					extrasBatch.Put(toSlice(txs[ta.index], ExtraTransactionAddress), (ldb::Slice)dev::ref(ta.rlp()));
 			}
 
 			// Update database with them.
-			ReadGuard l1(x_blocksBlooms);
 			for (auto const& h: alteredBlooms)
-				extrasBatch.Put(toSlice(h, ExtraBlocksBlooms), (ldb::Slice)dev::ref(m_blocksBlooms[h].rlp()));
+				extrasBatch.Put(toSlice(h.first, ExtraBlocksBlooms), (ldb::Slice)dev::ref(h.second.rlp()));
 			extrasBatch.Put(toSlice(h256(tbi.number), ExtraBlockHash), (ldb::Slice)dev::ref(BlockHash(tbi.hash()).rlp()));
 		}
 
@@ -650,12 +719,16 @@ ImportRoute BlockChain::import(bytes const& _block, OverlayDB const& _db, Import
 	}
 
 	if (m_lastBlockHash != newLastBlockHash)
+	{
+		unsigned canonChangedFrom = noteCanon(newLastBlockNumber, newCanon);
 		DEV_WRITE_GUARDED(x_lastBlockHash)
 		{
 			m_lastBlockHash = newLastBlockHash;
 			m_lastBlockNumber = newLastBlockNumber;
 			m_extrasDB->Put(m_writeOptions, ldb::Slice("best"), ldb::Slice((char const*)&m_lastBlockHash, 32));
 		}
+		writeCanon(canonChangedFrom);
+	}
 
 #if ETH_PARANOIA || !ETH_TRUE
 	checkConsistency();
@@ -671,9 +744,6 @@ ImportRoute BlockChain::import(bytes const& _block, OverlayDB const& _db, Import
 	cnote << "checkBest:" << checkBest;
 #endif
 
-	if (!route.empty())
-		noteCanonChanged();
-
 	h256s fresh;
 	h256s dead;
 	bool isOld = true;
@@ -723,8 +793,7 @@ void BlockChain::clearBlockBlooms(unsigned _begin, unsigned _end)
 				for (auto const& bloom: blocksBlooms(lowerChunkId).blooms)
 					acc |= bloom;
 			}
-			blocksBlooms(id);	// make sure it has been memoized.
-			m_blocksBlooms[id].blooms[offset] = acc;
+			m_blocksBlooms.update(id, blocksBlooms(id), [&](BlocksBlooms& _b) { _b.blooms[offset] = acc; });
 		}
 	}
 }
@@ -780,114 +849,60 @@ tuple<h256s, h256, unsigned> BlockChain::treeRoute(h256 const& _from, h256 const
 	return make_tuple(ret, from, i);
 }
 
-void BlockChain::noteUsed(h256 const& _h, unsigned _extra) const
-{
-	auto id = CacheID(_h, _extra);
-	Guard l(x_cacheUsage);
-	m_cacheUsage[0].insert(id);
-	if (m_cacheUsage[1].count(id))
-		m_cacheUsage[1].erase(id);
-	else
-		m_inUse.insert(id);
-}
-
-template <class T> static unsigned getHashSize(unordered_map<h256, T> const& _map)
+void BlockChain::updateStats() const
 {
-	unsigned ret = 0;
-	for (auto const& i: _map)
-		ret += i.second.size + 64;
-	return ret;
+	Statistics s;
+	s.blocks = m_blocks.stats();
+	s.headers = m_headers.stats();
+	s.bodyHashes = m_bodyHashes.stats();
+	s.details = m_details.stats();
+	s.logBlooms = m_logBlooms.stats();
+	s.receipts = m_receipts.stats();
+	s.transactionAddresses = m_transactionAddresses.stats();
+	s.blockHashes = m_blockHashes.stats();
+	s.blocksBlooms = m_blocksBlooms.stats();
+	s.memBlocks = s.blocks.bytes + s.headers.bytes;
+	s.memDetails = s.details.bytes;
+	s.memLogBlooms = s.logBlooms.bytes + s.blocksBlooms.bytes;
+	s.memReceipts = s.receipts.bytes;
+	s.memTransactionAddresses = s.transactionAddresses.bytes + s.bodyHashes.bytes;
+	s.memBlockHashes = s.blockHashes.bytes;
+	m_lastStats = s;
 }
 
-void BlockChain::updateStats() const
+void BlockChain::setCacheBudgets(CacheBudgets const& _budgets)
 {
-	{
-		ReadGuard l(x_blocks);
-		m_lastStats.memBlocks = 0;
-		for (auto const& i: m_blocks)
-			m_lastStats.memBlocks += i.second.size() + 64;
-	}
-	{
-		ReadGuard l(x_details);
-		m_lastStats.memDetails = getHashSize(m_details);
-	}
-	{
-		ReadGuard l1(x_logBlooms);
-		ReadGuard l2(x_blocksBlooms);
-		m_lastStats.memLogBlooms = getHashSize(m_logBlooms) + getHashSize(m_blocksBlooms);
-	}
-	{
-		ReadGuard l(x_receipts);
-		m_lastStats.memReceipts = getHashSize(m_receipts);
-	}
-	{
-		ReadGuard l(x_blockHashes);
-		m_lastStats.memBlockHashes = getHashSize(m_blockHashes);
-	}
-	{
-		ReadGuard l(x_transactionAddresses);
-		m_lastStats.memTransactionAddresses = getHashSize(m_transactionAddresses);
-	}
+	m_blocks.setBudget(_budgets.blocks);
+	m_headers.setBudget(_budgets.headers);
+	m_bodyHashes.setBudget(_budgets.bodyHashes);
+	m_details.setBudget(_budgets.details);
+	m_logBlooms.setBudget(_budgets.logBlooms);
+	m_receipts.setBudget(_budgets.receipts);
+	m_transactionAddresses.setBudget(_budgets.transactionAddresses);
+	m_blockHashes.setBudget(_budgets.blockHashes);
+	m_blocksBlooms.setBudget(_budgets.blocksBlooms);
 }
 
 void BlockChain::garbageCollect(bool _force)
 {
-	updateStats();
-
-	if (!_force && chrono::system_clock::now() < m_lastCollection + c_collectionDuration && m_lastStats.memTotal() < c_maxCacheSize)
-		return;
-	if (m_lastStats.memTotal() < c_minCacheSize)
-		return;
-
-	m_lastCollection = chrono::system_clock::now();
-
-	Guard l(x_cacheUsage);
-	WriteGuard l1(x_blocks);
-	WriteGuard l2(x_details);
-	WriteGuard l3(x_blockHashes);
-	WriteGuard l4(x_receipts);
-	WriteGuard l5(x_logBlooms);
-	WriteGuard l6(x_transactionAddresses);
-	WriteGuard l7(x_blocksBlooms);
-	for (CacheID const& id: m_cacheUsage.back())
+	if (_force)
 	{
-		m_inUse.erase(id);
-		// kill i from cache.
-		switch (id.second)
-		{
-		case (unsigned)-1:
-			m_blocks.erase(id.first);
-			break;
-		case ExtraDetails:
-			m_details.erase(id.first);
-			break;
-		case ExtraBlockHash:
-			m_blockHashes.erase(id.first);
-			break;
-		case ExtraReceipts:
-			m_receipts.erase(id.first);
-			break;
-		case ExtraLogBlooms:
-			m_logBlooms.erase(id.first);
-			break;
-		case ExtraTransactionAddress:
-			m_transactionAddresses.erase(id.first);
-			break;
-		case ExtraBlocksBlooms:
-			m_blocksBlooms.erase(id.first);
-			break;
-		}
+		m_blocks.clear();
+		m_headers.clear();
+		m_bodyHashes.clear();
+		m_details.clear();
+		m_logBlooms.clear();
+		m_receipts.clear();
+		m_transactionAddresses.clear();
+		m_blockHashes.clear();
+		m_blocksBlooms.clear();
 	}
-	m_cacheUsage.pop_back();
-	m_cacheUsage.push_front(std::unordered_set<CacheID>{});
+	updateStats();
 }
 
 void BlockChain::checkConsistency()
 {
-	{
-		WriteGuard l(x_details);
-		m_details.clear();
-	}
+	m_details.clear();
 	ldb::Iterator* it = m_blocksDB->NewIterator(m_readOptions);
 	for (it->SeekToFirst(); it->Valid(); it->Next())
 		if (it->key().size() == 32)
@@ -1001,51 +1016,107 @@ bool BlockChain::isKnown(h256 const& _hash) const
 	if (_hash == m_genesisHash)
 		return true;
 
-	DEV_READ_GUARDED(x_blocks)
-		if (!m_blocks.count(_hash))
-		{
-			string d;
-			m_blocksDB->Get(m_readOptions, toSlice(_hash), &d);
-			if (d.empty())
-				return false;
-		}
-	DEV_READ_GUARDED(x_details)
-		if (!m_details.count(_hash))
-		{
-			string d;
-			m_extrasDB->Get(m_readOptions, toSlice(_hash, ExtraDetails), &d);
-			if (d.empty())
-				return false;
-		}
+	if (!m_blocks.contains(_hash))
+	{
+		string d;
+		m_blocksDB->Get(m_readOptions, toSlice(_hash), &d);
+		if (d.empty())
+			return false;
+	}
+	if (!m_details.contains(_hash))
+	{
+		string d;
+		m_extrasDB->Get(m_readOptions, toSlice(_hash, ExtraDetails), &d);
+		if (d.empty())
+			return false;
+	}
 	return true;
 }
 
-bytes BlockChain::block(h256 const& _hash) const
+SharedBytes BlockChain::blockData(h256 const& _hash) const
+{
+	if (SharedBytes ret = findBlockData(_hash))
+		return ret;
+	cwarn << "Couldn't find requested block:" << _hash;
+	return make_shared<bytes const>();
+}
+
+SharedBytes BlockChain::findBlockData(h256 const& _hash) const
 {
 	if (_hash == m_genesisHash)
 		return m_genesisBlock;
 
-	{
-		ReadGuard l(x_blocks);
-		auto it = m_blocks.find(_hash);
-		if (it != m_blocks.end())
-			return it->second;
-	}
+	SharedBytes ret;
+	if (m_blocks.get(_hash, ret))
+		return ret;
 
 	string d;
 	m_blocksDB->Get(m_readOptions, toSlice(_hash), &d);
-
 	if (d.empty())
+		return nullptr;
+
+	ret = make_shared<bytes const>(asBytes(d));
+	m_blocks.insert(_hash, ret);
+	return ret;
+}
+
+SharedBytes BlockChain::headerData(h256 const& _hash) const
+{
+	if (_hash == m_genesisHash)
+		return m_genesisHeader;
+
+	SharedBytes ret;
+	if (m_headers.get(_hash, ret))
+		return ret;
+
+	string d;
+	m_extrasDB->Get(m_readOptions, toSlice(_hash, ExtraHeader), &d);
+	if (!d.empty())
+		ret = make_shared<bytes const>(asBytes(d));
+	else
 	{
-		cwarn << "Couldn't find requested block:" << _hash;
-		return bytes();
+		// Imported before headers were kept apart; split it out of the block.
+		SharedBytes b = blockData(_hash);
+		if (b->empty())
+			return b;
+		ret = make_shared<bytes const>(RLP(*b)[0].data().toBytes());
 	}
+	m_headers.insert(_hash, ret);
+	return ret;
+}
 
-	noteUsed(_hash);
+BlockInfo BlockChain::info(h256 const& _hash) const
+{
+	SharedBytes h = headerData(_hash);
+	if (h->empty())
+		BOOST_THROW_EXCEPTION(InvalidBlockFormat() << errinfo_comment("unknown block"));
+	return BlockInfo::fromHeader(*h, IgnoreNonce, _hash);
+}
 
-	WriteGuard l(x_blocks);
-	m_blocks[_hash].resize(d.size());
-	memcpy(m_blocks[_hash].data(), d.data(), d.size());
+BlockBodyHashes BlockChain::bodyHashes(h256 const& _hash) const
+{
+	BlockBodyHashes ret;
+	if (m_bodyHashes.get(_hash, ret))
+		return ret;
 
-	return m_blocks[_hash];
+	string d;
+	m_extrasDB->Get(m_readOptions, toSlice(_hash, ExtraBodyHashes), &d);
+	if (!d.empty())
+		ret = BlockBodyHashes(RLP(d));
+	else
+	{
+		// Imported before the hashes were recorded (or genesis); work them out from the block.
+		SharedBytes b = blockData(_hash);
+		if (b->empty())
+			return ret;
+		RLP r(*b);
+		vector<bytesConstRef> txs;
+		for (auto const& t: r[1])
+			txs.push_back(t.data());
+		ret.transactions = sha3Batch(txs);
+		for (auto const& u: r[2])
+			ret.uncles.push_back(sha3(u.data()));
+	}
+	m_bodyHashes.insert(_hash, ret);
+	return ret;
 }
@@ -28,11 +28,14 @@
 
 #include <deque>
 #include <chrono>
+#include <fstream>
 #include <unordered_map>
 #include <unordered_set>
 #include <libdevcore/Log.h>
 #include <libdevcore/Exceptions.h>
 #include <libdevcore/Guards.h>
+#include <libdevcore/LruCache.h>
+#include <libdevcore/SharedBytes.h>
 #include <libethcore/Common.h>
 #include <libethcore/BlockInfo.h>
 #include <libevm/ExtVMFace.h>
@@ -40,6 +43,7 @@
 #include "Account.h"
 #include "Transaction.h"
 #include "BlockQueue.h"
+#include "Defaults.h"
 namespace ldb = leveldb;
 
 namespace std
@@ -77,6 +81,7 @@ std::unordered_map<Address, Account> const& genesisState();
 ldb::Slice toSlice(h256 const& _h, unsigned _sub = 0);
 
 using BlocksHash = std::unordered_map<h256, bytes>;
+template <class T> using ExtrasCache = ShardedLruCache<h256, T>;
 using TransactionHashes = h256s;
 using UncleHashes = h256s;
 using ImportRoute = std::pair<h256s, h256s>;
@@ -87,7 +92,9 @@ enum {
 	ExtraTransactionAddress,
 	ExtraLogBlooms,
 	ExtraReceipts,
-	ExtraBlocksBlooms
+	ExtraBlocksBlooms,
+	ExtraHeader,
+	ExtraBodyHashes
 };
 
 using ProgressCallback = std::function<void(unsigned, unsigned)>;
@@ -119,42 +126,55 @@ public:
 
 	/// Import block into disk-backed DB
 	/// @returns the block hashes of any blocks that came into/went out of the canonical block chain.
-	ImportRoute import(bytes const& _block, OverlayDB const& _stateDB, ImportRequirements::value _ir = ImportRequirements::Default);
+	ImportRoute import(bytes const& _block, OverlayDB const& _stateDB, ImportRequirements::value _ir = ImportRequirements::Default) { return import(&_block, _stateDB, _ir); }
+	ImportRoute import(bytesConstRef _block, OverlayDB const& _stateDB, ImportRequirements::value _ir = ImportRequirements::Default);
 
 	/// Returns true if the given block is known (though not necessarily a part of the canon chain).
 	bool isKnown(h256 const& _hash) const;
 
-	/// Get the familial details concerning a block (or the most recent mined if none given). Thread-safe.
-	BlockInfo info(h256 const& _hash) const { return BlockInfo(block(_hash), IgnoreNonce, _hash); }
+	/// Get the header information of a block (or the most recent mined if none given). Never reads the block's body. Thread-safe.
+	BlockInfo info(h256 const& _hash) const;
 	BlockInfo info() const { return info(currentHash()); }
 
 	/// Get a block (RLP format) for the given hash (or the most recent mined if none given). Thread-safe.
-	bytes block(h256 const& _hash) const;
+	bytes block(h256 const& _hash) const { return *blockData(_hash); }
 	bytes block() const { return block(currentHash()); }
 	bytes oldBlock(h256 const& _hash) const;
 
+	/// Get a block (RLP format) as a buffer shared with the cache; it's empty if the block is unknown. Thread-safe.
+	SharedBytes blockData(h256 const& _hash) const;
+
+	/// Like blockData() but quietly gives null if the block is unknown, so that a known block costs only one lookup. Thread-safe.
+	SharedBytes findBlockData(h256 const& _hash) const;
+
+	/// Get a block's header (RLP format) without reading its body; it's empty if the block is unknown. Thread-safe.
+	SharedBytes headerData(h256 const& _hash) const;
+
 	/// Get the familial details concerning a block (or the most recent mined if none given). Thread-safe.
-	BlockDetails details(h256 const& _hash) const { return queryExtras<BlockDetails, ExtraDetails>(_hash, m_details, x_details, NullBlockDetails); }
+	BlockDetails details(h256 const& _hash) const { return queryExtras<BlockDetails, ExtraDetails>(_hash, m_details, NullBlockDetails); }
 	BlockDetails details() const { return details(currentHash()); }
 
 	/// Get the transactions' log blooms of a block (or the most recent mined if none given). Thread-safe.
-	BlockLogBlooms logBlooms(h256 const& _hash) const { return queryExtras<BlockLogBlooms, ExtraLogBlooms>(_hash, m_logBlooms, x_logBlooms, NullBlockLogBlooms); }
+	BlockLogBlooms logBlooms(h256 const& _hash) const { return queryExtras<BlockLogBlooms, ExtraLogBlooms>(_hash, m_logBlooms, NullBlockLogBlooms); }
 	BlockLogBlooms logBlooms() const { return logBlooms(currentHash()); }
 
 	/// Get the transactions' receipts of a block (or the most recent mined if none given). Thread-safe.
-	BlockReceipts receipts(h256 const& _hash) const { return queryExtras<BlockReceipts, ExtraReceipts>(_hash, m_receipts, x_receipts, NullBlockReceipts); }
+	BlockReceipts receipts(h256 const& _hash) const { return queryExtras<BlockReceipts, ExtraReceipts>(_hash, m_receipts, NullBlockReceipts); }
 	BlockReceipts receipts() const { return receipts(currentHash()); }
 
+	/// Get the transaction and uncle hashes of a given block, as recorded at import. Thread-safe.
+	BlockBodyHashes bodyHashes(h256 const& _hash) const;
+
 	/// Get a list of transaction hashes for a given block. Thread-safe.
-	TransactionHashes transactionHashes(h256 const& _hash) const { auto b = block(_hash); RLP rlp(b); h256s ret; for (auto t: rlp[1]) ret.push_back(sha3(t.data())); return ret; }
+	TransactionHashes transactionHashes(h256 const& _hash) const { return bodyHashes(_hash).transactions; }
 	TransactionHashes transactionHashes() const { return transactionHashes(currentHash()); }
 
 	/// Get a list of uncle hashes for a given block. Thread-safe.
-	UncleHashes uncleHashes(h256 const& _hash) const { auto b = block(_hash); RLP rlp(b); h256s ret; for (auto t: rlp[2]) ret.push_back(sha3(t.data())); return ret; }
+	UncleHashes uncleHashes(h256 const& _hash) const { return bodyHashes(_hash).uncles; }
 	UncleHashes uncleHashes() const { return uncleHashes(currentHash()); }
 	
-	/// Get the hash for a given block's number.
-	h256 numberHash(unsigned _i) const { if (!_i) return genesisHash(); return queryExtras<BlockHash, ExtraBlockHash>(h256(_i), m_blockHashes, x_blockHashes, NullBlockHash).value; }
+	/// Get the hash for a given block's number on the canonical chain, or the null hash if there's none. Thread-safe.
+	h256 numberHash(unsigned _i) const { ReadGuard l(x_canon); return _i < m_canon.size() ? m_canon[_i] : h256(); }
 
 	/// Get the last N hashes for a given block. (N is determined by the LastHashes type.)
 	LastHashes lastHashes() const { return lastHashes(number()); }
@@ -175,23 +195,24 @@ public:
 	 * i * (x ^ n) + o * x ^ (n - 1)
 	 */
 	BlocksBlooms blocksBlooms(unsigned _level, unsigned _index) const { return blocksBlooms(chunkId(_level, _index)); }
-	BlocksBlooms blocksBlooms(h256 const& _chunkId) const { return queryExtras<BlocksBlooms, ExtraBlocksBlooms>(_chunkId, m_blocksBlooms, x_blocksBlooms, NullBlocksBlooms); }
+	BlocksBlooms blocksBlooms(h256 const& _chunkId) const { return queryExtras<BlocksBlooms, ExtraBlocksBlooms>(_chunkId, m_blocksBlooms, NullBlocksBlooms); }
 	void clearBlockBlooms(unsigned _begin, unsigned _end);
 	LogBloom blockBloom(unsigned _number) const { return blocksBlooms(chunkId(0, _number / c_bloomIndexSize)).blooms[_number % c_bloomIndexSize]; }
 	std::vector<unsigned> withBlockBloom(LogBloom const& _b, unsigned _earliest, unsigned _latest) const;
 	std::vector<unsigned> withBlockBloom(LogBloom const& _b, unsigned _earliest, unsigned _latest, unsigned _topLevel, unsigned _index) const;
 
 	/// Get a transaction from its hash. Thread-safe.
-	bytes transaction(h256 const& _transactionHash) const { TransactionAddress ta = queryExtras<TransactionAddress, ExtraTransactionAddress>(_transactionHash, m_transactionAddresses, x_transactionAddresses, NullTransactionAddress); if (!ta) return bytes(); return transaction(ta.blockHash, ta.index); }
-	std::pair<h256, unsigned> transactionLocation(h256 const& _transactionHash) const { TransactionAddress ta = queryExtras<TransactionAddress, ExtraTransactionAddress>(_transactionHash, m_transactionAddresses, x_transactionAddresses, NullTransactionAddress); if (!ta) return std::pair<h256, unsigned>(h256(), 0); return std::make_pair(ta.blockHash, ta.index); }
+	SharedBytesRef transaction(h256 const& _transactionHash) const { TransactionAddress ta = queryExtras<TransactionAddress, ExtraTransactionAddress>(_transactionHash, m_transactionAddresses, NullTransactionAddress); if (!ta) return SharedBytesRef(); return transaction(ta.blockHash, ta.index); }
+	std::pair<h256, unsigned> transactionLocation(h256 const& _transactionHash) const { TransactionAddress ta = queryExtras<TransactionAddress, ExtraTransactionAddress>(_transactionHash, m_transactionAddresses, NullTransactionAddress); if (!ta) return std::pair<h256, unsigned>(h256(), 0); return std::make_pair(ta.blockHash, ta.index); }
 
-	/// Get a block's transaction (RLP format) for the given block hash (or the most recent mined if none given) & index. Thread-safe.
-	bytes transaction(h256 const& _blockHash, unsigned _i) const { bytes b = block(_blockHash); return RLP(b)[1][_i].data().toBytes(); }
-	bytes transaction(unsigned _i) const { return transaction(currentHash(), _i); }
+	/// Get a block's transaction (RLP format) for the given block hash (or the most recent mined if none given) & index.
+	/// It views the block's own buffer, keeping that alive rather than copying out of it. Thread-safe.
+	SharedBytesRef transaction(h256 const& _blockHash, unsigned _i) const { SharedBytes b = blockData(_blockHash); return SharedBytesRef(b, RLP(*b)[1][_i].data()); }
+	SharedBytesRef transaction(unsigned _i) const { return transaction(currentHash(), _i); }
 
-	/// Get all transactions from a block.
-	std::vector<bytes> transactions(h256 const& _blockHash) const { bytes b = block(_blockHash); std::vector<bytes> ret; for (auto const& i: RLP(b)[1]) ret.push_back(i.data().toBytes()); return ret; }
-	std::vector<bytes> transactions() const { return transactions(currentHash()); }
+	/// Get all transactions from a block, as views of the block's buffer. Thread-safe.
+	std::vector<SharedBytesRef> transactions(h256 const& _blockHash) const { SharedBytes b = blockData(_blockHash); std::vector<SharedBytesRef> ret; for (auto const& i: RLP(*b)[1]) ret.push_back(SharedBytesRef(b, i.data())); return ret; }
+	std::vector<SharedBytesRef> transactions() const { return transactions(currentHash()); }
 
 	/// Get a number for the given hash (or the most recent mined if none given). Thread-safe.
 	unsigned number(h256 const& _hash) const { return details(_hash).number; }
@@ -247,12 +268,28 @@ public:
 		unsigned memTransactionAddresses;
 		unsigned memBlockHashes;
 		unsigned memTotal() const { return memBlocks + memDetails + memLogBlooms + memReceipts + memTransactionAddresses + memBlockHashes; }
+
+		/// Per-cache sizes, budgets and hit/miss/eviction counts.
+		CacheStats blocks;
+		CacheStats headers;
+		CacheStats bodyHashes;
+		CacheStats details;
+		CacheStats logBlooms;
+		CacheStats receipts;
+		CacheStats transactionAddresses;
+		CacheStats blockHashes;
+		CacheStats blocksBlooms;
+		CacheStats total() const { CacheStats ret = blocks; ret += headers; ret += bodyHashes; ret += details; ret += logBlooms; ret += receipts; ret += transactionAddresses; ret += blockHashes; ret += blocksBlooms; return ret; }
 	};
 
 	/// @returns statistics about memory usage.
 	Statistics usage(bool _freshen = false) const { if (_freshen) updateStats(); return m_lastStats; }
 
-	/// Deallocate unused data.
+	/// Sets the byte budgets of the caches, evicting whatever no longer fits.
+	void setCacheBudgets(CacheBudgets const& _budgets);
+
+	/// Caches evict incrementally as they are filled; this just refreshes the statistics,
+	/// and if @a _force is given drops everything that's cached.
 	void garbageCollect(bool _force = false);
 
 private:
@@ -261,14 +298,11 @@ private:
 	void open(std::string const& _path, WithExisting _we = WithExisting::Trust);
 	void close();
 
-	template<class T, unsigned N> T queryExtras(h256 const& _h, std::unordered_map<h256, T>& _m, boost::shared_mutex& _x, T const& _n, ldb::DB* _extrasDB = nullptr) const
+	template<class T, unsigned N> T queryExtras(h256 const& _h, ExtrasCache<T>& _m, T const& _n, ldb::DB* _extrasDB = nullptr) const
 	{
-		{
-			ReadGuard l(_x);
-			auto it = _m.find(_h);
-			if (it != _m.end())
-				return it->second;
-		}
+		T ret;
+		if (_m.get(_h, ret))
+			return ret;
 
 		std::string s;
 		(_extrasDB ? _extrasDB : m_extrasDB)->Get(m_readOptions, toSlice(_h, N), &s);
@@ -278,42 +312,37 @@ private:
 			return _n;
 		}
 
-		noteUsed(_h, N);
-
-		WriteGuard l(_x);
-		auto ret = _m.insert(std::make_pair(_h, T(RLP(s))));
-		return ret.first->second;
+		ret = T(RLP(s));
+		_m.insert(_h, ret);
+		return ret;
 	}
 
 	void checkConsistency();
 
-	/// The caches of the disk DB and their locks.
-	mutable SharedMutex x_blocks;
-	mutable BlocksHash m_blocks;
-	mutable SharedMutex x_details;
-	mutable BlockDetailsHash m_details;
-	mutable SharedMutex x_logBlooms;
-	mutable BlockLogBloomsHash m_logBlooms;
-	mutable SharedMutex x_receipts;
-	mutable BlockReceiptsHash m_receipts;
-	mutable SharedMutex x_transactionAddresses;
-	mutable TransactionAddressHash m_transactionAddresses;
-	mutable SharedMutex x_blockHashes;
-	mutable BlockHashHash m_blockHashes;
-	mutable SharedMutex x_blocksBlooms;
-	mutable BlocksBloomsHash m_blocksBlooms;
-
-	using CacheID = std::pair<h256, unsigned>;
-	mutable Mutex x_cacheUsage;
-	mutable std::deque<std::unordered_set<CacheID>> m_cacheUsage;
-	mutable std::unordered_set<CacheID> m_inUse;
-	void noteUsed(h256 const& _h, unsigned _extra = (unsigned)-1) const;
-	std::chrono::system_clock::time_point m_lastCollection;
-
-	void noteCanonChanged() const { Guard l(x_lastLastHashes); m_lastLastHashes.clear(); }
-	mutable Mutex x_lastLastHashes;
-	mutable LastHashes m_lastLastHashes;
-	mutable unsigned m_lastLastHashesNumber = (unsigned)-1;
+	/// The caches of the disk DB. Each is internally locked and kept within its byte budget.
+	mutable ExtrasCache<SharedBytes> m_blocks;
+	mutable ExtrasCache<SharedBytes> m_headers;
+	mutable ExtrasCache<BlockBodyHashes> m_bodyHashes;
+	mutable ExtrasCache<BlockDetails> m_details;
+	mutable ExtrasCache<BlockLogBlooms> m_logBlooms;
+	mutable ExtrasCache<BlockReceipts> m_receipts;
+	mutable ExtrasCache<TransactionAddress> m_transactionAddresses;
+	mutable ExtrasCache<BlockHash> m_blockHashes;
+	mutable ExtrasCache<BlocksBlooms> m_blocksBlooms;
+
+	/// Loads the canonical number->hash index from its side file in @a _path, rebuilding it if it's stale.
+	void loadCanon(std::string const& _path);
+	/// Makes the canonical chain end at block @a _number, with @a _fresh giving the (number, hash) of each new canonical block.
+	/// @returns the lowest number whose entry changed.
+	unsigned noteCanon(unsigned _number, std::vector<std::pair<unsigned, h256>> const& _fresh);
+	/// Writes the index from @a _from onwards to the side file. To be called once "best" is persisted.
+	void writeCanon(unsigned _from);
+
+	/// Hashes of the canonical chain's blocks, indexed by number; mirrored in the side file at m_canonPath.
+	mutable SharedMutex x_canon;
+	h256s m_canon;
+	std::string m_canonPath;
+	std::fstream m_canonFile;
 
 	void updateStats() const;
 	mutable Statistics m_lastStats;
@@ -329,7 +358,8 @@ private:
 
 	/// Genesis block info.
 	h256 m_genesisHash;
-	bytes m_genesisBlock;
+	SharedBytes m_genesisBlock;
+	SharedBytes m_genesisHeader;
 
 	ldb::ReadOptions m_readOptions;
 	ldb::WriteOptions m_writeOptions;
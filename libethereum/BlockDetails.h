@@ -115,6 +115,17 @@ struct TransactionAddress
 	static const unsigned size = 67;
 };
 
+/// The hashes of a block's transactions and uncles, worked out once at import.
+struct BlockBodyHashes
+{
+	BlockBodyHashes() {}
+	BlockBodyHashes(RLP const& _r) { transactions = _r[0].toVector<h256>(); uncles = _r[1].toVector<h256>(); }
+	bytes rlp() const { RLPStream s(2); s << transactions << uncles; return s.out(); }
+
+	h256s transactions;
+	h256s uncles;
+};
+
 using BlockDetailsHash = std::unordered_map<h256, BlockDetails>;
 using BlockLogBloomsHash = std::unordered_map<h256, BlockLogBlooms>;
 using BlockReceiptsHash = std::unordered_map<h256, BlockReceipts>;
@@ -35,10 +35,10 @@ const char* BlockQueueChannel::name() { return EthOrange "[]>"; }
 const char* BlockQueueChannel::name() { return EthOrange "▣┅▶"; }
 #endif
 
-ImportResult BlockQueue::import(bytesConstRef _block, BlockChain const& _bc, bool _isOurs)
+ImportResult BlockQueue::import(SharedBytesRef const& _block, BlockChain const& _bc, bool _isOurs)
 {
 	// Check if we already know this block.
-	h256 h = BlockInfo::headerHash(_block);
+	h256 h = BlockInfo::headerHash(_block.ref());
 
 	cblockq << "Queuing block" << h << "for import...";
 
@@ -57,8 +57,8 @@ ImportResult BlockQueue::import(bytesConstRef _block, BlockChain const& _bc, boo
 	try
 	{
 		// TODO: quick verify
-		bi.populate(_block);
-		bi.verifyInternals(_block);
+		bi.populate(_block.ref());
+		bi.verifyInternals(_block.ref());
 	}
 	catch (Exception const& _e)
 	{
@@ -80,7 +80,8 @@ ImportResult BlockQueue::import(bytesConstRef _block, BlockChain const& _bc, boo
 	(void)_isOurs;
 	if (bi.timestamp > (u256)time(0)/* && !_isOurs*/)
 	{
-		m_future.insert(make_pair((unsigned)bi.timestamp, make_pair(h, _block.toBytes())));
+		// Parked blocks may wait a long time, so they don't get to keep a whole network frame alive.
+		m_future.insert(make_pair((unsigned)bi.timestamp, make_pair(h, _block.compacted())));
 		char buf[24];
 		time_t bit = (unsigned)bi.timestamp;
 		if (strftime(buf, 24, "%X", localtime(&bit)) == 0)
@@ -101,7 +102,7 @@ ImportResult BlockQueue::import(bytesConstRef _block, BlockChain const& _bc, boo
 		{
 			// We don't know the parent (yet) - queue it up for later. It'll get resent to us if we find out about its ancestry later on.
 			cblockq << "OK - queued as unknown parent:" << bi.parentHash;
-			m_unknown.insert(make_pair(bi.parentHash, make_pair(h, _block.toBytes())));
+			m_unknown.insert(make_pair(bi.parentHash, make_pair(h, _block.compacted())));
 			m_unknownSet.insert(h);
 
 			return ImportResult::UnknownParent;
@@ -110,7 +111,7 @@ ImportResult BlockQueue::import(bytesConstRef _block, BlockChain const& _bc, boo
 		{
 			// If valid, append to blocks.
 			cblockq << "OK - ready for chain insertion.";
-			m_ready.push_back(make_pair(h, _block.toBytes()));
+			m_ready.push_back(make_pair(h, _block));
 			m_readySet.insert(h);
 
 			noteReady_WITH_LOCK(h);
@@ -127,11 +128,11 @@ bool BlockQueue::doneDrain(h256s const& _bad)
 	m_drainingSet.clear();
 	if (_bad.size())
 	{
-		vector<pair<h256, bytes>> old;
+		vector<pair<h256, SharedBytesRef>> old;
 		swap(m_ready, old);
 		for (auto& b: old)
 		{
-			BlockInfo bi(b.second);
+			BlockInfo bi(b.second.ref());
 			if (m_knownBad.count(bi.parentHash))
 			{
 				m_knownBad.insert(b.first);
@@ -147,7 +148,7 @@ bool BlockQueue::doneDrain(h256s const& _bad)
 
 void BlockQueue::tick(BlockChain const& _bc)
 {
-	vector<pair<h256, bytes>> todo;
+	vector<pair<h256, SharedBytesRef>> todo;
 	{
 		UpgradableGuard l(m_lock);
 		if (m_future.empty())
@@ -173,7 +174,7 @@ void BlockQueue::tick(BlockChain const& _bc)
 	cblockq << "Importing" << todo.size() << "past-future blocks.";
 
 	for (auto const& b: todo)
-		import(&b.second, _bc);
+		import(b.second, _bc);
 }
 
 template <class T> T advanced(T _t, unsigned _n)
@@ -197,7 +198,7 @@ QueueStatus BlockQueue::blockStatus(h256 const& _h) const
 			QueueStatus::Unknown;
 }
 
-void BlockQueue::drain(std::vector<bytes>& o_out, unsigned _max)
+void BlockQueue::drain(std::vector<SharedBytesRef>& o_out, unsigned _max)
 {
 	WriteGuard l(m_lock);
 	DEV_INVARIANT_CHECK;
@@ -210,7 +211,7 @@ void BlockQueue::drain(std::vector<bytes>& o_out, unsigned _max)
 		for (auto const& bs: o_out)
 		{
 			// TODO: @optimise use map<h256, bytes> rather than vector<bytes> & set<h256>.
-			auto h = BlockInfo::headerHash(bs);
+			auto h = BlockInfo::headerHash(bs.ref());
 			m_drainingSet.insert(h);
 			m_readySet.erase(h);
 		}
@@ -26,6 +26,7 @@
 #include <libdevcore/Log.h>
 #include <libethcore/Common.h>
 #include <libdevcore/Guards.h>
+#include <libdevcore/SharedBytes.h>
 #include <libethcore/Common.h>
 
 namespace dev
@@ -64,15 +65,18 @@ enum class QueueStatus
 class BlockQueue: HasInvariants
 {
 public:
-	/// Import a block into the queue.
-	ImportResult import(bytesConstRef _tx, BlockChain const& _bc, bool _isOurs = false);
+	/// Import a block into the queue. The block is copied.
+	ImportResult import(bytesConstRef _block, BlockChain const& _bc, bool _isOurs = false) { return import(SharedBytesRef(_block), _bc, _isOurs); }
+
+	/// Import a block into the queue, which keeps (rather than copies) the block's buffer until it's drained.
+	ImportResult import(SharedBytesRef const& _block, BlockChain const& _bc, bool _isOurs = false);
 
 	/// Notes that time has moved on and some blocks that used to be "in the future" may no be valid.
 	void tick(BlockChain const& _bc);
 
 	/// Grabs at most @a _max of the blocks that are ready, giving them in the correct order for insertion into the chain.
 	/// Don't forget to call doneDrain() once you're done importing.
-	void drain(std::vector<bytes>& o_out, unsigned _max);
+	void drain(std::vector<SharedBytesRef>& o_out, unsigned _max);
 
 	/// Must be called after a drain() call. Notes that the drained blocks have been imported into the blockchain, so we can forget about them.
 	/// @returns true iff there are additional blocks ready to be processed.
@@ -109,11 +113,11 @@ private:
 	mutable boost::shared_mutex m_lock;									///< General lock.
 	h256Hash m_drainingSet;												///< All blocks being imported.
 	h256Hash m_readySet;												///< All blocks ready for chain-import.
-	std::vector<std::pair<h256, bytes>> m_ready;						///< List of blocks, in correct order, ready for chain-import.
+	std::vector<std::pair<h256, SharedBytesRef>> m_ready;				///< List of blocks, in correct order, ready for chain-import.
 	h256Hash m_unknownSet;												///< Set of all blocks whose parents are not ready/in-chain.
-	std::unordered_multimap<h256, std::pair<h256, bytes>> m_unknown;	///< For blocks that have an unknown parent; we map their parent hash to the block stuff, and insert once the block appears.
+	std::unordered_multimap<h256, std::pair<h256, SharedBytesRef>> m_unknown;	///< For blocks that have an unknown parent; we map their parent hash to the block stuff, and insert once the block appears.
 	h256Hash m_knownBad;												///< Set of blocks that we know will never be valid.
-	std::multimap<unsigned, std::pair<h256, bytes>> m_future;			///< Set of blocks that are not yet valid. Ordered by timestamp
+	std::multimap<unsigned, std::pair<h256, SharedBytesRef>> m_future;	///< Set of blocks that are not yet valid. Ordered by timestamp
 	Signal m_onReady;													///< Called when a subsequent call to import blocks will return a non-empty container. Be nice and exit fast.
 };
 
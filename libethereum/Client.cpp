@@ -215,6 +215,9 @@ Client::Client(p2p::Host* _extNet, std::shared_ptr<GasPricer> _gp, std::string c
 
 Client::~Client()
 {
+	// Their callbacks call back into us, so they go first.
+	m_workServer.reset();
+	m_tq.stopVerification();
 	stopWorking();
 }
 
@@ -404,9 +407,10 @@ MiningProgress Client::miningProgress() const
 
 uint64_t Client::hashrate() const
 {
+	uint64_t ret = m_workServer ? m_workServer->hashrate() : 0;
 	if (m_farm.isMining())
-		return m_farm.miningProgress().rate();
-	return 0;
+		ret += m_farm.miningProgress().rate();
+	return ret;
 }
 
 std::list<MineInfo> Client::miningHistory()
@@ -458,6 +462,11 @@ ProofOfWork::WorkPackage Client::getWork()
 	return ProofOfWork::package(m_miningInfo);
 }
 
+void Client::startWorkServer(unsigned short _port, string const& _address)
+{
+	m_workServer.reset(new WorkServer(_address, _port, [=]() { return getWork(); }, [=](ProofOfWork::Solution const& _s) { return submitWork(_s); }));
+}
+
 bool Client::submitWork(ProofOfWork::Solution const& _solution)
 {
 	bytes newBlock;
@@ -510,8 +519,12 @@ void Client::syncTransactionQueue()
 			m_postMine = m_working;
 
 	DEV_READ_GUARDED(x_postMine)
+	{
+		// The new receipts are for the transactions at the end of the pending list.
+		size_t first = m_postMine.pending().size() - newPendingReceipts.size();
 		for (size_t i = 0; i < newPendingReceipts.size(); i++)
-			appendFromNewPending(newPendingReceipts[i], changeds, m_postMine.pending()[i].sha3());
+			appendFromNewPending(newPendingReceipts[i], changeds, m_postMine.pending()[first + i].sha3());
+	}
 	changeds.insert(PendingChangedFilter);
 
 	// Tell farm about new transaction (i.e. restartProofOfWork mining).
@@ -533,8 +546,8 @@ void Client::onChainChanged(ImportRoute const& _ir)
 		clog(ClientNote) << "Dead block:" << h;
 		for (auto const& t: m_bc.transactions(h))
 		{
-			clog(ClientNote) << "Resubmitting dead-block transaction " << Transaction(t, CheckTransaction::None);
-			m_tq.import(t, TransactionQueue::ImportCallback(), IfDropped::Retry);
+			clog(ClientNote) << "Resubmitting dead-block transaction " << Transaction(t.ref(), CheckTransaction::None);
+			m_tq.import(t.ref(), TransactionQueue::ImportCallback(), IfDropped::Retry);
 		}
 	}
 
@@ -601,7 +614,7 @@ void Client::onChainChanged(ImportRoute const& _ir)
 
 bool Client::remoteActive() const
 {
-	return chrono::system_clock::now() - m_lastGetWork < chrono::seconds(30);
+	return chrono::system_clock::now() - m_lastGetWork < chrono::seconds(30) || (m_workServer && m_workServer->connections());
 }
 
 void Client::onPostStateChanged()
@@ -618,6 +631,8 @@ void Client::onPostStateChanged()
 			m_miningInfo = m_postMine.info();
 		}
 		m_farm.setWork(m_miningInfo);
+		if (m_workServer)
+			m_workServer->setWork(ProofOfWork::package(m_miningInfo));
 	}
 	m_remoteWorking = false;
 }
@@ -716,6 +731,13 @@ State Client::asOf(h256 const& _block) const
 	return State(m_stateDB, bc(), _block);
 }
 
+shared_ptr<StateSnapshot const> Client::snapshot() const
+{
+	ReadGuard l(x_preMine);
+	ReadGuard l2(x_postMine);
+	return make_shared<StateSnapshot>(StateSnapshot{m_preMine, m_postMine});
+}
+
 void Client::prepareForTransaction()
 {
 	startWorking();
@@ -43,6 +43,7 @@
 #include "State.h"
 #include "CommonNet.h"
 #include "Farm.h"
+#include "WorkServer.h"
 #include "ClientBase.h"
 
 namespace dev
@@ -144,6 +145,9 @@ public:
 	/// Get the remaining gas limit in this block.
 	virtual u256 gasLimitRemaining() const { return m_postMine.gasLimitRemaining(); }
 
+	/// Copies the latest and pending states under both of their locks, so the pair is consistent.
+	virtual std::shared_ptr<StateSnapshot const> snapshot() const override;
+
 	// [PRIVATE API - only relevant for base clients, not available in general]
 	dev::eth::State state(unsigned _txi, h256 _block) const;
 	dev::eth::State state(h256 _block) const;
@@ -198,6 +202,11 @@ public:
 	 */
 	virtual bool submitWork(ProofOfWork::Solution const& _proof) override;
 
+	/// Starts pushing work to remote miners connecting to TCP @a _address:@a _port; see WorkServer.
+	void startWorkServer(unsigned short _port, std::string const& _address = "127.0.0.1");
+	/// @returns the work server's statistics on each remote miner; empty if it isn't running.
+	std::map<std::string, WorkerStats> remoteWorkers() const { return m_workServer ? m_workServer->workers() : std::map<std::string, WorkerStats>(); }
+
 	// Debug stuff:
 
 	DownloadMan const* downloadMan() const;
@@ -294,6 +303,7 @@ private:
 	std::weak_ptr<EthereumHost> m_host;		///< Our Ethereum Host. Don't do anything if we can't lock.
 
 	GenericFarm<ProofOfWork> m_farm;		///< Our mining farm.
+	std::unique_ptr<WorkServer> m_workServer;	///< Pushes work to remote miners, if started.
 
 	Handler m_tqReady;
 	Handler m_bqReady;
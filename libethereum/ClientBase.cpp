@@ -36,8 +36,36 @@ const char* WorkInChannel::name() { return EthOrange "⚒" EthGreen "▬▶"; }
 const char* WorkOutChannel::name() { return EthOrange "⚒" EthNavy "◀▬"; }
 const char* WorkChannel::name() { return EthOrange "⚒" EthWhite "  "; }
 
+static thread_local StatePin* s_statePin = nullptr;
+
+StatePin::StatePin(Interface const* _client, shared_ptr<StateSnapshot const> const& _s):
+	m_client(_client),
+	m_latest(_s->latest),
+	m_pending(_s->pending),
+	m_outer(s_statePin)
+{
+	s_statePin = this;
+}
+
+StatePin::~StatePin()
+{
+	s_statePin = m_outer;
+}
+
+State* StatePin::pinned(Interface const* _client, BlockNumber _block)
+{
+	if (_block != PendingBlock && _block != LatestBlock)
+		return nullptr;
+	for (StatePin* p = s_statePin; p; p = p->m_outer)
+		if (p->m_client == _client)
+			return _block == PendingBlock ? &p->m_pending : &p->m_latest;
+	return nullptr;
+}
+
 State ClientBase::asOf(BlockNumber _h) const
 {
+	if (State* s = StatePin::pinned(this, _h))
+		return *s;
 	if (_h == PendingBlock)
 		return postMine();
 	else if (_h == LatestBlock)
@@ -124,32 +152,32 @@ ImportResult ClientBase::injectBlock(bytes const& _block)
 
 u256 ClientBase::balanceAt(Address _a, BlockNumber _block) const
 {
-	return asOf(_block).balance(_a);
+	return withState(_block, [&](State& _s) { return _s.balance(_a); });
 }
 
 u256 ClientBase::countAt(Address _a, BlockNumber _block) const
 {
-	return asOf(_block).transactionsFrom(_a);
+	return withState(_block, [&](State& _s) { return _s.transactionsFrom(_a); });
 }
 
 u256 ClientBase::stateAt(Address _a, u256 _l, BlockNumber _block) const
 {
-	return asOf(_block).storage(_a, _l);
+	return withState(_block, [&](State& _s) { return _s.storage(_a, _l); });
 }
 
 bytes ClientBase::codeAt(Address _a, BlockNumber _block) const
 {
-	return asOf(_block).code(_a);
+	return withState(_block, [&](State& _s) { return _s.code(_a); });
 }
 
 h256 ClientBase::codeHashAt(Address _a, BlockNumber _block) const
 {
-	return asOf(_block).codeHash(_a);
+	return withState(_block, [&](State& _s) { return _s.codeHash(_a); });
 }
 
 unordered_map<u256, u256> ClientBase::storageAt(Address _a, BlockNumber _block) const
 {
-	return asOf(_block).storage(_a);
+	return withState(_block, [&](State& _s) { return _s.storage(_a); });
 }
 
 // TODO: remove try/catch, allow exceptions
@@ -202,13 +230,15 @@ LocalisedLogEntries ClientBase::logs(LogFilter const& _f) const
 		int total = 0;
 		auto h = bc().numberHash(n);
 		auto receipts = bc().receipts(h).receipts;
+		TransactionHashes hashes;
 		for (size_t i = 0; i < receipts.size(); i++)
 		{
 			TransactionReceipt receipt = receipts[i];
 			if (_f.matches(receipt.bloom()))
 			{
-				auto info = bc().info(h);
-				auto th = transaction(info.hash(), i).sha3();
+				if (hashes.empty())
+					hashes = bc().transactionHashes(h);
+				auto th = hashes[i];
 				LogEntries le = _f.matches(receipt);
 				if (le.size())
 				{
@@ -313,7 +343,7 @@ LocalisedLogEntries ClientBase::checkWatch(unsigned _watchId)
 
 BlockInfo ClientBase::blockInfo(h256 _hash) const
 {
-	return BlockInfo(bc().block(_hash));
+	return bc().info(_hash);
 }
 
 BlockDetails ClientBase::blockDetails(h256 _hash) const
@@ -323,13 +353,13 @@ BlockDetails ClientBase::blockDetails(h256 _hash) const
 
 Transaction ClientBase::transaction(h256 _transactionHash) const
 {
-	return Transaction(bc().transaction(_transactionHash), CheckTransaction::Cheap);
+	return Transaction(bc().transaction(_transactionHash).ref(), CheckTransaction::Cheap);
 }
 
 Transaction ClientBase::transaction(h256 _blockHash, unsigned _i) const
 {
-	auto bl = bc().block(_blockHash);
-	RLP b(bl);
+	auto bl = bc().blockData(_blockHash);
+	RLP b(*bl);
 	if (_i < b[1].itemCount())
 		return Transaction(b[1][_i].data(), CheckTransaction::Cheap);
 	else
@@ -343,8 +373,8 @@ pair<h256, unsigned> ClientBase::transactionLocation(h256 const& _transactionHas
 
 Transactions ClientBase::transactions(h256 _blockHash) const
 {
-	auto bl = bc().block(_blockHash);
-	RLP b(bl);
+	auto bl = bc().blockData(_blockHash);
+	RLP b(*bl);
 	Transactions res;
 	for (unsigned i = 0; i < b[1].itemCount(); i++)
 		res.emplace_back(b[1][i].data(), CheckTransaction::Cheap);
@@ -358,8 +388,8 @@ TransactionHashes ClientBase::transactionHashes(h256 _blockHash) const
 
 BlockInfo ClientBase::uncle(h256 _blockHash, unsigned _i) const
 {
-	auto bl = bc().block(_blockHash);
-	RLP b(bl);
+	auto bl = bc().blockData(_blockHash);
+	RLP b(*bl);
 	if (_i < b[2].itemCount())
 		return BlockInfo::fromHeader(b[2][_i].data());
 	else
@@ -373,16 +403,12 @@ UncleHashes ClientBase::uncleHashes(h256 _blockHash) const
 
 unsigned ClientBase::transactionCount(h256 _blockHash) const
 {
-	auto bl = bc().block(_blockHash);
-	RLP b(bl);
-	return b[1].itemCount();
+	return bc().transactionHashes(_blockHash).size();
 }
 
 unsigned ClientBase::uncleCount(h256 _blockHash) const
 {
-	auto bl = bc().block(_blockHash);
-	RLP b(bl);
-	return b[2].itemCount();
+	return bc().uncleHashes(_blockHash).size();
 }
 
 unsigned ClientBase::number() const
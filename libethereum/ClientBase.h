@@ -26,6 +26,7 @@
 #include "Interface.h"
 #include "LogFilter.h"
 #include "TransactionQueue.h"
+#include "State.h"
 
 namespace dev {
 
@@ -69,6 +70,35 @@ struct WorkChannel: public LogChannel { static const char* name(); static const
 #define cworkin LogOutputStream<WorkInChannel, true>()
 #define cworkout LogOutputStream<WorkOutChannel, true>()
 
+/// The latest and pending states of a client, as they stood at a single moment.
+struct StateSnapshot
+{
+	State latest;
+	State pending;
+};
+
+/**
+ * @brief Pins a snapshot to the calling thread for the lifetime of the object.
+ * While alive, queries made on this thread against @a _client for LatestBlock or PendingBlock are
+ * answered from this pin's private copy of the snapshot without touching the client's locks.
+ * Pins nest; the innermost pin for a given client wins.
+ */
+class StatePin
+{
+public:
+	StatePin(Interface const* _client, std::shared_ptr<StateSnapshot const> const& _s);
+	~StatePin();
+
+	/// @returns the pinned state for @a _block on @a _client as seen by the calling thread, or nullptr if none applies.
+	static State* pinned(Interface const* _client, BlockNumber _block);
+
+private:
+	Interface const* m_client;
+	State m_latest;
+	State m_pending;
+	StatePin* m_outer;
+};
+
 class ClientBase: public Interface
 {
 public:
@@ -143,6 +173,8 @@ public:
 	virtual Addresses addresses(BlockNumber _block) const override;
 	virtual u256 gasLimitRemaining() const override;
 
+	virtual std::shared_ptr<StateSnapshot const> snapshot() const override { return std::make_shared<StateSnapshot>(StateSnapshot{preMine(), postMine()}); }
+
 	/// Set the coinbase address
 	virtual void setAddress(Address _us) = 0;
 
@@ -172,6 +204,15 @@ protected:
 	virtual void prepareForTransaction() = 0;
 	/// }
 
+	/// Evaluates @a _f against the state as of @a _block, preferring the calling thread's pinned snapshot.
+	template <class F> auto withState(BlockNumber _block, F const& _f) const -> decltype(_f(std::declval<State&>()))
+	{
+		if (State* s = StatePin::pinned(this, _block))
+			return _f(*s);
+		State s = asOf(_block);
+		return _f(s);
+	}
+
 	TransactionQueue m_tq;							///< Maintains a list of incoming transactions not yet in a block on the blockchain.
 
 	// filters
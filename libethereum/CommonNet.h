@@ -47,6 +47,8 @@ static const unsigned c_maxHashesAsk = 2048;		///< Maximum number of hashes GetB
 static const unsigned c_maxBlocks = 128;		///< Maximum number of blocks Blocks will ever send.
 static const unsigned c_maxBlocksAsk = 128;		///< Maximum number of blocks we ask to receive in Blocks (when using GetChain).
 #endif
+static const size_t c_maxServedBytesPerSecond = 4 * 1024 * 1024;	///< Sustained rate at which we serve Blocks to any one peer.
+static const size_t c_maxServedBytesBurst = 8 * 1024 * 1024;		///< Amount of Blocks a peer may take in one go after being quiet for a while.
 
 class BlockChain;
 class TransactionQueue;
@@ -28,6 +28,20 @@ namespace dev
 namespace eth
 {
 
+/// Byte budgets of the BlockChain's in-memory caches.
+struct CacheBudgets
+{
+	size_t blocks = 16 * 1024 * 1024;
+	size_t headers = 4 * 1024 * 1024;
+	size_t bodyHashes = 4 * 1024 * 1024;
+	size_t details = 8 * 1024 * 1024;
+	size_t logBlooms = 4 * 1024 * 1024;
+	size_t receipts = 8 * 1024 * 1024;
+	size_t transactionAddresses = 4 * 1024 * 1024;
+	size_t blockHashes = 4 * 1024 * 1024;
+	size_t blocksBlooms = 4 * 1024 * 1024;
+};
+
 struct Defaults
 {
 	friend class BlockChain;
@@ -39,9 +53,12 @@ public:
 	static Defaults* get() { if (!s_this) s_this = new Defaults; return s_this; }
 	static void setDBPath(std::string const& _dbPath) { get()->m_dbPath = _dbPath; }
 	static std::string const& dbPath() { return get()->m_dbPath; }
+	static void setCacheBudgets(CacheBudgets const& _budgets) { get()->m_cacheBudgets = _budgets; }
+	static CacheBudgets const& cacheBudgets() { return get()->m_cacheBudgets; }
 
 private:
 	std::string m_dbPath;
+	CacheBudgets m_cacheBudgets;
 
 	static Defaults* s_this;
 };
@@ -24,6 +24,17 @@ using namespace std;
 using namespace dev;
 using namespace dev::eth;
 
+/// How long we'd like a block request to take.
+static const chrono::milliseconds c_targetResponseTime(2000);
+/// No request is called stalled before this long.
+static const chrono::milliseconds c_minDeadline(3000);
+/// Number of blocks asked of a peer whose speed we don't know yet.
+static const unsigned c_initialFetch = 32;
+/// Fewest blocks asked of a peer, however slow.
+static const unsigned c_minFetch = 4;
+/// Weight of the latest response in the smoothed stats.
+static const double c_smoothing = 0.25;
+
 DownloadSub::DownloadSub(DownloadMan& _man): m_man(&_man)
 {
 	WriteGuard l(m_man->x_subs);
@@ -57,12 +68,15 @@ h256Hash DownloadSub::nextFetch(unsigned _n)
 	if (m_asked.empty())
 		m_asked = (~(m_man->taken(true) + m_attempted)).lowest(_n);
 	m_attempted += m_asked;
-	for (auto i: m_asked)
-	{
-		auto x = m_man->m_chain[i];
-		m_remaining.insert(x);
-		m_indices[x] = i;
-	}
+	m_askedAt = chrono::steady_clock::now();
+	DEV_READ_GUARDED(m_man->m_lock)
+		for (auto i: m_asked)
+		{
+			auto x = m_man->m_chain[i];
+			m_remaining.insert(x);
+			m_indices[x] = i;
+		}
+	publishClaim();
 	return m_remaining;
 }
 
@@ -70,8 +84,61 @@ bool DownloadSub::noteBlock(h256 _hash)
 {
 	Guard l(m_fetch);
 	if (m_man && m_indices.count(_hash))
-		m_man->m_blocksGot += m_indices[_hash];
+		DEV_WRITE_GUARDED(m_man->m_lock)
+			m_man->m_blocksGot += m_indices[_hash];
 	bool ret = !!m_remaining.count(_hash);
 	m_remaining.erase(_hash);
+	if (ret && m_remaining.empty())
+		publishClaim();
 	return ret;
 }
+
+void DownloadSub::noteResponse(unsigned _blocks, size_t _bytes)
+{
+	Guard l(m_fetch);
+	auto took = chrono::steady_clock::now() - m_askedAt;
+	if (!m_indices.empty() && took > deadline(m_indices.size()))
+		++m_stats.stalls;
+
+	double rate = _blocks / max(0.001, chrono::duration<double>(took).count());
+	auto latency = chrono::duration_cast<chrono::milliseconds>(took);
+	if (m_stats.responses)
+	{
+		m_stats.blocksPerSecond += c_smoothing * (rate - m_stats.blocksPerSecond);
+		m_stats.latency += chrono::milliseconds((long long)(c_smoothing * (latency - m_stats.latency).count()));
+	}
+	else
+	{
+		m_stats.blocksPerSecond = rate;
+		m_stats.latency = latency;
+	}
+	++m_stats.responses;
+	m_stats.blocks += _blocks;
+	m_stats.bytes += _bytes;
+	publishClaim();
+}
+
+unsigned DownloadSub::fetchSize(unsigned _max) const
+{
+	Guard l(m_fetch);
+	if (!m_stats.responses)
+		return min(_max, c_initialFetch);
+	unsigned n = (unsigned)(m_stats.blocksPerSecond * chrono::duration<double>(c_targetResponseTime).count());
+	return max(min(_max, c_minFetch), min(_max, n));
+}
+
+void DownloadSub::publishClaim()
+{
+	Guard l(x_claim);
+	m_claimed = m_asked;
+	m_claimDeadline = m_remaining.empty() ? chrono::steady_clock::time_point::max() : m_askedAt + deadline(m_indices.size());
+}
+
+chrono::steady_clock::duration DownloadSub::deadline(unsigned _n) const
+{
+	if (!m_stats.responses || m_stats.blocksPerSecond <= 0)
+		return c_minDeadline;
+	// Allow three times as long as the peer's speed suggests.
+	auto expected = chrono::duration<double>(3.0 * _n / m_stats.blocksPerSecond);
+	return max<chrono::steady_clock::duration>(c_minDeadline, chrono::duration_cast<chrono::steady_clock::duration>(expected));
+}
@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <vector>
 #include <unordered_set>
 #include <unordered_map>
@@ -37,6 +38,17 @@ namespace eth
 
 class DownloadMan;
 
+/// Download performance of a single peer.
+struct DownloadStats
+{
+	unsigned responses = 0;					///< Number of block requests answered.
+	unsigned blocks = 0;					///< Number of requested blocks received.
+	size_t bytes = 0;						///< Total size of the responses.
+	unsigned stalls = 0;					///< Number of responses which came after their request's deadline, by which time its blocks were offered to other peers.
+	double blocksPerSecond = 0;				///< Smoothed rate at which requested blocks arrive.
+	std::chrono::milliseconds latency{0};	///< Smoothed time from a request to its response.
+};
+
 class DownloadSub
 {
 	friend class DownloadMan;
@@ -54,6 +66,17 @@ public:
 	/// Nothing doing here.
 	void doneFetch() { resetFetch(); }
 
+	/// Note a response to our last fetch, of @a _blocks of the blocks asked for and @a _bytes in all. Updates the stats.
+	void noteResponse(unsigned _blocks, size_t _bytes);
+
+	/// @returns how many blocks (up to @a _max) to ask for next, so that the response takes around two seconds at the peer's measured speed.
+	unsigned fetchSize(unsigned _max) const;
+
+	/// @returns true iff we've asked for blocks and their deadline, based on the peer's measured speed, has passed.
+	bool isStalled(std::chrono::steady_clock::time_point _now = std::chrono::steady_clock::now()) const { Guard l(m_fetch); return !m_remaining.empty() && _now - m_askedAt > deadline(m_indices.size()); }
+
+	DownloadStats stats() const { Guard l(m_fetch); return m_stats; }
+
 	bool askedContains(unsigned _i) const { Guard l(m_fetch); return m_asked.contains(_i); }
 	RangeMask<unsigned> const& asked() const { return m_asked; }
 	RangeMask<unsigned> const& attemped() const { return m_attempted; }
@@ -66,15 +89,29 @@ private:
 		m_indices.clear();
 		m_asked.reset();
 		m_attempted.reset();
+		publishClaim();
 	}
 
+	/// @returns how long the response to a request for @a _n blocks may take before we call it stalled.
+	std::chrono::steady_clock::duration deadline(unsigned _n) const;
+
+	/// Copies what we've asked for, and when it'll have stalled, to where DownloadMan::taken() can read it. Call with m_fetch held.
+	void publishClaim();
+
 	DownloadMan* m_man = nullptr;
 
 	mutable Mutex m_fetch;
+	DownloadStats m_stats;
+	std::chrono::steady_clock::time_point m_askedAt;	///< When we last asked for blocks.
 	h256Hash m_remaining;
 	std::unordered_map<h256, unsigned> m_indices;
 	RangeMask<unsigned> m_asked;
 	RangeMask<unsigned> m_attempted;
+
+	/// Taken without m_fetch, which a sub may hold while it reads every other sub's claim; LOCK m_fetch first if both are needed.
+	mutable Mutex x_claim;
+	RangeMask<unsigned> m_claimed;							///< m_asked, as of the last change to it.
+	std::chrono::steady_clock::time_point m_claimDeadline;	///< When m_claimed stalls, if it's still outstanding.
 };
 
 class DownloadMan
@@ -115,15 +152,21 @@ public:
 		m_blocksGot.reset();
 	}
 
+	/// @returns the blocks got and, unless @a _desperate, those asked for by peers which haven't stalled.
 	RangeMask<unsigned> taken(bool _desperate = false) const
 	{
 		ReadGuard l(m_lock);
 		auto ret = m_blocksGot;
 		if (!_desperate)
 		{
+			auto now = std::chrono::steady_clock::now();
 			ReadGuard l(x_subs);
 			for (auto i: m_subs)
-				ret += i->m_asked;
+			{
+				Guard l(i->x_claim);
+				if (now <= i->m_claimDeadline)
+					ret += i->m_claimed;
+			}
 		}
 		return ret;
 	}
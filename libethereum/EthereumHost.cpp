@@ -62,8 +62,8 @@ bool EthereumHost::ensureInitialised()
 		m_latestBlockSent = m_chain.currentHash();
 		clog(NetNote) << "Initialising: latest=" << m_latestBlockSent;
 
-		for (auto const& i: m_tq.transactions())
-			m_transactionsSent.insert(i.first);
+		// Don't propagate the transactions we already have.
+		m_tq.transactionsSince(m_transactionsSince);
 		return true;
 	}
 	return false;
@@ -149,7 +149,7 @@ void EthereumHost::reset()
 	m_man.resetToChain(h256s());
 
 	m_latestBlockSent = h256();
-	m_transactionsSent.clear();
+	m_transactionsSince = 0;
 }
 
 void EthereumHost::doWork()
@@ -182,38 +182,60 @@ void EthereumHost::doWork()
 
 void EthereumHost::maintainTransactions()
 {
-	// Send any new transactions.
-	unordered_map<std::shared_ptr<EthereumPeer>, h256s> peerTransactions;
-	auto ts = m_tq.transactions();
-	for (auto const& i: ts)
-	{
-		bool unsent = !m_transactionsSent.count(i.first);
-		for (auto const& p: randomSelection(0, [&](EthereumPeer* p) { return p->m_requireTransactions || (unsent && !p->m_knownTransactions.count(i.first)); }).second)
-			peerTransactions[p].push_back(i.first);
-	}
-	for (auto const& t: ts)
-		m_transactionsSent.insert(t.first);
+	// Only transactions which arrived since the last round are sent on; each is encoded just once.
+	auto fresh = m_tq.transactionsSince(m_transactionsSince);
+	bytes freshRLP;
+	for (auto const& t: fresh)
+		freshRLP += t.second;
+
+	// Peers which asked for our transactions get all of them.
+	bytes allRLP;
+	unsigned allCount = 0;
+	bool haveAll = false;
+
 	for (auto p: peerSessions())
 		if (auto ep = p.first->cap<EthereumPeer>())
 		{
-			bytes b;
-			unsigned n = 0;
-			for (auto const& h: peerTransactions[ep])
+			RLPStream ts;
+			if (ep->m_requireTransactions)
 			{
-				ep->m_knownTransactions.insert(h);
-				b += ts[h].rlp();
-				++n;
+				if (!haveAll)
+				{
+					for (auto const& t: m_tq.transactions())
+					{
+						allRLP += t.second.rlp();
+						++allCount;
+					}
+					haveAll = true;
+				}
+				ep->prep(ts, TransactionsPacket, allCount).appendRaw(allRLP, allCount);
+				ep->m_requireTransactions = false;
 			}
-
-			ep->clearKnownTransactions();
-
-			if (n || ep->m_requireTransactions)
+			else
 			{
-				RLPStream ts;
-				ep->prep(ts, TransactionsPacket, n).appendRaw(b, n);
-				ep->sealAndSend(ts);
+				vector<unsigned> unknown;
+				DEV_GUARDED(ep->x_knownTransactions)
+					for (unsigned i = 0; i < fresh.size(); ++i)
+						if (!ep->m_knownTransactions.contains(fresh[i].first))
+						{
+							ep->m_knownTransactions.insert(fresh[i].first);
+							unknown.push_back(i);
+						}
+				if (unknown.empty())
+					continue;
+
+				// Usually the peer knows none of them and gets the batch as built; otherwise it gets its own.
+				if (unknown.size() == fresh.size())
+					ep->prep(ts, TransactionsPacket, fresh.size()).appendRaw(freshRLP, fresh.size());
+				else
+				{
+					bytes b;
+					for (auto i: unknown)
+						b += fresh[i].second;
+					ep->prep(ts, TransactionsPacket, unknown.size()).appendRaw(b, unknown.size());
+				}
 			}
-			ep->m_requireTransactions = false;
+			ep->sealAndSend(ts);
 		}
 }
 
@@ -257,7 +279,7 @@ void EthereumHost::maintainBlocks(h256 const& _currentHash)
 				for (auto const& b: blocks)
 				{
 					RLPStream ts;
-					p->prep(ts, NewBlockPacket, 2).appendRaw(m_chain.block(b), 1).append(m_chain.details(b).totalDifficulty);
+					p->prep(ts, NewBlockPacket, 2).appendRaw(*m_chain.blockData(b), 1).append(m_chain.details(b).totalDifficulty);
 
 					Guard l(p->x_knownBlocks);
 					p->sealAndSend(ts);
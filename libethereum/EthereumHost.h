@@ -121,7 +121,7 @@ private:
 	DownloadMan m_man;
 
 	h256 m_latestBlockSent;
-	h256Hash m_transactionsSent;
+	unsigned m_transactionsSince = 0;		///< Cursor into m_tq's arrivals; those before it have been propagated.
 
 	std::unordered_set<p2p::NodeId> m_banned;
 
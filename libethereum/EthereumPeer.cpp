@@ -23,6 +23,7 @@
 
 #include <chrono>
 #include <libdevcore/Common.h>
+#include <libdevcore/CommonIO.h>
 #include <libethcore/Exceptions.h>
 #include <libp2p/Session.h>
 #include "BlockChain.h"
@@ -152,7 +153,7 @@ void EthereumPeer::transition(Asking _a, bool _force)
 		{
 			// Looks like it's the best yet for total difficulty. Set to download.
 			setAsking(Asking::Blocks, isSyncing());		// will kick off other peers to help if available.
-			auto blocks = m_sub.nextFetch(c_maxBlocksAsk);
+			auto blocks = m_sub.nextFetch(m_sub.fetchSize(c_maxBlocksAsk));
 			if (blocks.size())
 			{
 				prep(s, GetBlocksPacket, blocks.size());
@@ -237,6 +238,48 @@ void EthereumPeer::tick()
 	if (chrono::system_clock::now() - m_lastAsk > chrono::seconds(10) && m_asking != Asking::Nothing)
 		// timeout
 		session()->disconnect(PingTimeout);
+
+	DEV_GUARDED(x_serving)
+		if (!m_deferredGetBlocks.empty())
+		{
+			m_serveThrottle.refill();
+			if (m_serveThrottle.mayServe())
+			{
+				h256s hashes;
+				swap(hashes, m_deferredGetBlocks);
+				serveBlocks_WITH_LOCK(hashes);
+			}
+		}
+}
+
+void EthereumPeer::serveBlocks_WITH_LOCK(h256s const& _hashes)
+{
+	// gather the requested blocks as they're held by the chain; they're copied only into the outgoing frame.
+	vector<SharedBytes> blocks;
+	vector<bytesConstRef> payload;
+	size_t payloadSize = 0;
+	unsigned i = 0;
+	for (; i < _hashes.size() && m_serveThrottle.mayServe(); ++i)
+		if (SharedBytes b = host()->m_chain.findBlockData(_hashes[i]))
+		{
+			payload.push_back(&*b);
+			payloadSize += b->size();
+			m_serveThrottle.charge(b->size());
+			blocks.push_back(move(b));
+		}
+	unsigned n = blocks.size();
+	if (_hashes.size() > 20 && n == 0 && i == _hashes.size())
+		clog(NetWarn) << "all" << _hashes.size() << "unknown blocks requested; peer on different chain?";
+	else
+		clog(NetMessageSummary) << n << "blocks known and returned;" << (i - n) << "blocks unknown;" << (_hashes.size() - i) << "blocks throttled";
+
+	m_blocksServed += n;
+	m_bytesServed += payloadSize;
+	session()->addNote("served", toString(m_blocksServed) + " blocks, " + toString(m_bytesServed / 1024) + " KB");
+
+	RLPStream s;
+	prepGathered(s, BlocksPacket, payloadSize);
+	sealAndSend(s, payload);
 }
 
 bool EthereumPeer::isSyncing() const
@@ -294,6 +337,13 @@ void EthereumPeer::attemptSync()
 	}
 }
 
+void ServeThrottle::refill(Clock::time_point _now)
+{
+	auto elapsed = chrono::duration_cast<chrono::milliseconds>(_now - m_refilled).count();
+	m_allowance = min<int64_t>(c_maxServedBytesBurst, m_allowance + elapsed * c_maxServedBytesPerSecond / 1000);
+	m_refilled = _now;
+}
+
 bool EthereumPeer::interpret(unsigned _id, RLP const& _r)
 {
 	try
@@ -330,27 +380,22 @@ bool EthereumPeer::interpret(unsigned _id, RLP const& _r)
 	{
 		unsigned itemCount = _r.itemCount();
 		clog(NetAllDetail) << "Transactions (" << dec << itemCount << "entries)";
+		// Our verifiers rate them once they've been checked; the peer may be gone by then.
+		weak_ptr<Session> s = session()->shared_from_this();
+		auto rate = [s](ImportResult _ir)
+		{
+			if (auto p = s.lock())
+				if (_ir == ImportResult::Malformed || _ir == ImportResult::Success)
+					p->postRating(_ir == ImportResult::Malformed ? -100 : 100);
+		};
 		Guard l(x_knownTransactions);
 		for (unsigned i = 0; i < itemCount; ++i)
 		{
 			auto h = sha3(_r[i].data());
 			m_knownTransactions.insert(h);
-			ImportResult ir = host()->m_tq.import(_r[i].data());
-			switch (ir)
-			{
-			case ImportResult::Malformed:
-				addRating(-100);
-				break;
-			case ImportResult::AlreadyKnown:
-				// if we already had the transaction, then don't bother sending it on.
-				host()->m_transactionsSent.insert(h);
+			if (host()->m_tq.enqueue(_r[i].data(), rate) == ImportResult::AlreadyKnown)
+				// we already had the transaction, so it's not new and won't be sent on.
 				addRating(0);
-				break;
-			case ImportResult::Success:
-				addRating(100);
-				break;
-			default:;
-			}
 		}
 		break;
 	}
@@ -430,27 +475,29 @@ bool EthereumPeer::interpret(unsigned _id, RLP const& _r)
 			addRating(-10);
 			break;
 		}
-		// return the requested blocks.
-		bytes rlp;
-		unsigned n = 0;
-		for (unsigned i = 0; i < min(count, c_maxBlocks); ++i)
+		unsigned limit = min(count, c_maxBlocks);
+		if (count > limit)
+			clog(NetMessageSummary) << (count - limit) << "blocks ignored";
+		h256s hashes;
+		hashes.reserve(limit);
+		for (unsigned i = 0; i < limit; ++i)
+			hashes.push_back(_r[i].toHash<h256>());
+
+		addRating(0);
+		Guard l(x_serving);
+		// top up the peer's serving allowance for the time since it was last asked.
+		m_serveThrottle.refill();
+		if (m_serveThrottle.mayServe())
 		{
-			auto h = _r[i].toHash<h256>();
-			if (host()->m_chain.isKnown(h))
-			{
-				rlp += host()->m_chain.block(_r[i].toHash<h256>());
-				++n;
-			}
+			m_deferredGetBlocks.clear();
+			serveBlocks_WITH_LOCK(hashes);
 		}
-		if (count > 20 && n == 0)
-			clog(NetWarn) << "all" << count << "unknown blocks requested; peer on different chain?";
 		else
-			clog(NetMessageSummary) << n << "blocks known and returned;" << (min(count, c_maxBlocks) - n) << "blocks unknown;" << (count > c_maxBlocks ? count - c_maxBlocks : 0) << "blocks ignored";
-
-		addRating(0);
-		RLPStream s;
-		prep(s, BlocksPacket, n).appendRaw(rlp, n);
-		sealAndSend(s);
+		{
+			// a peer asks again only once answered, so this replaces at most a request it's given up on.
+			clog(NetMessageSummary) << "Allowance spent; answering once it has refilled.";
+			m_deferredGetBlocks = move(hashes);
+		}
 		break;
 	}
 	case BlocksPacket:
@@ -473,14 +520,16 @@ bool EthereumPeer::interpret(unsigned _id, RLP const& _r)
 		unsigned unknown = 0;
 		unsigned got = 0;
 		unsigned repeated = 0;
+		unsigned requested = 0;
 
 		for (unsigned i = 0; i < itemCount; ++i)
 		{
 			auto h = BlockInfo::headerHash(_r[i].data());
 			if (m_sub.noteBlock(h))
 			{
+				++requested;
 				addRating(10);
-				switch (host()->m_bq.import(_r[i].data(), host()->m_chain))
+				switch (host()->m_bq.import(session()->retain(_r[i].data()), host()->m_chain))
 				{
 				case ImportResult::Success:
 					success++;
@@ -516,6 +565,10 @@ bool EthereumPeer::interpret(unsigned _id, RLP const& _r)
 
 		clog(NetMessageSummary) << dec << success << "imported OK," << unknown << "with unknown parents," << future << "with future timestamps," << got << " already known," << repeated << " repeats received.";
 
+		m_sub.noteResponse(requested, _r.data().size());
+		auto st = m_sub.stats();
+		session()->addNote("download", toString((unsigned)st.blocksPerSecond) + " blocks/s, " + toString(st.latency.count()) + " ms, " + toString(st.stalls) + " stalls");
+
 		if (m_asking == Asking::Blocks)
 		{
 			if (!got)
@@ -534,7 +587,7 @@ bool EthereumPeer::interpret(unsigned _id, RLP const& _r)
 			disable("NewBlock without 2 data fields.");
 		else
 		{
-			switch (host()->m_bq.import(_r[0].data(), host()->m_chain))
+			switch (host()->m_bq.import(session()->retain(_r[0].data()), host()->m_chain))
 			{
 			case ImportResult::Success:
 				addRating(100);
@@ -23,6 +23,7 @@
 
 #include <mutex>
 #include <array>
+#include <chrono>
 #include <memory>
 #include <utility>
 
@@ -32,6 +33,7 @@
 #include <libdevcore/RLP.h>
 #include <libdevcore/Guards.h>
 #include <libdevcore/RangeMask.h>
+#include <libdevcore/RollingBloom.h>
 #include <libethcore/Common.h>
 #include <libp2p/Capability.h>
 #include "CommonNet.h"
@@ -42,6 +44,33 @@ namespace dev
 namespace eth
 {
 
+/**
+ * @brief Meters the bytes of Blocks served to a peer: an allowance of up to c_maxServedBytesBurst, refilled at
+ * c_maxServedBytesPerSecond, which serving a block draws down (the last block of a reply perhaps taking it below
+ * zero, though never into more than c_maxServedBytesBurst of debt).
+ * A GetBlocks which finds the allowance spent isn't answered until it has refilled: an empty Blocks says
+ * "no more blocks" and would end the peer's sync with us.
+ */
+class ServeThrottle
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	explicit ServeThrottle(Clock::time_point _now = Clock::now()): m_refilled(_now) {}
+
+	/// Tops up the allowance for the time since it was last topped up.
+	void refill(Clock::time_point _now = Clock::now());
+	/// @returns true iff another block may be served.
+	bool mayServe() const { return m_allowance > 0; }
+	/// Draws @a _bytes from the allowance.
+	void charge(size_t _bytes) { m_allowance = std::max<int64_t>(m_allowance - _bytes, -int64_t(c_maxServedBytesBurst)); }
+	int64_t allowance() const { return m_allowance; }
+
+private:
+	int64_t m_allowance = c_maxServedBytesBurst;
+	Clock::time_point m_refilled;
+};
+
 /**
  * @brief The EthereumPeer class
  * @todo Document fully.
@@ -85,9 +114,6 @@ private:
 	/// Abort the sync operation.
 	void abortSync();
 
-	/// Clear all known transactions.
-	void clearKnownTransactions() { std::lock_guard<std::mutex> l(x_knownTransactions); m_knownTransactions.clear(); }
-
 	/// Update our asking state.
 	void setAsking(Asking _g, bool _isSyncing);
 
@@ -107,6 +133,9 @@ private:
 	/// Runs period checks to check up on the peer.
 	void tick();
 
+	/// Sends the peer the blocks of @a _hashes we have, as far as m_serveThrottle allows. Must hold x_serving.
+	void serveBlocks_WITH_LOCK(h256s const& _hashes);
+
 	/// Peer's protocol version.
 	unsigned m_protocolVersion;
 	/// Peer's network id.
@@ -138,10 +167,17 @@ private:
 	/// Have we received a GetTransactions packet that we haven't yet answered?
 	bool m_requireTransactions = false;
 
+	/// Limits how fast we serve the peer Blocks.
+	Mutex x_serving;							///< Guards the below; GetBlocks are answered by interpret() or, once deferred, tick().
+	ServeThrottle m_serveThrottle;
+	h256s m_deferredGetBlocks;					///< Hashes of the GetBlocks awaiting m_serveThrottle's refill, if any.
+	uint64_t m_blocksServed = 0;				///< Total blocks sent to the peer in answer to GetBlocks.
+	uint64_t m_bytesServed = 0;					///< Total bytes of those blocks.
+
 	Mutex x_knownBlocks;
 	h256Hash m_knownBlocks;					///< Blocks that the peer already knows about (that don't need to be sent to them).
 	Mutex x_knownTransactions;
-	h256Hash m_knownTransactions;			///< Transactions that the peer already knows of.
+	RollingBloom<> m_knownTransactions;		///< Transactions that the peer (probably) already knows of; recent ones are never forgotten.
 
 };
 
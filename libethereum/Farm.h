@@ -115,9 +115,14 @@ public:
 		{
 			ReadGuard l2(x_minerWork);
 			for (auto const& i: m_miners)
-				p.hashes += i->hashCount();
+			{
+				uint64_t h = i->hashCount();
+				p.hashes += h;
+				if (i->numaNode() >= 0)
+					p.nodeHashes[i->numaNode()] += h;
+			}
 		}
-		ReadGuard l(x_progress);
+		WriteGuard l(x_progress);
 		m_progress = p;
 		return m_progress;
 	}
@@ -39,6 +39,8 @@ namespace eth
 using TransactionHashes = h256s;
 using UncleHashes = h256s;
 
+struct StateSnapshot;
+
 enum class Reaping
 {
 	Automatic,
@@ -178,6 +180,9 @@ public:
 	virtual Addresses addresses() const { return addresses(m_default); }
 	virtual Addresses addresses(BlockNumber _block) const = 0;
 
+	/// @returns a consistent copy of the latest and pending states, for use with StatePin; null if unsupported.
+	virtual std::shared_ptr<StateSnapshot const> snapshot() const { return nullptr; }
+
 	/// Get the remaining gas limit in this block.
 	virtual u256 gasLimitRemaining() const = 0;
 
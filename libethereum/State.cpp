@@ -46,6 +46,8 @@ using namespace dev::eth;
 #define ETH_TIMED_ENACTMENTS 0
 
 static const u256 c_blockReward = 1500 * finney;
+/// The most transactions State::sync() considers in one round.
+static const unsigned c_maxSyncTransactions = 1024;
 
 const char* StateSafeExceptions::name() { return EthViolet "⚙" EthBlue " ℹ"; }
 const char* StateDetail::name() { return EthViolet "⚙" EthWhite " ◌"; }
@@ -134,7 +136,7 @@ State::State(OverlayDB const& _db, BlockChain const& _bc, h256 _h):
 
 		// 1. Start at parent's end state (state root).
 		BlockInfo bip;
-		bip.populate(_bc.block(bi.parentHash));
+		bip = _bc.info(bi.parentHash);
 		sync(_bc, bi.parentHash, bip);
 
 		// 2. Enact the block's transactions onto this state.
@@ -194,6 +196,7 @@ State& State::operator=(State const& _s)
 	m_ourAddress = _s.m_ourAddress;
 	m_blockReward = _s.m_blockReward;
 	m_lastTx = _s.m_lastTx;
+	resetPendingTries();
 	paranoia("after state cloning (assignment op)", true);
 
 	m_committedToMine = false;
@@ -349,7 +352,7 @@ bool State::sync(BlockChain const& _bc, h256 _block, BlockInfo const& _bi, Impor
 		while (bi.number != 0 && m_db.lookup(bi.stateRoot).empty())	// while we don't have the state root of the latest block...
 		{
 			chain.push_back(bi.hash());				// push back for later replay.
-			bi.populate(_bc.block(bi.parentHash));	// move to parent.
+			bi = _bc.info(bi.parentHash);	// move to parent.
 		}
 
 		m_previousBlock = bi;
@@ -447,6 +450,7 @@ void State::resetCurrent()
 	m_transactions.clear();
 	m_receipts.clear();
 	m_transactionSet.clear();
+	resetPendingTries();
 	m_cache.clear();
 	m_currentBlock = BlockInfo();
 	m_currentBlock.coinbaseAddress = m_ourAddress;
@@ -472,82 +476,82 @@ pair<TransactionReceipts, bool> State::sync(BlockChain const& _bc, TransactionQu
 	pair<TransactionReceipts, bool> ret;
 	ret.second = false;
 
-	auto ts = _tq.transactions();
-
 	LastHashes lh;
 
 	auto deadline =  chrono::steady_clock::now() + chrono::milliseconds(msTimeout);
 
+	// Each round takes the best of what's not yet in the block, senders' transactions in nonce order. Another round
+	// is needed only if executing some let future transactions into the queue.
 	for (int goodTxs = 1; goodTxs; )
 	{
 		goodTxs = 0;
-		for (auto const& i: ts)
-			if (!m_transactionSet.count(i.first))
+		for (auto const& t: _tq.topTransactions(c_maxSyncTransactions, m_transactionSet))
+		{
+			auto i = make_pair(t.sha3(), t);
+			try
 			{
-				try
+				if (i.second.gasPrice() >= _gp.ask(*this))
 				{
-					if (i.second.gasPrice() >= _gp.ask(*this))
-					{
 	//					boost::timer t;
-						if (lh.empty())
-							lh = _bc.lastHashes();
-						execute(lh, i.second);
-						ret.first.push_back(m_receipts.back());
-						_tq.noteGood(i);
-						++goodTxs;
+					if (lh.empty())
+						lh = _bc.lastHashes();
+					execute(lh, i.second);
+					ret.first.push_back(m_receipts.back());
+					_tq.noteGood(i);
+					++goodTxs;
 	//					cnote << "TX took:" << t.elapsed() * 1000;
-					}
-					else if (i.second.gasPrice() < _gp.ask(*this) * 9 / 10)
-					{
-						// less than 90% of our ask price for gas. drop.
-						cnote << i.first << "Dropping El Cheapo transaction (<90% of ask price)";
-						_tq.drop(i.first);
-					}
 				}
-				catch (InvalidNonce const& in)
+				else if (i.second.gasPrice() < _gp.ask(*this) * 9 / 10)
 				{
-					bigint const& req = *boost::get_error_info<errinfo_required>(in);
-					bigint const& got = *boost::get_error_info<errinfo_got>(in);
-
-					if (req > got)
-					{
-						// too old
-						cnote << i.first << "Dropping old transaction (nonce too low)";
-						_tq.drop(i.first);
-					}
-					else if (got > req + 25)
-					{
-						// too new
-						cnote << i.first << "Dropping new transaction (> 25 nonces ahead)";
-						_tq.drop(i.first);
-					}
-					else
-						_tq.setFuture(i);
+					// less than 90% of our ask price for gas. drop.
+					cnote << i.first << "Dropping El Cheapo transaction (<90% of ask price)";
+					_tq.drop(i.first);
 				}
-				catch (BlockGasLimitReached const& e)
+			}
+			catch (InvalidNonce const& in)
+			{
+				bigint const& req = *boost::get_error_info<errinfo_required>(in);
+				bigint const& got = *boost::get_error_info<errinfo_got>(in);
+
+				if (req > got)
 				{
-					bigint const& got = *boost::get_error_info<errinfo_got>(e);
-					if (got > m_currentBlock.gasLimit)
-					{
-						cnote << i.first << "Dropping over-gassy transaction (gas > block's gas limit)";
-						_tq.drop(i.first);
-					}
-					else
-						_tq.setFuture(i);
+					// too old
+					cnote << i.first << "Dropping old transaction (nonce too low)";
+					_tq.drop(i.first);
 				}
-				catch (Exception const& _e)
+				else if (got > req + 25)
 				{
-					// Something else went wrong - drop it.
-					cnote << i.first << "Dropping invalid transaction:" << diagnostic_information(_e);
+					// too new
+					cnote << i.first << "Dropping new transaction (> 25 nonces ahead)";
 					_tq.drop(i.first);
 				}
-				catch (std::exception const&)
+				else
+					_tq.setFuture(i);
+			}
+			catch (BlockGasLimitReached const& e)
+			{
+				bigint const& got = *boost::get_error_info<errinfo_got>(e);
+				if (got > m_currentBlock.gasLimit)
 				{
-					// Something else went wrong - drop it.
+					cnote << i.first << "Dropping over-gassy transaction (gas > block's gas limit)";
 					_tq.drop(i.first);
-					cnote << i.first << "Transaction caused low-level exception :(";
 				}
+				else
+					_tq.setFuture(i);
+			}
+			catch (Exception const& _e)
+			{
+				// Something else went wrong - drop it.
+				cnote << i.first << "Dropping invalid transaction:" << diagnostic_information(_e);
+				_tq.drop(i.first);
+			}
+			catch (std::exception const&)
+			{
+				// Something else went wrong - drop it.
+				_tq.drop(i.first);
+				cnote << i.first << "Transaction caused low-level exception :(";
 			}
+		}
 		if (chrono::steady_clock::now() > deadline)
 		{
 			ret.second = true;
@@ -663,7 +667,7 @@ u256 State::enact(bytesConstRef _block, BlockChain const& _bc, ImportRequirement
 		if (nonces.count(uncle.nonce))
 			BOOST_THROW_EXCEPTION(DuplicateUncleNonce());
 
-		BlockInfo uncleParent(_bc.block(uncle.parentHash));
+		BlockInfo uncleParent = _bc.info(uncle.parentHash);
 		if ((bigint)uncleParent.number < (bigint)m_currentBlock.number - 7)
 			BOOST_THROW_EXCEPTION(UncleTooOld());
 		uncle.verifyParent(uncleParent);
@@ -797,6 +801,55 @@ LogBloom State::logBloom() const
 	return ret;
 }
 
+void State::resetPendingTries()
+{
+	m_pendingTrieTxs = 0;
+	m_transactionsTrieDB = MemoryDB();
+	m_receiptsTrieDB = MemoryDB();
+	m_transactionsTrieRoot = m_receiptsTrieRoot = h256();
+	m_pendingTxsData.clear();
+	m_pendingBloom = LogBloom();
+}
+
+void State::updatePendingTries()
+{
+	GenericTrieDB<MemoryDB> transactionsTrie(&m_transactionsTrieDB);
+	GenericTrieDB<MemoryDB> receiptsTrie(&m_receiptsTrieDB);
+	if (!m_pendingTrieTxs || m_pendingTrieTxs > m_transactions.size())
+	{
+		resetPendingTries();
+		transactionsTrie.init();
+		receiptsTrie.init();
+	}
+	else
+	{
+		transactionsTrie.setRoot(m_transactionsTrieRoot, Verification::Skip);
+		receiptsTrie.setRoot(m_receiptsTrieRoot, Verification::Skip);
+	}
+
+	// Only the paths to the new entries get rehashed.
+	for (unsigned i = m_pendingTrieTxs; i < m_transactions.size(); ++i)
+	{
+		RLPStream k;
+		k << i;
+
+		RLPStream receiptrlp;
+		m_receipts[i].streamRLP(receiptrlp);
+		receiptsTrie.insert(&k.out(), &receiptrlp.out());
+
+		RLPStream txrlp;
+		m_transactions[i].streamRLP(txrlp);
+		transactionsTrie.insert(&k.out(), &txrlp.out());
+
+		m_pendingTxsData += txrlp.out();
+		m_pendingBloom |= m_receipts[i].bloom();
+	}
+
+	m_pendingTrieTxs = m_transactions.size();
+	m_transactionsTrieRoot = transactionsTrie.root();
+	m_receiptsTrieRoot = receiptsTrie.root();
+}
+
 void State::commitToMine(BlockChain const& _bc)
 {
 	uncommitToMine();
@@ -826,7 +879,7 @@ void State::commitToMine(BlockChain const& _bc)
 			for (auto const& u: us)
 				if (!knownUncles.count(u))	// ignore any uncles/mainline blocks that we know about.
 				{
-					BlockInfo ubi(_bc.block(u));
+					BlockInfo ubi = _bc.info(u);
 					ubi.streamRLP(unclesData, WithNonce);
 					++unclesCount;
 					uncleBlockHeaders.push_back(ubi);
@@ -836,40 +889,14 @@ void State::commitToMine(BlockChain const& _bc)
 		}
 	}
 
-	MemoryDB tm;
-	GenericTrieDB<MemoryDB> transactionsTrie(&tm);
-	transactionsTrie.init();
-
-	MemoryDB rm;
-	GenericTrieDB<MemoryDB> receiptsTrie(&rm);
-	receiptsTrie.init();
-
-	RLPStream txs;
-	txs.appendList(m_transactions.size());
-
-	for (unsigned i = 0; i < m_transactions.size(); ++i)
-	{
-		RLPStream k;
-		k << i;
-
-		RLPStream receiptrlp;
-		m_receipts[i].streamRLP(receiptrlp);
-		receiptsTrie.insert(&k.out(), &receiptrlp.out());
-
-		RLPStream txrlp;
-		m_transactions[i].streamRLP(txrlp);
-		transactionsTrie.insert(&k.out(), &txrlp.out());
-
-		txs.appendRaw(txrlp.out());
-	}
-
-	txs.swapOut(m_currentTxs);
+	updatePendingTries();
+	RLPStream(m_transactions.size()).appendRaw(m_pendingTxsData, m_transactions.size()).swapOut(m_currentTxs);
 
 	RLPStream(unclesCount).appendRaw(unclesData.out(), unclesCount).swapOut(m_currentUncles);
 
-	m_currentBlock.transactionsRoot = transactionsTrie.root();
-	m_currentBlock.receiptsRoot = receiptsTrie.root();
-	m_currentBlock.logBloom = logBloom();
+	m_currentBlock.transactionsRoot = m_transactionsTrieRoot;
+	m_currentBlock.receiptsRoot = m_receiptsTrieRoot;
+	m_currentBlock.logBloom = m_pendingBloom;
 	m_currentBlock.sha3Uncles = sha3(m_currentUncles);
 
 	// Apply rewards last of all.
@@ -915,6 +942,7 @@ void State::completeMine()
 	m_transactions.clear();
 	m_receipts.clear();
 	m_transactionSet.clear();
+	resetPendingTries();
 	m_lastTx = m_db;
 }
 
@@ -342,6 +342,12 @@ private:
 	/// Finalise the block, applying the earned rewards.
 	void applyRewards(std::vector<BlockInfo> const& _uncleBlockHeaders);
 
+	/// Forgets the incrementally-built tries of the pending transactions; they'll be rebuilt from scratch when next needed.
+	void resetPendingTries();
+	/// Brings the transactions and receipts tries, the transaction list RLP and the log bloom up to date with any
+	/// transactions executed since they were last updated.
+	void updatePendingTries();
+
 	/// @returns gas used by transactions thus far executed.
 	u256 gasUsed() const { return m_receipts.size() ? m_receipts.back().gasUsed() : 0; }
 
@@ -367,6 +373,15 @@ private:
 	bytes m_currentTxs;							///< The RLP-encoded block of transactions.
 	bytes m_currentUncles;						///< The RLP-encoded block of uncles.
 
+	// Built up as transactions are added so that commitToMine() need only deal with the new ones. Never copied.
+	unsigned m_pendingTrieTxs = 0;				///< How many of m_transactions the following cover.
+	MemoryDB m_transactionsTrieDB;				///< Backing for the trie of m_transactions by index.
+	MemoryDB m_receiptsTrieDB;					///< Backing for the trie of m_receipts by index.
+	h256 m_transactionsTrieRoot;
+	h256 m_receiptsTrieRoot;
+	bytes m_pendingTxsData;						///< The concatenated RLP of the transactions.
+	LogBloom m_pendingBloom;					///< The combined bloom of the receipts.
+
 	Address m_ourAddress;						///< Our address (i.e. the address to which fees go).
 
 	u256 m_blockReward;
@@ -381,47 +396,72 @@ std::ostream& operator<<(std::ostream& _out, State const& _s);
 template <class DB>
 void commit(std::unordered_map<Address, Account> const& _cache, DB& _db, SecureTrieDB<Address, DB>& _state)
 {
+	// Trie keys are hashes of addresses and storage slots; work them out in batches rather than one by one.
+	std::vector<std::pair<Address const, Account> const*> dirty;
+	std::vector<bytesConstRef> addresses;
 	for (auto const& i: _cache)
 		if (i.second.isDirty())
 		{
-			if (!i.second.isAlive())
-				_state.remove(i.first);
-			else
-			{
-				RLPStream s(4);
-				s << i.second.nonce() << i.second.balance();
+			dirty.push_back(&i);
+			addresses.push_back(i.first.ref());
+		}
+	h256s addressHashes = sha3Batch(addresses);
 
-				if (i.second.storageOverlay().empty())
-				{
-					assert(i.second.baseRoot());
-					s.append(i.second.baseRoot());
-				}
-				else
-				{
-					SecureTrieDB<h256, DB> storageDB(&_db, i.second.baseRoot());
-					for (auto const& j: i.second.storageOverlay())
-						if (j.second)
-							storageDB.insert(j.first, rlp(j.second));
-						else
-							storageDB.remove(j.first);
-					assert(storageDB.root());
-					s.append(storageDB.root());
-				}
+	for (size_t k = 0; k < dirty.size(); ++k)
+	{
+		auto const& i = *dirty[k];
+		if (!i.second.isAlive())
+			_state.removeHashed(i.first, addressHashes[k]);
+		else
+		{
+			RLPStream s(4);
+			s << i.second.nonce() << i.second.balance();
 
-				if (i.second.isFreshCode())
+			if (i.second.storageOverlay().empty())
+			{
+				assert(i.second.baseRoot());
+				s.append(i.second.baseRoot());
+			}
+			else
+			{
+				h256s slots;
+				for (auto const& j: i.second.storageOverlay())
+					slots.push_back(j.first);
+				std::vector<bytesConstRef> slotRefs;
+				for (auto const& j: slots)
+					slotRefs.push_back(j.ref());
+				h256s slotHashes = sha3Batch(slotRefs);
+
+				SecureTrieDB<h256, DB> storageDB(&_db, i.second.baseRoot());
+				size_t n = 0;
+				for (auto const& j: i.second.storageOverlay())
 				{
-					h256 ch = sha3(i.second.code());
-					_db.insert(ch, &i.second.code());
-					s << ch;
+					if (j.second)
+					{
+						bytes v = rlp(j.second);
+						storageDB.insertHashed(slots[n], slotHashes[n], &v);
+					}
+					else
+						storageDB.removeHashed(slots[n], slotHashes[n]);
+					++n;
 				}
-				else
-					s << i.second.codeHash();
+				assert(storageDB.root());
+				s.append(storageDB.root());
+			}
 
-				_state.insert(i.first, &s.out());
+			if (i.second.isFreshCode())
+			{
+				h256 ch = sha3(i.second.code());
+				_db.insert(ch, &i.second.code());
+				s << ch;
 			}
+			else
+				s << i.second.codeHash();
+
+			_state.insertHashed(i.first, addressHashes[k], &s.out());
 		}
+	}
 }
-
 }
 }
 
@@ -30,22 +30,113 @@ using namespace dev::eth;
 
 const char* TransactionQueueChannel::name() { return EthCyan "┉┅▶"; }
 
+TransactionQueue::TransactionQueue(unsigned _limit):
+	m_limit(_limit),
+	m_verifier(new ThreadPool(c_verifierThreads, "txverify"))
+{
+}
+
+TransactionQueue::~TransactionQueue()
+{
+	stopVerification();
+}
+
 ImportResult TransactionQueue::import(bytesConstRef _transactionRLP, ImportCallback const& _cb, IfDropped _ik)
 {
 	// Check if we already know this transaction.
 	h256 h = sha3(_transactionRLP);
+	{
+		ReadGuard l(m_lock);
+		auto ir = check_WITH_LOCK(h, _ik);
+		if (ir != ImportResult::Success)
+			return ir;
+	}
 
-	UpgradableGuard l(m_lock);
+	// Recover the sender before taking the lock for writing; it's by far the most costly part.
+	Transaction t;
+	try
+	{
+		t = Transaction(_transactionRLP, CheckTransaction::Everything);
+	}
+	catch (Exception const& _e)
+	{
+		ctxq << "Ignoring invalid transaction: " << diagnostic_information(_e);
+		return ImportResult::Malformed;
+	}
+	catch (std::exception const& _e)
+	{
+		ctxq << "Ignoring invalid transaction: " << _e.what();
+		return ImportResult::Malformed;
+	}
 
+	UpgradableGuard l(m_lock);
+	// Someone else may have imported it meanwhile.
 	auto ir = check_WITH_LOCK(h, _ik);
 	if (ir != ImportResult::Success)
 		return ir;
 
-	Transaction t(_transactionRLP, CheckTransaction::Everything);
 	UpgradeGuard ul(l);
 	return manageImport_WITH_LOCK(h, t, _cb);
 }
 
+ImportResult TransactionQueue::enqueue(bytesConstRef _tx, ImportCallback const& _cb)
+{
+	h256 h = sha3(_tx);
+	unsigned limit;
+	{
+		ReadGuard l(m_lock);
+		auto ir = check_WITH_LOCK(h, IfDropped::Ignore);
+		if (ir != ImportResult::Success)
+			return ir;
+		limit = m_limit;
+	}
+	{
+		Guard l(x_unverified);
+		if (m_verifier)
+		{
+			if (m_unverified.count(h))
+				return ImportResult::AlreadyKnown;
+			// Every task queued on the verifier has its entry here, so this bounds both.
+			if (m_unverified.size() >= limit)
+			{
+				ctxq << "Verification backlog full; dropping transaction" << h;
+				return ImportResult::Overloaded;
+			}
+			m_unverified.insert(h);
+			bytes tx = _tx.toBytes();
+			m_verifier->post([=]() { verify(h, tx, _cb); });
+			return ImportResult::Success;
+		}
+	}
+	ImportResult ret = import(_tx);
+	if (_cb)
+		_cb(ret);
+	return ret;
+}
+
+void TransactionQueue::verify(h256 const& _h, bytes const& _tx, ImportCallback const& _cb)
+{
+	DEV_GUARDED(x_unverified)
+		if (!m_unverified.count(_h))
+			return;	// abandoned by stopVerification().
+	ImportResult ir = import(&_tx);
+	DEV_GUARDED(x_unverified)
+		m_unverified.erase(_h);
+	if (_cb)
+		_cb(ir);
+}
+
+void TransactionQueue::stopVerification()
+{
+	unique_ptr<ThreadPool> v;
+	DEV_GUARDED(x_unverified)
+	{
+		swap(v, m_verifier);
+		m_unverified.clear();
+	}
+	v.reset();
+}
+
 ImportResult TransactionQueue::check_WITH_LOCK(h256 const& _h, IfDropped _ik)
 {
 	if (m_known.count(_h))
@@ -82,7 +173,24 @@ ImportResult TransactionQueue::manageImport_WITH_LOCK(h256 const& _h, Transactio
 		// The transaction's nonce may yet be invalid (or, it could be "valid" but we may be missing a marginally older transaction).
 
 		// If valid, append to blocks.
-		insertCurrent_WITH_LOCK(make_pair(_h, _transaction));
+		auto s = m_currentByAddressAndNonce.find(_transaction.sender());
+		bool replacing = s != m_currentByAddressAndNonce.end() && s->second.count(_transaction.nonce());
+		if (!replacing && !makeRoom_WITH_LOCK(1, &_transaction))
+		{
+			ctxq << "Queue full; ignoring cheap transaction" << _h;
+			return ImportResult::Underpriced;
+		}
+		if (!insertCurrent_WITH_LOCK(make_pair(_h, _transaction)))
+		{
+			ctxq << "Ignoring transaction" << _h << "as it doesn't outbid the one it would replace";
+			return ImportResult::Underpriced;
+		}
+		m_arrivals.push_back(_h);
+		if (m_arrivals.size() > c_maxArrivals)
+		{
+			m_arrivals.pop_front();
+			++m_firstArrival;
+		}
 		m_known.insert(_h);
 		if (_cb)
 			m_callbacks[_h] = _cb;
@@ -105,53 +213,155 @@ ImportResult TransactionQueue::manageImport_WITH_LOCK(h256 const& _h, Transactio
 
 u256 TransactionQueue::maxNonce(Address const& _a) const
 {
-	cdebug << "txQ::maxNonce" << _a;
 	ReadGuard l(m_lock);
-	u256 ret = 0;
-	auto r = m_senders.equal_range(_a);
-	for (auto it = r.first; it != r.second; ++it)
+	auto it = m_currentByAddressAndNonce.find(_a);
+	if (it == m_currentByAddressAndNonce.end() || it->second.empty())
+		return 0;
+	return it->second.rbegin()->first + 1;
+}
+
+Transactions TransactionQueue::topTransactions(unsigned _limit, h256Hash const& _avoid) const
+{
+	// A max-heap by gas price of each sender's next transaction; popping one pushes that sender's next after it.
+	using Position = pair<map<u256, h256>::const_iterator, map<u256, h256>::const_iterator>;
+	auto worse = [&](Position const& _a, Position const& _b)
+	{
+		u256 const& a = m_current.at(_a.first->second).gasPrice();
+		u256 const& b = m_current.at(_b.first->second).gasPrice();
+		return a < b || (a == b && _a.first->second > _b.first->second);
+	};
+	auto skipAvoided = [&](Position& _p)
+	{
+		while (_p.first != _p.second && _avoid.count(_p.first->second))
+			++_p.first;
+		return _p.first != _p.second;
+	};
+
+	Transactions ret;
+	ReadGuard l(m_lock);
+	vector<Position> heads;
+	heads.reserve(m_currentByAddressAndNonce.size());
+	for (auto const& s: m_currentByAddressAndNonce)
 	{
-		cdebug << it->first << "1+" << m_current.at(it->second).nonce();
-		DEV_IGNORE_EXCEPTIONS(ret = max(ret, m_current.at(it->second).nonce() + 1));
+		Position p(s.second.begin(), s.second.end());
+		if (skipAvoided(p))
+			heads.push_back(p);
+	}
+	make_heap(heads.begin(), heads.end(), worse);
+	while (!heads.empty() && ret.size() < _limit)
+	{
+		pop_heap(heads.begin(), heads.end(), worse);
+		Position& p = heads.back();
+		ret.push_back(m_current.at(p.first->second));
+		++p.first;
+		if (skipAvoided(p))
+			push_heap(heads.begin(), heads.end(), worse);
+		else
+			heads.pop_back();
 	}
 	return ret;
 }
 
-void TransactionQueue::insertCurrent_WITH_LOCK(std::pair<h256, Transaction> const& _p)
+bool TransactionQueue::insertCurrent_WITH_LOCK(std::pair<h256, Transaction> const& _p)
 {
-	cdebug << "txQ::insertCurrent" << _p.first << _p.second.sender() << _p.second.nonce();
-	m_senders.insert(make_pair(_p.second.sender(), _p.first));
+	auto& byNonce = m_currentByAddressAndNonce[_p.second.sender()];
+	auto it = byNonce.find(_p.second.nonce());
+	if (it != byNonce.end())
+	{
+		h256 old = it->second;
+		if (m_current.at(old).gasPrice() >= _p.second.gasPrice())
+			return false;
+		ctxq << "Replacing" << old << "with better-paying" << _p.first;
+		removeCurrent_WITH_LOCK(old);
+		m_known.erase(old);
+		m_dropped.insert(old);
+	}
+	m_currentByAddressAndNonce[_p.second.sender()][_p.second.nonce()] = _p.first;
+	m_currentByPrice.insert(make_pair(_p.second.gasPrice(), _p.first));
 	m_current.insert(_p);
+	return true;
 }
 
-bool TransactionQueue::removeCurrent_WITH_LOCK(h256 const& _txHash)
+bool TransactionQueue::makeRoom_WITH_LOCK(unsigned _room, Transaction const* _for)
+{
+	while (m_current.size() + m_unknown.size() + _room > m_limit)
+		if (!m_unknown.empty())
+		{
+			ctxq << "Queue full; evicting future transaction" << m_unknown.begin()->second.first;
+			m_known.erase(m_unknown.begin()->second.first);
+			m_unknown.erase(m_unknown.begin());
+		}
+		else if (!m_currentByPrice.empty() && (!_for || m_currentByPrice.begin()->first < _for->gasPrice()))
+		{
+			// The cheapest transaction holds up all of its sender's later ones, so they're worth no more than it.
+			// Take the last of them: that frees a place without leaving any transaction waiting on one that's gone.
+			Transaction const& t = m_current.at(m_currentByPrice.begin()->second);
+			auto const& queue = m_currentByAddressAndNonce.at(t.sender());
+			// If that's _for's own sender and _for comes after them, it's held up just the same and worth no more.
+			if (_for && t.sender() == _for->sender() && queue.rbegin()->first < _for->nonce())
+				return false;
+			h256 last = queue.rbegin()->second;
+			ctxq << "Queue full; evicting cheap transaction" << last;
+			removeCurrent_WITH_LOCK(last);
+			m_known.erase(last);
+		}
+		else
+			return false;
+	return true;
+}
+
+void TransactionQueue::setLimit(unsigned _limit)
+{
+	WriteGuard l(m_lock);
+	m_limit = _limit;
+	makeRoom_WITH_LOCK(0);
+}
+
+vector<pair<h256, bytes>> TransactionQueue::transactionsSince(unsigned& io_since) const
 {
-	cdebug << "txQ::removeCurrent" << _txHash;
-	if (m_current.count(_txHash))
+	vector<pair<h256, bytes>> ret;
+	h256Hash seen;
+	ReadGuard l(m_lock);
+	unsigned end = m_firstArrival + m_arrivals.size();
+	for (unsigned i = max(io_since, m_firstArrival); i < end; ++i)
 	{
-		auto r = m_senders.equal_range(m_current[_txHash].sender());
-		for (auto it = r.first; it != r.second; ++it)
-			if (it->second == _txHash)
-			{
-				cdebug << "=> sender" << it->first;
-				m_senders.erase(it);
-				break;
-			}
-		cdebug << "=> nonce" << m_current[_txHash].nonce();
-		m_current.erase(_txHash);
-		return true;
+		// a transaction dropped and then made current again arrives twice.
+		auto it = m_current.find(m_arrivals[i - m_firstArrival]);
+		if (it != m_current.end() && seen.insert(it->first).second)
+			ret.push_back(make_pair(it->first, it->second.rlp()));
 	}
-	return false;
+	if (max(io_since, 1u) < m_firstArrival)
+	{
+		// Some arrivals were forgotten before they were asked for, so we can't tell which of the rest are new; hand over everything.
+		ctxq << "Lost track of" << (m_firstArrival - io_since) << "arrivals; returning all current transactions.";
+		for (auto const& t: m_current)
+			if (seen.insert(t.first).second)
+				ret.push_back(make_pair(t.first, t.second.rlp()));
+	}
+	io_since = end;
+	return ret;
+}
+
+bool TransactionQueue::removeCurrent_WITH_LOCK(h256 const& _txHash)
+{
+	auto it = m_current.find(_txHash);
+	if (it == m_current.end())
+		return false;
+	Transaction const& t = it->second;
+	auto s = m_currentByAddressAndNonce.find(t.sender());
+	s->second.erase(t.nonce());
+	if (s->second.empty())
+		m_currentByAddressAndNonce.erase(s);
+	m_currentByPrice.erase(make_pair(t.gasPrice(), _txHash));
+	m_current.erase(it);
+	return true;
 }
 
 void TransactionQueue::setFuture(std::pair<h256, Transaction> const& _t)
 {
 	WriteGuard l(m_lock);
-	if (m_current.count(_t.first))
-	{
+	if (removeCurrent_WITH_LOCK(_t.first))
 		m_unknown.insert(make_pair(_t.second.sender(), _t));
-		m_current.erase(_t.first);
-	}
 }
 
 void TransactionQueue::noteGood(std::pair<h256, Transaction> const& _t)
@@ -159,7 +369,8 @@ void TransactionQueue::noteGood(std::pair<h256, Transaction> const& _t)
 	WriteGuard l(m_lock);
 	auto r = m_unknown.equal_range(_t.second.sender());
 	for (auto it = r.first; it != r.second; ++it)
-		m_current.insert(it->second);
+		if (!insertCurrent_WITH_LOCK(it->second))
+			m_known.erase(it->second.first);
 	m_unknown.erase(r.first, r.second);
 }
 
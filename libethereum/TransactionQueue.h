@@ -21,10 +21,15 @@
 
 #pragma once
 
+#include <map>
+#include <set>
+#include <deque>
+#include <memory>
 #include <functional>
 #include <libdevcore/Common.h>
 #include <libdevcore/Guards.h>
 #include <libdevcore/Log.h>
+#include <libdevcore/ThreadPool.h>
 #include <libethcore/Common.h>
 #include "Transaction.h"
 
@@ -42,6 +47,13 @@ enum class IfDropped { Ignore, Retry };
 
 /**
  * @brief A queue of Transactions, each stored as RLP.
+ * Current transactions are kept in a nonce-ordered queue per sender and indexed by gas price. Only one transaction
+ * per sender and nonce is kept: a later one replaces it only if it pays a higher gas price. The queue holds at most
+ * limit() transactions; when full, future transactions go first, then the last queued transaction of whoever sent
+ * the cheapest one, since it's held up by that one. An incoming transaction never evicts one of its own sender's that
+ * it would have to wait for; it's refused as underpriced instead.
+ * Transactions from the network should come in through enqueue(), which leaves the decoding and sender recovery
+ * to a pool of verifier threads so that neither the caller nor anyone waiting on the queue's lock pays for it.
  * @threadsafe
  */
 class TransactionQueue
@@ -49,37 +61,87 @@ class TransactionQueue
 public:
 	using ImportCallback = std::function<void(ImportResult)>;
 
+	static const unsigned c_defaultLimit = 1024;
+
+	static const unsigned c_verifierThreads = 2;
+
+	static const unsigned c_maxArrivals = 4096;	///< Arrivals remembered for transactionsSince().
+
+	explicit TransactionQueue(unsigned _limit = c_defaultLimit);
+	~TransactionQueue();
+
 	ImportResult import(Transaction const& _tx, ImportCallback const& _cb = ImportCallback(), IfDropped _ik = IfDropped::Ignore);
 	ImportResult import(bytes const& _tx, ImportCallback const& _cb = ImportCallback(), IfDropped _ik = IfDropped::Ignore) { return import(&_tx, _cb, _ik); }
 	ImportResult import(bytesConstRef _tx, ImportCallback const& _cb = ImportCallback(), IfDropped _ik = IfDropped::Ignore);
 
+	/// Queues the transaction RLP @a _tx for verification and import on a verifier thread. Only its hash is worked out here;
+	/// if it's already known, dropped or awaiting verification that's returned at once, as is Overloaded if limit()
+	/// transactions already await verification. Otherwise returns Success and, once verified and imported, calls @a _cb
+	/// (on the verifier thread) with the real outcome.
+	ImportResult enqueue(bytesConstRef _tx, ImportCallback const& _cb = ImportCallback());
+	/// @returns the number of transactions awaiting verification.
+	size_t unverified() const { Guard l(x_unverified); return m_unverified.size(); }
+	/// Abandons any transactions awaiting verification and waits for those under way. enqueue() imports directly after this.
+	/// Call before tearing down anything hooked to onReady().
+	void stopVerification();
+
 	void drop(h256 const& _txHash);
 
+	/// @returns a copy of all current transactions. Prefer topTransactions().
 	std::unordered_map<h256, Transaction> transactions() const { ReadGuard l(m_lock); return m_current; }
+	/// @returns up to @a _limit current transactions not in @a _avoid, best first: each sender's come in nonce order, and
+	/// at each point the next is whichever sender's next one pays the highest gas price.
+	Transactions topTransactions(unsigned _limit, h256Hash const& _avoid = h256Hash()) const;
+	/// @returns the RLP of those current transactions which became current after @a io_since, oldest first, and moves
+	/// @a io_since on past them. Start with 0. Only the last c_maxArrivals arrivals are remembered; if some since
+	/// @a io_since have been forgotten, every current transaction is returned, those remembered first.
+	std::vector<std::pair<h256, bytes>> transactionsSince(unsigned& io_since) const;
 	std::pair<unsigned, unsigned> items() const { ReadGuard l(m_lock); return std::make_pair(m_current.size(), m_unknown.size()); }
 	u256 maxNonce(Address const& _a) const;
 
+	unsigned limit() const { ReadGuard l(m_lock); return m_limit; }
+	/// Sets the most transactions the queue holds, evicting as necessary to meet it.
+	void setLimit(unsigned _limit);
+
 	void setFuture(std::pair<h256, Transaction> const& _t);
 	void noteGood(std::pair<h256, Transaction> const& _t);
 
-	void clear() { WriteGuard l(m_lock); m_known.clear(); m_current.clear(); m_unknown.clear(); }
+	void clear() { WriteGuard l(m_lock); m_known.clear(); m_current.clear(); m_currentByAddressAndNonce.clear(); m_currentByPrice.clear(); m_unknown.clear(); m_firstArrival += m_arrivals.size(); m_arrivals.clear(); }
 	template <class T> Handler onReady(T const& _t) { return m_onReady.add(_t); }
 
 private:
 	ImportResult check_WITH_LOCK(h256 const& _h, IfDropped _ik);
 	ImportResult manageImport_WITH_LOCK(h256 const& _h, Transaction const& _transaction, ImportCallback const& _cb);
+	/// Decodes and imports the enqueued transaction @a _tx, of hash @a _h, and tells @a _cb how it went.
+	void verify(h256 const& _h, bytes const& _tx, ImportCallback const& _cb);
 
-	void insertCurrent_WITH_LOCK(std::pair<h256, Transaction> const& _p);
+	/// Makes @a _p current, replacing any current one of the same sender and nonce.
+	/// @returns false, changing nothing, if that one's gas price is as high.
+	bool insertCurrent_WITH_LOCK(std::pair<h256, Transaction> const& _p);
 	bool removeCurrent_WITH_LOCK(h256 const& _txHash);
+	/// Evicts until there's room for @a _room more transactions, taking current ones from the end of the queue of whoever
+	/// sent the cheapest. If making room for @a _for, only evicts those held up by a transaction cheaper than it, and
+	/// never ones it would itself have to wait for.
+	/// @returns true iff there's now room.
+	bool makeRoom_WITH_LOCK(unsigned _room, Transaction const* _for = nullptr);
 
 	mutable SharedMutex m_lock;													///< General lock.
 	h256Hash m_known;															///< Hashes of transactions in both sets.
 	std::unordered_map<h256, Transaction> m_current;							///< Map of SHA3(tx) to tx.
+	std::unordered_map<Address, std::map<u256, h256>> m_currentByAddressAndNonce;	///< Hashes of each sender's current transactions by nonce.
+	std::set<std::pair<u256, h256>> m_currentByPrice;							///< Gas price and hash of each current transaction, cheapest first.
 	std::unordered_multimap<Address, std::pair<h256, Transaction>> m_unknown;	///< For transactions that have a future nonce; we map their sender address to the tx stuff, and insert once the sender has a valid TX.
 	std::unordered_map<h256, std::function<void(ImportResult)>> m_callbacks;	///< Called once.
 	h256Hash m_dropped;															///< Transactions that have previously been dropped.
-	std::multimap<Address, h256> m_senders;										///< Mapping from the sender address to the transaction hash; useful for determining the nonce of a given sender.
+	std::deque<h256> m_arrivals;												///< Hashes of transactions in the order they became current; may include some since removed.
+	unsigned m_firstArrival = 1;												///< Arrival number of m_arrivals.front(). Arrivals are numbered from 1.
+	unsigned m_limit;															///< The most transactions, current and future, we'll hold.
+
 	Signal m_onReady;															///< Called when a subsequent call to import transactions will return a non-empty container. Be nice and exit fast.
+
+	mutable Mutex x_unverified;													///< Protects m_unverified and m_verifier.
+	h256Hash m_unverified;														///< Hashes of enqueued transactions awaiting verification.
+	std::unique_ptr<ThreadPool> m_verifier;										///< Verifies enqueued transactions. Null once stopped.
 };
 
 }
@@ -0,0 +1,453 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file WorkServer.cpp
+ * @date 2015
+ */
+
+// Make sure boost/asio.hpp is included before windows.h.
+#include <boost/asio.hpp>
+
+#include "WorkServer.h"
+
+#include <deque>
+#include <sstream>
+#include <condition_variable>
+#include <libdevcore/Log.h>
+#include <libethcore/EthashAux.h>
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+namespace ba = boost::asio;
+namespace bi = boost::asio::ip;
+
+namespace
+{
+
+struct WorkServerChannel: public LogChannel { static const char* name() { return "<W>"; } static const int verbosity = 6; };
+
+/// Longest line either end will buffer; a peer sending a longer one is disconnected.
+size_t const c_maxLineLength = 64 * 1024;
+
+string workLine(ProofOfWork::WorkPackage const& _wp)
+{
+	return "work " + _wp.headerHash.hex() + " " + _wp.seedHash.hex() + " " + _wp.boundary.hex() + "\n";
+}
+
+vector<string> words(string const& _line)
+{
+	vector<string> ret;
+	istringstream in(_line);
+	for (string w; in >> w;)
+		ret.push_back(w);
+	return ret;
+}
+
+}
+
+/// One miner's connection. Lives on the network thread, kept alive by the read or write it has outstanding.
+class WorkServer::Session: public enable_shared_from_this<WorkServer::Session>
+{
+public:
+	Session(WorkServer& _server): m_server(_server), m_socket(_server.m_io), m_in(c_maxLineLength) {}
+
+	bi::tcp::socket& socket() { return m_socket; }
+
+	void start()
+	{
+		boost::system::error_code ec;
+		auto ep = m_socket.remote_endpoint(ec);
+		if (!setName(ec ? "anonymous" : ep.address().to_string()))
+		{
+			// Reading the closed socket fails at once and finishes us.
+			read();
+			return;
+		}
+		ProofOfWork::WorkPackage w;
+		DEV_GUARDED(m_server.x_work)
+			w = m_server.m_work;
+		if (!w)
+		{
+			w = m_server.m_getWork();
+			DEV_GUARDED(m_server.x_work)
+				if (!m_server.m_work)
+					m_server.m_work = w;
+		}
+		if (w)
+			send(workLine(w));
+		read();
+	}
+
+	void send(string const& _line)
+	{
+		m_outbox.push_back(_line);
+		if (m_outbox.size() == 1)
+			write();
+	}
+
+	void close()
+	{
+		boost::system::error_code ec;
+		m_socket.close(ec);
+	}
+
+private:
+	/// Files this connection under worker @a _name. If the worker table is full of connected workers, closes
+	/// the connection instead. @returns false iff it did so.
+	bool setName(string const& _name)
+	{
+		Guard l(m_server.x_workers);
+		if (!m_name.empty())
+		{
+			// Drop the provisional entry made under the miner's address if it's come to nothing.
+			auto old = m_server.m_workers.find(m_name);
+			if (!--old->second.connections && !old->second.accepted && !old->second.stale && !old->second.rejected)
+				m_server.m_workers.erase(old);
+			m_name.clear();
+		}
+		if (!m_server.m_workers.count(_name) && m_server.m_workers.size() >= c_maxWorkers && !m_server.evictIdleWorker_WITH_LOCK())
+		{
+			clog(WorkServerChannel) << "Dropping" << _name << ": too many workers.";
+			close();
+			return false;
+		}
+		m_name = _name;
+		WorkerStats& s = m_server.m_workers[m_name];
+		++s.connections;
+		s.lastSeen = chrono::steady_clock::now();
+		return true;
+	}
+
+	void read()
+	{
+		auto self = shared_from_this();
+		ba::async_read_until(m_socket, m_in, '\n', [this, self](boost::system::error_code const& _ec, size_t)
+		{
+			if (_ec || !m_socket.is_open())
+			{
+				if (_ec == ba::error::not_found)
+					clog(WorkServerChannel) << "Dropping" << m_name << ": line too long.";
+				finish();
+				return;
+			}
+			istream in(&m_in);
+			string line;
+			getline(in, line);
+			handle(line);
+			read();
+		});
+	}
+
+	void write()
+	{
+		auto self = shared_from_this();
+		ba::async_write(m_socket, ba::buffer(m_outbox.front()), [this, self](boost::system::error_code const& _ec, size_t)
+		{
+			if (_ec)
+			{
+				close();
+				return;
+			}
+			m_outbox.pop_front();
+			if (!m_outbox.empty())
+				write();
+		});
+	}
+
+	void handle(string const& _line)
+	{
+		vector<string> w = words(_line);
+		if (w.empty())
+			return;
+		DEV_GUARDED(m_server.x_workers)
+			m_server.m_workers[m_name].lastSeen = chrono::steady_clock::now();
+		try
+		{
+			if (w[0] == "hello" && w.size() == 2)
+			{
+				if (w[1] != m_name)
+					setName(w[1]);
+			}
+			else if (w[0] == "hashrate" && w.size() == 2)
+			{
+				Guard l(m_server.x_workers);
+				m_server.m_workers[m_name].hashrate = stoull(w[1]);
+			}
+			else if (w[0] == "submit")
+			{
+				vector<pair<h256, ProofOfWork::Solution>> shares;
+				for (size_t i = 1; i < w.size(); ++i)
+				{
+					vector<string> parts;
+					istringstream share(w[i]);
+					for (string p; getline(share, p, ':');)
+						parts.push_back(p);
+					if (parts.size() != 3)
+						BOOST_THROW_EXCEPTION(BadHexCharacter());
+					shares.push_back(make_pair(h256(parts[1]), ProofOfWork::Solution{Nonce(parts[0]), h256(parts[2])}));
+				}
+				string reply = "result";
+				for (ShareResult r: m_server.submit(m_name, shares))
+					reply += r == ShareResult::Accepted ? " a" : r == ShareResult::Stale ? " s" : " r";
+				send(reply + "\n");
+			}
+			else
+				clog(WorkServerChannel) << "Ignoring unknown request from" << m_name << ":" << _line;
+		}
+		catch (...)
+		{
+			clog(WorkServerChannel) << "Malformed request from" << m_name << ":" << _line;
+		}
+	}
+
+	void finish()
+	{
+		DEV_GUARDED(m_server.x_workers)
+			if (!m_name.empty())
+			{
+				--m_server.m_workers[m_name].connections;
+				m_name.clear();
+			}
+		close();
+		m_server.m_sessions.erase(shared_from_this());
+	}
+
+	WorkServer& m_server;
+	bi::tcp::socket m_socket;
+	ba::streambuf m_in;
+	deque<string> m_outbox;
+	string m_name;
+};
+
+WorkServer::WorkServer(string const& _address, unsigned short _port, GetWork const& _getWork, Submit const& _submit):
+	m_getWork(_getWork),
+	m_submit(_submit),
+	m_acceptor(m_io, bi::tcp::endpoint(bi::address::from_string(_address), _port))
+{
+	accept();
+	m_thread = thread([this]()
+	{
+		setThreadName("work");
+		m_io.run();
+	});
+}
+
+WorkServer::~WorkServer()
+{
+	// Sockets close as the sessions holding them are destroyed along with us.
+	m_io.stop();
+	if (m_thread.joinable())
+		m_thread.join();
+}
+
+void WorkServer::accept()
+{
+	auto s = make_shared<Session>(*this);
+	m_acceptor.async_accept(s->socket(), [this, s](boost::system::error_code const& _ec)
+	{
+		if (_ec)
+			return;
+		m_sessions.insert(s);
+		s->start();
+		accept();
+	});
+}
+
+void WorkServer::setWork(ProofOfWork::WorkPackage const& _wp)
+{
+	DEV_GUARDED(x_work)
+	{
+		if (_wp.headerHash == m_work.headerHash)
+			return;
+		m_work = _wp;
+	}
+	if (!_wp)
+		return;
+	string line = workLine(_wp);
+	m_io.post([this, line]()
+	{
+		for (auto const& s: m_sessions)
+			s->send(line);
+	});
+}
+
+bool WorkServer::evictIdleWorker_WITH_LOCK()
+{
+	auto oldest = m_workers.end();
+	for (auto it = m_workers.begin(); it != m_workers.end(); ++it)
+		if (!it->second.connections && (oldest == m_workers.end() || it->second.lastSeen < oldest->second.lastSeen))
+			oldest = it;
+	if (oldest == m_workers.end())
+		return false;
+	m_workers.erase(oldest);
+	return true;
+}
+
+unsigned WorkServer::connections() const
+{
+	Guard l(x_workers);
+	unsigned ret = 0;
+	for (auto const& w: m_workers)
+		ret += w.second.connections;
+	return ret;
+}
+
+uint64_t WorkServer::hashrate() const
+{
+	Guard l(x_workers);
+	uint64_t ret = 0;
+	for (auto const& w: m_workers)
+		if (w.second.connections)
+			ret += w.second.hashrate;
+	return ret;
+}
+
+vector<ShareResult> WorkServer::submit(string const& _worker, vector<pair<h256, ProofOfWork::Solution>> const& _shares)
+{
+	h256 current;
+	DEV_GUARDED(x_work)
+		current = m_work.headerHash;
+	vector<ShareResult> ret;
+	for (auto const& s: _shares)
+		if (s.first != current)
+			ret.push_back(ShareResult::Stale);
+		else
+			ret.push_back(m_submit(s.second) ? ShareResult::Accepted : ShareResult::Rejected);
+
+	Guard l(x_workers);
+	WorkerStats& w = m_workers[_worker];
+	for (ShareResult r: ret)
+		++(r == ShareResult::Accepted ? w.accepted : r == ShareResult::Stale ? w.stale : w.rejected);
+	return ret;
+}
+
+WorkClient::WorkClient(string const& _host, unsigned short _port, string const& _name):
+	m_socket(m_io)
+{
+	bi::tcp::resolver r(m_io);
+	ba::connect(m_socket, r.resolve(bi::tcp::resolver::query(_host, toString(_port))));
+	send("hello " + _name + "\n");
+}
+
+WorkClient::~WorkClient()
+{
+	boost::system::error_code ec;
+	m_socket.close(ec);
+}
+
+void WorkClient::send(string const& _line)
+{
+	Guard l(x_socket);
+	ba::write(m_socket, ba::buffer(_line));
+}
+
+void WorkClient::run(GenericFarm<ProofOfWork>& _farm, chrono::milliseconds _reportPeriod)
+{
+	Mutex x_pending;
+	condition_variable pendingChanged;
+	vector<pair<h256, ProofOfWork::Solution>> pending;
+	atomic<bool> connected{true};
+
+	_farm.onSolutionFound([&](ProofOfWork::Solution const& _s)
+	{
+		ProofOfWork::WorkPackage w = _farm.work();
+		if (EthashAux::eval(EthashAux::number(w.seedHash), w.headerHash, _s.nonce).value >= w.boundary)
+		{
+			cwarn << "FAILURE: miner gave incorrect result!";
+			return false;
+		}
+		DEV_GUARDED(x_pending)
+			pending.push_back(make_pair(w.headerHash, _s));
+		pendingChanged.notify_one();
+		// Keep going on this work; the server will push new work if the solution is accepted.
+		return false;
+	});
+
+	// Reads on this thread; whatever the server says is acted on at once.
+	thread reader([&]()
+	{
+		setThreadName("workcli");
+		ba::streambuf in(c_maxLineLength);
+		boost::system::error_code ec;
+		while (ba::read_until(m_socket, in, '\n', ec) && !ec)
+		{
+			istream is(&in);
+			string line;
+			getline(is, line);
+			vector<string> w = words(line);
+			if (w.size() == 4 && w[0] == "work")
+			{
+				ProofOfWork::WorkPackage wp;
+				wp.headerHash = h256(w[1]);
+				wp.seedHash = h256(w[2]);
+				wp.boundary = h256(w[3]);
+				cnote << "Got work package" << wp.headerHash.abridged() << "(target" << wp.boundary.abridged() << ")";
+				_farm.setWork(wp);
+			}
+			else if (!w.empty() && w[0] == "result")
+				for (size_t i = 1; i < w.size(); ++i)
+					if (w[i] == "a")
+						cnote << "Solution accepted.";
+					else
+						cnote << (w[i] == "s" ? "Solution stale." : "Solution rejected.");
+		}
+		if (ec == ba::error::not_found)
+			cwarn << "Work server sent an overlong line; disconnecting.";
+		connected = false;
+		pendingChanged.notify_one();
+	});
+
+	auto lastReport = chrono::steady_clock::now();
+	try
+	{
+		while (connected)
+		{
+			vector<pair<h256, ProofOfWork::Solution>> batch;
+			{
+				unique_lock<Mutex> l(x_pending);
+				pendingChanged.wait_for(l, _reportPeriod, [&]() { return !pending.empty() || !connected; });
+				swap(batch, pending);
+			}
+			if (!batch.empty())
+			{
+				string line = "submit";
+				for (auto const& s: batch)
+					line += " " + s.second.nonce.hex() + ":" + s.first.hex() + ":" + s.second.mixHash.hex();
+				send(line + "\n");
+			}
+			if (chrono::steady_clock::now() - lastReport >= _reportPeriod)
+			{
+				// New work restarts the farm's timer, so there may be nothing to rate yet.
+				MiningProgress p = _farm.miningProgress();
+				if (p.ms)
+				{
+					cnote << "Mining:" << p;
+					send("hashrate " + toString(p.rate()) + "\n");
+				}
+				_farm.resetMiningProgress();
+				lastReport = chrono::steady_clock::now();
+			}
+		}
+	}
+	catch (...)
+	{
+		// A failed write means the connection's gone; the reader will notice too.
+	}
+	boost::system::error_code ec;
+	m_socket.shutdown(bi::tcp::socket::shutdown_both, ec);
+	reader.join();
+	_farm.onSolutionFound(GenericFarm<ProofOfWork>::SolutionFound());
+}
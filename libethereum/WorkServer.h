@@ -0,0 +1,153 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file WorkServer.h
+ * @date 2015
+ *
+ * Push-based distribution of work to remote miners over persistent TCP connections.
+ *
+ * The protocol is line-based ASCII; hashes and nonces are hex without a 0x prefix.
+ * Server to miner:
+ *   work <headerHash> <seedHash> <boundary>	New work, sent on connection and as soon as the work changes.
+ *   result <a|s|r>...							Outcome of each share of the last submission, in order:
+ *												accepted, stale (made for old work) or rejected.
+ * Miner to server:
+ *   hello <name>								Names the worker for the server's statistics.
+ *   hashrate <H/s>								Reports the worker's hashrate.
+ *   submit <nonce>:<headerHash>:<mixHash>...	Submits any number of shares at once.
+ * Lines may be at most 64KiB long; either end drops a connection on which a longer one arrives.
+ *
+ * Anyone who can connect may submit shares and see the work, so the server listens on localhost unless told otherwise.
+ */
+
+#pragma once
+
+#include <map>
+#include <set>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <functional>
+#include <boost/asio.hpp>
+#include <libdevcore/Guards.h>
+#include <libethcore/ProofOfWork.h>
+#include "Farm.h"
+
+namespace dev
+{
+namespace eth
+{
+
+/// What became of a share submitted to a WorkServer.
+enum class ShareResult
+{
+	Accepted,
+	Stale,		///< It was for work that's since been replaced.
+	Rejected
+};
+
+/// What a WorkServer knows of one remote worker.
+struct WorkerStats
+{
+	uint64_t hashrate = 0;		///< As last reported by the worker.
+	unsigned accepted = 0;
+	unsigned stale = 0;
+	unsigned rejected = 0;
+	unsigned connections = 0;	///< Connections currently open under this worker's name.
+	std::chrono::steady_clock::time_point lastSeen;
+
+	/// @returns the proportion of shares submitted that were stale.
+	double staleRate() const { unsigned n = accepted + stale + rejected; return n ? double(stale) / n : 0; }
+};
+
+/**
+ * @brief Serves work to remote miners, pushing each new work package to all of them the moment it's set.
+ * Runs its own network thread; see the file comment for the protocol.
+ * @threadsafe
+ */
+class WorkServer
+{
+public:
+	using GetWork = std::function<ProofOfWork::WorkPackage()>;
+	using Submit = std::function<bool(ProofOfWork::Solution const&)>;
+
+	/// Most workers whose statistics are kept. Once full, the longest-idle disconnected worker is forgotten
+	/// to make room for a new one; if every worker is connected, connections under new names are refused.
+	static const unsigned c_maxWorkers = 256;
+
+	/// Listens on @a _address:@a _port. New connections are given the last work set, or that given by @a _getWork
+	/// if none has been; shares for the current work are passed to @a _submit, which says whether they're good.
+	WorkServer(std::string const& _address, unsigned short _port, GetWork const& _getWork, Submit const& _submit);
+	~WorkServer();
+
+	/// Makes @a _wp the current work and pushes it to every connected miner.
+	void setWork(ProofOfWork::WorkPackage const& _wp);
+
+	/// @returns the statistics of every worker seen so far, by name.
+	std::map<std::string, WorkerStats> workers() const { Guard l(x_workers); return m_workers; }
+	/// @returns the number of connected miners.
+	unsigned connections() const;
+	/// @returns the total hashrate reported by connected miners.
+	uint64_t hashrate() const;
+
+private:
+	class Session;
+	friend class Session;
+
+	void accept();
+	/// Forgets the disconnected worker seen longest ago. @returns false if every worker is connected.
+	bool evictIdleWorker_WITH_LOCK();
+	std::vector<ShareResult> submit(std::string const& _worker, std::vector<std::pair<h256, ProofOfWork::Solution>> const& _shares);
+
+	GetWork m_getWork;
+	Submit m_submit;
+
+	boost::asio::io_service m_io;
+	boost::asio::ip::tcp::acceptor m_acceptor;
+	std::set<std::shared_ptr<Session>> m_sessions;	///< Only touched on the network thread.
+	std::thread m_thread;
+
+	mutable Mutex x_work;
+	ProofOfWork::WorkPackage m_work;
+
+	mutable Mutex x_workers;
+	std::map<std::string, WorkerStats> m_workers;
+};
+
+/**
+ * @brief The miner's end of a WorkServer connection: feeds pushed work to a farm and sends back its solutions.
+ */
+class WorkClient
+{
+public:
+	/// Connects to the WorkServer at @a _host:@a _port as worker @a _name. Throws if it can't.
+	WorkClient(std::string const& _host, unsigned short _port, std::string const& _name);
+	~WorkClient();
+
+	/// Mines with @a _farm on whatever work the server pushes, submitting solutions (gathered together if
+	/// several turn up at once) and reporting the hashrate every @a _reportPeriod. Returns when the connection drops.
+	void run(GenericFarm<ProofOfWork>& _farm, std::chrono::milliseconds _reportPeriod = std::chrono::seconds(5));
+
+private:
+	void send(std::string const& _line);
+
+	boost::asio::io_service m_io;
+	boost::asio::ip::tcp::socket m_socket;
+	Mutex x_socket;		///< Serialises writes.
+};
+
+}
+}
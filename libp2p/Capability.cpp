@@ -43,11 +43,21 @@ RLPStream& Capability::prep(RLPStream& _s, unsigned _id, unsigned _args)
 	return _s.appendRaw(bytes(1, _id + m_idOffset)).appendList(_args);
 }
 
+RLPStream& Capability::prepGathered(RLPStream& _s, unsigned _id, size_t _payloadSize)
+{
+	return _s.appendRaw(bytes(1, _id + m_idOffset)).appendListHeader(_payloadSize);
+}
+
 void Capability::sealAndSend(RLPStream& _s)
 {
 	m_session->sealAndSend(_s);
 }
 
+void Capability::sealAndSend(RLPStream& _s, std::vector<bytesConstRef> const& _payload)
+{
+	m_session->sealAndSend(_s, _payload);
+}
+
 void Capability::addRating(int _r)
 {
 	m_session->addRating(_r);
@@ -51,7 +51,10 @@ protected:
 	void disable(std::string const& _problem);
 
 	RLPStream& prep(RLPStream& _s, unsigned _id, unsigned _args = 0);
+	/// Begins a packet whose arguments, already encoded and @a _payloadSize bytes in all, are to be given to sealAndSend() separately.
+	RLPStream& prepGathered(RLPStream& _s, unsigned _id, size_t _payloadSize);
 	void sealAndSend(RLPStream& _s);
+	void sealAndSend(RLPStream& _s, std::vector<bytesConstRef> const& _payload);
 	void addRating(int _r);
 
 private:
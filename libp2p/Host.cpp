@@ -62,6 +62,7 @@ Host::Host(std::string const& _clientVersion, NetworkPreferences const& _n, byte
 	m_netPrefs(_n),
 	m_ifAddresses(Network::getInterfaceAddresses()),
 	m_ioService(2),
+	m_strand(m_ioService),
 	m_tcp4Acceptor(m_ioService),
 	m_alias(networkAlias(_restoreNetwork)),
 	m_lastPing(chrono::steady_clock::time_point::min())
@@ -105,6 +106,19 @@ void Host::stop()
 
 void Host::doneWorking()
 {
+	// run() has stopped the ioservice; wait for the other I/O threads to leave it
+	for (auto& t: m_ioThreads)
+		t.join();
+	m_ioThreads.clear();
+
+	// run() has handed the node table back to the discovery thread to release; that thread leaves once it's gone
+	if (m_discoveryThread.joinable())
+		m_discoveryThread.join();
+	m_discoveryService.reset();
+
+	// let capabilities finish the packets already handed to them; from here on sessions interpret inline
+	m_capabilityWorker.reset();
+
 	// reset ioservice (allows manually polling network, below)
 	m_ioService.reset();
 
@@ -339,7 +353,7 @@ void Host::runAcceptor()
 		m_accepting = true;
 
 		auto socket = make_shared<RLPXSocket>(new bi::tcp::socket(m_ioService));
-		m_tcp4Acceptor.async_accept(socket->ref(), [=](boost::system::error_code ec)
+		m_tcp4Acceptor.async_accept(socket->ref(), m_strand.wrap([=](boost::system::error_code ec)
 		{
 			if (peerCount() > 9 * m_idealPeerCount)
 			{
@@ -358,7 +372,8 @@ void Host::runAcceptor()
 				{
 					// incoming connection; we don't yet know nodeid
 					auto handshake = make_shared<RLPXHandshake>(this, socket);
-					m_connecting.push_back(handshake);
+					DEV_GUARDED(x_connecting)
+						m_connecting.push_back(handshake);
 					handshake->start();
 					success = true;
 				}
@@ -378,7 +393,7 @@ void Host::runAcceptor()
 			m_accepting = false;
 			if (ec.value() < 1)
 				runAcceptor();
-		});
+		}));
 	}
 }
 
@@ -492,7 +507,7 @@ void Host::connect(std::shared_ptr<Peer> const& _p)
 	bi::tcp::endpoint ep(_p->endpoint);
 	clog(NetConnect) << "Attempting connection to node" << _p->id << "@" << ep << "from" << id();
 	auto socket = make_shared<RLPXSocket>(new bi::tcp::socket(m_ioService));
-	socket->ref().async_connect(ep, [=](boost::system::error_code const& ec)
+	socket->ref().async_connect(ep, m_strand.wrap([=](boost::system::error_code const& ec)
 	{
 		_p->m_lastAttempted = std::chrono::system_clock::now();
 		_p->m_failedAttempts++;
@@ -517,7 +532,7 @@ void Host::connect(std::shared_ptr<Peer> const& _p)
 		
 		Guard l(x_pendingNodeConns);
 		m_pendingPeerConns.erase(nptr);
-	});
+	}));
 }
 
 PeerSessionInfos Host::peerSessionInfo() const
@@ -549,11 +564,14 @@ void Host::run(boost::system::error_code const&)
 {
 	if (!m_run)
 	{
-		// reset NodeTable
-		m_nodeTable.reset();
+		// reset NodeTable; it's released on the discovery thread, after which that thread runs out of work
+		auto nodeTable = make_shared<shared_ptr<NodeTable>>(move(m_nodeTable));
+		m_discoveryService.post([nodeTable]() { nodeTable->reset(); });
+		m_discoveryWork.reset();
 
 		// stopping io service allows running manual network operations for shutdown
 		// and also stops blocking worker thread, allowing worker thread to exit
+		m_ioWork.reset();
 		m_ioService.stop();
 
 		// resetting timer signals network that nothing else can be scheduled to run
@@ -576,9 +594,10 @@ void Host::run(boost::system::error_code const&)
 		});
 	}
 	
-	for (auto p: m_sessions)
-		if (auto pp = p.second.lock())
-			pp->serviceNodesRequest();
+	DEV_RECURSIVE_GUARDED(x_sessions)
+		for (auto p: m_sessions)
+			if (auto pp = p.second.lock())
+				pp->serviceNodesRequest();
 
 	keepAlivePeers();
 	
@@ -613,7 +632,7 @@ void Host::run(boost::system::error_code const&)
 
 	auto runcb = [this](boost::system::error_code const& error) { run(error); };
 	m_timer->expires_from_now(boost::posix_time::milliseconds(c_timerInterval));
-	m_timer->async_wait(runcb);
+	m_timer->async_wait(m_strand.wrap(runcb));
 }
 
 void Host::startedWorking()
@@ -629,6 +648,8 @@ void Host::startedWorking()
 		m_timer.reset(new boost::asio::deadline_timer(m_ioService));
 		m_run = true;
 	}
+	m_ioWork.reset(new ba::io_service::work(m_ioService));
+	m_capabilityWorker.reset(new ThreadPool(1, "p2p.cap"));
 
 	// start capability threads (ready for incoming connections)
 	for (auto const& h: m_capabilities)
@@ -649,14 +670,29 @@ void Host::startedWorking()
 	else
 		clog(NetNote) << "p2p.start.notice id:" << id() << "TCP Listen port is invalid or unavailable.";
 
-	shared_ptr<NodeTable> nodeTable(new NodeTable(m_ioService, m_alias, NodeIPEndpoint(bi::address::from_string(listenAddress()), listenPort(), listenPort())));
+	shared_ptr<NodeTable> nodeTable(new NodeTable(m_discoveryService, m_alias, NodeIPEndpoint(bi::address::from_string(listenAddress()), listenPort(), listenPort())));
 	nodeTable->setEventHandler(new HostNodeTableHandler(*this));
 	m_nodeTable = nodeTable;
+	// discovery gets a thread of its own, as the node table mustn't run on several at once
+	m_discoveryWork.reset(new ba::io_service::work(m_discoveryService));
+	m_discoveryThread = thread([=]()
+	{
+		setThreadName("p2p.udp");
+		m_discoveryService.run();
+	});
 	restoreNetwork(&m_restoreNetwork);
 
 	clog(NetNote) << "p2p.started id:" << id();
 
 	run(boost::system::error_code());
+
+	// the worker thread runs the ioservice too (see doWork()), so start one fewer
+	for (unsigned i = 1; i < ioThreadCount(); ++i)
+		m_ioThreads.push_back(thread([=]()
+		{
+			setThreadName("p2p.io" + toString(i));
+			m_ioService.run();
+		}));
 }
 
 void Host::doWork()
@@ -665,6 +701,13 @@ void Host::doWork()
 		m_ioService.run();
 }
 
+unsigned Host::ioThreadCount() const
+{
+	if (m_netPrefs.ioThreads)
+		return m_netPrefs.ioThreads;
+	return max(2u, thread::hardware_concurrency() / 2);
+}
+
 void Host::keepAlivePeers()
 {
 	if (chrono::steady_clock::now() - c_keepAliveInterval < m_lastPing)
@@ -30,9 +30,11 @@
 #include <utility>
 #include <thread>
 #include <chrono>
+#include <atomic>
 
 #include <libdevcore/Guards.h>
 #include <libdevcore/Worker.h>
+#include <libdevcore/ThreadPool.h>
 #include <libdevcore/RangeMask.h>
 #include <libdevcrypto/Common.h>
 #include <libdevcrypto/ECDHE.h>
@@ -187,6 +189,9 @@ private:
 	/// Called only from startedWorking().
 	void runAcceptor();
 
+	/// @returns the number of threads which should run m_ioService.
+	unsigned ioThreadCount() const;
+
 	/// Called by Worker. Not thread-safe; to be called only by worker.
 	virtual void startedWorking();
 	/// Called by startedWorking. Not thread-safe; to be called only be Worker.
@@ -216,8 +221,16 @@ private:
 	int m_listenPort = -1;												///< What port are we listening on. -1 means binding failed or acceptor hasn't been initialized.
 
 	ba::io_service m_ioService;											///< IOService for network stuff.
+	ba::io_service::strand m_strand;										///< Serialises the scheduler (run()) and acceptor handlers, which may otherwise run on any I/O thread.
 	bi::tcp::acceptor m_tcp4Acceptor;										///< Listening acceptor.
 
+	std::unique_ptr<ba::io_service::work> m_ioWork;						///< Keeps m_ioService running while the network is up.
+	std::vector<std::thread> m_ioThreads;									///< Threads running m_ioService besides the worker thread.
+	ba::io_service m_discoveryService;										///< IOService for the node table. Run by m_discoveryThread alone, as NodeTable requires.
+	std::unique_ptr<ba::io_service::work> m_discoveryWork;					///< Keeps m_discoveryService running while the network is up.
+	std::thread m_discoveryThread;											///< The one thread running m_discoveryService.
+	std::unique_ptr<ThreadPool> m_capabilityWorker;						///< Single thread on which sessions hand capability packets to Capability::interpret(), off the I/O threads.
+
 	std::unique_ptr<boost::asio::deadline_timer> m_timer;					///< Timer which, when network is running, calls scheduler() every c_timerInterval ms.
 	static const unsigned c_timerInterval = 100;							///< Interval which m_timer is run when network is connected.
 
@@ -252,7 +265,7 @@ private:
 	Mutex x_timers;
 
 	std::chrono::steady_clock::time_point m_lastPing;						///< Time we sent the last ping to all peers.
-	bool m_accepting = false;
+	std::atomic<bool> m_accepting{false};
 	bool m_dropPeers = false;
 };
 
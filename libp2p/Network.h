@@ -52,6 +52,7 @@ struct NetworkPreferences
 	std::string listenIPAddress;
 	unsigned short listenPort = 30303;
 	bool traverseNAT = true;
+	unsigned ioThreads = 0;				///< Number of threads servicing network I/O; 0 picks one per two hardware threads (at least two).
 };
 
 /**
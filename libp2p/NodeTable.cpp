@@ -38,16 +38,54 @@ const char* NodeTableAllDetail::name() { return "=P="; }
 const char* NodeTableEgress::name() { return ">>P"; }
 const char* NodeTableIngress::name() { return "<<P"; }
 
-NodeEntry::NodeEntry(Node _src, Public _pubk, NodeIPEndpoint _gw): Node(_pubk, _gw), distance(NodeTable::distance(_src.id,_pubk)) {}
+NodeEntry::NodeEntry(h256 const& _srcHash, Public _pubk, NodeIPEndpoint _gw): Node(_pubk, _gw), hash(sha3(_pubk)), distance(NodeTable::distance(_srcHash, hash)) {}
+
+namespace
+{
+
+/// @returns the index of the highest set bit of @a _w, which mustn't be zero.
+inline unsigned highestBit(uint64_t _w)
+{
+#if defined(_MSC_VER)
+	unsigned long ret;
+	_BitScanReverse64(&ret, _w);
+	return ret;
+#else
+	return 63 - __builtin_clzll(_w);
+#endif
+}
+
+/// @returns the @a _i th big-endian 64-bit word of @a _h.
+inline uint64_t word(h256 const& _h, unsigned _i)
+{
+	uint64_t ret = 0;
+	for (byte const* p = _h.data() + _i * 8, *e = p + 8; p != e; ++p)
+		ret = (ret << 8) | *p;
+	return ret;
+}
+
+}
+
+unsigned NodeTable::distance(h256 const& _a, h256 const& _b)
+{
+	for (unsigned i = 0; i < h256::size / 8; ++i)
+		if (uint64_t d = word(_a, i) ^ word(_b, i))
+			return (h256::size / 8 - 1 - i) * 64 + highestBit(d);
+	return 0;
+}
 
 NodeTable::NodeTable(ba::io_service& _io, KeyPair const& _alias, NodeIPEndpoint const& _endpoint):
 	m_node(Node(_alias.pub(), _endpoint)),
+	m_nodeHash(sha3(m_node.id)),
 	m_secret(_alias.sec()),
 	m_io(_io),
 	m_socket(new NodeSocket(m_io, *this, (bi::udp::endpoint)m_node.endpoint)),
 	m_socketPointer(m_socket.get()),
 	m_bucketRefreshTimer(m_io),
-	m_evictionCheckTimer(m_io)
+	m_evictionCheckTimer(m_io),
+	m_verifier(new ThreadPool(c_verifierThreads, "p2p.disc")),
+	m_unverifiedPackets(make_shared<atomic<unsigned>>(0)),
+	m_recentSalt(h256::random())
 {
 	for (unsigned i = 0; i < s_bins; i++)
 	{
@@ -79,7 +117,7 @@ shared_ptr<NodeEntry> NodeTable::addNode(Node const& _node, NodeRelation _relati
 {
 	if (_relation == Known)
 	{
-		shared_ptr<NodeEntry> ret(new NodeEntry(m_node, _node.id, _node.endpoint));
+		shared_ptr<NodeEntry> ret(new NodeEntry(m_nodeHash, _node.id, _node.endpoint));
 		ret->pending = false;
 		DEV_GUARDED(x_nodes)
 			m_nodes[_node.id] = ret;
@@ -106,7 +144,7 @@ shared_ptr<NodeEntry> NodeTable::addNode(Node const& _node, NodeRelation _relati
 		if (m_nodes.count(_node.id))
 			return m_nodes[_node.id];
 	
-	shared_ptr<NodeEntry> ret(new NodeEntry(m_node, _node.id, _node.endpoint));
+	shared_ptr<NodeEntry> ret(new NodeEntry(m_nodeHash, _node.id, _node.endpoint));
 	DEV_GUARDED(x_nodes)
 		m_nodes[_node.id] = ret;
 	clog(NodeTableConnect) << "addNode pending for" << _node.endpoint;
@@ -116,12 +154,16 @@ shared_ptr<NodeEntry> NodeTable::addNode(Node const& _node, NodeRelation _relati
 
 void NodeTable::discover()
 {
-	static chrono::steady_clock::time_point s_lastDiscover = chrono::steady_clock::now() - std::chrono::seconds(30);
-	if (chrono::steady_clock::now() > s_lastDiscover + std::chrono::seconds(30))
+	auto self(shared_from_this());
+	m_io.dispatch([this, self]()
 	{
-		s_lastDiscover = chrono::steady_clock::now();
-		discover(m_node.id);
-	}
+		static chrono::steady_clock::time_point s_lastDiscover = chrono::steady_clock::now() - std::chrono::seconds(30);
+		if (chrono::steady_clock::now() > s_lastDiscover + std::chrono::seconds(30))
+		{
+			s_lastDiscover = chrono::steady_clock::now();
+			discover(m_node.id);
+		}
+	});
 }
 
 list<NodeId> NodeTable::nodes() const
@@ -136,11 +178,13 @@ list<NodeId> NodeTable::nodes() const
 list<NodeEntry> NodeTable::snapshot() const
 {
 	list<NodeEntry> ret;
-	DEV_GUARDED(x_state)
-		for (auto const& s: m_state)
-			for (auto const& np: s.nodes)
-				if (auto n = np.lock())
-					ret.push_back(*n);
+	for (auto const& s: m_state)
+	{
+		auto nodes = s.nodes();
+		for (auto const& np: *nodes)
+			if (auto n = np.lock())
+				ret.push_back(*n);
+	}
 	return move(ret);
 }
 
@@ -177,6 +221,7 @@ void NodeTable::discover(NodeId _node, unsigned _round, shared_ptr<set<shared_pt
 	
 	auto nearest = nearestNodeEntries(_node);
 	list<shared_ptr<NodeEntry>> tried;
+	vector<UDPDatagram> requests;
 	for (unsigned i = 0; i < nearest.size() && tried.size() < s_alpha; i++)
 		if (!_tried->count(nearest[i]))
 		{
@@ -186,8 +231,9 @@ void NodeTable::discover(NodeId _node, unsigned _round, shared_ptr<set<shared_pt
 			p.sign(m_secret);
 			DEV_GUARDED(x_findNodeTimeout)
 				m_findNodeTimeout.push_back(make_pair(r->id, chrono::steady_clock::now()));
-			m_socketPointer->send(p);
+			requests.push_back(move(p));
 		}
+	m_socketPointer->send(move(requests));
 	
 	if (tried.empty())
 	{
@@ -215,7 +261,8 @@ vector<shared_ptr<NodeEntry>> NodeTable::nearestNodeEntries(NodeId _target)
 {
 	// send s_alpha FindNode packets to nodes we know, closest to target
 	static unsigned lastBin = s_bins - 1;
-	unsigned head = distance(m_node.id, _target);
+	h256 target = sha3(_target);
+	unsigned head = distance(m_nodeHash, target);
 	unsigned tail = head == 0 ? lastBin : (head - 1) % s_bins;
 	
 	map<unsigned, list<shared_ptr<NodeEntry>>> found;
@@ -225,25 +272,28 @@ vector<shared_ptr<NodeEntry>> NodeTable::nearestNodeEntries(NodeId _target)
 	if (head > 1 && tail != lastBin)
 		while (head != tail && head < s_bins && count < s_bucketSize)
 		{
-			Guard l(x_state);
-			for (auto const& n: m_state[head].nodes)
+			auto nodes = m_state[head].nodes();
+			for (auto const& n: *nodes)
 				if (auto p = n.lock())
 				{
 					if (count < s_bucketSize)
-						found[distance(_target, p->id)].push_back(p);
+						found[distance(target, p->hash)].push_back(p);
 					else
 						break;
 				}
 			
 			if (count < s_bucketSize && tail)
-				for (auto const& n: m_state[tail].nodes)
+			{
+				auto tailNodes = m_state[tail].nodes();
+				for (auto const& n: *tailNodes)
 					if (auto p = n.lock())
 					{
 						if (count < s_bucketSize)
-							found[distance(_target, p->id)].push_back(p);
+							found[distance(target, p->hash)].push_back(p);
 						else
 							break;
 					}
+			}
 
 			head++;
 			if (tail)
@@ -252,12 +302,12 @@ vector<shared_ptr<NodeEntry>> NodeTable::nearestNodeEntries(NodeId _target)
 	else if (head < 2)
 		while (head < s_bins && count < s_bucketSize)
 		{
-			Guard l(x_state);
-			for (auto const& n: m_state[head].nodes)
+			auto nodes = m_state[head].nodes();
+			for (auto const& n: *nodes)
 				if (auto p = n.lock())
 				{
 					if (count < s_bucketSize)
-						found[distance(_target, p->id)].push_back(p);
+						found[distance(target, p->hash)].push_back(p);
 					else
 						break;
 				}
@@ -266,12 +316,12 @@ vector<shared_ptr<NodeEntry>> NodeTable::nearestNodeEntries(NodeId _target)
 	else
 		while (tail > 0 && count < s_bucketSize)
 		{
-			Guard l(x_state);
-			for (auto const& n: m_state[tail].nodes)
+			auto nodes = m_state[tail].nodes();
+			for (auto const& n: *nodes)
 				if (auto p = n.lock())
 				{
 					if (count < s_bucketSize)
-						found[distance(_target, p->id)].push_back(p);
+						found[distance(target, p->hash)].push_back(p);
 					else
 						break;
 				}
@@ -288,9 +338,14 @@ vector<shared_ptr<NodeEntry>> NodeTable::nearestNodeEntries(NodeId _target)
 
 void NodeTable::ping(NodeIPEndpoint _to) const
 {
-	PingNode p(m_node.endpoint, _to);
-	p.sign(m_secret);
-	m_socketPointer->send(p);
+	// m_node.endpoint is updated by the pong handler, so it's only read on the I/O service too.
+	auto self(shared_from_this());
+	m_io.dispatch([this, self, _to]()
+	{
+		PingNode p(m_node.endpoint, _to);
+		p.sign(m_secret);
+		m_socketPointer->send(p);
+	});
 }
 
 void NodeTable::ping(NodeEntry* _n) const
@@ -312,7 +367,11 @@ void NodeTable::evict(shared_ptr<NodeEntry> _leastSeen, shared_ptr<NodeEntry> _n
 	}
 
 	if (ec == 1)
-		doCheckEvictions(boost::system::error_code());
+	{
+		// m_evictionCheckTimer may only be touched on the I/O service; addNode() brings us here from anywhere.
+		auto self(shared_from_this());
+		m_io.dispatch([this, self]() { doCheckEvictions(boost::system::error_code()); });
+	}
 	ping(_leastSeen.get());
 }
 
@@ -332,31 +391,36 @@ void NodeTable::noteActiveNode(Public const& _pubk, bi::udp::endpoint const& _en
 		{
 			Guard l(x_state);
 			NodeBucket& s = bucket_UNSAFE(node.get());
+			NodeBucket::Nodes nodes = *s.nodes();
 			bool removed = false;
-			s.nodes.remove_if([&node, &removed](weak_ptr<NodeEntry> const& n)
+			nodes.erase(remove_if(nodes.begin(), nodes.end(), [&node, &removed](weak_ptr<NodeEntry> const& n)
 			{
 				if (n.lock() == node)
 					removed = true;
 				return removed;
-			});
+			}), nodes.end());
 			
-			if (s.nodes.size() >= s_bucketSize)
+			if (nodes.size() >= s_bucketSize)
 			{
 				// It's only contested iff nodeentry exists
-				contested = s.nodes.front().lock();
+				contested = nodes.front().lock();
 				if (!contested)
 				{
-					s.nodes.pop_front();
-					s.nodes.push_back(node);
+					nodes.erase(nodes.begin());
+					nodes.push_back(node);
+					s.setNodes(move(nodes));
 					s.touch();
 					
 					if (!removed && m_nodeEventHandler)
 						m_nodeEventHandler->appendEvent(node->id, NodeEntryAdded);
 				}
+				else if (removed)
+					s.setNodes(move(nodes));
 			}
 			else
 			{
-				s.nodes.push_back(node);
+				nodes.push_back(node);
+				s.setNodes(move(nodes));
 				s.touch();
 				
 				if (!removed && m_nodeEventHandler)
@@ -375,7 +439,9 @@ void NodeTable::dropNode(shared_ptr<NodeEntry> _n)
 	{
 		Guard l(x_state);
 		NodeBucket& s = bucket_UNSAFE(_n.get());
-		s.nodes.remove_if([&_n](weak_ptr<NodeEntry> n) { return n.lock() == _n; });
+		NodeBucket::Nodes nodes = *s.nodes();
+		nodes.erase(remove_if(nodes.begin(), nodes.end(), [&_n](weak_ptr<NodeEntry> const& n) { return n.lock() == _n; }), nodes.end());
+		s.setNodes(move(nodes));
 	}
 	
 	// notify host
@@ -390,12 +456,67 @@ NodeTable::NodeBucket& NodeTable::bucket_UNSAFE(NodeEntry const* _n)
 }
 
 void NodeTable::onReceived(UDPSocketFace*, bi::udp::endpoint const& _from, bytesConstRef _packet)
+{
+	if (!accept(_from, _packet))
+		return;
+	if (Public nodeid = recoverSender(_packet))
+		interpret(_from, nodeid, _packet);
+	else
+		clog(NodeTableTriviaSummary) << "Invalid message signature from " << _from.address().to_string() << ":" << _from.port();
+}
+
+void NodeTable::onReceivedBatch(UDPSocketFace*, vector<UDPDatagram>&& _batch)
+{
+	// Whatever won't fit behind the packets already waiting for their signatures to be checked is dropped unread,
+	// so that a flood costs us no more than c_maxUnverifiedPackets recoveries' worth of memory.
+	unsigned room = c_maxUnverifiedPackets - min<unsigned>(*m_unverifiedPackets, c_maxUnverifiedPackets);
+	auto packets = make_shared<vector<UDPDatagram>>();
+	unsigned dropped = 0;
+	for (auto& d: _batch)
+		if (packets->size() == room)
+			++dropped;
+		else if (accept(d.endpoint(), &d.data))
+			packets->push_back(move(d));
+	if (dropped)
+		clog(NodeTableTriviaSummary) << "Dropping" << dropped << "packets: too many waiting for verification.";
+	if (packets->empty())
+		return;
+	*m_unverifiedPackets += packets->size();
+
+	// Recover the senders off the I/O threads, then come back to them to act on the packets.
+	// The task holds only a weak reference so that the table is never destroyed on a verifier thread.
+	weak_ptr<NodeTable> table(shared_from_this());
+	ba::io_service& io = m_io;
+	auto unverified = m_unverifiedPackets;
+	m_verifier->post([packets, table, unverified, &io]()
+	{
+		auto senders = make_shared<vector<Public>>();
+		senders->reserve(packets->size());
+		for (auto const& d: *packets)
+			senders->push_back(recoverSender(&d.data));
+		*unverified -= packets->size();
+		io.post([packets, senders, table]()
+		{
+			if (auto t = table.lock())
+				for (unsigned i = 0; i < packets->size(); ++i)
+				{
+					auto const& d = (*packets)[i];
+					if ((*senders)[i])
+						t->interpret(d.endpoint(), (*senders)[i], &d.data);
+					else
+						clog(NodeTableTriviaSummary) << "Invalid message signature from " << d.endpoint().address().to_string() << ":" << d.endpoint().port();
+				}
+		});
+	});
+}
+
+bool NodeTable::accept(bi::udp::endpoint const& _from, bytesConstRef _packet)
 {
 	// h256 + Signature + type + RLP (smallest possible packet is empty neighbours packet which is 3 bytes)
 	if (_packet.size() < h256::size + Signature::size + 1 + 3)
 	{
 		clog(NodeTableTriviaSummary) << "Invalid message size from " << _from.address().to_string() << ":" << _from.port();
-		return;
+		return false;
 	}
 	
 	bytesConstRef hashedBytes(_packet.cropped(h256::size, _packet.size() - h256::size));
@@ -403,22 +524,51 @@ void NodeTable::onReceived(UDPSocketFace*, bi::udp::endpoint const& _from, bytes
 	if (!_packet.cropped(0, h256::size).contentsEqual(hashSigned.asBytes()))
 	{
 		clog(NodeTableTriviaSummary) << "Invalid message hash from " << _from.address().to_string() << ":" << _from.port();
-		return;
+		return false;
 	}
-	
-	bytesConstRef signedBytes(hashedBytes.cropped(Signature::size, hashedBytes.size() - Signature::size));
 
-	// todo: verify sig via known-nodeid and MDC
-	
-	bytesConstRef sigBytes(_packet.cropped(h256::size, Signature::size));
-	Public nodeid(dev::recover(*(Signature const*)sigBytes.data(), sha3(signedBytes)));
-	if (!nodeid)
+	// The hash covers the signature, so a repeat of it is a replay (or a retransmission) of the very same packet.
+	// It's keyed with our own salt so that a sender can't choose which filter bits its packets land on.
+	h256 recent = sha3(hashSigned ^ m_recentSalt);
+	DEV_GUARDED(x_recentPackets)
 	{
-		clog(NodeTableTriviaSummary) << "Invalid message signature from " << _from.address().to_string() << ":" << _from.port();
-		return;
+		if (m_recentPackets.contains(recent))
+		{
+			clog(NodeTableTriviaSummary) << "Duplicate message from " << _from.address().to_string() << ":" << _from.port();
+			return false;
+		}
+		m_recentPackets.insert(recent);
 	}
-	
-	unsigned packetType = signedBytes[0];
+
+	// Requests which have expired would be ignored anyway; don't pay for their signatures.
+	unsigned packetType = _packet[h256::size + Signature::size];
+	if (packetType == PingNode::type || packetType == FindNode::type)
+		try
+		{
+			RLP r(_packet.cropped(h256::size + Signature::size + 1));
+			bool timed = packetType == FindNode::type ? r.itemCount() == 2 : r.itemCount() == 4 && r[0].toInt<unsigned>() == dev::p2p::c_protocolVersion;
+			if (timed && RLPXDatagramFace::secondsSinceEpoch() > r[r.itemCount() - 1].toInt<uint32_t>())
+			{
+				clog(NodeTableTriviaSummary) << "Received expired " << (packetType == FindNode::type ? "FindNode" : "PingNode") << " from " << _from.address().to_string() << ":" << _from.port();
+				return false;
+			}
+		}
+		catch (...) {}
+
+	return true;
+}
+
+Public NodeTable::recoverSender(bytesConstRef _packet)
+{
+	// todo: verify sig via known-nodeid and MDC
+	bytesConstRef signedBytes(_packet.cropped(h256::size + Signature::size));
+	bytesConstRef sigBytes(_packet.cropped(h256::size, Signature::size));
+	return dev::recover(*(Signature const*)sigBytes.data(), sha3(signedBytes));
+}
+
+void NodeTable::interpret(bi::udp::endpoint const& _from, Public const& _nodeid, bytesConstRef _packet)
+{
+	unsigned packetType = _packet[h256::size + Signature::size];
 	bytesConstRef rlpBytes(_packet.cropped(h256::size + Signature::size + 1));
 	RLP rlp(rlpBytes);
 	try {
@@ -433,7 +583,7 @@ void NodeTable::onReceived(UDPSocketFace*, bi::udp::endpoint const& _from, bytes
 				EvictionTimeout evictionEntry;
 				DEV_GUARDED(x_evictions)
 					for (auto it = m_evictions.begin(); it != m_evictions.end(); ++it)
-						if (it->first.first == nodeid && it->first.second > std::chrono::steady_clock::now())
+						if (it->first.first == _nodeid && it->first.second > std::chrono::steady_clock::now())
 						{
 							found = true;
 							evictionEntry = *it;
@@ -450,7 +600,7 @@ void NodeTable::onReceived(UDPSocketFace*, bi::udp::endpoint const& _from, bytes
 				else
 				{
 					// if not, check if it's known/pending or a pubk discovery ping
-					if (auto n = nodeEntry(nodeid))
+					if (auto n = nodeEntry(_nodeid))
 						n->pending = false;
 					else
 					{
@@ -460,8 +610,8 @@ void NodeTable::onReceived(UDPSocketFace*, bi::udp::endpoint const& _from, bytes
 								return; // unsolicited pong; don't note node as active
 							m_pubkDiscoverPings.erase(_from.address());
 						}
-						if (!haveNode(nodeid))
-							addNode(Node(nodeid, NodeIPEndpoint(_from.address(), _from.port(), _from.port())));
+						if (!haveNode(_nodeid))
+							addNode(Node(_nodeid, NodeIPEndpoint(_from.address(), _from.port(), _from.port())));
 					}
 				}
 				
@@ -470,7 +620,7 @@ void NodeTable::onReceived(UDPSocketFace*, bi::udp::endpoint const& _from, bytes
 					m_node.endpoint.address = in.destination.address;
 				m_node.endpoint.udpPort = in.destination.udpPort;
 				
-				clog(NodeTableConnect) << "PONG from " << nodeid << _from;
+				clog(NodeTableConnect) << "PONG from " << _nodeid << _from;
 				break;
 			}
 				
@@ -481,9 +631,9 @@ void NodeTable::onReceived(UDPSocketFace*, bi::udp::endpoint const& _from, bytes
 				DEV_GUARDED(x_findNodeTimeout)
 					m_findNodeTimeout.remove_if([&](NodeIdTimePoint const& t)
 					{
-						if (t.first == nodeid && now - t.second < c_reqTimeout)
+						if (t.first == _nodeid && now - t.second < c_reqTimeout)
 							expected = true;
-						else if (t.first == nodeid)
+						else if (t.first == _nodeid)
 							return true;
 						return false;
 					});
@@ -511,14 +661,16 @@ void NodeTable::onReceived(UDPSocketFace*, bi::udp::endpoint const& _from, bytes
 
 				vector<shared_ptr<NodeEntry>> nearest = nearestNodeEntries(in.target);
 				static unsigned const nlimit = (m_socketPointer->maxDatagramSize - 109) / 90;
+				vector<UDPDatagram> out;
 				for (unsigned offset = 0; offset < nearest.size(); offset += nlimit)
 				{
-					Neighbours out(_from, nearest, offset, nlimit);
-					out.sign(m_secret);
-					if (out.data.size() > 1280)
-						clog(NetWarn) << "Sending truncated datagram, size: " << out.data.size();
-					m_socketPointer->send(out);
+					Neighbours n(_from, nearest, offset, nlimit);
+					n.sign(m_secret);
+					if (n.data.size() > 1280)
+						clog(NetWarn) << "Sending truncated datagram, size: " << n.data.size();
+					out.push_back(move(n));
 				}
+				m_socketPointer->send(move(out));
 				break;
 			}
 
@@ -546,7 +698,7 @@ void NodeTable::onReceived(UDPSocketFace*, bi::udp::endpoint const& _from, bytes
 				
 				in.source.address = _from.address();
 				in.source.udpPort = _from.port();
-				addNode(Node(nodeid, in.source));
+				addNode(Node(_nodeid, in.source));
 				Pong p(in.source);
 				p.echo = sha3(rlpBytes);
 				p.sign(m_secret);
@@ -559,7 +711,7 @@ void NodeTable::onReceived(UDPSocketFace*, bi::udp::endpoint const& _from, bytes
 				return;
 		}
 
-		noteActiveNode(nodeid, _from);
+		noteActiveNode(_nodeid, _from);
 	}
 	catch (...)
 	{
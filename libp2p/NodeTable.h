@@ -22,10 +22,14 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <deque>
+#include <memory>
 
 #include <boost/integer/static_log2.hpp>
 
+#include <libdevcore/RollingBloom.h>
+#include <libdevcore/ThreadPool.h>
 #include <libp2p/UDP.h>
 #include "Common.h"
 
@@ -40,7 +44,9 @@ namespace p2p
  */
 struct NodeEntry: public Node
 {
-	NodeEntry(Node _src, Public _pubk, NodeIPEndpoint _gw);
+	NodeEntry(h256 const& _srcHash, Public _pubk, NodeIPEndpoint _gw);
+	NodeEntry(Node const& _src, Public _pubk, NodeIPEndpoint _gw): NodeEntry(sha3(_src.id), _pubk, _gw) {}
+	h256 const hash;			///< sha3 of the node's id, the point at which it sits in the xor metric's space.
 	unsigned const distance;	///< Node's distance (xor of _src as integer).
 	bool pending = true;		///< Node will be ignored until Pong is received
 };
@@ -130,11 +136,15 @@ public:
 	enum NodeRelation { Unknown = 0, Known };
 	
 	/// Constructor requiring host for I/O, credentials, and IP Address and port to listen on.
+	/// @a _io must be run by a single thread: the table's handlers, timers and socket all rely on it to keep them apart.
 	NodeTable(ba::io_service& _io, KeyPair const& _alias, NodeIPEndpoint const& _endpoint);
 	~NodeTable();
 
 	/// Returns distance based on xor metric two node ids. Used by NodeEntry and NodeTable.
-	static unsigned distance(NodeId const& _a, NodeId const& _b) { u256 d = sha3(_a) ^ sha3(_b); unsigned ret; for (ret = 0; d >>= 1; ++ret) {}; return ret; }
+	static unsigned distance(NodeId const& _a, NodeId const& _b) { return distance(sha3(_a), sha3(_b)); }
+
+	/// Returns distance based on xor metric of two node ids' hashes (i.e. the index of the highest bit in which they differ, or 0 if none).
+	static unsigned distance(h256 const& _a, h256 const& _b);
 
 	/// Set event handler for NodeEntryAdded and NodeEntryDropped events.
 	void setEventHandler(NodeTableEventHandler* _handler) { m_nodeEventHandler.reset(_handler); }
@@ -146,6 +156,7 @@ public:
 	std::shared_ptr<NodeEntry> addNode(Node const& _node, NodeRelation _relation = NodeRelation::Unknown);
 
 	/// To be called when node table is empty. Runs node discovery with m_node.id as the target in order to populate node-table.
+	/// May be called from any thread; the discovery itself runs on the I/O service.
 	void discover();
 
 	/// Returns list of node ids active in node table.
@@ -180,6 +191,8 @@ private:
 
 	static unsigned const s_bucketSize = 16;			///< Denoted by k in [Kademlia]. Number of nodes stored in each bucket.
 	static unsigned const s_alpha = 3;				///< Denoted by \alpha in [Kademlia]. Number of concurrent FindNode requests.
+	static unsigned const c_verifierThreads = 2;	///< Number of threads recovering the senders of received packets.
+	static unsigned const c_maxUnverifiedPackets = 1024;	///< Most received packets which may wait for their senders to be recovered; the rest are dropped.
 
 	/// Intervals
 
@@ -188,22 +201,40 @@ private:
 	std::chrono::milliseconds const c_reqTimeout = std::chrono::milliseconds(300);						///< How long to wait for requests (evict, find iterations).
 	std::chrono::milliseconds const c_bucketRefresh = std::chrono::milliseconds(57600);							///< Refresh interval prevents bucket from becoming stale. [Kademlia]
 
+	/// A bucket's nodes are an immutable list, replaced whole whenever it changes, so that readers only hold
+	/// a lock for as long as it takes to copy the pointer.
 	struct NodeBucket
 	{
+		using Nodes = std::vector<std::weak_ptr<NodeEntry>>;	///< Least recently seen first.
+
 		unsigned distance;
 		TimePoint modified;
-		std::list<std::weak_ptr<NodeEntry>> nodes;
+
+		/// @returns the bucket's current nodes.
+		std::shared_ptr<Nodes const> nodes() const { SpinGuard l(x_nodes); return m_nodes; }
+		/// Replaces the bucket's nodes with @a _nodes. Must hold x_state.
+		void setNodes(Nodes&& _nodes)
+		{
+			std::shared_ptr<Nodes const> n = std::make_shared<Nodes>(std::move(_nodes));
+			SpinGuard l(x_nodes);
+			m_nodes.swap(n);
+		}
 		void touch() { modified = std::chrono::steady_clock::now(); }
+
+	private:
+		/// Guards only the pointer; std::atomic_load/atomic_store for shared_ptr need a newer libstdc++ than we require.
+		mutable SpinLock x_nodes;
+		std::shared_ptr<Nodes const> m_nodes = std::make_shared<Nodes const>();
 	};
 
-	/// Used to ping endpoint.
+	/// Used to ping endpoint. May be called from any thread; the ping is sent from the I/O service, where m_node.endpoint is kept.
 	void ping(NodeIPEndpoint _to) const;
 
 	/// Used ping known node. Used by node table when refreshing buckets and as part of eviction process (see evict).
 	void ping(NodeEntry* _n) const;
 
 	/// Returns center node entry which describes this node and used with dist() to calculate xor metric for node table nodes.
-	NodeEntry center() const { return NodeEntry(m_node, m_node.publicKey(), m_node.endpoint); }
+	NodeEntry center() const { return NodeEntry(m_nodeHash, m_node.publicKey(), m_node.endpoint); }
 
 	/// Used by asynchronous operations to return NodeEntry which is active and managed by node table.
 	std::shared_ptr<NodeEntry> nodeEntry(NodeId _id);
@@ -225,7 +256,7 @@ private:
 	void dropNode(std::shared_ptr<NodeEntry> _n);
 
 	/// Returns references to bucket which corresponds to distance of node id.
-	/// @warning Only use the return reference locked x_state mutex.
+	/// @warning Only change the bucket with x_state locked.
 	// TODO p2p: Remove this method after removing offset-by-one functionality.
 	NodeBucket& bucket_UNSAFE(NodeEntry const* _n);
 
@@ -234,6 +265,19 @@ private:
 	/// Called by m_socket when packet is received.
 	void onReceived(UDPSocketFace*, bi::udp::endpoint const& _from, bytesConstRef _packet);
 
+	/// Called by m_socket with the packets read in one go. Their signatures are checked on m_verifier and they're then interpreted back on the I/O service.
+	void onReceivedBatch(UDPSocketFace*, std::vector<UDPDatagram>&& _batch);
+
+	/// Cheap checks made before a packet's signature is: its size and hash, that it's not a repeat and, for requests, that it's not expired.
+	/// @returns true iff the packet is worth verifying.
+	bool accept(bi::udp::endpoint const& _from, bytesConstRef _packet);
+
+	/// @returns the id of the node which signed @a _packet, or null if the signature is invalid. Thread-safe; costs an ECDSA recovery.
+	static Public recoverSender(bytesConstRef _packet);
+
+	/// Acts on an accepted @a _packet, signed by @a _nodeid, from @a _from.
+	void interpret(bi::udp::endpoint const& _from, Public const& _nodeid, bytesConstRef _packet);
+
 	/// Called by m_socket when socket is disconnected.
 	void onDisconnected(UDPSocketFace*) {}
 
@@ -248,13 +292,14 @@ private:
 	std::unique_ptr<NodeTableEventHandler> m_nodeEventHandler;		///< Event handler for node events.
 
 	Node m_node;													///< This node.
+	h256 m_nodeHash;												///< sha3(m_node.id).
 	Secret m_secret;												///< This nodes secret key.
 
 	mutable Mutex x_nodes;											///< LOCK x_state first if both locks are required. Mutable for thread-safe copy in nodes() const.
 	std::unordered_map<NodeId, std::shared_ptr<NodeEntry>> m_nodes;	///< Nodes
 
-	mutable Mutex x_state;											///< LOCK x_state first if both x_nodes and x_state locks are required.
-	std::array<NodeBucket, s_bins> m_state;							///< State of p2p node network.
+	mutable Mutex x_state;											///< Serialises changes to m_state. LOCK x_state first if both x_nodes and x_state locks are required.
+	std::array<NodeBucket, s_bins> m_state;							///< State of p2p node network. Buckets may be read without locking.
 
 	Mutex x_evictions;												///< LOCK x_evictions first if both x_nodes and x_evictions locks are required.
 	std::deque<EvictionTimeout> m_evictions;						///< Eviction timeouts.
@@ -265,12 +310,18 @@ private:
 	Mutex x_findNodeTimeout;
 	std::list<NodeIdTimePoint> m_findNodeTimeout;					///< Timeouts for pending Ping and FindNode requests.
 	
-	ba::io_service& m_io;											///< Used by bucket refresh timer.
+	ba::io_service& m_io;											///< Runs the socket, timers and packet handling, all on one thread.
 	std::shared_ptr<NodeSocket> m_socket;							///< Shared pointer for our UDPSocket; ASIO requires shared_ptr.
 	NodeSocket* m_socketPointer;									///< Set to m_socket.get(). Socket is created in constructor and disconnected in destructor to ensure access to pointer is safe.
 
 	boost::asio::deadline_timer m_bucketRefreshTimer;				///< Timer which schedules and enacts bucket refresh.
 	boost::asio::deadline_timer m_evictionCheckTimer;				///< Timer for handling node evictions.
+
+	std::unique_ptr<ThreadPool> m_verifier;							///< Recovers the senders of received packets off the I/O threads.
+	std::shared_ptr<std::atomic<unsigned>> m_unverifiedPackets;		///< Packets posted to m_verifier and not yet recovered. Shared with its tasks.
+	h256 m_recentSalt;												///< Keys m_recentPackets.
+	Mutex x_recentPackets;
+	RollingBloom<65536, 1024> m_recentPackets;						///< Hashes of packets recently accepted, so repeats are dropped before their signatures are checked.
 };
 
 inline std::ostream& operator<<(std::ostream& _out, NodeTable const& _nodeTable)
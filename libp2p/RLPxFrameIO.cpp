@@ -97,33 +97,32 @@ RLPXFrameIO::RLPXFrameIO(RLPXHandshake const& _init): m_socket(_init.m_socket)
 void RLPXFrameIO::writeSingleFramePacket(bytesConstRef _packet, bytes& o_bytes)
 {
 	// _packet = type || rlpList()
+	o_bytes.resize(frameSize(_packet.size()));
+	_packet.copyTo(bytesRef(&o_bytes).cropped(h256::size, _packet.size()));
+	sealFramePacket(&o_bytes, _packet.size());
+}
+
+void RLPXFrameIO::sealFramePacket(bytesRef io_frame, size_t _packetSize)
+{
+	asserts(io_frame.size() == frameSize(_packetSize));
 
-	RLPStream header;
-	uint32_t len = (uint32_t)_packet.size();
-	header.appendRaw(bytes({byte((len >> 16) & 0xff), byte((len >> 8) & 0xff), byte(len & 0xff)}));
+	// header = frame-size || zeroHeader, zero-padded to 16 bytes.
 	// zeroHeader: []byte{0xC2, 0x80, 0x80}. Should be rlpList(protocolType,seqId,totalPacketSize).
-	header.appendRaw(bytes({0xc2,0x80,0x80}));
-	
-	// TODO: SECURITY check that header is <= 16 bytes
-
-	bytes headerWithMac(h256::size);
-	bytesConstRef(&header.out()).copyTo(bytesRef(&headerWithMac));
-	m_frameEnc.ProcessData(headerWithMac.data(), headerWithMac.data(), 16);
-	updateEgressMACWithHeader(bytesConstRef(&headerWithMac).cropped(0, 16));
-	egressDigest().ref().copyTo(bytesRef(&headerWithMac).cropped(h128::size,h128::size));
-
-	auto padding = (16 - (_packet.size() % 16)) % 16;
-	o_bytes.swap(headerWithMac);
-	o_bytes.resize(32 + _packet.size() + padding + h128::size);
-	bytesRef packetRef(o_bytes.data() + 32, _packet.size());
-	m_frameEnc.ProcessData(packetRef.data(), _packet.data(), _packet.size());
-	bytesRef paddingRef(o_bytes.data() + 32 + _packet.size(), padding);
-	if (padding)
-		m_frameEnc.ProcessData(paddingRef.data(), paddingRef.data(), padding);
-	bytesRef packetWithPaddingRef(o_bytes.data() + 32, _packet.size() + padding);
+	bytesRef header = io_frame.cropped(0, h128::size);
+	uint32_t len = (uint32_t)_packetSize;
+	byte const headerPrefix[] = { byte((len >> 16) & 0xff), byte((len >> 8) & 0xff), byte(len & 0xff), 0xc2, 0x80, 0x80 };
+	std::fill(header.begin(), header.end(), 0);
+	std::copy(headerPrefix, headerPrefix + sizeof(headerPrefix), header.begin());
+	m_frameEnc.ProcessData(header.data(), header.data(), h128::size);
+	updateEgressMACWithHeader(header);
+	egressDigest().ref().copyTo(io_frame.cropped(h128::size, h128::size));
+
+	auto padding = (16 - _packetSize % 16) % 16;
+	bytesRef packetWithPaddingRef = io_frame.cropped(h256::size, _packetSize + padding);
+	std::fill(packetWithPaddingRef.begin() + _packetSize, packetWithPaddingRef.end(), 0);
+	m_frameEnc.ProcessData(packetWithPaddingRef.data(), packetWithPaddingRef.data(), packetWithPaddingRef.size());
 	updateEgressMACWithFrame(packetWithPaddingRef);
-	bytesRef macRef(o_bytes.data() + 32 + _packet.size() + padding, h128::size);
-	egressDigest().ref().copyTo(macRef);
+	egressDigest().ref().copyTo(io_frame.cropped(h256::size + packetWithPaddingRef.size(), h128::size));
 }
 
 bool RLPXFrameIO::authAndDecryptHeader(bytesRef io)
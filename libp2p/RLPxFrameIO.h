@@ -82,6 +82,12 @@ public:
 	/// Encrypt _packet as RLPx frame.
 	void writeSingleFramePacket(bytesConstRef _packet, bytes& o_bytes);
 
+	/// @returns the size of the RLPx frame (header, header MAC, padded packet and frame MAC) which carries a packet of @a _packetSize bytes.
+	static size_t frameSize(size_t _packetSize) { return h256::size + _packetSize + (16 - _packetSize % 16) % 16 + h128::size; }
+
+	/// Encrypt in place the frame @a io_frame of frameSize(_packetSize) bytes, whose plaintext packet starts after the 32 bytes left for the header.
+	void sealFramePacket(bytesRef io_frame, size_t _packetSize);
+
 	/// Authenticate and decrypt header in-place.
 	bool authAndDecryptHeader(bytesRef io_cipherWithMac);
 	
@@ -109,7 +115,11 @@ protected:
 	
 	bi::tcp::socket& socket() { return m_socket->ref(); }
 	
+#if defined(BOOST_AUTO_TEST_SUITE) || defined(_MSC_VER) // MSVC includes access specifier in symbol name
+protected:
+#else
 private:
+#endif
 	/// Update state of _mac.
 	void updateMAC(CryptoPP::SHA3_256& _mac, bytesConstRef _seed = bytesConstRef());
 
@@ -48,10 +48,10 @@ void RLPXHandshake::writeAuth()
 	encryptECIES(m_remote, &m_auth, m_authCipher);
 
 	auto self(shared_from_this());
-	ba::async_write(m_socket->ref(), ba::buffer(m_authCipher), [this, self](boost::system::error_code ec, std::size_t)
+	ba::async_write(m_socket->ref(), ba::buffer(m_authCipher), m_strand.wrap([this, self](boost::system::error_code ec, std::size_t)
 	{
 		transition(ec);
-	});
+	}));
 }
 
 void RLPXHandshake::writeAck()
@@ -66,10 +66,10 @@ void RLPXHandshake::writeAck()
 	encryptECIES(m_remote, &m_ack, m_ackCipher);
 	
 	auto self(shared_from_this());
-	ba::async_write(m_socket->ref(), ba::buffer(m_ackCipher), [this, self](boost::system::error_code ec, std::size_t)
+	ba::async_write(m_socket->ref(), ba::buffer(m_ackCipher), m_strand.wrap([this, self](boost::system::error_code ec, std::size_t)
 	{
 		transition(ec);
-	});
+	}));
 }
 
 void RLPXHandshake::readAuth()
@@ -77,7 +77,7 @@ void RLPXHandshake::readAuth()
 	clog(NetConnect) << "p2p.connect.ingress recving auth from " << m_socket->remoteEndpoint();
 	m_authCipher.resize(307);
 	auto self(shared_from_this());
-	ba::async_read(m_socket->ref(), ba::buffer(m_authCipher, 307), [this, self](boost::system::error_code ec, std::size_t)
+	ba::async_read(m_socket->ref(), ba::buffer(m_authCipher, 307), m_strand.wrap([this, self](boost::system::error_code ec, std::size_t)
 	{
 		if (ec)
 			transition(ec);
@@ -105,7 +105,7 @@ void RLPXHandshake::readAuth()
 			m_nextState = Error;
 			transition();
 		}
-	});
+	}));
 }
 
 void RLPXHandshake::readAck()
@@ -113,7 +113,7 @@ void RLPXHandshake::readAck()
 	clog(NetConnect) << "p2p.connect.egress recving ack from " << m_socket->remoteEndpoint();
 	m_ackCipher.resize(210);
 	auto self(shared_from_this());
-	ba::async_read(m_socket->ref(), ba::buffer(m_ackCipher, 210), [this, self](boost::system::error_code ec, std::size_t)
+	ba::async_read(m_socket->ref(), ba::buffer(m_ackCipher, 210), m_strand.wrap([this, self](boost::system::error_code ec, std::size_t)
 	{
 		if (ec)
 			transition(ec);
@@ -129,7 +129,7 @@ void RLPXHandshake::readAck()
 			m_nextState = Error;
 			transition();
 		}
-	});
+	}));
 }
 
 void RLPXHandshake::error()
@@ -193,10 +193,10 @@ void RLPXHandshake::transition(boost::system::error_code _ech)
 		bytes packet;
 		s.swapOut(packet);
 		m_io->writeSingleFramePacket(&packet, m_handshakeOutBuffer);
-		ba::async_write(m_socket->ref(), ba::buffer(m_handshakeOutBuffer), [this, self](boost::system::error_code ec, std::size_t)
+		ba::async_write(m_socket->ref(), ba::buffer(m_handshakeOutBuffer), m_strand.wrap([this, self](boost::system::error_code ec, std::size_t)
 		{
 			transition(ec);
-		});
+		}));
 	}
 	else if (m_nextState == ReadHello)
 	{
@@ -206,7 +206,7 @@ void RLPXHandshake::transition(boost::system::error_code _ech)
 		
 		// read frame header
 		m_handshakeInBuffer.resize(h256::size);
-		ba::async_read(m_socket->ref(), boost::asio::buffer(m_handshakeInBuffer, h256::size), [this, self](boost::system::error_code ec, std::size_t)
+		ba::async_read(m_socket->ref(), boost::asio::buffer(m_handshakeInBuffer, h256::size), m_strand.wrap([this, self](boost::system::error_code ec, std::size_t)
 		{
 			if (ec)
 				transition(ec);
@@ -240,7 +240,7 @@ void RLPXHandshake::transition(boost::system::error_code _ech)
 				
 				/// read padded frame and mac
 				m_handshakeInBuffer.resize(frameSize + ((16 - (frameSize % 16)) % 16) + h128::size);
-				ba::async_read(m_socket->ref(), boost::asio::buffer(m_handshakeInBuffer, m_handshakeInBuffer.size()), [this, self, headerRLP](boost::system::error_code ec, std::size_t)
+				ba::async_read(m_socket->ref(), boost::asio::buffer(m_handshakeInBuffer, m_handshakeInBuffer.size()), m_strand.wrap([this, self, headerRLP](boost::system::error_code ec, std::size_t)
 				{
 					if (ec)
 						transition(ec);
@@ -268,13 +268,13 @@ void RLPXHandshake::transition(boost::system::error_code _ech)
 						RLP rlp(frame.cropped(1), RLP::ThrowOnFail | RLP::FailIfTooSmall);
 						m_host->startPeerSession(m_remote, rlp, m_io, m_socket->remoteEndpoint());
 					}
-				});
+				}));
 			}
-		});
+		}));
 	}
 	
 	m_idleTimer.expires_from_now(c_timeout);
-	m_idleTimer.async_wait([this, self](boost::system::error_code const& _ec)
+	m_idleTimer.async_wait(m_strand.wrap([this, self](boost::system::error_code const& _ec)
 	{
 		if (!_ec)
 		{
@@ -282,5 +282,5 @@ void RLPXHandshake::transition(boost::system::error_code _ech)
 				clog(NetConnect) << "Disconnecting " << m_socket->remoteEndpoint() << " (Handshake Timeout)";
 			cancel();
 		}
-	});
+	}));
 }
@@ -23,6 +23,7 @@
 #pragma once
 
 #include <memory>
+#include <atomic>
 #include <libdevcrypto/Common.h>
 #include <libdevcrypto/ECDHE.h>
 #include "RLPxFrameIO.h"
@@ -62,17 +63,17 @@ class RLPXHandshake: public std::enable_shared_from_this<RLPXHandshake>
 	
 public:
 	/// Setup incoming connection.
-	RLPXHandshake(Host* _host, std::shared_ptr<RLPXSocket> const& _socket): m_host(_host), m_originated(false), m_socket(_socket), m_idleTimer(m_socket->ref().get_io_service()) { crypto::Nonce::get().ref().copyTo(m_nonce.ref()); }
+	RLPXHandshake(Host* _host, std::shared_ptr<RLPXSocket> const& _socket): m_host(_host), m_originated(false), m_socket(_socket), m_strand(m_socket->ref().get_io_service()), m_idleTimer(m_socket->ref().get_io_service()) { crypto::Nonce::get().ref().copyTo(m_nonce.ref()); }
 	
 	/// Setup outbound connection.
-	RLPXHandshake(Host* _host, std::shared_ptr<RLPXSocket> const& _socket, NodeId _remote): m_host(_host), m_remote(_remote), m_originated(true), m_socket(_socket), m_idleTimer(m_socket->ref().get_io_service()) { crypto::Nonce::get().ref().copyTo(m_nonce.ref()); }
+	RLPXHandshake(Host* _host, std::shared_ptr<RLPXSocket> const& _socket, NodeId _remote): m_host(_host), m_remote(_remote), m_originated(true), m_socket(_socket), m_strand(m_socket->ref().get_io_service()), m_idleTimer(m_socket->ref().get_io_service()) { crypto::Nonce::get().ref().copyTo(m_nonce.ref()); }
 
 	~RLPXHandshake() {}
 
 	/// Start handshake.
-	void start() { transition(); }
+	void start() { auto self(shared_from_this()); m_strand.dispatch([this, self]() { transition(); }); }
 
-	/// Cancels handshake preventing
+	/// Cancels handshake preventing. May be called from any thread.
 	void cancel() { m_cancel = true; }
 	
 protected:
@@ -98,7 +99,7 @@ protected:
 	boost::posix_time::milliseconds const c_timeout = boost::posix_time::milliseconds(1800);
 
 	State m_nextState = New;			///< Current or expected state of transition.
-	bool m_cancel = false;			///< Will be set to true if connection was canceled.
+	std::atomic<bool> m_cancel{false};	///< Will be set to true if connection was canceled.
 	
 	Host* m_host;					///< Host which provides m_alias, protocolVersion(), m_clientVersion, caps(), and TCP listenPort().
 	
@@ -125,6 +126,7 @@ protected:
 	RLPXFrameIO* m_io = nullptr;
 	
 	std::shared_ptr<RLPXSocket> m_socket;		///< Socket.
+	ba::io_service::strand m_strand;			///< Runs the socket's and m_idleTimer's handlers one at a time, whichever I/O thread picks them up.
 	boost::asio::deadline_timer m_idleTimer;	///< Timer which enforces c_timeout.
 };
 	
@@ -37,6 +37,7 @@ Session::Session(Host* _s, RLPXFrameIO* _io, std::shared_ptr<Peer> const& _n, Pe
 	m_server(_s),
 	m_io(_io),
 	m_socket(m_io->socket()),
+	m_strand(_s->m_ioService),
 	m_peer(_n),
 	m_info(_info),
 	m_ping(chrono::steady_clock::time_point::max())
@@ -86,6 +87,12 @@ void Session::addRating(int _r)
 	}
 }
 
+void Session::postRating(int _r)
+{
+	auto self(shared_from_this());
+	m_strand.post([this, self, _r]() { addRating(_r); });
+}
+
 int Session::rating() const
 {
 	return m_peer->m_rating;
@@ -277,10 +284,15 @@ RLPStream& Session::prep(RLPStream& _s, PacketType _id, unsigned _args)
 }
 
 void Session::sealAndSend(RLPStream& _s)
+{
+	sealAndSend(_s, vector<bytesConstRef>());
+}
+
+void Session::sealAndSend(RLPStream& _s, vector<bytesConstRef> const& _payload)
 {
 	bytes b;
 	_s.swapOut(b);
-	send(move(b));
+	send(&b, _payload);
 }
 
 bool Session::checkPacket(bytesConstRef _msg)
@@ -295,34 +307,89 @@ bool Session::checkPacket(bytesConstRef _msg)
 	return true;
 }
 
-void Session::send(bytes&& _msg)
+void Session::send(bytesConstRef _prefix, vector<bytesConstRef> const& _parts)
 {
-	clog(NetLeft) << RLP(bytesConstRef(&_msg).cropped(1));
+	// the socket itself is only looked at on m_strand (see write())
+	if (m_dropped)
+		return;
 
-	bytesConstRef msg(&_msg);
-	if (!checkPacket(msg))
-		clog(NetWarn) << "INVALID PACKET CONSTRUCTED!";
+	size_t size = _prefix.size();
+	for (auto const& p: _parts)
+		size += p.size();
 
-	if (!m_socket.is_open())
-		return;
+	Frame f{bytes(), size};
+	{
+		Guard l(x_writeQueue);
+		if (!m_framePool.empty())
+		{
+			f.data.swap(m_framePool.back());
+			m_framePool.pop_back();
+		}
+	}
+
+	// Gather everything straight into its place in the frame; it's encrypted in place by write().
+	f.data.resize(RLPXFrameIO::frameSize(size));
+	bytesRef out = bytesRef(&f.data).cropped(h256::size, size);
+	_prefix.copyTo(out);
+	size_t offset = _prefix.size();
+	for (auto const& p: _parts)
+	{
+		p.copyTo(out.cropped(offset));
+		offset += p.size();
+	}
+
+	bytesConstRef packet(out.data(), out.size());
+	clog(NetLeft) << RLP(packet.cropped(1));
+	if (!checkPacket(packet))
+		clog(NetWarn) << "INVALID PACKET CONSTRUCTED!";
 
 	bool doWrite = false;
 	{
 		Guard l(x_writeQueue);
-		m_writeQueue.push_back(_msg);
-		doWrite = (m_writeQueue.size() == 1);
+		m_writeQueue.push_back(move(f));
+		doWrite = !m_writing;
+		m_writing = true;
 	}
 
 	if (doWrite)
-		write();
+	{
+		auto self(shared_from_this());
+		m_strand.dispatch([this, self]() { write(); });
+	}
+}
+
+void Session::recycleFrame(bytes&& _buffer)
+{
+	if (m_framePool.size() < c_maxPooledFrames && _buffer.capacity() <= c_maxPooledFrameSize)
+		m_framePool.push_back(move(_buffer));
 }
 
 void Session::write()
 {
-	const bytes& bytes = m_writeQueue[0];
-	m_io->writeSingleFramePacket(&bytes, m_writeQueue[0]);
+	if (!m_socket.is_open())
+		return;
+
+	{
+		Guard l(x_writeQueue);
+		size_t total = 0;
+		while (!m_writeQueue.empty() && (m_inFlight.empty() || total + m_writeQueue.front().data.size() <= c_maxWriteBytes))
+		{
+			total += m_writeQueue.front().data.size();
+			m_inFlight.push_back(move(m_writeQueue.front()));
+			m_writeQueue.pop_front();
+		}
+	}
+
+	// Frames must be sealed in the order they're sent, as each advances the egress cipher and MAC.
+	m_inFlightBuffers.clear();
+	for (Frame& f: m_inFlight)
+	{
+		m_io->sealFramePacket(&f.data, f.packetSize);
+		m_inFlightBuffers.push_back(ba::buffer(f.data));
+	}
+
 	auto self(shared_from_this());
-	ba::async_write(m_socket, ba::buffer(bytes), [this, self](boost::system::error_code ec, std::size_t /*length*/)
+	ba::async_write(m_socket, m_inFlightBuffers, m_strand.wrap([this, self](boost::system::error_code ec, std::size_t /*length*/)
 	{
 		ThreadContext tc(info().id.abridged());
 		ThreadContext tc2(info().clientVersion);
@@ -336,16 +403,28 @@ void Session::write()
 		else
 		{
 			Guard l(x_writeQueue);
-			m_writeQueue.pop_front();
+			for (Frame& f: m_inFlight)
+				recycleFrame(move(f.data));
+			m_inFlight.clear();
 			if (m_writeQueue.empty())
+			{
+				m_writing = false;
 				return;
+			}
 		}
 		write();
-	});
+	}));
 }
 
 void Session::drop(DisconnectReason _reason)
 {
+	if (!m_strand.running_in_this_thread())
+	{
+		// the socket may only be closed between its operations' handlers
+		auto self(shared_from_this());
+		m_strand.dispatch([this, self, _reason]() { drop(_reason); });
+		return;
+	}
 	if (m_dropped)
 		return;
 	if (m_socket.is_open())
@@ -369,6 +448,13 @@ void Session::drop(DisconnectReason _reason)
 
 void Session::disconnect(DisconnectReason _reason)
 {
+	if (!m_strand.running_in_this_thread())
+	{
+		// as with drop(), the socket is only looked at between its operations' handlers
+		auto self(shared_from_this());
+		m_strand.dispatch([this, self, _reason]() { disconnect(_reason); });
+		return;
+	}
 	clog(NetConnect) << "Disconnecting (our reason:" << reasonOf(_reason) << ")";
 	StructuredLogger::p2pDisconnected(
 		m_info.id.abridged(),
@@ -397,7 +483,7 @@ void Session::doRead()
 		return;
 
 	auto self(shared_from_this());
-	ba::async_read(m_socket, boost::asio::buffer(m_data, h256::size), [this,self](boost::system::error_code ec, std::size_t length)
+	ba::async_read(m_socket, boost::asio::buffer(m_header), m_strand.wrap([this,self](boost::system::error_code ec, std::size_t length)
 	{
 		ThreadContext tc(info().id.abridged());
 		ThreadContext tc2(info().clientVersion);
@@ -411,7 +497,7 @@ void Session::doRead()
 		else
 		{
 			/// authenticate and decrypt header
-			bytesRef header(m_data.data(), h256::size);
+			bytesRef header(m_header.data(), h256::size);
 			if (!m_io->authAndDecryptHeader(header))
 			{
 				clog(NetWarn) << "header decrypt failed";
@@ -420,7 +506,7 @@ void Session::doRead()
 			}
 
 			/// check frame size
-			uint32_t frameSize = (m_data[0] * 256 + m_data[1]) * 256 + m_data[2];
+			uint32_t frameSize = (m_header[0] * 256 + m_header[1]) * 256 + m_header[2];
 			if (frameSize >= (uint32_t)1 << 24)
 			{
 				clog(NetWarn) << "frame size too large";
@@ -430,11 +516,14 @@ void Session::doRead()
 			
 			/// rlp of header has protocol-type, sequence-id[, total-packet-size]
 			bytes headerRLP(13);
-			bytesConstRef(m_data.data(), h128::size).cropped(3).copyTo(&headerRLP);
+			bytesConstRef(m_header.data(), h128::size).cropped(3).copyTo(&headerRLP);
 			
-			/// read padded frame and mac
+			/// read padded frame and mac into a buffer of our own; the last one is reused unless some of it was retained
 			auto tlen = frameSize + ((16 - (frameSize % 16)) % 16) + h128::size;
-			ba::async_read(m_socket, boost::asio::buffer(m_data, tlen), [this, self, headerRLP, frameSize, tlen](boost::system::error_code ec, std::size_t length)
+			if (!m_frame || !m_frame.unique() || m_frame->capacity() > c_maxReusedFrameSize)
+				m_frame = make_shared<bytes>();
+			m_frame->resize(tlen);
+			ba::async_read(m_socket, boost::asio::buffer(*m_frame), m_strand.wrap([this, self, headerRLP, frameSize](boost::system::error_code ec, std::size_t length)
 			{
 				ThreadContext tc(info().id.abridged());
 				ThreadContext tc2(info().clientVersion);
@@ -447,14 +536,14 @@ void Session::doRead()
 					return;
 				else
 				{
-					if (!m_io->authAndDecryptFrame(bytesRef(m_data.data(), tlen)))
+					if (!m_io->authAndDecryptFrame(bytesRef(m_frame.get())))
 					{
 						clog(NetWarn) << "frame decrypt failed";
 						drop(BadProtocol); // todo: better error
 						return;
 					}
 					
-					bytesConstRef frame(m_data.data(), frameSize);
+					bytesConstRef frame(m_frame->data(), frameSize);
 					if (!checkPacket(frame))
 					{
 						cerr << "Received " << frame.size() << ": " << toHex(frame) << endl;
@@ -462,16 +551,49 @@ void Session::doRead()
 						disconnect(BadProtocol);
 						return;
 					}
-					else
+					auto packetType = (PacketType)RLP(frame.cropped(0, 1)).toInt<unsigned>();
+					// @returns false if the packet threw something interpret() didn't catch, in which case the peer's dropped
+					// rather than read from again: whatever it sent has left us in a state we know nothing about.
+					auto handle = [this, packetType, frame]()
 					{
-						auto packetType = (PacketType)RLP(frame.cropped(0, 1)).toInt<unsigned>();
-						RLP r(frame.cropped(1));
-						if (!interpret(packetType, r))
-							clog(NetWarn) << "Couldn't interpret packet." << RLP(r);
+						try
+						{
+							RLP r(frame.cropped(1));
+							if (!interpret(packetType, r))
+								clog(NetWarn) << "Couldn't interpret packet." << RLP(r);
+							return true;
+						}
+						catch (...)
+						{
+							clog(NetWarn) << "Exception handling packet" << packetType << ":" << boost::current_exception_diagnostic_information();
+							return false;
+						}
+					};
+					if (packetType >= UserPacket && m_server->m_capabilityWorker)
+					{
+						// Capability packets can be costly to handle, so they go to the host's capability thread.
+						// The next frame isn't read until this one is handled, which keeps m_frame valid and the order intact.
+						m_server->m_capabilityWorker->post([this, self, handle]()
+						{
+							ThreadContext tc(info().id.abridged());
+							ThreadContext tc2(info().clientVersion);
+							bool handled = handle();
+							m_strand.post([this, self, handled]()
+							{
+								if (handled)
+									doRead();
+								else
+									drop(BadProtocol);
+							});
+						});
+						return;
 					}
-					doRead();
+					if (handle())
+						doRead();
+					else
+						drop(BadProtocol);
 				}
-			});
+			}));
 		}
-	});
+	}));
 }
@@ -23,6 +23,7 @@
 #pragma once
 
 #include <mutex>
+#include <atomic>
 #include <array>
 #include <deque>
 #include <set>
@@ -33,6 +34,7 @@
 #include <libdevcore/RLP.h>
 #include <libdevcore/RangeMask.h>
 #include <libdevcore/Guards.h>
+#include <libdevcore/SharedBytes.h>
 #include "RLPxHandshake.h"
 #include "Common.h"
 
@@ -62,7 +64,7 @@ public:
 
 	void ping();
 
-	bool isConnected() const { return m_socket.is_open(); }
+	bool isConnected() const { return !m_dropped; }
 
 	NodeId id() const;
 	unsigned socketId() const { return m_info.socketId; }
@@ -72,19 +74,29 @@ public:
 
 	static RLPStream& prep(RLPStream& _s, PacketType _t, unsigned _args = 0);
 	void sealAndSend(RLPStream& _s);
+	/// Sends the packet begun in @a _s followed by @a _payload, gathered straight into the outgoing frame.
+	/// The buffers in @a _payload need only stay valid for the duration of the call.
+	void sealAndSend(RLPStream& _s, std::vector<bytesConstRef> const& _payload);
 
 	int rating() const;
 	void addRating(int _r);
+	/// Adds @a _r to the rating on the session's strand; for threads which neither read the session nor interpret its packets.
+	void postRating(int _r);
 
 	void addNote(std::string const& _k, std::string const& _v) { m_info.notes[_k] = _v; }
 
 	PeerSessionInfo const& info() const { return m_info; }
 
+	/// @returns a view of @a _data, which must lie within the packet being interpreted, that keeps the packet's receive buffer alive.
+	/// Lets capabilities hold on to received data without copying it. Only to be called during interpret().
+	SharedBytesRef retain(bytesConstRef _data) const { return SharedBytesRef(m_frame, _data); }
+
 	void ensureNodesRequested();
 	void serviceNodesRequest();
 
 private:
-	void send(bytes&& _msg);
+	/// Queues the packet made of @a _prefix followed by each of @a _parts, copying them into a pooled frame buffer.
+	void send(bytesConstRef _prefix, std::vector<bytesConstRef> const& _parts);
 
 	/// Drop the connection for the reason @a _r.
 	void drop(DisconnectReason _r);
@@ -92,7 +104,7 @@ private:
 	/// Perform a read on the socket.
 	void doRead();
 
-	/// Perform a single round of the write operation. This could end up calling itself asynchronously.
+	/// Seal all queued frames and write them with one gathering write. This could end up calling itself asynchronously.
 	void write();
 
 	/// Interpret an incoming message.
@@ -101,18 +113,38 @@ private:
 	/// @returns true iff the _msg forms a valid message for sending or receiving on the network.
 	static bool checkPacket(bytesConstRef _msg);
 
+	/// An egress frame: plaintext packet at offset 32 until sealed by write().
+	struct Frame
+	{
+		bytes data;
+		size_t packetSize;
+	};
+
+	/// Gives @a _buffer back to the frame pool for reuse by send(). Must hold x_writeQueue.
+	void recycleFrame(bytes&& _buffer);
+
+	static const unsigned c_maxPooledFrames = 32;			///< Maximum number of spare frame buffers kept by a session.
+	static const size_t c_maxPooledFrameSize = 64 * 1024;	///< Frame buffers larger than this aren't kept for reuse.
+	static const size_t c_maxWriteBytes = 256 * 1024;		///< Maximum number of bytes gathered into one write (but always at least one frame).
+	static const size_t c_maxReusedFrameSize = 1024 * 1024;	///< Ingress frame buffers larger than this aren't reused for the next frame.
+
 	Host* m_server;							///< The host that owns us. Never null.
 
 	RLPXFrameIO* m_io;						///< Transport over which packets are sent.
 	bi::tcp::socket& m_socket;				///< Socket for the peer's connection.
-	Mutex x_writeQueue;						///< Mutex for the write queue.
-	std::deque<bytes> m_writeQueue;			///< The write queue.
-	std::array<byte, 16777216> m_data;			///< Buffer for ingress packet data.
-	bytes m_incoming;						///< Read buffer for ingress bytes.
+	ba::io_service::strand m_strand;		///< All socket operations and their handlers run through this, keeping them ordered whichever I/O thread runs them.
+	Mutex x_writeQueue;						///< Mutex for the write queue, frame pool and m_writing.
+	std::deque<Frame> m_writeQueue;			///< The write queue.
+	std::vector<bytes> m_framePool;			///< Spare frame buffers, so sending doesn't allocate per packet.
+	bool m_writing = false;					///< Whether a write is in progress (and will pick up what's queued when done).
+	std::vector<Frame> m_inFlight;			///< Frames being written. Used only by write().
+	std::vector<ba::const_buffer> m_inFlightBuffers;	///< The buffer sequence for m_inFlight. Used only by write().
+	std::array<byte, h256::size> m_header;	///< Buffer for ingress frame headers.
+	std::shared_ptr<bytes> m_frame;			///< Buffer for the ingress frame being read or interpreted; shared with anything which retain()s part of it.
 
 	unsigned m_protocolVersion = 0;			///< The protocol version of the peer.
 	std::shared_ptr<Peer> m_peer;			///< The Peer object.
-	bool m_dropped = false;					///< If true, we've already divested ourselves of this peer. We're just waiting for the reads & writes to fail before the shared_ptr goes OOS and the destructor kicks in.
+	std::atomic<bool> m_dropped{false};					///< If true, we've already divested ourselves of this peer. We're just waiting for the reads & writes to fail before the shared_ptr goes OOS and the destructor kicks in.
 
 	PeerSessionInfo m_info;						///< Dynamic information about this peer.
 
@@ -101,6 +101,8 @@ struct UDPSocketEvents
 {
 	virtual void onDisconnected(UDPSocketFace*) {};
 	virtual void onReceived(UDPSocketFace*, bi::udp::endpoint const& _from, bytesConstRef _packetData) = 0;
+	/// Called with all the datagrams read in one go; the owner may keep them. By default hands each to onReceived().
+	virtual void onReceivedBatch(UDPSocketFace* _s, std::vector<UDPDatagram>&& _batch) { for (auto const& d: _batch) onReceived(_s, d.endpoint(), bytesConstRef(&d.data)); }
 };
 
 /**
@@ -130,15 +132,26 @@ public:
 	/// Send datagram.
 	bool send(UDPDatagram const& _datagram);
 
+	/// Send several datagrams, queueing them together.
+	bool send(std::vector<UDPDatagram>&& _datagrams);
+
 	/// Returns if socket is open.
 	bool isOpen() { return !m_closed; }
 
 	/// Disconnect socket.
 	void disconnect() { disconnectWithError(boost::asio::error::connection_reset); }
 
+	/// If nonzero, each write acts as though the send buffer filled after this many datagrams, so that tests can
+	/// exercise the asynchronous fallback, which the loopback interface never needs.
+	static unsigned test_sendBufferDatagrams;
+
 protected:
+	static const unsigned c_maxReadBatch = 64;		///< Maximum number of datagrams read before they are handed to the host.
+	static const unsigned c_maxWriteBatch = 64;		///< Maximum number of datagrams sent before yielding the I/O thread.
+
 	void doRead();
 
+	/// Sends as much of m_sendQ as the socket takes without blocking, then waits for the rest asynchronously. Must hold x_sendQ.
 	void doWrite();
 
 	void disconnectWithError(boost::system::error_code _ec);
@@ -153,12 +166,16 @@ protected:
 	std::deque<UDPDatagram> m_sendQ;				///< Queue for egress data.
 	std::array<byte, maxDatagramSize> m_recvData;	///< Buffer for ingress data.
 	bi::udp::endpoint m_recvEndpoint;				///< Endpoint data was received from.
+	std::vector<UDPDatagram> m_recvBatch;			///< Datagrams read in the current batch.
 	bi::udp::socket m_socket;						///< Boost asio udp socket.
 
 	Mutex x_socketError;							///< Mutex for error which can be set from host or IO thread.
 	boost::system::error_code m_socketError;		///< Set when shut down due to error.
 };
 
+template <typename Handler, unsigned MaxDatagramSize>
+unsigned UDPSocket<Handler, MaxDatagramSize>::test_sendBufferDatagrams = 0;
+
 template <typename Handler, unsigned MaxDatagramSize>
 void UDPSocket<Handler, MaxDatagramSize>::connect()
 {
@@ -175,6 +192,8 @@ void UDPSocket<Handler, MaxDatagramSize>::connect()
 	{
 		m_socket.bind(bi::udp::endpoint(bi::udp::v4(), m_endpoint.port()));
 	}
+	// Lets reads and writes drain what's ready in a batch without blocking the I/O thread.
+	m_socket.non_blocking(true);
 
 	// clear write queue so reconnect doesn't send stale messages
 	Guard l(x_sendQ);
@@ -198,6 +217,24 @@ bool UDPSocket<Handler, MaxDatagramSize>::send(UDPDatagram const& _datagram)
 	return true;
 }
 
+template <typename Handler, unsigned MaxDatagramSize>
+bool UDPSocket<Handler, MaxDatagramSize>::send(std::vector<UDPDatagram>&& _datagrams)
+{
+	if (m_closed)
+		return false;
+	if (_datagrams.empty())
+		return true;
+
+	Guard l(x_sendQ);
+	bool idle = m_sendQ.empty();
+	for (auto& d: _datagrams)
+		m_sendQ.push_back(std::move(d));
+	if (idle)
+		doWrite();
+
+	return true;
+}
+
 template <typename Handler, unsigned MaxDatagramSize>
 void UDPSocket<Handler, MaxDatagramSize>::doRead()
 {
@@ -214,7 +251,25 @@ void UDPSocket<Handler, MaxDatagramSize>::doRead()
 			clog(NetWarn) << "Receiving UDP message failed. " << _ec.value() << ":" << _ec.message();
 
 		if (_len)
-			m_host.onReceived(this, m_recvEndpoint, bytesConstRef(m_recvData.data(), _len));
+			m_recvBatch.push_back(UDPDatagram(m_recvEndpoint, bytes(m_recvData.begin(), m_recvData.begin() + _len)));
+
+		// Pick up whatever else has already arrived, so a flood is handled a batch at a time.
+		boost::system::error_code ec;
+		while (m_recvBatch.size() < c_maxReadBatch)
+		{
+			size_t len = m_socket.receive_from(boost::asio::buffer(m_recvData), m_recvEndpoint, 0, ec);
+			if (ec)
+				break;
+			if (len)
+				m_recvBatch.push_back(UDPDatagram(m_recvEndpoint, bytes(m_recvData.begin(), m_recvData.begin() + len)));
+		}
+
+		if (!m_recvBatch.empty())
+		{
+			std::vector<UDPDatagram> batch;
+			batch.swap(m_recvBatch);
+			m_host.onReceivedBatch(this, std::move(batch));
+		}
 		doRead();
 	});
 }
@@ -225,8 +280,38 @@ void UDPSocket<Handler, MaxDatagramSize>::doWrite()
 	if (m_closed)
 		return;
 
-	const UDPDatagram& datagram = m_sendQ[0];
+	// Send straight away what the socket will take; datagrams which fail for other reasons are dropped as they would be asynchronously.
+	boost::system::error_code ec;
+	for (unsigned i = 0; i < c_maxWriteBatch && !m_sendQ.empty(); ++i)
+	{
+		if (test_sendBufferDatagrams && i == test_sendBufferDatagrams)
+		{
+			ec = boost::asio::error::would_block;
+			break;
+		}
+		m_socket.send_to(boost::asio::buffer(m_sendQ.front().data), m_sendQ.front().endpoint(), 0, ec);
+		if (ec == boost::asio::error::would_block || ec == boost::asio::error::try_again)
+			break;
+		if (ec)
+			clog(NetWarn) << "Failed delivering UDP message. " << ec.value() << ":" << ec.message();
+		m_sendQ.pop_front();
+	}
+	if (m_sendQ.empty())
+		return;
+
 	auto self(UDPSocket<Handler, MaxDatagramSize>::shared_from_this());
+	if (ec != boost::asio::error::would_block && ec != boost::asio::error::try_again)
+	{
+		// A full batch went out; let other handlers run before sending the rest.
+		m_socket.get_io_service().post([this, self]()
+		{
+			Guard l(x_sendQ);
+			doWrite();
+		});
+		return;
+	}
+
+	const UDPDatagram& datagram = m_sendQ[0];
 	bi::udp::endpoint endpoint(datagram.endpoint());
 	m_socket.async_send_to(boost::asio::buffer(datagram.data), endpoint, [this, self, endpoint](boost::system::error_code _ec, std::size_t)
 	{
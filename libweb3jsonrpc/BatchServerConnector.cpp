@@ -0,0 +1,64 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file BatchServerConnector.cpp
+ * @date 2015
+ */
+
+// Make sure boost/asio.hpp is included before windows.h.
+#include <boost/asio.hpp>
+
+#include "BatchServerConnector.h"
+#include "WebThreeStubServerBase.h"
+using namespace std;
+using namespace dev;
+
+BatchServerConnector::BatchServerConnector(jsonrpc::AbstractServerConnector* _transport):
+	m_transport(_transport)
+{
+	m_transport->SetHandler(this);
+}
+
+bool BatchServerConnector::SendResponse(string const& _response, void* _addInfo)
+{
+	if (_addInfo)
+		*static_cast<string*>(_addInfo) = _response;
+	return true;
+}
+
+void BatchServerConnector::HandleRequest(string const& _request, string& o_response)
+{
+	if (m_server)
+	{
+		Json::Value request;
+		Json::Reader reader;
+		if (reader.parse(_request, request, false))
+		{
+			if (m_server->isParallelBatch(request))
+			{
+				o_response = m_server->handleBatch(request);
+				return;
+			}
+			if (m_server->isStreamable(request))
+			{
+				o_response = m_server->handleStreamed(request);
+				return;
+			}
+		}
+	}
+	// Anything we don't handle ourselves goes through the stock protocol handler, which replies via SendResponse().
+	OnRequest(_request, &o_response);
+}
@@ -0,0 +1,62 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file BatchServerConnector.h
+ * @date 2015
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <jsonrpccpp/server.h>
+
+namespace dev
+{
+
+class WebThreeStubServerBase;
+
+/**
+ * @brief Server connector which sits between a transport (e.g. jsonrpc::HttpServer) and the server.
+ * JSON-RPC batch arrays made only of read-only calls are handed to WebThreeStubServerBase::handleBatch()
+ * so they run in parallel against one state snapshot, and single calls returning blocks, transactions or
+ * logs have their results streamed; everything else takes the usual jsoncpp-based path.
+ */
+class BatchServerConnector: public jsonrpc::AbstractServerConnector, public jsonrpc::IProtocolHandler
+{
+public:
+	/// Takes ownership of @a _transport and installs itself as the transport's request handler.
+	explicit BatchServerConnector(jsonrpc::AbstractServerConnector* _transport);
+
+	/// Sets the server to which parallelisable batches are given. Until set, all requests take the sequential path.
+	void setServer(WebThreeStubServerBase* _server) { m_server = _server; }
+
+	virtual bool StartListening() override { return m_transport->StartListening(); }
+	virtual bool StopListening() override { return m_transport->StopListening(); }
+
+	/// Used by the base class to hand back responses from the sequential path; @a _addInfo points at the response buffer.
+	virtual bool SendResponse(std::string const& _response, void* _addInfo = nullptr) override;
+
+	/// Called by the transport for each request it receives.
+	virtual void HandleRequest(std::string const& _request, std::string& o_response) override;
+	virtual void AddProcedure(jsonrpc::Procedure&) {}
+
+private:
+	std::unique_ptr<jsonrpc::AbstractServerConnector> m_transport;
+	WebThreeStubServerBase* m_server = nullptr;
+};
+
+}
@@ -0,0 +1,251 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file JsonHelper.cpp
+ * @authors:
+ *   Gav Wood <i@gavwood.com>
+ *   Marek Kotewicz <marek@ethdev.com>
+ * @date 2015
+ */
+
+#include "JsonHelper.h"
+
+#include <libethcore/CommonJS.h>
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+
+Json::Value dev::toJson(BlockInfo const& _bi)
+{
+	Json::Value res;
+	if (_bi)
+	{
+		res["hash"] = toJS(_bi.hash());
+		res["parentHash"] = toJS(_bi.parentHash);
+		res["sha3Uncles"] = toJS(_bi.sha3Uncles);
+		res["miner"] = toJS(_bi.coinbaseAddress);
+		res["stateRoot"] = toJS(_bi.stateRoot);
+		res["transactionsRoot"] = toJS(_bi.transactionsRoot);
+		res["difficulty"] = toJS(_bi.difficulty);
+		res["number"] = toJS(_bi.number);
+		res["gasUsed"] = toJS(_bi.gasUsed);
+		res["gasLimit"] = toJS(_bi.gasLimit);
+		res["timestamp"] = toJS(_bi.timestamp);
+		res["extraData"] = toJS(_bi.extraData);
+		res["nonce"] = toJS(_bi.nonce);
+		res["logsBloom"] = toJS(_bi.logBloom);
+	}
+	return res;
+}
+
+Json::Value dev::toJson(Transaction const& _t, pair<h256, unsigned> _location, BlockNumber _blockNumber)
+{
+	Json::Value res;
+	if (_t)
+	{
+		res["hash"] = toJS(_t.sha3());
+		res["input"] = toJS(_t.data());
+		res["to"] = _t.isCreation() ? Json::Value() : toJS(_t.receiveAddress());
+		res["from"] = toJS(_t.safeSender());
+		res["gas"] = toJS(_t.gas());
+		res["gasPrice"] = toJS(_t.gasPrice());
+		res["nonce"] = toJS(_t.nonce());
+		res["value"] = toJS(_t.value());
+		res["blockHash"] = toJS(_location.first);
+		res["transactionIndex"] = toJS(_location.second);
+		res["blockNumber"] = toJS(_blockNumber);
+	}
+	return res;
+}
+
+Json::Value dev::toJson(BlockInfo const& _bi, UncleHashes const& _us, Transactions const& _ts)
+{
+	Json::Value res = toJson(_bi);
+	if (_bi)
+	{
+		res["uncles"] = Json::Value(Json::arrayValue);
+		for (h256 h: _us)
+			res["uncles"].append(toJS(h));
+		res["transactions"] = Json::Value(Json::arrayValue);
+		for (unsigned i = 0; i < _ts.size(); i++)
+			res["transactions"].append(toJson(_ts[i], std::make_pair(_bi.hash(), i), (BlockNumber)_bi.number));
+	}
+	return res;
+}
+
+Json::Value dev::toJson(BlockInfo const& _bi, UncleHashes const& _us, TransactionHashes const& _ts)
+{
+	Json::Value res = toJson(_bi);
+	if (_bi)
+	{
+		res["uncles"] = Json::Value(Json::arrayValue);
+		for (h256 h: _us)
+			res["uncles"].append(toJS(h));
+		res["transactions"] = Json::Value(Json::arrayValue);
+		for (h256 const& t: _ts)
+			res["transactions"].append(toJS(t));
+	}
+	return res;
+}
+
+Json::Value dev::toJson(LocalisedLogEntry const& _e)
+{
+	Json::Value res;
+	if (_e.transactionHash)
+	{
+		res["data"] = toJS(_e.data);
+		res["address"] = toJS(_e.address);
+		res["topics"] = Json::Value(Json::arrayValue);
+		for (auto const& t: _e.topics)
+			res["topics"].append(toJS(t));
+		res["number"] = _e.number;
+		res["hash"] = toJS(_e.transactionHash);
+	}
+	return res;
+}
+
+Json::Value dev::toJson(LocalisedLogEntries const& _es)
+{
+	Json::Value res(Json::arrayValue);
+	for (LocalisedLogEntry const& e: _es)
+		res.append(toJson(e));
+	return res;
+}
+
+// The streamed forms write keys in the same (lexicographic) order in which jsoncpp serialises objects.
+
+namespace
+{
+
+/// Writes the header fields of @a _bi; if @a _body is given it writes the "transactions" member and
+/// "uncles" are taken from @a _us.
+template <class Body>
+void streamBlock(JsonStream& _s, BlockInfo const& _bi, UncleHashes const* _us, Body const& _body)
+{
+	if (!_bi)
+	{
+		_s.null();
+		return;
+	}
+	_s.beginObject();
+	_s.key("difficulty").quantity(_bi.difficulty);
+	_s.key("extraData").hex(&_bi.extraData);
+	_s.key("gasLimit").quantity(_bi.gasLimit);
+	_s.key("gasUsed").quantity(_bi.gasUsed);
+	_s.key("hash").hex(_bi.hash());
+	_s.key("logsBloom").hex(_bi.logBloom);
+	_s.key("miner").hex(_bi.coinbaseAddress);
+	_s.key("nonce").hex(_bi.nonce);
+	_s.key("number").quantity(_bi.number);
+	_s.key("parentHash").hex(_bi.parentHash);
+	_s.key("sha3Uncles").hex(_bi.sha3Uncles);
+	_s.key("stateRoot").hex(_bi.stateRoot);
+	_s.key("timestamp").quantity(_bi.timestamp);
+	if (_us)
+	{
+		_s.key("transactions").beginArray();
+		_body();
+		_s.endArray();
+	}
+	_s.key("transactionsRoot").hex(_bi.transactionsRoot);
+	if (_us)
+	{
+		_s.key("uncles").beginArray();
+		for (h256 const& h: *_us)
+			_s.hex(h);
+		_s.endArray();
+	}
+	_s.endObject();
+}
+
+}
+
+void dev::toJson(JsonStream& _s, BlockInfo const& _bi)
+{
+	streamBlock(_s, _bi, nullptr, [](){});
+}
+
+void dev::toJson(JsonStream& _s, Transaction const& _t, pair<h256, unsigned> _location, BlockNumber _blockNumber)
+{
+	if (!_t)
+	{
+		_s.null();
+		return;
+	}
+	_s.beginObject();
+	_s.key("blockHash").hex(_location.first);
+	_s.key("blockNumber").quantity(uint64_t(_blockNumber));
+	_s.key("from").hex(_t.safeSender());
+	_s.key("gas").quantity(_t.gas());
+	_s.key("gasPrice").quantity(_t.gasPrice());
+	_s.key("hash").hex(_t.sha3());
+	_s.key("input").hex(&_t.data());
+	_s.key("nonce").quantity(_t.nonce());
+	_s.key("to");
+	if (_t.isCreation())
+		_s.null();
+	else
+		_s.hex(_t.receiveAddress());
+	_s.key("transactionIndex").quantity(uint64_t(_location.second));
+	_s.key("value").quantity(_t.value());
+	_s.endObject();
+}
+
+void dev::toJson(JsonStream& _s, BlockInfo const& _bi, UncleHashes const& _us, Transactions const& _ts)
+{
+	streamBlock(_s, _bi, &_us, [&]()
+	{
+		h256 h = _bi.hash();
+		for (unsigned i = 0; i < _ts.size(); i++)
+			toJson(_s, _ts[i], make_pair(h, i), (BlockNumber)_bi.number);
+	});
+}
+
+void dev::toJson(JsonStream& _s, BlockInfo const& _bi, UncleHashes const& _us, TransactionHashes const& _ts)
+{
+	streamBlock(_s, _bi, &_us, [&]()
+	{
+		for (h256 const& t: _ts)
+			_s.hex(t);
+	});
+}
+
+void dev::toJson(JsonStream& _s, LocalisedLogEntry const& _e)
+{
+	if (!_e.transactionHash)
+	{
+		_s.null();
+		return;
+	}
+	_s.beginObject();
+	_s.key("address").hex(_e.address);
+	_s.key("data").hex(&_e.data);
+	_s.key("hash").hex(_e.transactionHash);
+	_s.key("number").value(_e.number);
+	_s.key("topics").beginArray();
+	for (auto const& t: _e.topics)
+		_s.hex(t);
+	_s.endArray();
+	_s.endObject();
+}
+
+void dev::toJson(JsonStream& _s, LocalisedLogEntries const& _es)
+{
+	_s.beginArray();
+	for (LocalisedLogEntry const& e: _es)
+		toJson(_s, e);
+	_s.endArray();
+}
@@ -0,0 +1,50 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file JsonHelper.h
+ * @authors:
+ *   Gav Wood <i@gavwood.com>
+ *   Marek Kotewicz <marek@ethdev.com>
+ * @date 2015
+ *
+ * JSON representations of chain objects for the JSON-RPC API, both as jsoncpp trees and
+ * streamed straight into a JsonStream. The two forms produce byte-identical text.
+ */
+
+#pragma once
+
+#include <json/json.h>
+#include <libdevcore/JsonStream.h>
+#include <libethereum/Interface.h>
+
+namespace dev
+{
+
+Json::Value toJson(eth::BlockInfo const& _bi);
+Json::Value toJson(eth::Transaction const& _t, std::pair<h256, unsigned> _location, eth::BlockNumber _blockNumber);
+Json::Value toJson(eth::BlockInfo const& _bi, eth::UncleHashes const& _us, eth::Transactions const& _ts);
+Json::Value toJson(eth::BlockInfo const& _bi, eth::UncleHashes const& _us, eth::TransactionHashes const& _ts);
+Json::Value toJson(eth::LocalisedLogEntry const& _e);
+Json::Value toJson(eth::LocalisedLogEntries const& _es);
+
+void toJson(JsonStream& _s, eth::BlockInfo const& _bi);
+void toJson(JsonStream& _s, eth::Transaction const& _t, std::pair<h256, unsigned> _location, eth::BlockNumber _blockNumber);
+void toJson(JsonStream& _s, eth::BlockInfo const& _bi, eth::UncleHashes const& _us, eth::Transactions const& _ts);
+void toJson(JsonStream& _s, eth::BlockInfo const& _bi, eth::UncleHashes const& _us, eth::TransactionHashes const& _ts);
+void toJson(JsonStream& _s, eth::LocalisedLogEntry const& _e);
+void toJson(JsonStream& _s, eth::LocalisedLogEntries const& _es);
+
+}
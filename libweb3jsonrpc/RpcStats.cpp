@@ -0,0 +1,71 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file RpcStats.cpp
+ * @date 2015
+ */
+
+#include "RpcStats.h"
+
+#include <algorithm>
+using namespace std;
+using namespace dev;
+
+void RpcStats::record(string const& _method, chrono::steady_clock::duration _duration, bool _failed)
+{
+	uint64_t us = chrono::duration_cast<chrono::microseconds>(_duration).count();
+	unsigned bucket = 0;
+	while (bucket < MethodLatency::c_buckets - 1 && (uint64_t(1) << bucket) <= us)
+		++bucket;
+
+	Guard l(x_methods);
+	MethodLatency& m = m_methods[_method];
+	++m.count;
+	if (_failed)
+		++m.failures;
+	m.totalMicroseconds += us;
+	m.maxMicroseconds = max(m.maxMicroseconds, us);
+	++m.buckets[bucket];
+}
+
+MethodLatency RpcStats::latency(string const& _method) const
+{
+	Guard l(x_methods);
+	auto it = m_methods.find(_method);
+	return it == m_methods.end() ? MethodLatency() : it->second;
+}
+
+Json::Value RpcStats::toJson() const
+{
+	Json::Value ret(Json::objectValue);
+	Guard l(x_methods);
+	for (auto const& i: m_methods)
+	{
+		MethodLatency const& m = i.second;
+		Json::Value v(Json::objectValue);
+		v["count"] = Json::UInt64(m.count);
+		v["failures"] = Json::UInt64(m.failures);
+		v["meanMicroseconds"] = Json::UInt64(m.count ? m.totalMicroseconds / m.count : 0);
+		v["maxMicroseconds"] = Json::UInt64(m.maxMicroseconds);
+		Json::Value h(Json::objectValue);
+		for (unsigned b = 0; b < MethodLatency::c_buckets; ++b)
+			if (m.buckets[b])
+				h[b == MethodLatency::c_buckets - 1 ? "inf" : to_string(uint64_t(1) << b)] = Json::UInt64(m.buckets[b]);
+		v["histogram"] = h;
+		ret[i.first] = v;
+	}
+	return ret;
+}
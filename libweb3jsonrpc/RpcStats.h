@@ -0,0 +1,69 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file RpcStats.h
+ * @date 2015
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <json/json.h>
+#include <libdevcore/Guards.h>
+
+namespace dev
+{
+
+/// Latency distribution of a single JSON-RPC method.
+struct MethodLatency
+{
+	/// Bucket i counts calls that took less than 2^i microseconds; the last bucket takes everything slower.
+	static const unsigned c_buckets = 24;
+
+	uint64_t count = 0;
+	uint64_t failures = 0;
+	uint64_t totalMicroseconds = 0;
+	uint64_t maxMicroseconds = 0;
+	std::array<uint64_t, c_buckets> buckets = {{}};
+};
+
+/**
+ * @brief Thread-safe per-method latency histograms for the JSON-RPC server.
+ */
+class RpcStats
+{
+public:
+	/// Records one call to @a _method which took @a _duration.
+	void record(std::string const& _method, std::chrono::steady_clock::duration _duration, bool _failed);
+
+	/// @returns a copy of the histogram for @a _method.
+	MethodLatency latency(std::string const& _method) const;
+
+	/// @returns every method's histogram, keyed by method name, with only the non-empty buckets listed.
+	Json::Value toJson() const;
+
+	/// Forgets everything recorded so far.
+	void reset() { Guard l(x_methods); m_methods.clear(); }
+
+private:
+	mutable Mutex x_methods;
+	std::unordered_map<std::string, MethodLatency> m_methods;
+};
+
+}
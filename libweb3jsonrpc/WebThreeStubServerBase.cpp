@@ -43,6 +43,7 @@
 #endif
 #include "WebThreeStubServerBase.h"
 #include "AccountHolder.h"
+#include "JsonHelper.h"
 
 using namespace std;
 using namespace jsonrpc;
@@ -56,79 +57,6 @@ const unsigned dev::SensibleHttpThreads = 4;
 #endif
 const unsigned dev::SensibleHttpPort = 8545;
 
-static Json::Value toJson(dev::eth::BlockInfo const& _bi)
-{
-	Json::Value res;
-	if (_bi)
-	{
-		res["hash"] = toJS(_bi.hash());
-		res["parentHash"] = toJS(_bi.parentHash);
-		res["sha3Uncles"] = toJS(_bi.sha3Uncles);
-		res["miner"] = toJS(_bi.coinbaseAddress);
-		res["stateRoot"] = toJS(_bi.stateRoot);
-		res["transactionsRoot"] = toJS(_bi.transactionsRoot);
-		res["difficulty"] = toJS(_bi.difficulty);
-		res["number"] = toJS(_bi.number);
-		res["gasUsed"] = toJS(_bi.gasUsed);
-		res["gasLimit"] = toJS(_bi.gasLimit);
-		res["timestamp"] = toJS(_bi.timestamp);
-		res["extraData"] = toJS(_bi.extraData);
-		res["nonce"] = toJS(_bi.nonce);
-		res["logsBloom"] = toJS(_bi.logBloom);
-	}
-	return res;
-}
-
-static Json::Value toJson(dev::eth::Transaction const& _t, std::pair<h256, unsigned> _location, BlockNumber _blockNumber)
-{
-	Json::Value res;
-	if (_t)
-	{
-		res["hash"] = toJS(_t.sha3());
-		res["input"] = toJS(_t.data());
-		res["to"] = _t.isCreation() ? Json::Value() : toJS(_t.receiveAddress());
-		res["from"] = toJS(_t.safeSender());
-		res["gas"] = toJS(_t.gas());
-		res["gasPrice"] = toJS(_t.gasPrice());
-		res["nonce"] = toJS(_t.nonce());
-		res["value"] = toJS(_t.value());
-		res["blockHash"] = toJS(_location.first);
-		res["transactionIndex"] = toJS(_location.second);
-		res["blockNumber"] = toJS(_blockNumber);
-	}
-	return res;
-}
-
-static Json::Value toJson(dev::eth::BlockInfo const& _bi, UncleHashes const& _us, Transactions const& _ts)
-{
-	Json::Value res = toJson(_bi);
-	if (_bi)
-	{
-		res["uncles"] = Json::Value(Json::arrayValue);
-		for (h256 h: _us)
-			res["uncles"].append(toJS(h));
-		res["transactions"] = Json::Value(Json::arrayValue);
-		for (unsigned i = 0; i < _ts.size(); i++)
-			res["transactions"].append(toJson(_ts[i], std::make_pair(_bi.hash(), i), (BlockNumber)_bi.number));
-	}
-	return res;
-}
-
-static Json::Value toJson(dev::eth::BlockInfo const& _bi, UncleHashes const& _us, TransactionHashes const& _ts)
-{
-	Json::Value res = toJson(_bi);
-	if (_bi)
-	{
-		res["uncles"] = Json::Value(Json::arrayValue);
-		for (h256 h: _us)
-			res["uncles"].append(toJS(h));
-		res["transactions"] = Json::Value(Json::arrayValue);
-		for (h256 const& t: _ts)
-			res["transactions"].append(toJS(t));
-	}
-	return res;
-}
-
 static Json::Value toJson(dev::eth::TransactionSkeleton const& _t)
 {
 	Json::Value res;
@@ -159,30 +87,6 @@ static Json::Value toJson(dev::eth::Transaction const& _t)
 	return res;
 }
 
-static Json::Value toJson(dev::eth::LocalisedLogEntry const& _e)
-{
-	Json::Value res;
-	if (_e.transactionHash)
-	{
-		res["data"] = toJS(_e.data);
-		res["address"] = toJS(_e.address);
-		res["topics"] = Json::Value(Json::arrayValue);
-		for (auto const& t: _e.topics)
-			res["topics"].append(toJS(t));
-		res["number"] = _e.number;
-		res["hash"] = toJS(_e.transactionHash);
-	}
-	return res;
-}
-
-static Json::Value toJson(dev::eth::LocalisedLogEntries const& _es)
-{
-	Json::Value res(Json::arrayValue);
-	for (dev::eth::LocalisedLogEntry const& e: _es)
-		res.append(toJson(e));
-	return res;
-}
-
 static Json::Value toJson(map<u256, u256> const& _storage)
 {
 	Json::Value res(Json::objectValue);
@@ -297,6 +201,43 @@ static Json::Value toJson(h256 const& _h, shh::Envelope const& _e, shh::Message
 	return res;
 }
 
+/// Methods which only read chain or client state and so may run concurrently within a batch, with the types of their
+/// positional parameters as declared in abstractwebthreestubserver.h. Batches don't pass through libjson-rpc-cpp's
+/// request handler, so their parameters are checked against these instead.
+static const map<string, vector<Json::ValueType>> c_parallelMethods =
+{
+	{"web3_sha3", {Json::stringValue}},
+	{"web3_clientVersion", {}},
+	{"net_version", {}},
+	{"net_peerCount", {}},
+	{"net_listening", {}},
+	{"eth_protocolVersion", {}},
+	{"eth_hashrate", {}},
+	{"eth_coinbase", {}},
+	{"eth_mining", {}},
+	{"eth_gasPrice", {}},
+	{"eth_accounts", {}},
+	{"eth_blockNumber", {}},
+	{"eth_getBalance", {Json::stringValue, Json::stringValue}},
+	{"eth_getStorageAt", {Json::stringValue, Json::stringValue, Json::stringValue}},
+	{"eth_getTransactionCount", {Json::stringValue, Json::stringValue}},
+	{"eth_getCode", {Json::stringValue, Json::stringValue}},
+	{"eth_call", {Json::objectValue, Json::stringValue}},
+	{"eth_getBlockTransactionCountByHash", {Json::stringValue}},
+	{"eth_getBlockTransactionCountByNumber", {Json::stringValue}},
+	{"eth_getUncleCountByBlockHash", {Json::stringValue}},
+	{"eth_getUncleCountByBlockNumber", {Json::stringValue}},
+	{"eth_getBlockByHash", {Json::stringValue, Json::booleanValue}},
+	{"eth_getBlockByNumber", {Json::stringValue, Json::booleanValue}},
+	{"eth_getTransactionByHash", {Json::stringValue}},
+	{"eth_getTransactionByBlockHashAndIndex", {Json::stringValue, Json::stringValue}},
+	{"eth_getTransactionByBlockNumberAndIndex", {Json::stringValue, Json::stringValue}},
+	{"eth_getUncleByBlockHashAndIndex", {Json::stringValue, Json::stringValue}},
+	{"eth_getUncleByBlockNumberAndIndex", {Json::stringValue, Json::stringValue}},
+	{"eth_getCompilers", {}},
+	{"eth_getLogs", {Json::objectValue}}
+};
+
 WebThreeStubServerBase::WebThreeStubServerBase(AbstractServerConnector& _conn, std::shared_ptr<dev::eth::AccountHolder> const& _ethAccounts, vector<dev::KeyPair> const& _sshAccounts):
 	AbstractWebThreeStubServer(_conn),
 	m_ethAccounts(_ethAccounts)
@@ -311,6 +252,331 @@ void WebThreeStubServerBase::setIdentities(vector<dev::KeyPair> const& _ids)
 		m_shhIds[i.pub()] = i.secret();
 }
 
+void WebThreeStubServerBase::HandleMethodCall(Procedure& _proc, Json::Value const& _input, Json::Value& o_output)
+{
+	auto start = chrono::steady_clock::now();
+	try
+	{
+		AbstractWebThreeStubServer::HandleMethodCall(_proc, _input, o_output);
+	}
+	catch (...)
+	{
+		m_stats.record(_proc.GetProcedureName(), chrono::steady_clock::now() - start, true);
+		throw;
+	}
+	m_stats.record(_proc.GetProcedureName(), chrono::steady_clock::now() - start, false);
+}
+
+void WebThreeStubServerBase::setBatchWorkers(unsigned _n)
+{
+	m_batchPool.reset(_n > 1 ? new ThreadPool(_n, "rpc") : nullptr);
+}
+
+/// Methods whose results are written straight into a JsonStream rather than built as a Json::Value.
+static const set<string> c_streamedMethods =
+{
+	"eth_getBlockByHash", "eth_getBlockByNumber", "eth_getTransactionByHash",
+	"eth_getTransactionByBlockHashAndIndex", "eth_getTransactionByBlockNumberAndIndex",
+	"eth_getUncleByBlockHashAndIndex", "eth_getUncleByBlockNumberAndIndex", "eth_getLogs"
+};
+
+/// Writes @a _v, built by jsoncpp, into @a _out.
+static void writeValue(JsonStream& _out, Json::Value const& _v)
+{
+	string text = Json::FastWriter().write(_v);
+	if (!text.empty() && text.back() == '\n')
+		text.pop_back();
+	_out.raw(text);
+}
+
+/// @returns true if @a _r is a call to one of c_parallelMethods; its parameters are checked when it's executed.
+static bool isWellFormedCall(Json::Value const& _r)
+{
+	return _r.isObject() &&
+		_r["jsonrpc"] == "2.0" &&
+		_r["method"].isString() &&
+		c_parallelMethods.count(_r["method"].asString()) &&
+		(!_r.isMember("params") || _r["params"].isArray()) &&
+		(!_r.isMember("id") || _r["id"].isNull() || _r["id"].isString() || _r["id"].isIntegral());
+}
+
+bool WebThreeStubServerBase::isParallelBatch(Json::Value const& _request) const
+{
+	if (!_request.isArray() || _request.empty())
+		return false;
+	for (auto const& r: _request)
+		if (!isWellFormedCall(r))
+			return false;
+	return true;
+}
+
+bool WebThreeStubServerBase::isStreamable(Json::Value const& _request) const
+{
+	return isWellFormedCall(_request) && c_streamedMethods.count(_request["method"].asString());
+}
+
+string WebThreeStubServerBase::handleBatch(Json::Value const& _requests)
+{
+	unsigned n = _requests.size();
+	vector<string> responses(n);
+	shared_ptr<StateSnapshot const> snapshot = client() ? client()->snapshot() : nullptr;
+	unsigned workers = min<unsigned>(m_batchPool ? m_batchPool->size() : 1, n);
+
+	vector<ThreadPool::Task> tasks;
+	for (unsigned w = 0; w < workers; ++w)
+		tasks.push_back([&, w]()
+		{
+			// Each worker copies the snapshot once and serves its share of the batch from that copy.
+			unique_ptr<StatePin> pin(snapshot ? new StatePin(client(), snapshot) : nullptr);
+			JsonStream out;
+			for (unsigned i = w; i < n; i += workers)
+			{
+				out.clear();
+				handleEntry(_requests[i], out);
+				responses[i] = out.str();
+			}
+		});
+	if (m_batchPool)
+		m_batchPool->run(tasks);
+	else
+		for (auto const& t: tasks)
+			t();
+
+	string ret;
+	for (unsigned i = 0; i < n; ++i)
+		if (_requests[i].isMember("id"))
+		{
+			ret += ret.empty() ? '[' : ',';
+			ret += responses[i];
+		}
+	return ret.empty() ? ret : ret + "]";
+}
+
+string WebThreeStubServerBase::handleStreamed(Json::Value const& _request)
+{
+	JsonStream out;
+	handleEntry(_request, out);
+	return _request.isMember("id") ? out.str() : string();
+}
+
+void WebThreeStubServerBase::handleEntry(Json::Value const& _request, JsonStream& _out)
+{
+	string method = _request["method"].asString();
+	Json::Value params = _request.isMember("params") ? _request["params"] : Json::Value(Json::arrayValue);
+	Json::Value const& id = _request["id"];
+
+	_out.beginObject();
+	_out.key("id");
+	if (id.isString())
+		_out.value(id.asString());
+	else if (id.isIntegral())
+		_out.raw(id.isUInt64() ? toString(id.asUInt64()) : toString(id.asInt64()));
+	else
+		_out.null();
+	_out.key("jsonrpc").value("2.0");
+
+	auto mark = _out.mark();
+	bool failed = true;
+	int code = Errors::ERROR_RPC_INTERNAL_ERROR;
+	string message = Errors::GetErrorMessage(code);
+	try
+	{
+		// The same check libjson-rpc-cpp makes before dispatching: exactly the declared parameters, each of the declared type.
+		auto const& types = c_parallelMethods.at(method);
+		bool paramsOk = params.isArray() && params.size() == types.size();
+		for (unsigned i = 0; paramsOk && i < types.size(); ++i)
+			paramsOk = params[i].type() == types[i];
+		if (!paramsOk)
+			BOOST_THROW_EXCEPTION(JsonRpcException(Errors::ERROR_RPC_INVALID_PARAMS));
+
+		_out.key("result");
+		if (c_streamedMethods.count(method))
+		{
+			auto start = chrono::steady_clock::now();
+			try
+			{
+				streamResult(method, params, _out);
+			}
+			catch (...)
+			{
+				m_stats.record(method, chrono::steady_clock::now() - start, true);
+				throw;
+			}
+			m_stats.record(method, chrono::steady_clock::now() - start, false);
+		}
+		else
+		{
+			// Through our own HandleMethodCall(), so the call is timed like any other.
+			Json::Value result;
+			Procedure proc(method, PARAMS_BY_POSITION, JSON_OBJECT, NULL);
+			HandleMethodCall(proc, params, result);
+			writeValue(_out, result);
+		}
+		failed = false;
+	}
+	catch (JsonRpcException const& _e)
+	{
+		code = _e.GetCode();
+		message = _e.GetMessage();
+	}
+	catch (...)
+	{
+	}
+
+	if (failed)
+	{
+		_out.rewind(mark);
+		_out.key("error").beginObject();
+		_out.key("code").raw(toString(code));
+		_out.key("message").value(message);
+		_out.endObject();
+	}
+	_out.endObject();
+}
+
+/// When streamResult() calls one of the streamed methods, it leaves the response here for the method to write
+/// its result into directly; null otherwise.
+static thread_local JsonStream* s_streamTo = nullptr;
+
+/// The streamed methods are each implemented once, below, as a function of the client, the method's parameters
+/// and where its result goes.
+namespace
+{
+
+/// Takes the response left by streamResult(), if any, and writes the result straight into it; otherwise builds
+/// the result as a Json::Value. Only the first sink made on the thread takes the response, so any other
+/// streamed method an override calls on the way builds its result as usual.
+struct ToResult
+{
+	ToResult(): stream(s_streamTo) { s_streamTo = nullptr; }
+	template <class... Args> void operator()(Args const&... _args)
+	{
+		if (stream)
+			toJson(*stream, _args...);
+		else
+			result = toJson(_args...);
+	}
+	JsonStream* stream;
+	Json::Value result;
+};
+
+/// Runs @a _f, reporting anything it throws as bad parameters.
+template <class F> void withParams(F const& _f)
+{
+	try
+	{
+		_f();
+	}
+	catch (...)
+	{
+		BOOST_THROW_EXCEPTION(JsonRpcException(Errors::ERROR_RPC_INVALID_PARAMS));
+	}
+}
+
+template <class Out, class Block> void getBlock(eth::Interface* _c, Block const& _b, bool _includeTransactions, Out& _out)
+{
+	if (_includeTransactions)
+		_out(_c->blockInfo(_b), _c->uncleHashes(_b), _c->transactions(_b));
+	else
+		_out(_c->blockInfo(_b), _c->uncleHashes(_b), _c->transactionHashes(_b));
+}
+
+template <class Out> void getBlockByHash(eth::Interface* _c, string const& _blockHash, bool _includeTransactions, Out& _out)
+{
+	withParams([&]() { getBlock(_c, jsToFixed<32>(_blockHash), _includeTransactions, _out); });
+}
+
+template <class Out> void getBlockByNumber(eth::Interface* _c, string const& _blockNumber, bool _includeTransactions, Out& _out)
+{
+	withParams([&]() { getBlock(_c, jsToBlockNumber(_blockNumber), _includeTransactions, _out); });
+}
+
+template <class Out> void getTransactionByHash(eth::Interface* _c, string const& _transactionHash, Out& _out)
+{
+	withParams([&]()
+	{
+		h256 h = jsToFixed<32>(_transactionHash);
+		auto l = _c->transactionLocation(h);
+		_out(_c->transaction(h), l, _c->numberFromHash(l.first));
+	});
+}
+
+template <class Out> void getTransactionByBlockHashAndIndex(eth::Interface* _c, string const& _blockHash, string const& _transactionIndex, Out& _out)
+{
+	withParams([&]()
+	{
+		h256 bh = jsToFixed<32>(_blockHash);
+		unsigned ti = jsToInt(_transactionIndex);
+		_out(_c->transaction(bh, ti), make_pair(bh, ti), _c->numberFromHash(bh));
+	});
+}
+
+template <class Out> void getTransactionByBlockNumberAndIndex(eth::Interface* _c, string const& _blockNumber, string const& _transactionIndex, Out& _out)
+{
+	withParams([&]()
+	{
+		BlockNumber bn = jsToBlockNumber(_blockNumber);
+		unsigned ti = jsToInt(_transactionIndex);
+		_out(_c->transaction(bn, ti), make_pair(_c->hashFromNumber(bn), ti), bn);
+	});
+}
+
+template <class Out> void getUncleByBlockHashAndIndex(eth::Interface* _c, string const& _blockHash, string const& _uncleIndex, Out& _out)
+{
+	withParams([&]() { _out(_c->uncle(jsToFixed<32>(_blockHash), jsToInt(_uncleIndex))); });
+}
+
+template <class Out> void getUncleByBlockNumberAndIndex(eth::Interface* _c, string const& _blockNumber, string const& _uncleIndex, Out& _out)
+{
+	withParams([&]() { _out(_c->uncle(jsToBlockNumber(_blockNumber), jsToInt(_uncleIndex))); });
+}
+
+template <class Out> void getLogs(eth::Interface* _c, Json::Value const& _json, Out& _out)
+{
+	withParams([&]() { _out(_c->logs(toLogFilter(_json))); });
+}
+
+}
+
+void WebThreeStubServerBase::streamResult(string const& _method, Json::Value const& _params, JsonStream& _out)
+{
+	// handleEntry() has already checked the parameters against c_parallelMethods. The call goes through the
+	// virtual method so that overrides are honoured; our own implementations take the response from s_streamTo
+	// and write into it, anything else returns a Json::Value which is written here.
+	s_streamTo = &_out;
+	Json::Value result;
+	try
+	{
+		if (_method == "eth_getBlockByHash")
+			result = eth_getBlockByHash(_params[0u].asString(), _params[1u].asBool());
+		else if (_method == "eth_getBlockByNumber")
+			result = eth_getBlockByNumber(_params[0u].asString(), _params[1u].asBool());
+		else if (_method == "eth_getTransactionByHash")
+			result = eth_getTransactionByHash(_params[0u].asString());
+		else if (_method == "eth_getTransactionByBlockHashAndIndex")
+			result = eth_getTransactionByBlockHashAndIndex(_params[0u].asString(), _params[1u].asString());
+		else if (_method == "eth_getTransactionByBlockNumberAndIndex")
+			result = eth_getTransactionByBlockNumberAndIndex(_params[0u].asString(), _params[1u].asString());
+		else if (_method == "eth_getUncleByBlockHashAndIndex")
+			result = eth_getUncleByBlockHashAndIndex(_params[0u].asString(), _params[1u].asString());
+		else if (_method == "eth_getUncleByBlockNumberAndIndex")
+			result = eth_getUncleByBlockNumberAndIndex(_params[0u].asString(), _params[1u].asString());
+		else if (_method == "eth_getLogs")
+			result = eth_getLogs(_params[0u]);
+	}
+	catch (...)
+	{
+		s_streamTo = nullptr;
+		throw;
+	}
+	if (s_streamTo)
+	{
+		// Not taken: an override built the result itself.
+		s_streamTo = nullptr;
+		writeValue(_out, result);
+	}
+}
+
 string WebThreeStubServerBase::web3_sha3(string const& _param1)
 {
 	return toJS(sha3(jsToBytes(_param1)));
@@ -548,7 +814,7 @@ Json::Value WebThreeStubServerBase::eth_inspectTransaction(std::string const& _r
 {
 	try
 	{
-		return toJson(Transaction(jsToBytes(_rlp), CheckTransaction::Everything));
+		return ::toJson(Transaction(jsToBytes(_rlp), CheckTransaction::Everything));
 	}
 	catch (...)
 	{
@@ -598,102 +864,51 @@ bool WebThreeStubServerBase::eth_flush()
 
 Json::Value WebThreeStubServerBase::eth_getBlockByHash(string const& _blockHash, bool _includeTransactions)
 {
-	try
-	{
-		auto h = jsToFixed<32>(_blockHash);
-		if (_includeTransactions)
-			return toJson(client()->blockInfo(h), client()->uncleHashes(h), client()->transactions(h));
-		else
-			return toJson(client()->blockInfo(h), client()->uncleHashes(h), client()->transactionHashes(h));
-	}
-	catch (...)
-	{
-		BOOST_THROW_EXCEPTION(JsonRpcException(Errors::ERROR_RPC_INVALID_PARAMS));
-	}
+	ToResult ret;
+	getBlockByHash(client(), _blockHash, _includeTransactions, ret);
+	return ret.result;
 }
 
 Json::Value WebThreeStubServerBase::eth_getBlockByNumber(string const& _blockNumber, bool _includeTransactions)
 {
-	try
-	{
-		auto h = jsToBlockNumber(_blockNumber);
-		if (_includeTransactions)
-			return toJson(client()->blockInfo(h), client()->uncleHashes(h), client()->transactions(h));
-		else
-			return toJson(client()->blockInfo(h), client()->uncleHashes(h), client()->transactionHashes(h));
-	}
-	catch (...)
-	{
-		BOOST_THROW_EXCEPTION(JsonRpcException(Errors::ERROR_RPC_INVALID_PARAMS));
-	}
+	ToResult ret;
+	getBlockByNumber(client(), _blockNumber, _includeTransactions, ret);
+	return ret.result;
 }
 
 Json::Value WebThreeStubServerBase::eth_getTransactionByHash(string const& _transactionHash)
 {
-	try
-	{
-		h256 h = jsToFixed<32>(_transactionHash);
-		auto l = client()->transactionLocation(h);
-		return toJson(client()->transaction(h), l, client()->numberFromHash(l.first));
-	}
-	catch (...)
-	{
-		BOOST_THROW_EXCEPTION(JsonRpcException(Errors::ERROR_RPC_INVALID_PARAMS));
-	}
+	ToResult ret;
+	getTransactionByHash(client(), _transactionHash, ret);
+	return ret.result;
 }
 
 Json::Value WebThreeStubServerBase::eth_getTransactionByBlockHashAndIndex(string const& _blockHash, string const& _transactionIndex)
 {
-	try
-	{
-		h256 bh = jsToFixed<32>(_blockHash);
-		unsigned ti = jsToInt(_transactionIndex);
-		Transaction t = client()->transaction(bh, ti);
-		return toJson(t, make_pair(bh, ti), client()->numberFromHash(bh));
-	}
-	catch (...)
-	{
-		BOOST_THROW_EXCEPTION(JsonRpcException(Errors::ERROR_RPC_INVALID_PARAMS));
-	}
+	ToResult ret;
+	getTransactionByBlockHashAndIndex(client(), _blockHash, _transactionIndex, ret);
+	return ret.result;
 }
 
 Json::Value WebThreeStubServerBase::eth_getTransactionByBlockNumberAndIndex(string const& _blockNumber, string const& _transactionIndex)
 {
-	try
-	{
-		BlockNumber bn = jsToBlockNumber(_blockNumber);
-		unsigned ti = jsToInt(_transactionIndex);
-		Transaction t = client()->transaction(bn, ti);
-		return toJson(t, make_pair(client()->hashFromNumber(bn), ti), bn);
-	}
-	catch (...)
-	{
-		BOOST_THROW_EXCEPTION(JsonRpcException(Errors::ERROR_RPC_INVALID_PARAMS));
-	}
+	ToResult ret;
+	getTransactionByBlockNumberAndIndex(client(), _blockNumber, _transactionIndex, ret);
+	return ret.result;
 }
 
 Json::Value WebThreeStubServerBase::eth_getUncleByBlockHashAndIndex(string const& _blockHash, string const& _uncleIndex)
 {
-	try
-	{
-		return toJson(client()->uncle(jsToFixed<32>(_blockHash), jsToInt(_uncleIndex)));
-	}
-	catch (...)
-	{
-		BOOST_THROW_EXCEPTION(JsonRpcException(Errors::ERROR_RPC_INVALID_PARAMS));
-	}
+	ToResult ret;
+	getUncleByBlockHashAndIndex(client(), _blockHash, _uncleIndex, ret);
+	return ret.result;
 }
 
 Json::Value WebThreeStubServerBase::eth_getUncleByBlockNumberAndIndex(string const& _blockNumber, string const& _uncleIndex)
 {
-	try
-	{
-		return toJson(client()->uncle(jsToBlockNumber(_blockNumber), jsToInt(_uncleIndex)));
-	}
-	catch (...)
-	{
-		BOOST_THROW_EXCEPTION(JsonRpcException(Errors::ERROR_RPC_INVALID_PARAMS));
-	}
+	ToResult ret;
+	getUncleByBlockNumberAndIndex(client(), _blockNumber, _uncleIndex, ret);
+	return ret.result;
 }
 
 Json::Value WebThreeStubServerBase::eth_getCompilers()
@@ -837,14 +1052,9 @@ Json::Value WebThreeStubServerBase::eth_getFilterLogs(string const& _filterId)
 
 Json::Value WebThreeStubServerBase::eth_getLogs(Json::Value const& _json)
 {
-	try
-	{
-		return toJson(client()->logs(toLogFilter(_json)));
-	}
-	catch (...)
-	{
-		BOOST_THROW_EXCEPTION(JsonRpcException(Errors::ERROR_RPC_INVALID_PARAMS));
-	}
+	ToResult ret;
+	getLogs(client(), _json, ret);
+	return ret.result;
 }
 
 Json::Value WebThreeStubServerBase::eth_getWork()
@@ -901,7 +1111,7 @@ Json::Value WebThreeStubServerBase::eth_fetchQueuedTransactions(string const& _a
 		Json::Value ret(Json::arrayValue);
 		// TODO: throw an error on no account with given id
 		for (TransactionSkeleton const& t: m_ethAccounts->queuedTransactions(id))
-			ret.append(toJson(t));
+			ret.append(::toJson(t));
 		m_ethAccounts->clearQueue(id);
 		return ret;
 	}
@@ -1029,7 +1239,7 @@ Json::Value WebThreeStubServerBase::shh_getFilterChanges(string const& _filterId
 					m = e.open(face()->fullTopic(id));
 				if (!m)
 					continue;
-				ret.append(toJson(h, e, m));
+				ret.append(::toJson(h, e, m));
 			}
 
 		return ret;
@@ -1062,7 +1272,7 @@ Json::Value WebThreeStubServerBase::shh_getMessages(string const& _filterId)
 					m = e.open(face()->fullTopic(id));
 				if (!m)
 					continue;
-				ret.append(toJson(h, e, m));
+				ret.append(::toJson(h, e, m));
 			}
 		return ret;
 	}
@@ -26,11 +26,14 @@
 #include <memory>
 #include <iostream>
 #include <jsonrpccpp/server.h>
+#include <libdevcore/ThreadPool.h>
+#include <libdevcore/JsonStream.h>
 #include <libdevcrypto/Common.h>
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 #include "abstractwebthreestubserver.h"
 #pragma GCC diagnostic pop
+#include "RpcStats.h"
 
 
 namespace dev
@@ -72,6 +75,7 @@ public:
 
 	virtual std::string web3_sha3(std::string const& _param1);
 	virtual std::string web3_clientVersion() { return "C++ (ethereum-cpp)"; }
+	virtual Json::Value web3_rpcStats() { return m_stats.toJson(); }
 
 	virtual std::string net_version() { return ""; }
 	virtual std::string net_peerCount();
@@ -137,6 +141,27 @@ public:
 	void setIdentities(std::vector<dev::KeyPair> const& _ids);
 	std::map<dev::Public, dev::Secret> const& ids() const { return m_shhIds; }
 
+	/// Times every call into the per-method latency histograms.
+	virtual void HandleMethodCall(jsonrpc::Procedure& _proc, Json::Value const& _input, Json::Value& o_output) override;
+
+	/// Sets the number of threads used to execute batches; 0 or 1 runs batches on the calling thread.
+	void setBatchWorkers(unsigned _n);
+	/// @returns true if @a _request is a well-formed batch made only of calls that do not alter state.
+	bool isParallelBatch(Json::Value const& _request) const;
+	/// Executes a batch accepted by isParallelBatch() on the batch workers, all against one snapshot of
+	/// the latest and pending states. @returns the serialised responses in request order, omitting
+	/// notifications, or the empty string if there are none.
+	std::string handleBatch(Json::Value const& _requests);
+
+	/// @returns true if @a _request is a single well-formed call whose result is streamed (blocks, transactions, logs).
+	bool isStreamable(Json::Value const& _request) const;
+	/// Executes a call accepted by isStreamable() through its eth_* method. Our own implementations write their
+	/// results without building a Json::Value and return null; an override returning a value of its own is serialised as usual.
+	/// @returns the serialised response, or the empty string for a notification.
+	std::string handleStreamed(Json::Value const& _request);
+
+	RpcStats const& stats() const { return m_stats; }
+
 protected:
 	virtual dev::eth::Interface* client() = 0;
 	virtual std::shared_ptr<dev::shh::Interface> face() = 0;
@@ -147,6 +172,15 @@ protected:
 
 	std::map<dev::Public, dev::Secret> m_shhIds;
 	std::map<unsigned, dev::Public> m_shhWatches;
+
+private:
+	/// Writes the complete response object for @a _request into @a _out.
+	void handleEntry(Json::Value const& _request, JsonStream& _out);
+	/// Writes the result of @a _method, which must be one of the streamed methods.
+	void streamResult(std::string const& _method, Json::Value const& _params, JsonStream& _out);
+
+	RpcStats m_stats;
+	std::unique_ptr<ThreadPool> m_batchPool;
 };
 
 } //namespace dev
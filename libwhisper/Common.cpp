@@ -21,6 +21,7 @@
 
 #include "Common.h"
 
+#include <algorithm>
 #include <libdevcrypto/SHA3.h>
 #include "Message.h"
 using namespace std;
@@ -66,22 +67,32 @@ h256 TopicFilter::sha3() const
 
 bool TopicFilter::matches(Envelope const& _e) const
 {
+	CollapsedTopic const& topic = _e.topic();
+	auto partMatched = [&](pair<CollapsedTopicPart, CollapsedTopicPart> const& _p)
+	{
+		for (auto const& et: topic)
+			if (((_p.first ^ et) & _p.second) == CollapsedTopicPart())
+				return true;
+		return false;
+	};
+	// A mask matches when each of its parts matches some part of the topic; the filter when any of its masks does.
+	for (TopicMask const& t: m_topicMasks)
+		if (all_of(t.begin(), t.end(), partMatched))
+			return true;
+	return false;
+}
+
+CollapsedTopic TopicFilter::requiredParts() const
+{
+	CollapsedTopic ret;
 	for (TopicMask const& t: m_topicMasks)
 	{
-		for (unsigned i = 0; i < t.size(); ++i)
-		{
-			for (auto et: _e.topic())
-				if (((t[i].first ^ et) & t[i].second) == CollapsedTopicPart())
-					goto NEXT_TOPICPART;
-			// failed to match topicmask against any topics: move on to next mask
-			goto NEXT_TOPICMASK;
-			NEXT_TOPICPART:;
-		}
-		// all topicmasks matched.
-		return true;
-		NEXT_TOPICMASK:;
+		auto exact = find_if(t.begin(), t.end(), [](pair<CollapsedTopicPart, CollapsedTopicPart> const& _p) { return _p.second == ~CollapsedTopicPart(); });
+		if (exact == t.end())
+			return CollapsedTopic();
+		ret.push_back(exact->first);
 	}
-	return false;
+	return ret;
 }
 
 TopicMask BuildTopicMask::toTopicMask() const
@@ -116,6 +116,11 @@ public:
 
 	bool matches(Envelope const& _m) const;
 
+	/// @returns for each mask a topic part which an envelope must carry for that mask to match it.
+	/// Empty if some mask needs no particular part (i.e. has only wildcard or partial parts), in which case the
+	/// filter can't be indexed by topic.
+	CollapsedTopic requiredParts() const;
+
 private:
 	TopicMasks m_topicMasks;
 };
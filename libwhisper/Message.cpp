@@ -21,6 +21,9 @@
 
 #include "Message.h"
 
+#include <thread>
+#include <libdevcore/ThreadPool.h>
+
 using namespace std;
 using namespace dev;
 using namespace dev::p2p;
@@ -161,25 +164,64 @@ unsigned Envelope::workProved() const
 	return dev::sha3(bytesConstRef(d[0].data(), 64)).firstBitSet();
 }
 
-void Envelope::proveWork(unsigned _ms)
+unsigned Envelope::proveWork(unsigned _ms)
 {
-	// PoW
-	h256 d[2];
-	d[0] = sha3(WithoutNonce);
-	uint32_t& n = *(uint32_t*)&(d[1][28]);
-	unsigned bestBitSet = 0;
-	bytesConstRef chuck(d[0].data(), 64);
+	static ThreadPool s_pool(max(1u, thread::hardware_concurrency()), "shh.pow");
+
+	struct Best
+	{
+		unsigned bitSet = 0;
+		uint64_t nonce = 0;
+		uint64_t tried = 0;
+		int64_t ms = 1;
+	};
 
-	chrono::high_resolution_clock::time_point then = chrono::high_resolution_clock::now() + chrono::milliseconds(_ms);
-	for (n = 0; chrono::high_resolution_clock::now() < then; )
-		// do it rounds of 1024 for efficiency
-		for (unsigned i = 0; i < 1024; ++i, ++n)
+	// PoW
+	FixedPrefixSHA3 hasher(sha3(WithoutNonce));
+	vector<Best> best(s_pool.size());
+	vector<ThreadPool::Task> tasks;
+	for (unsigned t = 0; t < best.size(); ++t)
+		tasks.push_back([&, t]()
 		{
-			auto fbs = dev::sha3(chuck).firstBitSet();
-			if (fbs > bestBitSet)
+			Best& b = best[t];
+			// the budget runs from when the task starts, not when it was queued: with other envelopes being sealed
+			// at once, the pool may only get to it after their searches are done.
+			auto start = chrono::steady_clock::now();
+			auto then = start + chrono::milliseconds(_ms);
+			// each thread searches its own part of the nonce space; the nonce is laid out as h256(m_nonce) is.
+			uint64_t n = uint64_t(t) << 48;
+			h256 d;
+			do
 			{
-				bestBitSet = fbs;
-				m_nonce = n;
+				// do it rounds of 1024 for efficiency
+				for (unsigned i = 0; i < 1024; ++i, ++n)
+				{
+					for (unsigned j = 0; j < 8; ++j)
+						d[31 - j] = (byte)(n >> (8 * j));
+					unsigned fbs = hasher(d).firstBitSet();
+					if (fbs > b.bitSet)
+					{
+						b.bitSet = fbs;
+						b.nonce = n;
+					}
+				}
+				b.tried += 1024;
 			}
+			while (chrono::steady_clock::now() < then);
+			b.ms = max<int64_t>(1, chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count());
+		});
+	s_pool.run(tasks);
+
+	uint64_t rate = 0;
+	unsigned bestBitSet = 0;
+	for (Best const& b: best)
+	{
+		rate += b.tried / b.ms;
+		if (b.bitSet > bestBitSet)
+		{
+			bestBitSet = b.bitSet;
+			m_nonce = b.nonce;
 		}
+	}
+	return (unsigned)rate;
 }
@@ -78,7 +78,10 @@ public:
 	Message open(FullTopic const& _ft, Secret const& _s = Secret()) const;
 
 	unsigned workProved() const;
-	void proveWork(unsigned _ms);
+	/// Searches for the nonce proving the most work, hashing candidates one at a time with FixedPrefixSHA3 on each of
+	/// a thread per core for @a _ms milliseconds. Concurrent calls share the threads, so may take longer to return.
+	/// @returns the rate of the search, in hashes per millisecond summed over the threads.
+	unsigned proveWork(unsigned _ms);
 
 private:
 	Envelope(unsigned _exp, unsigned _ttl, CollapsedTopic const& _topic): m_expiry(_exp), m_ttl(_ttl), m_topic(_topic) {}
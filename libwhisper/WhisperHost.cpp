@@ -63,15 +63,28 @@ void WhisperHost::inject(Envelope const& _m, WhisperPeer* _p)
 			return;
 		UpgradeGuard ll(l);
 		m_messages[h] = _m;
-		m_expiryQueue.insert(make_pair(_m.expiry(), h));
+		m_expiryBuckets[_m.expiry()].push_back(h);
 	}
 
 //	if (_p)
 	{
 		Guard l(m_filterLock);
-		for (auto const& f: m_filters)
-			if (f.second.filter.matches(_m))
-				noteChanged(h, f.first);
+		// Only filters indexed under one of the envelope's topic parts, or not indexed at all, can match it.
+		h256s candidates(m_unindexedFilters.begin(), m_unindexedFilters.end());
+		for (auto const& t: _m.topic())
+		{
+			auto it = m_filtersByTopic.find(t);
+			if (it != m_filtersByTopic.end())
+				candidates += it->second;
+		}
+		sort(candidates.begin(), candidates.end());
+		candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+		for (auto const& c: candidates)
+		{
+			auto fit = m_filters.find(c);
+			if (fit != m_filters.end() && fit->second.filter.matches(_m))
+				noteChanged(h, c);
+		}
 	}
 
 	// TODO p2p: capability-based rating
@@ -110,12 +123,43 @@ unsigned WhisperHost::installWatch(shh::FullTopic const& _ft)
 	InstalledFilter f(_ft);
 	h256 h = f.filter.sha3();
 
-	if (!m_filters.count(h))
+	auto fit = m_filters.find(h);
+	if (fit == m_filters.end())
+	{
 		m_filters.insert(make_pair(h, f));
+		indexFilter(h, f.filter);
+	}
+	else
+		++fit->second.refCount;
 
 	return installWatchOnId(h);
 }
 
+void WhisperHost::indexFilter(h256 const& _id, TopicFilter const& _f)
+{
+	CollapsedTopic parts = _f.requiredParts();
+	if (parts.empty())
+		m_unindexedFilters.insert(_id);
+	for (auto const& p: parts)
+		m_filtersByTopic[p].push_back(_id);
+}
+
+void WhisperHost::unindexFilter(h256 const& _id, TopicFilter const& _f)
+{
+	CollapsedTopic parts = _f.requiredParts();
+	if (parts.empty())
+		m_unindexedFilters.erase(_id);
+	for (auto const& p: parts)
+	{
+		auto it = m_filtersByTopic.find(p);
+		if (it == m_filtersByTopic.end())
+			continue;
+		it->second.erase(remove(it->second.begin(), it->second.end(), _id), it->second.end());
+		if (it->second.empty())
+			m_filtersByTopic.erase(it);
+	}
+}
+
 h256s WhisperHost::watchMessages(unsigned _watchId)
 {
 	h256s ret;
@@ -152,7 +196,10 @@ void WhisperHost::uninstallWatch(unsigned _i)
 	auto fit = m_filters.find(id);
 	if (fit != m_filters.end())
 		if (!--fit->second.refCount)
+		{
+			unindexFilter(id, fit->second.filter);
 			m_filters.erase(fit);
+		}
 }
 
 void WhisperHost::doWork()
@@ -168,6 +215,7 @@ void WhisperHost::cleanup()
 	// should be called every now and again.
 	unsigned now = (unsigned)time(0);
 	WriteGuard l(x_messages);
-	for (auto it = m_expiryQueue.begin(); it != m_expiryQueue.end() && it->first <= now; it = m_expiryQueue.erase(it))
-		m_messages.erase(it->second);
+	for (auto it = m_expiryBuckets.begin(); it != m_expiryBuckets.end() && it->first <= now; it = m_expiryBuckets.erase(it))
+		for (auto const& h: it->second)
+			m_messages.erase(h);
 }
@@ -26,6 +26,7 @@
 #include <set>
 #include <memory>
 #include <utility>
+#include <unordered_map>
 
 #include <libdevcore/RLP.h>
 #include <libdevcore/Worker.h>
@@ -42,6 +43,8 @@ namespace shh
 
 static const FullTopic EmptyFullTopic;
 
+using Envelopes = std::unordered_map<h256, Envelope>;
+
 class WhisperHost: public HostCapability<WhisperPeer>, public Interface, public Worker
 {
 	friend class WhisperPeer;
@@ -64,7 +67,7 @@ public:
 
 	virtual Envelope envelope(h256 _m) const override { try { dev::ReadGuard l(x_messages); return m_messages.at(_m); } catch (...) { return Envelope(); } }
 
-	std::map<h256, Envelope> all() const { ReadGuard l(x_messages); return m_messages; }
+	Envelopes all() const { ReadGuard l(x_messages); return m_messages; }
 
 	void cleanup();
 
@@ -79,13 +82,19 @@ private:
 
 	void noteChanged(h256 _messageHash, h256 _filter);
 
+	/// Adds the filter @a _id to or removes it from the topic index. Must hold m_filterLock.
+	void indexFilter(h256 const& _id, TopicFilter const& _f);
+	void unindexFilter(h256 const& _id, TopicFilter const& _f);
+
 	mutable dev::SharedMutex x_messages;
-	std::map<h256, Envelope> m_messages;
-	std::multimap<unsigned, h256> m_expiryQueue;
+	Envelopes m_messages;
+	std::map<unsigned, h256s> m_expiryBuckets;		///< Hashes of messages in m_messages by the second at which they expire.
 
 	mutable dev::Mutex m_filterLock;
 	std::map<h256, InstalledFilter> m_filters;
 	std::map<unsigned, ClientWatch> m_watches;
+	std::unordered_map<CollapsedTopicPart, h256s, CollapsedTopicPart::hash> m_filtersByTopic;	///< For each topic part, the filters with a mask which can match only topics including it.
+	h256Hash m_unindexedFilters;					///< Filters which can match without any particular topic part, so are tried against every envelope.
 };
 
 }
@@ -0,0 +1,81 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file lruCache.cpp
+ * @date 2015
+ * ShardedLruCache test functions.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <libdevcore/LruCache.h>
+#include <libdevcore/FixedHash.h>
+
+using namespace std;
+using namespace dev;
+
+BOOST_AUTO_TEST_SUITE(lruCache)
+
+BOOST_AUTO_TEST_CASE(evictsLeastRecentlyUsed)
+{
+	using Cache = ShardedLruCache<unsigned, bytes>;
+	// One shard with room for three 100-byte entries.
+	Cache c(3 * (100 + Cache::c_entryOverhead), [](bytes const& _b) { return _b.size(); }, 1);
+	for (unsigned i = 0; i < 3; ++i)
+		c.insert(i, bytes(100, i));
+
+	bytes b;
+	BOOST_CHECK(c.get(0, b));
+	BOOST_CHECK(b == bytes(100, 0));
+
+	c.insert(3, bytes(100, 3));
+	BOOST_CHECK(c.contains(0));
+	BOOST_CHECK(!c.contains(1));
+	BOOST_CHECK(c.contains(2));
+	BOOST_CHECK(c.contains(3));
+
+	CacheStats s = c.stats();
+	BOOST_CHECK_EQUAL(s.entries, 3);
+	BOOST_CHECK_EQUAL(s.evictions, 1);
+	BOOST_CHECK_EQUAL(s.hits, 1);
+	BOOST_CHECK(!c.get(1, b));
+	BOOST_CHECK_EQUAL(c.stats().hitRatio(), 0.5);
+	BOOST_CHECK(s.bytes <= s.budget);
+}
+
+BOOST_AUTO_TEST_CASE(updateAndBudget)
+{
+	using Cache = ShardedLruCache<h256, bytes>;
+	Cache c(1024 * 1024, [](bytes const& _b) { return _b.size(); });
+	h256 k(0xbeef);
+	bytes r = c.update(k, bytes{1}, [](bytes& _b) { _b.push_back(2); });
+	BOOST_CHECK(r == (bytes{1, 2}));
+	r = c.update(k, bytes(), [](bytes& _b) { _b.push_back(3); });
+	BOOST_CHECK(r == (bytes{1, 2, 3}));
+	BOOST_CHECK_EQUAL(c.stats().bytes, 3 + Cache::c_entryOverhead);
+
+	for (unsigned i = 0; i < 1000; ++i)
+		c.insert(h256(i), bytes(1000));
+	c.setBudget(64 * 1024);
+	CacheStats s = c.stats();
+	BOOST_CHECK(s.bytes <= s.budget);
+	BOOST_CHECK(s.entries > 0);
+
+	c.clear();
+	BOOST_CHECK_EQUAL(c.stats().entries, 0);
+	BOOST_CHECK_EQUAL(c.stats().bytes, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,54 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file numa.cpp
+ * @date 2015
+ * NUMA topology test functions.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <libdevcore/Numa.h>
+
+using namespace std;
+using namespace dev;
+
+BOOST_AUTO_TEST_SUITE(numa)
+
+BOOST_AUTO_TEST_CASE(parseCpuLists)
+{
+	BOOST_CHECK(parseCpuList("") == vector<unsigned>());
+	BOOST_CHECK(parseCpuList("\n") == vector<unsigned>());
+	BOOST_CHECK(parseCpuList("5\n") == vector<unsigned>{5});
+	BOOST_CHECK(parseCpuList("0-3\n") == (vector<unsigned>{0, 1, 2, 3}));
+	BOOST_CHECK(parseCpuList("0-1,8,10-11\n") == (vector<unsigned>{0, 1, 8, 10, 11}));
+
+	// Junk and backwards ranges are skipped; the rest is still read.
+	BOOST_CHECK(parseCpuList("x,3-1,4") == vector<unsigned>{4});
+	BOOST_CHECK(parseCpuList("2-") == vector<unsigned>{2});
+
+	// A range ending at the largest CPU number still ends.
+	BOOST_CHECK(parseCpuList("4294967295-4294967295") == vector<unsigned>{4294967295u});
+}
+
+BOOST_AUTO_TEST_CASE(nodesCoverSomeCpus)
+{
+	vector<NumaNode> const& nodes = numaNodes();
+	BOOST_REQUIRE(!nodes.empty());
+	for (auto const& n: nodes)
+		BOOST_CHECK(!n.cpus.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
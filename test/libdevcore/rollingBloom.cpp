@@ -0,0 +1,54 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file rollingBloom.cpp
+ * @date 2015
+ * RollingBloom test functions.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <libdevcore/RollingBloom.h>
+#include <libdevcore/FixedHash.h>
+
+using namespace std;
+using namespace dev;
+
+BOOST_AUTO_TEST_SUITE(rollingBloom)
+
+BOOST_AUTO_TEST_CASE(remembersRecentAndForgetsOld)
+{
+	RollingBloom<16384, 1024> b;
+	h256s hs;
+	for (unsigned i = 0; i < 3000; ++i)
+		hs.push_back(h256::random());
+
+	for (unsigned i = 0; i < 3000; ++i)
+		b.insert(hs[i]);
+	// The last generation's worth are certain to be there.
+	for (unsigned i = 3000 - 1024; i < 3000; ++i)
+		BOOST_CHECK(b.contains(hs[i]));
+
+	// The first thousand were dropped with their generation; at most a few false positives should remain.
+	unsigned found = 0;
+	for (unsigned i = 0; i < 1000; ++i)
+		found += b.contains(hs[i]);
+	BOOST_CHECK(found < 50);
+
+	b.clear();
+	BOOST_CHECK(!b.contains(hs.back()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
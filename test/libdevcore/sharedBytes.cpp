@@ -0,0 +1,50 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file sharedBytes.cpp
+ * @date 2015
+ * SharedBytesRef test functions.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <libdevcore/SharedBytes.h>
+
+using namespace std;
+using namespace dev;
+
+BOOST_AUTO_TEST_SUITE(sharedBytes)
+
+BOOST_AUTO_TEST_CASE(compacted)
+{
+	SharedBytes frame = make_shared<bytes const>(1024 * 1024, 0x42);
+	weak_ptr<bytes const> watch = frame;
+
+	// A view of part of a frame keeps the frame alive; compacted, it doesn't.
+	SharedBytesRef part(frame, bytesConstRef(frame.get()).cropped(100, 10));
+	SharedBytesRef kept = part.compacted();
+	frame.reset();
+	BOOST_CHECK(!watch.expired());
+	BOOST_CHECK(kept.toBytes() == bytes(10, 0x42));
+	part = SharedBytesRef();
+	BOOST_CHECK(watch.expired());
+	BOOST_CHECK(kept.toBytes() == bytes(10, 0x42));
+
+	// A view of a whole buffer is left as it is.
+	SharedBytesRef whole(bytes{1, 2, 3});
+	BOOST_CHECK(whole.compacted().ref().data() == whole.ref().data());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,73 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file threadPool.cpp
+ * @date 2015
+ * ThreadPool test functions.
+ */
+
+#include <atomic>
+#include <stdexcept>
+#include <boost/test/unit_test.hpp>
+#include <libdevcore/ThreadPool.h>
+
+using namespace std;
+using namespace dev;
+
+BOOST_AUTO_TEST_SUITE(threadPool)
+
+BOOST_AUTO_TEST_CASE(runsBatch)
+{
+	ThreadPool pool(4, "test");
+	atomic<unsigned> sum{0};
+	vector<ThreadPool::Task> tasks;
+	for (unsigned i = 1; i <= 100; ++i)
+		tasks.push_back([&, i]() { sum += i; });
+	pool.run(tasks);
+	BOOST_CHECK_EQUAL(sum, 5050);
+
+	// Batches run from within the pool go inline rather than deadlocking.
+	atomic<unsigned> inner{0};
+	pool.run({[&]() { pool.run({[&]() { ++inner; }, [&]() { ++inner; }}); }, [&]() { ++inner; }});
+	BOOST_CHECK_EQUAL(inner, 3);
+}
+
+BOOST_AUTO_TEST_CASE(throwingTask)
+{
+	ThreadPool pool(4, "test");
+	atomic<unsigned> ran{0};
+	vector<ThreadPool::Task> tasks;
+	for (unsigned i = 0; i < 50; ++i)
+		tasks.push_back([&, i]()
+		{
+			++ran;
+			if (i % 10 == 3)
+				throw runtime_error("task failed");
+		});
+
+	// Every task still runs, and run() returns, rethrowing.
+	BOOST_CHECK_THROW(pool.run(tasks), runtime_error);
+	BOOST_CHECK_EQUAL(ran, 50);
+
+	BOOST_CHECK_THROW(pool.run({[]() { throw runtime_error("alone"); }}), runtime_error);
+
+	// The pool is none the worse for it.
+	ran = 0;
+	pool.run(vector<ThreadPool::Task>(8, [&]() { ++ran; }));
+	BOOST_CHECK_EQUAL(ran, 8);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
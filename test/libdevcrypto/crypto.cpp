@@ -22,6 +22,9 @@
  */
 
 #include <random>
+#include <thread>
+#include <atomic>
+#include <chrono>
 #include <secp256k1/secp256k1.h>
 #include <libdevcore/Common.h>
 #include <libdevcore/RLP.h>
@@ -31,6 +34,7 @@
 #include <libdevcrypto/SHA3.h>
 #include <libdevcrypto/ECDHE.h>
 #include <libdevcrypto/CryptoPP.h>
+#include "../TestHelper.h"
 
 using namespace std;
 using namespace dev;
@@ -229,6 +233,89 @@ BOOST_AUTO_TEST_CASE(cryptopp_ecdsa_sipaseckp256k1)
 	}
 }
 
+BOOST_AUTO_TEST_CASE(secp256k1MatchesCryptoPP)
+{
+	// Half the group order: low-s signatures have s no greater than this.
+	u256 const halfOrder("0x7fffffffffffffffffffffffffffffff5d576e7357a4501ddfe92f46681b20a0");
+	KeyPair other = KeyPair::create();
+	for (unsigned i = 0; i < 100; ++i)
+	{
+		KeyPair key = KeyPair::create();
+		h256 m = sha3(toString(i));
+
+		// Signed by libsecp256k1: recovered and verified by both.
+		Signature sig = dev::sign(key.sec(), m);
+		BOOST_CHECK(sig[64] <= 1);
+		BOOST_CHECK(u256(h256(sig.data(), h256::ConstructFromPointer)) != 0);
+		BOOST_CHECK(u256(h256(sig.data() + 32, h256::ConstructFromPointer)) <= halfOrder);
+		BOOST_CHECK(dev::recover(sig, m) == key.pub());
+		BOOST_CHECK(s_secp256k1.recover(sig, m.ref()) == key.pub());
+		BOOST_CHECK(dev::verify(key.pub(), sig, m));
+
+		// Signed by CryptoPP: the same.
+		Signature cppSig = s_secp256k1.sign(key.sec(), m);
+		BOOST_CHECK(dev::recover(cppSig, m) == key.pub());
+		BOOST_CHECK(s_secp256k1.recover(cppSig, m.ref()) == key.pub());
+		BOOST_CHECK(dev::verify(key.pub(), cppSig, m));
+
+		// Wrong key, wrong message or a damaged signature don't pass.
+		BOOST_CHECK(!dev::verify(other.pub(), sig, m));
+		BOOST_CHECK(!dev::verify(key.pub(), sig, sha3(m)));
+		BOOST_CHECK(dev::recover(sig, sha3(m)) != key.pub());
+		Signature bad = sig;
+		bad[i % 64] ^= 0x10;
+		BOOST_CHECK(!dev::verify(key.pub(), bad, m));
+		BOOST_CHECK(dev::recover(bad, m) != key.pub());
+		bad = sig;
+		bad[64] ^= 1;
+		BOOST_CHECK(dev::recover(bad, m) != key.pub());
+		BOOST_CHECK(s_secp256k1.recover(bad, m.ref()) == dev::recover(bad, m));
+		bad[64] = 27;
+		BOOST_CHECK(!dev::recover(bad, m));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(recoverPerformance)
+{
+	if (!test::Options::get().performance)
+		return;
+
+	unsigned const c_sigs = 2000;
+	KeyPair key = KeyPair::create();
+	vector<pair<Signature, h256>> sigs;
+	for (unsigned i = 0; i < c_sigs; ++i)
+	{
+		h256 m = sha3(h256(i));
+		sigs.push_back(make_pair(dev::sign(key.sec(), m), m));
+	}
+
+	// Time recovery of all of sigs split over _threads threads.
+	auto timeRecovery = [&](unsigned _threads, function<Public(Signature const&, h256 const&)> const& _recover)
+	{
+		atomic<unsigned> failed(0);
+		auto start = chrono::steady_clock::now();
+		vector<thread> ts;
+		for (unsigned t = 0; t < _threads; ++t)
+			ts.push_back(thread([&, t]()
+			{
+				for (unsigned i = t; i < c_sigs; i += _threads)
+					if (_recover(sigs[i].first, sigs[i].second) != key.pub())
+						++failed;
+			}));
+		for (auto& t: ts)
+			t.join();
+		BOOST_CHECK_EQUAL(failed.load(), 0u);
+		return c_sigs * 1000.0 / max<int64_t>(1, chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count());
+	};
+
+	for (unsigned threads = 1; threads <= max(1u, thread::hardware_concurrency()); threads *= 2)
+	{
+		double lib = timeRecovery(threads, [](Signature const& _s, h256 const& _m) { return dev::recover(_s, _m); });
+		double cpp = timeRecovery(threads, [](Signature const& _s, h256 const& _m) { return s_secp256k1.recover(_s, _m.ref()); });
+		cnote << threads << "threads:" << lib << "recoveries/s with libsecp256k1," << cpp << "with CryptoPP";
+	}
+}
+
 BOOST_AUTO_TEST_CASE(sha3_norestart)
 {
 	CryptoPP::SHA3_256 ctx;
@@ -260,6 +347,35 @@ BOOST_AUTO_TEST_CASE(sha3_norestart)
 	BOOST_REQUIRE(finalDigest2 != finalDigest3);
 }
 
+BOOST_AUTO_TEST_CASE(sha3_fixedPrefix)
+{
+	for (unsigned i = 0; i < 100; ++i)
+	{
+		h256 d[2] = { h256::random(), h256::random() };
+		FixedPrefixSHA3 hasher(d[0]);
+		BOOST_REQUIRE_EQUAL(hasher(d[1]), sha3(bytesConstRef(d[0].data(), 64)));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(sha3_batch)
+{
+	// Lengths around the 136-byte block boundary, in an order that the batch has to regroup.
+	vector<bytes> inputs;
+	for (unsigned size: {0, 32, 135, 136, 137, 500, 1, 20, 272, 64, 100})
+	{
+		inputs.push_back(bytes(size));
+		for (unsigned i = 0; i < size; ++i)
+			inputs.back()[i] = byte(size * 7 + i);
+	}
+	vector<bytesConstRef> refs;
+	for (auto const& i: inputs)
+		refs.push_back(&i);
+	h256s hashes = sha3Batch(refs);
+	BOOST_REQUIRE_EQUAL(hashes.size(), inputs.size());
+	for (unsigned i = 0; i < inputs.size(); ++i)
+		BOOST_CHECK_EQUAL(hashes[i], sha3(inputs[i]));
+}
+
 BOOST_AUTO_TEST_CASE(ecies_kdf)
 {
 	KeyPair local = KeyPair::create();
@@ -24,6 +24,9 @@
 #include <random>
 #include "../JsonSpiritHeaders.h"
 #include <libdevcore/CommonIO.h>
+#include <libdevcore/TransientDirectory.h>
+#include <libethash/internal.h>
+#include <libethash/io.h>
 #include <libethcore/ProofOfWork.h>
 #include <libethcore/EthashAux.h>
 #include <boost/test/unit_test.hpp>
@@ -37,6 +40,61 @@ namespace js = json_spirit;
 
 using dev::operator <<;
 
+namespace
+{
+
+/// Generates DAG chunks as asked, giving up after @a stopAfter of them; remembers which it did.
+struct ChunkLog
+{
+	unsigned stopAfter;
+	vector<pair<uint32_t, uint32_t>> chunks;
+};
+
+bool logChunk(void* _user, void* _data, uint32_t _begin, uint32_t _end, ethash_light_t _light)
+{
+	ChunkLog& log = *static_cast<ChunkLog*>(_user);
+	if (log.chunks.size() == log.stopAfter)
+		return false;
+	ethash_compute_full_range(_data, _begin, _end, _light);
+	log.chunks.push_back(make_pair(_begin, _end));
+	return true;
+}
+
+uint64_t magicNumber(string const& _dir, ethash_h256_t const& _seed, uint64_t _fullSize, ethash_io_rc _expected)
+{
+	FILE* f = nullptr;
+	BOOST_REQUIRE_EQUAL(ethash_io_prepare(_dir.c_str(), _seed, &f, (size_t)_fullSize, false), _expected);
+	uint64_t ret = 0;
+	BOOST_CHECK(fseek(f, 0, SEEK_SET) == 0 && fread(&ret, sizeof(ret), 1, f) == 1);
+	fclose(f);
+	return ret;
+}
+
+/// Checks that hashing up to ETHASH_LANES nonces at once agrees with hashing each alone, and with the light client.
+void checkLanes(ethash_full_t _full, ethash_light_t _light)
+{
+	ethash_h256_t header = ethash_get_seedhash(ETHASH_EPOCH_LENGTH * 3);
+	uint64_t const nonces[ETHASH_LANES] = {0, 1, 0xdeadbeefcafe, ~(uint64_t)0};
+	ethash_return_value_t lanes[ETHASH_LANES];
+	for (unsigned count = 0; count <= ETHASH_LANES; ++count)
+	{
+		BOOST_REQUIRE(ethash_full_compute_lanes(_full, header, nonces, count, lanes));
+		for (unsigned i = 0; i < count; ++i)
+		{
+			ethash_return_value_t one = ethash_full_compute(_full, header, nonces[i]);
+			ethash_return_value_t light = ethash_light_compute_internal(_light, ethash_full_dag_size(_full), header, nonces[i]);
+			BOOST_REQUIRE(one.success && light.success && lanes[i].success);
+			BOOST_CHECK(!memcmp(&lanes[i].result, &one.result, sizeof(one.result)));
+			BOOST_CHECK(!memcmp(&lanes[i].mix_hash, &one.mix_hash, sizeof(one.mix_hash)));
+			BOOST_CHECK(!memcmp(&one.result, &light.result, sizeof(one.result)));
+			BOOST_CHECK(!memcmp(&one.mix_hash, &light.mix_hash, sizeof(one.mix_hash)));
+		}
+	}
+	BOOST_CHECK(!ethash_full_compute_lanes(_full, header, nonces, ETHASH_LANES + 1, lanes));
+}
+
+}
+
 BOOST_AUTO_TEST_SUITE(DashimotoTests)
 
 BOOST_AUTO_TEST_CASE(basic_test)
@@ -80,6 +138,98 @@ BOOST_AUTO_TEST_CASE(basic_test)
 	}
 }
 
+BOOST_AUTO_TEST_CASE(batch_verify)
+{
+	js::mValue v;
+	string s = asString(contents(test::getTestPath() + "/PoWTests/ethash_tests.json"));
+	BOOST_REQUIRE_MESSAGE(s.length() > 0, "Contents of 'ethash_tests.json' is empty. Have you cloned the 'tests' repo branch develop?");
+	js::read_string(s, v);
+
+	vector<BlockInfo> headers;
+	for (auto& i: v.get_obj())
+	{
+		BlockInfo header = BlockInfo::fromHeader(fromHex(i.second.get_obj()["header"].get_str()), CheckNothing);
+		headers.push_back(header);
+		header.nonce = Nonce(u64(header.nonce) + 1);
+		headers.push_back(header);
+	}
+
+	vector<bool> valid = Ethash::verify(headers);
+	BOOST_REQUIRE_EQUAL(valid.size(), headers.size());
+	for (size_t i = 0; i < headers.size(); ++i)
+		BOOST_CHECK_EQUAL(valid[i], Ethash::verify(headers[i]));
+
+#if !TEST_FULL
+	// Without a full DAG, the second evaluation of a header reuses the DAG items cached by the first.
+	uint64_t hits = EthashAux::itemCacheStats().hits;
+	Ethash::Result r1 = EthashAux::eval(headers[0]);
+	Ethash::Result r2 = EthashAux::eval(headers[0]);
+	BOOST_CHECK_EQUAL(r1.value, r2.value);
+	BOOST_CHECK_EQUAL(r1.mixHash, r2.mixHash);
+	BOOST_CHECK(EthashAux::itemCacheStats().hits >= hits + 128);
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(resume_partial_dag)
+{
+	TransientDirectory dir;
+	ethash_light_t light = ethash_light_new(0);
+	BOOST_REQUIRE(light);
+	ethash_h256_t seed = ethash_get_seedhash(0);
+	uint32_t const items = 20 * ETHASH_DAG_CHUNKS;
+	uint64_t const fullSize = (uint64_t)items * ETHASH_HASH_BYTES;
+
+	// Stopped part way, the file records how far it got.
+	ChunkLog first{3, {}};
+	BOOST_REQUIRE(!ethash_full_new_internal(dir.path().c_str(), seed, fullSize, light, nullptr, logChunk, &first));
+	BOOST_REQUIRE_EQUAL(first.chunks.size(), 3);
+	uint32_t const done = first.chunks.back().second;
+	BOOST_CHECK_EQUAL(magicNumber(dir.path(), seed, fullSize, ETHASH_IO_MEMO_PARTIAL), ETHASH_DAG_PARTIAL_MAGIC_NUM | done);
+
+	// Picked up again, only the rest is generated, and the DAG comes out as if done in one go.
+	ChunkLog second{~0u, {}};
+	ethash_full_t full = ethash_full_new_internal(dir.path().c_str(), seed, fullSize, light, nullptr, logChunk, &second);
+	BOOST_REQUIRE(full);
+	BOOST_REQUIRE(!second.chunks.empty());
+	BOOST_CHECK_EQUAL(second.chunks.front().first, done);
+	BOOST_CHECK_EQUAL(second.chunks.back().second, items);
+	bytes whole(fullSize);
+	ethash_compute_full_range(whole.data(), 0, items, light);
+	BOOST_CHECK(bytesConstRef((byte const*)ethash_full_dag(full), fullSize).toBytes() == whole);
+	ethash_full_delete(full);
+	BOOST_CHECK_EQUAL(magicNumber(dir.path(), seed, fullSize, ETHASH_IO_MEMO_MATCH), ETHASH_DAG_MAGIC_NUM);
+
+	ethash_light_delete(light);
+}
+
+BOOST_AUTO_TEST_CASE(compute_lanes)
+{
+	TransientDirectory dir;
+	ethash_light_t light = ethash_light_new(0);
+	BOOST_REQUIRE(light);
+	uint64_t const fullSize = 1000 * ETHASH_MIX_BYTES;
+	ethash_full_t full = ethash_full_new_internal(dir.path().c_str(), ethash_get_seedhash(0), fullSize, light, nullptr, nullptr, nullptr);
+	BOOST_REQUIRE(full);
+
+	// In the file mapping, then in huge pages (transparent ones at least, wherever there's Linux), and copied
+	// as for another NUMA node.
+	checkLanes(full, light);
+#if defined(__linux__)
+	BOOST_REQUIRE(ethash_full_use_hugepages(full));
+	checkLanes(full, light);
+	for (bool hugepages: { false, true })
+	{
+		ethash_full_t copy = ethash_full_replicate(full, hugepages);
+		BOOST_REQUIRE(copy);
+		checkLanes(copy, light);
+		ethash_full_delete(copy);
+	}
+#endif
+
+	ethash_full_delete(full);
+	ethash_light_delete(light);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
@@ -43,6 +43,8 @@ void overwriteBlockHeader(BlockInfo& _current_BlockHeader, mObject& _blObj);
 BlockInfo constructBlock(mObject& _o);
 void updatePoW(BlockInfo& _bi);
 mArray importUncles(mObject const& blObj, vector<BlockInfo>& vBiUncles, vector<BlockInfo> const& vBiBlocks);
+void checkBlockStore(BlockChain const& _bc);
+void checkCanonicalIndex(BlockChain const& _bc);
 
 void doBlockchainTests(json_spirit::mValue& _v, bool _fillin)
 {
@@ -317,6 +319,7 @@ void doBlockchainTests(json_spirit::mValue& _v, bool _fillin)
 					if (trueBc.info() != BlockInfo(blockRLP))
 						importedAndBest  = false;
 					trueState.sync(trueBc);
+					checkCanonicalIndex(trueBc);
 				}
 				// if exception is thrown, RLP is invalid and no blockHeader, Transaction list, or Uncle list should be given
 				catch (Exception const& _e)
@@ -474,6 +477,15 @@ void doBlockchainTests(json_spirit::mValue& _v, bool _fillin)
 				}//importedAndBest
 			}//all blocks
 
+			checkBlockStore(trueBc);
+
+			// The index is read back from disk when the chain is reopened, and rebuilt from the block details if it's missing.
+			trueBc.reopen(td.path());
+			checkCanonicalIndex(trueBc);
+			boost::filesystem::remove(td.path() + "/canon");
+			trueBc.reopen(td.path());
+			checkCanonicalIndex(trueBc);
+
 			BOOST_REQUIRE(o.count("lastblockhash") > 0);
 			BOOST_CHECK_MESSAGE(toString(trueBc.info().hash()) == o["lastblockhash"].get_str(),
 					"Boost check: " + i.first + " lastblockhash does not match " + toString(trueBc.info().hash()) + " expected: " + o["lastblockhash"].get_str());
@@ -736,6 +748,54 @@ RLPStream createFullBlockFromHeader(BlockInfo const& _bi, bytes const& _txs, byt
 	return ret;
 }
 
+void checkBlockStore(BlockChain const& _bc)
+{
+	// Headers, body hashes and transactions are each served without the rest of the block; they must agree with it.
+	for (h256 h = _bc.currentHash(); h;)
+	{
+		SharedBytes block = _bc.blockData(h);
+		BOOST_REQUIRE(!block->empty());
+		RLP root(*block);
+		BOOST_CHECK(*_bc.headerData(h) == root[0].data().toBytes());
+		BlockInfo bi = _bc.info(h);
+		BOOST_CHECK(bi == BlockInfo(*block));
+		BOOST_CHECK(bi.hash() == h);
+
+		TransactionHashes txHashes = _bc.transactionHashes(h);
+		vector<SharedBytesRef> txs = _bc.transactions(h);
+		BOOST_REQUIRE_EQUAL(txHashes.size(), root[1].itemCount());
+		BOOST_REQUIRE_EQUAL(txs.size(), root[1].itemCount());
+		for (unsigned i = 0; i < txs.size(); ++i)
+		{
+			BOOST_CHECK(txHashes[i] == sha3(root[1][i].data()));
+			BOOST_CHECK(txs[i].toBytes() == root[1][i].data().toBytes());
+			BOOST_CHECK(_bc.transaction(h, i).toBytes() == txs[i].toBytes());
+		}
+
+		UncleHashes uncleHashes = _bc.uncleHashes(h);
+		BOOST_REQUIRE_EQUAL(uncleHashes.size(), root[2].itemCount());
+		for (unsigned i = 0; i < uncleHashes.size(); ++i)
+			BOOST_CHECK(uncleHashes[i] == sha3(root[2][i].data()));
+
+		h = bi.number ? bi.parentHash : h256();
+	}
+}
+
+void checkCanonicalIndex(BlockChain const& _bc)
+{
+	// Every number up to the best block maps to the best block's ancestor of that number, and none after it.
+	unsigned n = _bc.number();
+	BOOST_CHECK(_bc.numberHash(n + 1) == h256());
+	for (h256 h = _bc.currentHash(); ; h = _bc.details(h).parent, --n)
+	{
+		BOOST_REQUIRE_EQUAL(_bc.number(h), n);
+		BOOST_CHECK_MESSAGE(_bc.numberHash(n) == h, "canonical index wrong at block #" + toString(n));
+		if (!n)
+			break;
+	}
+	BOOST_CHECK(_bc.numberHash(0) == _bc.genesisHash());
+}
+
 } }// Namespace Close
 
 BOOST_AUTO_TEST_SUITE(BlockChainTests)
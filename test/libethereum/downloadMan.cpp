@@ -0,0 +1,102 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file downloadMan.cpp
+ * @date 2015
+ * DownloadMan test functions.
+ */
+
+#include <thread>
+#include <boost/test/unit_test.hpp>
+#include <libethereum/DownloadMan.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+
+namespace
+{
+
+h256s chain(unsigned _n)
+{
+	h256s ret;
+	for (unsigned i = 0; i < _n; ++i)
+		ret.push_back(h256(i + 1));
+	return ret;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(downloadMan)
+
+BOOST_AUTO_TEST_CASE(subsAskForDifferentBlocks)
+{
+	DownloadMan man;
+	man.resetToChain(chain(30));
+	DownloadSub a(man);
+	DownloadSub b(man);
+
+	h256Hash fromA = a.nextFetch(10);
+	h256Hash fromB = b.nextFetch(10);
+	BOOST_CHECK_EQUAL(fromA.size(), 10);
+	BOOST_CHECK_EQUAL(fromB.size(), 10);
+	for (auto const& h: fromA)
+		BOOST_CHECK(!fromB.count(h));
+	BOOST_CHECK(!a.isStalled());
+
+	// Until a's blocks come in, a gets the same ones again.
+	BOOST_CHECK(a.nextFetch(10) == fromA);
+	for (auto const& h: fromA)
+		BOOST_CHECK(a.noteBlock(h));
+	BOOST_CHECK(!a.noteBlock(*fromA.begin()));
+	a.noteResponse(10, 0);
+
+	// Then it moves on to what neither has asked for.
+	h256Hash next = a.nextFetch(20);
+	BOOST_CHECK_EQUAL(next.size(), 10);
+	for (auto const& h: next)
+		BOOST_CHECK(!fromA.count(h) && !fromB.count(h));
+	RangeMask<unsigned> got = man.blocksGot();
+	for (unsigned i = 0; i < 30; ++i)
+		BOOST_CHECK_EQUAL(got.contains(i), i < 10);
+}
+
+BOOST_AUTO_TEST_CASE(concurrentSubs)
+{
+	// Each sub asks while the others note their blocks and responses.
+	DownloadMan man;
+	man.resetToChain(chain(4000));
+	vector<thread> peers;
+	for (unsigned p = 0; p < 4; ++p)
+		peers.push_back(thread([&]()
+		{
+			DownloadSub sub(man);
+			for (unsigned i = 0; i < 100000 && !man.isComplete(); ++i)
+			{
+				h256Hash blocks = sub.nextFetch(sub.fetchSize(16));
+				for (auto const& h: blocks)
+					sub.noteBlock(h);
+				sub.noteResponse(blocks.size(), 0);
+				sub.isStalled();
+				sub.doneFetch();
+			}
+		}));
+	for (auto& p: peers)
+		p.join();
+	BOOST_CHECK(man.isComplete());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,194 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file serveThrottle.cpp
+ * @date 2015
+ * ServeThrottle test functions.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <thread>
+#include <libdevcore/TransientDirectory.h>
+#include <libp2p/Host.h>
+#include <libp2p/Session.h>
+#include <libp2p/HostCapability.h>
+#include <libethereum/CanonBlockChain.h>
+#include <libethereum/BlockQueue.h>
+#include <libethereum/TransactionQueue.h>
+#include <libethereum/EthereumHost.h>
+#include <libethereum/EthereumPeer.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+using namespace dev::p2p;
+
+namespace
+{
+
+struct P2PFixture
+{
+	P2PFixture() { NodeIPEndpoint::test_allowLocal = true; }
+	~P2PFixture() { NodeIPEndpoint::test_allowLocal = false; }
+};
+
+/// Speaks just enough "eth" to ask a peer for the same @a c_maxBlocks blocks over and over, one request at a time.
+class BlocksTaker: public Capability
+{
+public:
+	BlocksTaker(Session* _s, HostCapabilityFace* _h, unsigned _idOffset): Capability(_s, _h, _idOffset) {}
+	static string name() { return "eth"; }
+	static u256 version() { return eth::c_protocolVersion; }
+	static unsigned messageCount() { return PacketCount; }
+
+	/// Introduces us as being on network @a _networkId at @a _genesis, then asks for it @a _requests times.
+	void start(u256 const& _networkId, h256 const& _genesis, unsigned _requests)
+	{
+		Guard l(x_taken);
+		m_genesis = _genesis;
+		m_requests = _requests;
+		RLPStream s;
+		prep(s, StatusPacket, 5) << eth::c_protocolVersion << _networkId << CanonBlockChain::genesis().difficulty << _genesis << _genesis;
+		sealAndSend(s);
+		ask();
+	}
+
+	unsigned answered() const { Guard l(x_taken); return m_answered; }
+	unsigned emptyAnswers() const { Guard l(x_taken); return m_empty; }
+	size_t bytesTaken() const { Guard l(x_taken); return m_bytes; }
+
+protected:
+	virtual bool interpret(unsigned _id, RLP const& _r) override
+	{
+		if (_id != BlocksPacket)
+			return true;
+		Guard l(x_taken);
+		++m_answered;
+		if (!_r.itemCount())
+			++m_empty;
+		for (auto const& b: _r)
+			m_bytes += b.data().size();
+		if (m_answered < m_requests)
+			ask();
+		return true;
+	}
+
+private:
+	void ask()
+	{
+		RLPStream s;
+		prep(s, GetBlocksPacket, c_maxBlocks);
+		for (unsigned i = 0; i < c_maxBlocks; ++i)
+			s << m_genesis;
+		sealAndSend(s);
+	}
+
+	mutable Mutex x_taken;
+	h256 m_genesis;
+	unsigned m_requests = 0;
+	unsigned m_answered = 0;
+	unsigned m_empty = 0;
+	size_t m_bytes = 0;
+};
+
+class BlocksTakerHost: public HostCapability<BlocksTaker>
+{
+public:
+	shared_ptr<BlocksTaker> taker()
+	{
+		for (auto const& i: peerSessions())
+			return i.first->cap<BlocksTaker>();
+		return nullptr;
+	}
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE(serveThrottle)
+
+BOOST_AUTO_TEST_CASE(debtIsBounded)
+{
+	ServeThrottle::Clock::time_point now;
+	ServeThrottle t(now);
+	BOOST_CHECK(t.mayServe());
+
+	// A huge block may overdraw the allowance, but only so far.
+	t.charge(c_maxServedBytesBurst * 10);
+	BOOST_CHECK_EQUAL(t.allowance(), -int64_t(c_maxServedBytesBurst));
+	BOOST_CHECK(!t.mayServe());
+
+	// Nothing more is served until time has paid the debt off.
+	now += chrono::seconds(c_maxServedBytesBurst / c_maxServedBytesPerSecond);
+	t.refill(now);
+	BOOST_CHECK(!t.mayServe());
+	now += chrono::seconds(1);
+	t.refill(now);
+	BOOST_CHECK(t.mayServe());
+
+	// And refilling stops at the burst.
+	now += chrono::seconds(60);
+	t.refill(now);
+	BOOST_CHECK_EQUAL(t.allowance(), int64_t(c_maxServedBytesBurst));
+}
+
+BOOST_FIXTURE_TEST_CASE(throttledPeerKeepsSyncing, P2PFixture)
+{
+	TransientDirectory td;
+	CanonBlockChain bc(td.path(), WithExisting::Kill);
+	TransactionQueue tq;
+	BlockQueue bq;
+	u256 const networkId = 0;
+
+	char const* const localhost = "127.0.0.1";
+	NetworkPreferences prefs1(localhost, 30311, false);
+	NetworkPreferences prefs2(localhost, 30312, false);
+	Host host1("Test", prefs1);
+	host1.registerCapability(new EthereumHost(bc, tq, bq, networkId));
+	host1.start();
+	Host host2("Test", prefs2);
+	auto takers = host2.registerCapability(new BlocksTakerHost());
+	host2.start();
+
+	int const step = 10;
+	for (int i = 0; i < 3000 && (!host1.isStarted() || !host2.isStarted()); i += step)
+		this_thread::sleep_for(chrono::milliseconds(step));
+	BOOST_REQUIRE(host1.isStarted() && host2.isStarted());
+	host1.requirePeer(host2.id(), NodeIPEndpoint(bi::address::from_string(localhost), prefs2.listenPort, prefs2.listenPort));
+	for (int i = 0; i < 3000 && (!host1.peerCount() || !host2.peerCount()); i += step)
+		this_thread::sleep_for(chrono::milliseconds(step));
+	BOOST_REQUIRE(host1.peerCount() > 0 && host2.peerCount() > 0);
+	shared_ptr<BlocksTaker> taker = takers->taker();
+	BOOST_REQUIRE(taker);
+
+	// Enough to take the burst twice over, so the later requests must wait on the allowance.
+	size_t const reply = c_maxBlocks * bc.block().size();
+	unsigned const requests = 2 * c_maxServedBytesBurst / reply + 1;
+	auto started = chrono::steady_clock::now();
+	taker->start(networkId, bc.genesisHash(), requests);
+	for (int i = 0; i < 30000 && taker->answered() < requests; i += step)
+		this_thread::sleep_for(chrono::milliseconds(step));
+	double elapsed = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+	// Every request answered, none of them with the empty Blocks which would end the sync...
+	BOOST_CHECK_EQUAL(taker->answered(), requests);
+	BOOST_CHECK_EQUAL(taker->emptyAnswers(), 0u);
+	BOOST_CHECK_EQUAL(taker->bytesTaken(), requests * reply);
+	// ...but no faster than the allowance permits, give or take the reply which overdraws it.
+	BOOST_CHECK_LE(double(taker->bytesTaken()), c_maxServedBytesBurst + c_maxServedBytesPerSecond * elapsed + reply);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -99,6 +99,44 @@ BOOST_AUTO_TEST_CASE(Complex)
 	cout << s;
 }
 
+BOOST_AUTO_TEST_CASE(IncrementalCommit)
+{
+	KeyPair me = sha3("Gav Wood");
+	KeyPair myMiner = sha3("Gav's Miner");
+
+	Defaults::setDBPath(boost::filesystem::temp_directory_path().string() + "/" + toString(chrono::system_clock::now().time_since_epoch().count()));
+
+	OverlayDB stateDB = State::openDB();
+	CanonBlockChain bc;
+	State s(stateDB, BaseState::CanonGenesis, myMiner.address());
+	s.sync(bc);
+	mine(s, bc);
+	bc.attemptImport(s.blockData(), stateDB);
+	s.sync(bc);
+
+	// Commit between each transaction, so the tries get built up a transaction at a time.
+	for (unsigned i = 0; i < 3; ++i)
+	{
+		if (i)
+			s.commitToMine(bc);
+		Transaction t(1000 + i, 10000, 100000, me.address(), bytes(), s.transactionsFrom(myMiner.address()), myMiner.secret());
+		s.execute(bc.lastHashes(), t);
+	}
+
+	// A copy builds them from scratch. It's taken before the last commit, which a copy doesn't carry over,
+	// so that each applies the block reward once.
+	State fresh(s);
+	s.commitToMine(bc);
+	fresh.commitToMine(bc);
+	BOOST_CHECK_EQUAL(s.info().transactionsRoot, fresh.info().transactionsRoot);
+	BOOST_CHECK_EQUAL(s.info().receiptsRoot, fresh.info().receiptsRoot);
+	BOOST_CHECK_EQUAL(s.info().stateRoot, fresh.info().stateRoot);
+	BOOST_CHECK(s.info().logBloom == fresh.info().logBloom);
+
+	mine(s, bc);
+	BOOST_CHECK(bc.attemptImport(s.blockData(), stateDB).first == ImportResult::Success);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
@@ -0,0 +1,231 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file transactionqueue.cpp
+ * @date 2015
+ * TransactionQueue test functions.
+ */
+
+#include <future>
+#include <boost/test/unit_test.hpp>
+#include <libethereum/TransactionQueue.h>
+#include "../TestHelper.h"
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+
+BOOST_AUTO_TEST_SUITE(transactionQueue)
+
+BOOST_AUTO_TEST_CASE(priceAndNonceOrder)
+{
+	KeyPair a = KeyPair::create();
+	KeyPair b = KeyPair::create();
+	Transaction a0(0, 10 * szabo, 21000, Address(1), bytes(), 0, a.secret());
+	Transaction a1(0, 100 * szabo, 21000, Address(1), bytes(), 1, a.secret());
+	Transaction b0(0, 50 * szabo, 21000, Address(1), bytes(), 0, b.secret());
+
+	TransactionQueue tq;
+	BOOST_CHECK(tq.import(a1) == ImportResult::Success);
+	BOOST_CHECK(tq.import(a0) == ImportResult::Success);
+	BOOST_CHECK(tq.import(b0) == ImportResult::Success);
+	BOOST_CHECK_EQUAL(tq.maxNonce(a.address()), 2);
+
+	// a1 pays most but has to wait for a0.
+	Transactions top = tq.topTransactions(10);
+	BOOST_REQUIRE_EQUAL(top.size(), 3);
+	BOOST_CHECK(top[0].sha3() == b0.sha3());
+	BOOST_CHECK(top[1].sha3() == a0.sha3());
+	BOOST_CHECK(top[2].sha3() == a1.sha3());
+
+	top = tq.topTransactions(10, h256Hash{b0.sha3(), a0.sha3()});
+	BOOST_REQUIRE_EQUAL(top.size(), 1);
+	BOOST_CHECK(top[0].sha3() == a1.sha3());
+
+	// Replacing a transaction takes a better price.
+	Transaction b0cheap(1, 50 * szabo, 21000, Address(1), bytes(), 0, b.secret());
+	Transaction b0dear(1, 60 * szabo, 21000, Address(1), bytes(), 0, b.secret());
+	BOOST_CHECK(tq.import(b0cheap) == ImportResult::Underpriced);
+	BOOST_CHECK(tq.import(b0dear) == ImportResult::Success);
+	BOOST_CHECK_EQUAL(tq.items().first, 3);
+	BOOST_CHECK(tq.topTransactions(1)[0].sha3() == b0dear.sha3());
+}
+
+BOOST_AUTO_TEST_CASE(evictsCheapest)
+{
+	KeyPair a = KeyPair::create();
+	KeyPair b = KeyPair::create();
+	KeyPair c = KeyPair::create();
+	TransactionQueue tq(3);
+	Transaction a0(0, 10 * szabo, 21000, Address(1), bytes(), 0, a.secret());
+	Transaction a1(0, 90 * szabo, 21000, Address(1), bytes(), 1, a.secret());
+	Transaction b0(0, 50 * szabo, 21000, Address(1), bytes(), 0, b.secret());
+	BOOST_CHECK(tq.import(a0) == ImportResult::Success);
+	BOOST_CHECK(tq.import(a1) == ImportResult::Success);
+	BOOST_CHECK(tq.import(b0) == ImportResult::Success);
+
+	// Too cheap to get in.
+	BOOST_CHECK(tq.import(Transaction(0, 5 * szabo, 21000, Address(1), bytes(), 0, c.secret())) == ImportResult::Underpriced);
+
+	// a0 is cheapest, and a1 can't go in without it, so a1 makes way.
+	Transaction c0(0, 20 * szabo, 21000, Address(1), bytes(), 0, c.secret());
+	BOOST_CHECK(tq.import(c0) == ImportResult::Success);
+	Transactions top = tq.topTransactions(10);
+	BOOST_REQUIRE_EQUAL(top.size(), 3);
+	BOOST_CHECK(top[0].sha3() == b0.sha3());
+	BOOST_CHECK(top[1].sha3() == c0.sha3());
+	BOOST_CHECK(top[2].sha3() == a0.sha3());
+	BOOST_CHECK_EQUAL(tq.maxNonce(a.address()), 1);
+
+	// Evicted transactions may come back.
+	tq.setLimit(4);
+	BOOST_CHECK(tq.import(a1) == ImportResult::Success);
+	tq.setLimit(1);
+	BOOST_CHECK_EQUAL(tq.items().first, 1);
+	BOOST_CHECK(tq.topTransactions(10)[0].sha3() == b0.sha3());
+}
+
+BOOST_AUTO_TEST_CASE(evictsOnlyWhatItMust)
+{
+	KeyPair a = KeyPair::create();
+	KeyPair b = KeyPair::create();
+	TransactionQueue tq(3);
+	Transaction a0(0, 10 * szabo, 21000, Address(1), bytes(), 0, a.secret());
+	Transaction a1(0, 11 * szabo, 21000, Address(1), bytes(), 1, a.secret());
+	Transaction a2(0, 12 * szabo, 21000, Address(1), bytes(), 2, a.secret());
+	BOOST_CHECK(tq.import(a0) == ImportResult::Success);
+	BOOST_CHECK(tq.import(a1) == ImportResult::Success);
+	BOOST_CHECK(tq.import(a2) == ImportResult::Success);
+
+	// One place is needed, so only the end of a's queue goes.
+	Transaction b0(0, 50 * szabo, 21000, Address(1), bytes(), 0, b.secret());
+	BOOST_CHECK(tq.import(b0) == ImportResult::Success);
+	BOOST_CHECK_EQUAL(tq.items().first, 3);
+	BOOST_CHECK_EQUAL(tq.maxNonce(a.address()), 2);
+	Transactions top = tq.topTransactions(10);
+	BOOST_REQUIRE_EQUAL(top.size(), 3);
+	BOOST_CHECK(top[0].sha3() == b0.sha3());
+	BOOST_CHECK(top[1].sha3() == a0.sha3());
+	BOOST_CHECK(top[2].sha3() == a1.sha3());
+}
+
+BOOST_AUTO_TEST_CASE(neverEvictsOwnPredecessor)
+{
+	KeyPair a = KeyPair::create();
+	KeyPair b = KeyPair::create();
+	KeyPair c = KeyPair::create();
+	TransactionQueue tq(2);
+	Transaction a0(0, 10 * szabo, 21000, Address(1), bytes(), 0, a.secret());
+	Transaction b0(0, 50 * szabo, 21000, Address(1), bytes(), 0, b.secret());
+	BOOST_CHECK(tq.import(a0) == ImportResult::Success);
+	BOOST_CHECK(tq.import(b0) == ImportResult::Success);
+
+	// a1 pays well, but would have to wait for a0, the cheapest; pushing a0 out would leave it waiting for nothing.
+	Transaction a1(0, 100 * szabo, 21000, Address(1), bytes(), 1, a.secret());
+	BOOST_CHECK(tq.import(a1) == ImportResult::Underpriced);
+	BOOST_CHECK_EQUAL(tq.items().first, 2);
+	BOOST_CHECK_EQUAL(tq.maxNonce(a.address()), 1);
+
+	// Someone else paying as much gets in.
+	Transaction c0(0, 100 * szabo, 21000, Address(1), bytes(), 0, c.secret());
+	BOOST_CHECK(tq.import(c0) == ImportResult::Success);
+	Transactions top = tq.topTransactions(10);
+	BOOST_REQUIRE_EQUAL(top.size(), 2);
+	BOOST_CHECK(top[0].sha3() == c0.sha3());
+	BOOST_CHECK(top[1].sha3() == b0.sha3());
+}
+
+BOOST_AUTO_TEST_CASE(arrivalsSince)
+{
+	KeyPair a = KeyPair::create();
+	KeyPair b = KeyPair::create();
+	Transaction a0(0, 10 * szabo, 21000, Address(1), bytes(), 0, a.secret());
+	Transaction b0(0, 10 * szabo, 21000, Address(1), bytes(), 0, b.secret());
+	TransactionQueue tq;
+	unsigned since = 0;
+	BOOST_CHECK(tq.transactionsSince(since).empty());
+
+	BOOST_CHECK(tq.import(a0) == ImportResult::Success);
+	auto fresh = tq.transactionsSince(since);
+	BOOST_REQUIRE_EQUAL(fresh.size(), 1);
+	BOOST_CHECK(fresh[0].first == a0.sha3());
+	BOOST_CHECK(tq.transactionsSince(since).empty());
+
+	// b0 arrives, then so many more arrivals that it's forgotten: it must still be handed over.
+	BOOST_CHECK(tq.import(b0) == ImportResult::Success);
+	for (unsigned i = 0; i < TransactionQueue::c_maxArrivals; ++i)
+	{
+		tq.drop(a0.sha3());
+		BOOST_REQUIRE(tq.import(a0, TransactionQueue::ImportCallback(), IfDropped::Retry) == ImportResult::Success);
+	}
+	fresh = tq.transactionsSince(since);
+	BOOST_REQUIRE_EQUAL(fresh.size(), 2);
+	BOOST_CHECK(fresh[0].first == a0.sha3());
+	BOOST_CHECK(fresh[1].first == b0.sha3());
+	BOOST_CHECK(tq.transactionsSince(since).empty());
+}
+
+BOOST_AUTO_TEST_CASE(enqueueVerifiesOffThread)
+{
+	KeyPair a = KeyPair::create();
+	Transaction a0(0, 10 * szabo, 21000, Address(1), bytes(), 0, a.secret());
+	bytes rlp = a0.rlp();
+	TransactionQueue tq;
+
+	promise<ImportResult> good;
+	BOOST_CHECK(tq.enqueue(&rlp, [&](ImportResult _ir) { good.set_value(_ir); }) == ImportResult::Success);
+	BOOST_CHECK(good.get_future().get() == ImportResult::Success);
+	BOOST_CHECK_EQUAL(tq.items().first, 1);
+	BOOST_CHECK(tq.enqueue(&rlp) == ImportResult::AlreadyKnown);
+
+	bytes junk(100, 0xab);
+	promise<ImportResult> bad;
+	BOOST_CHECK(tq.enqueue(&junk, [&](ImportResult _ir) { bad.set_value(_ir); }) == ImportResult::Success);
+	BOOST_CHECK(bad.get_future().get() == ImportResult::Malformed);
+	BOOST_CHECK_EQUAL(tq.unverified(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(enqueueBacklogBounded)
+{
+	promise<void> release;
+	shared_future<void> released = release.get_future().share();
+	vector<promise<void>> entered(TransactionQueue::c_verifierThreads);
+	// Declared after what its callbacks use, so its verifiers are stopped before those go.
+	TransactionQueue tq(2);
+
+	// Tie up both verifier threads in callbacks.
+	for (unsigned i = 0; i < entered.size(); ++i)
+	{
+		bytes junk(100 + i, 0xab);
+		BOOST_CHECK(tq.enqueue(&junk, [&, i](ImportResult) { entered[i].set_value(); released.wait(); }) == ImportResult::Success);
+	}
+	for (auto& e: entered)
+		e.get_future().wait();
+
+	// Now only limit() more may wait.
+	for (unsigned i = 0; i < 2; ++i)
+	{
+		bytes junk(200 + i, 0xab);
+		BOOST_CHECK(tq.enqueue(&junk) == ImportResult::Success);
+	}
+	bytes junk(300, 0xab);
+	BOOST_CHECK(tq.enqueue(&junk) == ImportResult::Overloaded);
+	BOOST_CHECK_EQUAL(tq.unverified(), 2);
+
+	release.set_value();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
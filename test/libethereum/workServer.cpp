@@ -0,0 +1,174 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file workServer.cpp
+ * @date 2015
+ * WorkServer and WorkClient test functions.
+ */
+
+#include <thread>
+#include <boost/test/unit_test.hpp>
+#include <libethereum/WorkServer.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+namespace ba = boost::asio;
+namespace bi = boost::asio::ip;
+
+namespace
+{
+
+unsigned short const c_port = 30390;
+
+ProofOfWork::WorkPackage package(unsigned _i)
+{
+	ProofOfWork::WorkPackage ret;
+	ret.headerHash = h256(_i);
+	ret.seedHash = h256(100 + _i);
+	ret.boundary = h256(200 + _i);
+	return ret;
+}
+
+/// A miner speaking the line protocol by hand.
+struct RawMiner
+{
+	RawMiner(): socket(io) { socket.connect(bi::tcp::endpoint(bi::address::from_string("127.0.0.1"), c_port)); }
+
+	void send(string const& _line) { boost::system::error_code ec; ba::write(socket, ba::buffer(_line + "\n"), ec); }
+
+	/// @returns the next line from the server, or "" once it's hung up.
+	string receive()
+	{
+		boost::system::error_code ec;
+		ba::read_until(socket, in, '\n', ec);
+		if (ec)
+			return string();
+		istream is(&in);
+		string ret;
+		getline(is, ret);
+		return ret;
+	}
+
+	/// Waits for the server to get through everything sent so far.
+	void sync() { send("submit"); BOOST_REQUIRE_EQUAL(receive(), "result"); }
+
+	ba::io_service io;
+	bi::tcp::socket socket;
+	ba::streambuf in;
+};
+
+string share(Nonce const& _nonce, h256 const& _header) { return _nonce.hex() + ":" + _header.hex() + ":" + h256(1).hex(); }
+
+/// Waits up to a few seconds for @a _f to hold.
+template <class F> bool eventually(F const& _f)
+{
+	for (unsigned i = 0; i < 100 && !_f(); ++i)
+		this_thread::sleep_for(chrono::milliseconds(20));
+	return _f();
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(workServer)
+
+BOOST_AUTO_TEST_CASE(lineProtocol)
+{
+	WorkServer server("127.0.0.1", c_port, []() { return package(1); }, [](ProofOfWork::Solution const& _s) { return _s.nonce == Nonce(7); });
+	RawMiner m;
+	BOOST_CHECK_EQUAL(m.receive(), "work " + package(1).headerHash.hex() + " " + package(1).seedHash.hex() + " " + package(1).boundary.hex());
+
+	m.send("hello rig");
+	m.send("hashrate 1000");
+	m.send("bogus request");
+	m.send("submit " + share(Nonce(7), h256(1)) + " " + share(Nonce(8), h256(1)) + " " + share(Nonce(7), h256(9)));
+	BOOST_CHECK_EQUAL(m.receive(), "result a r s");
+	m.send("submit garbage");
+	m.sync();
+
+	auto workers = server.workers();
+	BOOST_REQUIRE_EQUAL(workers.size(), 1);
+	WorkerStats const& rig = workers["rig"];
+	BOOST_CHECK_EQUAL(rig.hashrate, 1000);
+	BOOST_CHECK_EQUAL(rig.accepted, 1);
+	BOOST_CHECK_EQUAL(rig.rejected, 1);
+	BOOST_CHECK_EQUAL(rig.stale, 1);
+	BOOST_CHECK_EQUAL(server.connections(), 1);
+	BOOST_CHECK_EQUAL(server.hashrate(), 1000);
+
+	// New work is pushed at once; shares for the old work are then stale.
+	server.setWork(package(2));
+	BOOST_CHECK_EQUAL(m.receive(), "work " + package(2).headerHash.hex() + " " + package(2).seedHash.hex() + " " + package(2).boundary.hex());
+	m.send("submit " + share(Nonce(7), h256(1)));
+	BOOST_CHECK_EQUAL(m.receive(), "result s");
+
+	// A line that never ends gets the miner dropped.
+	m.send(string(100 * 1024, 'x'));
+	BOOST_CHECK_EQUAL(m.receive(), "");
+	BOOST_CHECK(eventually([&]() { return !server.connections(); }));
+	BOOST_CHECK_EQUAL(server.workers()["rig"].stale, 2);
+}
+
+BOOST_AUTO_TEST_CASE(workerTableBounded)
+{
+	WorkServer server("127.0.0.1", c_port, []() { return package(1); }, [](ProofOfWork::Solution const&) { return false; });
+	unsigned const max = WorkServer::c_maxWorkers;
+	vector<unique_ptr<RawMiner>> miners;
+	for (unsigned i = 0; i < max; ++i)
+	{
+		miners.emplace_back(new RawMiner);
+		BOOST_REQUIRE(!miners.back()->receive().empty());
+		miners.back()->send("hello rig" + toString(i));
+		miners.back()->sync();
+	}
+	BOOST_CHECK_EQUAL(server.workers().size(), max);
+
+	// Every worker is connected, so there's no room for another.
+	RawMiner refused;
+	BOOST_CHECK_EQUAL(refused.receive(), "");
+
+	// Once one leaves, it's forgotten to make room.
+	miners.front().reset();
+	BOOST_REQUIRE(eventually([&]() { return server.connections() == max - 1; }));
+	RawMiner m;
+	BOOST_REQUIRE(!m.receive().empty());
+	m.send("hello newcomer");
+	m.sync();
+	auto workers = server.workers();
+	BOOST_CHECK_EQUAL(workers.size(), max);
+	BOOST_CHECK(workers.count("newcomer"));
+	BOOST_CHECK(!workers.count("rig0"));
+}
+
+BOOST_AUTO_TEST_CASE(client)
+{
+	BOOST_CHECK_THROW(WorkClient("127.0.0.1", c_port, "rig"), boost::system::system_error);
+
+	unique_ptr<WorkServer> server(new WorkServer("127.0.0.1", c_port, []() { return package(1); }, [](ProofOfWork::Solution const&) { return true; }));
+	WorkClient c("127.0.0.1", c_port, "rig");
+	BOOST_CHECK(eventually([&]() { return server->workers().count("rig") && server->connections() == 1; }));
+
+	// The client mines whatever it's pushed until the server goes away.
+	GenericFarm<ProofOfWork> farm;
+	thread miner([&]() { c.run(farm, chrono::milliseconds(10)); });
+	BOOST_CHECK(eventually([&]() { return farm.work().headerHash == package(1).headerHash; }));
+	server->setWork(package(2));
+	BOOST_CHECK(eventually([&]() { return farm.work().headerHash == package(2).headerHash; }));
+	server.reset();
+	miner.join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -19,6 +19,7 @@
  * @date 2014
  */
 
+#include <future>
 #include <boost/test/unit_test.hpp>
 
 #include <libdevcore/Worker.h>
@@ -112,8 +113,17 @@ struct TestNodeTable: public NodeTable
 	void reset()
 	{
 		Guard l(x_state);
-		for (auto& n: m_state) n.nodes.clear();
+		for (auto& n: m_state) n.setNodes(NodeBucket::Nodes());
 	}
+
+	bool testAccept(bytesConstRef _packet) { return accept(bi::udp::endpoint(), _packet); }
+	static Public testRecoverSender(bytesConstRef _packet) { return recoverSender(_packet); }
+	void testReceiveBatch(std::vector<UDPDatagram>&& _batch) { onReceivedBatch(nullptr, std::move(_batch)); }
+
+	/// Keeps every verifier thread busy until @a _until is ready.
+	void stallVerifier(std::shared_future<void> _until) { for (unsigned i = 0; i < c_verifierThreads; ++i) m_verifier->post([=]() { _until.wait(); }); }
+	unsigned unverifiedPackets() const { return *m_unverifiedPackets; }
+	static unsigned maxUnverifiedPackets() { return c_maxUnverifiedPackets; }
 };
 
 /**
@@ -151,6 +161,50 @@ public:
 	bool success = false;
 };
 
+/// Records the datagrams it receives as the batches they were handed over in.
+class TestBatchUDPSocket: UDPSocketEvents, public TestHost
+{
+public:
+	using Socket = UDPSocket<TestBatchUDPSocket, 1024>;
+
+	TestBatchUDPSocket(unsigned _port): m_socket(new Socket(m_io, *this, _port)) {}
+
+	void onReceived(UDPSocketFace*, bi::udp::endpoint const&, bytesConstRef) {}
+	void onReceivedBatch(UDPSocketFace*, std::vector<UDPDatagram>&& _batch) { Guard l(x_batches); batches.push_back(move(_batch)); }
+
+	/// @returns the data of every datagram received so far, in order.
+	vector<bytes> received() const
+	{
+		vector<bytes> ret;
+		Guard l(x_batches);
+		for (auto const& b: batches)
+			for (auto const& d: b)
+				ret.push_back(d.data);
+		return ret;
+	}
+
+	/// Waits up to five seconds for @a _count datagrams to have arrived.
+	vector<bytes> waitFor(unsigned _count) const
+	{
+		for (unsigned i = 0; i < 100 && received().size() < _count; ++i)
+			this_thread::sleep_for(chrono::milliseconds(50));
+		return received();
+	}
+
+	shared_ptr<Socket> m_socket;
+	mutable Mutex x_batches;
+	vector<vector<UDPDatagram>> batches;
+};
+
+/// @returns @a _count datagrams to @a _port on the loopback interface, each carrying its index.
+vector<UDPDatagram> numberedDatagrams(unsigned _count, unsigned _port)
+{
+	vector<UDPDatagram> ret;
+	for (unsigned i = 0; i < _count; ++i)
+		ret.push_back(UDPDatagram(bi::udp::endpoint(bi::address::from_string("127.0.0.1"), _port), rlp(i)));
+	return ret;
+}
+
 BOOST_AUTO_TEST_CASE(requestTimeout)
 {
 	using TimePoint = std::chrono::steady_clock::time_point;
@@ -322,6 +376,178 @@ BOOST_AUTO_TEST_CASE(kademlia)
 
 }
 
+BOOST_AUTO_TEST_CASE(nodeDistance)
+{
+	// log2 of the xor of the ids' hashes, as it used to be worked out bit by bit.
+	auto reference = [](NodeId const& _a, NodeId const& _b) { u256 d = sha3(_a) ^ sha3(_b); unsigned ret; for (ret = 0; d >>= 1; ++ret) {}; return ret; };
+	for (unsigned i = 0; i < 256; ++i)
+	{
+		NodeId a = KeyPair::create().pub();
+		NodeId b = KeyPair::create().pub();
+		BOOST_CHECK_EQUAL(NodeTable::distance(a, b), reference(a, b));
+	}
+	BOOST_CHECK_EQUAL(NodeTable::distance(h256(), h256()), 0);
+	BOOST_CHECK_EQUAL(NodeTable::distance(h256(), h256(1)), 0);
+	BOOST_CHECK_EQUAL(NodeTable::distance(h256(), h256(0x100)), 8);
+	BOOST_CHECK_EQUAL(NodeTable::distance(h256(u256(1) << 64), h256()), 64);
+	BOOST_CHECK_EQUAL(NodeTable::distance(h256(u256(1) << 255), h256(1)), 255);
+}
+
+BOOST_AUTO_TEST_CASE(acceptPacket)
+{
+	ba::io_service io;
+	KeyPair k = KeyPair::create();
+	auto table = make_shared<TestNodeTable>(io, KeyPair::create(), bi::address::from_string("127.0.0.1"), 30310);
+	NodeIPEndpoint ep(bi::address::from_string("127.0.0.1"), 30311, 30311);
+
+	PingNode p(ep, ep);
+	p.sign(k.sec());
+	BOOST_REQUIRE(TestNodeTable::testRecoverSender(&p.data) == k.pub());
+	BOOST_CHECK(table->testAccept(&p.data));
+
+	// Repeats, truncations, tampering and expired requests are all turned away before the signature is looked at.
+	BOOST_CHECK(!table->testAccept(&p.data));
+	BOOST_CHECK(!table->testAccept(bytesConstRef(&p.data).cropped(0, h256::size + Signature::size + 3)));
+	bytes tampered = p.data;
+	tampered.back() ^= 1;
+	BOOST_CHECK(!table->testAccept(&tampered));
+
+	PingNode expired(ep, ep);
+	expired.ts = RLPXDatagramFace::secondsSinceEpoch() - 1;
+	expired.sign(k.sec());
+	BOOST_CHECK(!table->testAccept(&expired.data));
+
+	// A well-formed packet with a bad signature gets through, but no sender is recovered.
+	bytes forged = p.data;
+	forged[h256::size] ^= 1;
+	bytesConstRef signedBytes = bytesConstRef(&forged).cropped(h256::size);
+	sha3(signedBytes).ref().copyTo(bytesRef(&forged).cropped(0, h256::size));
+	BOOST_CHECK(table->testAccept(&forged));
+	BOOST_CHECK(TestNodeTable::testRecoverSender(&forged) != k.pub());
+}
+
+BOOST_AUTO_TEST_CASE(unverifiedPacketsBounded)
+{
+	ba::io_service io;
+	auto table = make_shared<TestNodeTable>(io, KeyPair::create(), bi::address::from_string("127.0.0.1"), 30312);
+	promise<void> release;
+	table->stallVerifier(release.get_future().share());
+
+	// Distinct, well-hashed packets with junk signatures: each one is worth a recovery.
+	unsigned const max = TestNodeTable::maxUnverifiedPackets();
+	vector<UDPDatagram> batch;
+	for (unsigned i = 0; i < max + 10; ++i)
+	{
+		bytes body = Signature::random().asBytes() + bytes{2, 0xc1, 0x80, 0x80};
+		bytes packet = sha3(body).asBytes() + body;
+		batch.push_back(UDPDatagram(bi::udp::endpoint(), packet));
+	}
+	table->testReceiveBatch(move(batch));
+	BOOST_CHECK_EQUAL(table->unverifiedPackets(), max);
+
+	// Anything more is dropped while the backlog is full.
+	bytes body = Signature::random().asBytes() + bytes{2, 0xc1, 0x80, 0x80};
+	table->testReceiveBatch(vector<UDPDatagram>{UDPDatagram(bi::udp::endpoint(), sha3(body).asBytes() + body)});
+	BOOST_CHECK_EQUAL(table->unverifiedPackets(), max);
+
+	release.set_value();
+	for (unsigned i = 0; i < 100 && table->unverifiedPackets(); ++i)
+		this_thread::sleep_for(chrono::milliseconds(50));
+	BOOST_CHECK_EQUAL(table->unverifiedPackets(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(unverifiedPacketsDroppedFromSocket)
+{
+	TestNodeTableHost host(0);
+	promise<void> release;
+	host.nodeTable->stallVerifier(release.get_future().share());
+	host.start();
+
+	// Sent in rounds which the table is given time to read, so that none are lost to the kernel's receive buffer.
+	bi::udp::endpoint to(bi::address::from_string("127.0.0.1"), 30300);
+	ba::io_service io;
+	bi::udp::socket out(io, bi::udp::endpoint(bi::udp::v4(), 0));
+	unsigned const max = TestNodeTable::maxUnverifiedPackets();
+	unsigned const round = 128;
+	for (unsigned sent = 0; sent < max + round; sent += round)
+	{
+		for (unsigned i = 0; i < round; ++i)
+		{
+			bytes body = Signature::random().asBytes() + bytes{2, 0xc1, 0x80, 0x80};
+			out.send_to(ba::buffer(sha3(body).asBytes() + body), to);
+		}
+		unsigned expected = min(max, sent + round);
+		for (unsigned i = 0; i < 100 && host.nodeTable->unverifiedPackets() < expected; ++i)
+			this_thread::sleep_for(chrono::milliseconds(50));
+		BOOST_REQUIRE_EQUAL(host.nodeTable->unverifiedPackets(), expected);
+	}
+	// The last round found no room and was dropped rather than queued.
+	this_thread::sleep_for(chrono::milliseconds(200));
+	BOOST_CHECK_EQUAL(host.nodeTable->unverifiedPackets(), max);
+
+	release.set_value();
+	for (unsigned i = 0; i < 100 && host.nodeTable->unverifiedPackets(); ++i)
+		this_thread::sleep_for(chrono::milliseconds(50));
+	BOOST_CHECK_EQUAL(host.nodeTable->unverifiedPackets(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(udpBatchedRead)
+{
+	TestBatchUDPSocket a(30320);
+	TestBatchUDPSocket b(30321);
+	a.m_socket->connect();
+	b.m_socket->connect();
+
+	// Everything is waiting by the time b starts reading, so it should come in batches of up to c_maxReadBatch.
+	unsigned const count = 2 * 64 + 5;
+	a.start();
+	BOOST_REQUIRE(a.m_socket->send(numberedDatagrams(count, 30321)));
+	this_thread::sleep_for(chrono::milliseconds(200));
+	b.start();
+
+	vector<bytes> received = b.waitFor(count);
+	BOOST_REQUIRE_EQUAL(received.size(), count);
+	for (unsigned i = 0; i < count; ++i)
+		BOOST_CHECK(received[i] == rlp(i));
+	Guard l(b.x_batches);
+	BOOST_CHECK(b.batches.size() >= 3u);
+	size_t largest = 0;
+	for (auto const& batch: b.batches)
+		largest = max(largest, batch.size());
+	BOOST_CHECK(largest > 1u);
+	BOOST_CHECK(largest <= 64u);
+}
+
+BOOST_AUTO_TEST_CASE(udpFullSendBuffer)
+{
+	struct SendBufferHolder
+	{
+		SendBufferHolder() { TestBatchUDPSocket::Socket::test_sendBufferDatagrams = 3; }
+		~SendBufferHolder() { TestBatchUDPSocket::Socket::test_sendBufferDatagrams = 0; }
+	} holder;
+
+	TestBatchUDPSocket a(30322);
+	TestBatchUDPSocket b(30323);
+	a.m_socket->connect();
+	b.m_socket->connect();
+	a.start();
+	b.start();
+
+	// Only the first few of each write go out straight away; the rest must follow asynchronously, in order.
+	unsigned const count = 50;
+	BOOST_REQUIRE(a.m_socket->send(numberedDatagrams(count, 30323)));
+	vector<bytes> received = b.waitFor(count);
+	BOOST_REQUIRE_EQUAL(received.size(), count);
+	for (unsigned i = 0; i < count; ++i)
+		BOOST_CHECK(received[i] == rlp(i));
+
+	// And single sends queued behind them still get through.
+	BOOST_REQUIRE(a.m_socket->send(UDPDatagram(bi::udp::endpoint(bi::address::from_string("127.0.0.1"), 30323), rlp(count))));
+	received = b.waitFor(count + 1);
+	BOOST_REQUIRE_EQUAL(received.size(), count + 1);
+	BOOST_CHECK(received.back() == rlp(count));
+}
+
 BOOST_AUTO_TEST_CASE(udpOnce)
 {
 	UDPDatagram d(bi::udp::endpoint(boost::asio::ip::address::from_string("127.0.0.1"), 30300), bytes({65,65,65,65}));
@@ -31,11 +31,70 @@
 #include <libdevcrypto/ECDHE.h>
 #include <libdevcrypto/CryptoPP.h>
 #include <libp2p/RLPxHandshake.h>
+#include <libp2p/RLPxFrameIO.h>
 
 using namespace std;
 using namespace dev;
 using namespace dev::crypto;
+using namespace dev::p2p;
 using namespace CryptoPP;
+namespace bi = boost::asio::ip;
+
+namespace
+{
+
+/// A handshake whose outcome is set by hand, to make frame coders from.
+class TestHandshake: public RLPXHandshake
+{
+public:
+	TestHandshake(shared_ptr<RLPXSocket> const& _socket, bool _originated, ECDHE const& _ecdhe, Public const& _remoteEphemeral, h256 const& _nonce, h256 const& _remoteNonce, bytes const& _authCipher, bytes const& _ackCipher):
+		RLPXHandshake(nullptr, _socket)
+	{
+		m_originated = _originated;
+		m_ecdhe = _ecdhe;
+		m_remoteEphemeral = _remoteEphemeral;
+		m_nonce = _nonce;
+		m_remoteNonce = _remoteNonce;
+		m_authCipher = _authCipher;
+		m_ackCipher = _ackCipher;
+	}
+};
+
+/// Frames packets as RLPXFrameIO::writeSingleFramePacket() did before frames were sealed in place.
+class LegacyFrameIO: public RLPXFrameIO
+{
+public:
+	LegacyFrameIO(RLPXHandshake const& _init): RLPXFrameIO(_init) {}
+
+	void writeSingleFramePacket(bytesConstRef _packet, bytes& o_bytes)
+	{
+		RLPStream header;
+		uint32_t len = (uint32_t)_packet.size();
+		header.appendRaw(bytes({byte((len >> 16) & 0xff), byte((len >> 8) & 0xff), byte(len & 0xff)}));
+		header.appendRaw(bytes({0xc2,0x80,0x80}));
+
+		bytes headerWithMac(h256::size);
+		bytesConstRef(&header.out()).copyTo(bytesRef(&headerWithMac));
+		m_frameEnc.ProcessData(headerWithMac.data(), headerWithMac.data(), 16);
+		updateEgressMACWithHeader(bytesConstRef(&headerWithMac).cropped(0, 16));
+		egressDigest().ref().copyTo(bytesRef(&headerWithMac).cropped(h128::size,h128::size));
+
+		auto padding = (16 - (_packet.size() % 16)) % 16;
+		o_bytes.swap(headerWithMac);
+		o_bytes.resize(32 + _packet.size() + padding + h128::size);
+		bytesRef packetRef(o_bytes.data() + 32, _packet.size());
+		m_frameEnc.ProcessData(packetRef.data(), _packet.data(), _packet.size());
+		bytesRef paddingRef(o_bytes.data() + 32 + _packet.size(), padding);
+		if (padding)
+			m_frameEnc.ProcessData(paddingRef.data(), paddingRef.data(), padding);
+		bytesRef packetWithPaddingRef(o_bytes.data() + 32, _packet.size() + padding);
+		updateEgressMACWithFrame(packetWithPaddingRef);
+		bytesRef macRef(o_bytes.data() + 32 + _packet.size() + padding, h128::size);
+		egressDigest().ref().copyTo(macRef);
+	}
+};
+
+}
 
 BOOST_AUTO_TEST_SUITE(rlpx)
 
@@ -451,5 +510,51 @@ BOOST_AUTO_TEST_CASE(ecies_interop_test_primitives)
 	BOOST_REQUIRE(plainTest3 == expectedPlain3);
 }
 
-BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_CASE(sealFramePacketMatchesLegacy)
+{
+	boost::asio::io_service io;
+	auto socket = [&]() { bi::tcp::socket s(io); return make_shared<RLPXSocket>(&s); };
+	ECDHE initEcdhe;
+	ECDHE recvEcdhe;
+	h256 initNonce = h256::random();
+	h256 recvNonce = h256::random();
+	bytes authCipher = sha3("auth").asBytes();
+	bytes ackCipher = sha3("ack").asBytes();
+	TestHandshake initiator(socket(), true, initEcdhe, recvEcdhe.pubkey(), initNonce, recvNonce, authCipher, ackCipher);
+	TestHandshake recipient(socket(), false, recvEcdhe, initEcdhe.pubkey(), recvNonce, initNonce, authCipher, ackCipher);
+
+	// Each coder starts from the same secrets, so they must stay in step frame after frame.
+	LegacyFrameIO legacy(initiator);
+	RLPXFrameIO single(initiator);
+	RLPXFrameIO sealer(initiator);
+	RLPXFrameIO receiver(recipient);
+
+	for (size_t size: {1, 15, 16, 17, 100, 1024, 70000})
+	{
+		bytes packet(size);
+		for (size_t i = 0; i < size; ++i)
+			packet[i] = byte(i * 7 + size);
+
+		bytes expected;
+		legacy.writeSingleFramePacket(&packet, expected);
+		BOOST_REQUIRE_EQUAL(expected.size(), RLPXFrameIO::frameSize(size));
 
+		bytes written;
+		single.writeSingleFramePacket(&packet, written);
+		BOOST_CHECK(written == expected);
+
+		// Sealed in place over a buffer with junk where the header, padding and MACs go, as from the session's pool.
+		bytes frame(RLPXFrameIO::frameSize(size), 0xff);
+		bytesConstRef(&packet).copyTo(bytesRef(&frame).cropped(h256::size, size));
+		sealer.sealFramePacket(&frame, size);
+		BOOST_CHECK(frame == expected);
+
+		// And the other end can read it.
+		BOOST_REQUIRE(receiver.authAndDecryptHeader(bytesRef(&frame).cropped(0, h256::size)));
+		BOOST_CHECK_EQUAL((size_t)((frame[0] << 16) | (frame[1] << 8) | frame[2]), size);
+		BOOST_REQUIRE(receiver.authAndDecryptFrame(bytesRef(&frame).cropped(h256::size)));
+		BOOST_CHECK(bytesConstRef(&frame).cropped(h256::size, size).toBytes() == packet);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,278 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file batch.cpp
+ * @date 2015
+ * Tests for the parallel execution of JSON-RPC batches and for streamed calls.
+ */
+
+#if ETH_JSONRPC || !ETH_TRUE
+
+#include <boost/test/unit_test.hpp>
+#include <libethcore/CommonJS.h>
+#include <libweb3jsonrpc/WebThreeStubServerBase.h>
+#include <libweb3jsonrpc/AccountHolder.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+
+namespace
+{
+
+class NullConnector: public jsonrpc::AbstractServerConnector
+{
+public:
+	virtual bool StartListening() override { return true; }
+	virtual bool StopListening() override { return true; }
+	virtual bool SendResponse(string const&, void* = nullptr) override { return true; }
+};
+
+/// Constructed before the server, which installs itself as the connector's handler.
+struct ConnectorHolder
+{
+	NullConnector connector;
+};
+
+/// A server with no client, network or whisper behind it; only the methods which need none of them may be called.
+class TestServer: ConnectorHolder, public WebThreeStubServerBase
+{
+public:
+	TestServer(): WebThreeStubServerBase(connector, shared_ptr<AccountHolder>(), vector<KeyPair>()) {}
+
+protected:
+	virtual eth::Interface* client() override { return nullptr; }
+	virtual shared_ptr<shh::Interface> face() override { return nullptr; }
+	virtual WebThreeNetworkFace* network() override { return nullptr; }
+	virtual WebThreeStubDatabaseFace* db() override { return nullptr; }
+};
+
+/// Overrides one of the streamed methods.
+class OverridingServer: public TestServer
+{
+public:
+	virtual Json::Value eth_getBlockByHash(string const& _blockHash, bool _includeTransactions) override
+	{
+		Json::Value ret;
+		ret["hash"] = _blockHash;
+		ret["full"] = _includeTransactions;
+		return ret;
+	}
+};
+
+Json::Value call(string const& _method, Json::Value const& _params, Json::Value const& _id = Json::Value())
+{
+	Json::Value ret;
+	ret["jsonrpc"] = "2.0";
+	ret["method"] = _method;
+	ret["params"] = _params;
+	if (!_id.isNull())
+		ret["id"] = _id;
+	return ret;
+}
+
+Json::Value params(Json::Value const& _p0)
+{
+	Json::Value ret(Json::arrayValue);
+	ret.append(_p0);
+	return ret;
+}
+
+Json::Value parse(string const& _s)
+{
+	Json::Value ret;
+	BOOST_REQUIRE(Json::Reader().parse(_s, ret, false));
+	return ret;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(batch)
+
+BOOST_AUTO_TEST_CASE(parallelBatchAcceptsOnlyReadOnlyCalls)
+{
+	TestServer server;
+	Json::Value ok = call("web3_sha3", params("0x01"), 1);
+
+	Json::Value b(Json::arrayValue);
+	BOOST_CHECK(!server.isParallelBatch(b));
+	BOOST_CHECK(!server.isParallelBatch(ok));
+	b.append(ok);
+	BOOST_CHECK(server.isParallelBatch(b));
+
+	// Any one malformed or state-altering entry sends the whole batch down the sequential path.
+	Json::Value bad = ok;
+	bad["jsonrpc"] = "1.0";
+	Json::Value withBad = b;
+	withBad.append(bad);
+	BOOST_CHECK(!server.isParallelBatch(withBad));
+
+	bad = ok;
+	bad["params"] = "0x01";
+	withBad = b;
+	withBad.append(bad);
+	BOOST_CHECK(!server.isParallelBatch(withBad));
+
+	bad = ok;
+	bad["id"] = Json::Value(Json::objectValue);
+	withBad = b;
+	withBad.append(bad);
+	BOOST_CHECK(!server.isParallelBatch(withBad));
+
+	withBad = b;
+	withBad.append(call("eth_sendTransaction", params(Json::Value(Json::objectValue)), 2));
+	BOOST_CHECK(!server.isParallelBatch(withBad));
+
+	withBad = b;
+	withBad.append(Json::Value(3));
+	BOOST_CHECK(!server.isParallelBatch(withBad));
+}
+
+BOOST_AUTO_TEST_CASE(batchKeepsRequestOrder)
+{
+	TestServer server;
+	server.setBatchWorkers(4);
+	unsigned const c_calls = 64;
+	Json::Value b(Json::arrayValue);
+	for (unsigned i = 0; i < c_calls; ++i)
+		b.append(call("web3_sha3", params(toJS(bytes(1, i))), i % 2 ? Json::Value(toString(i)) : Json::Value(i)));
+	BOOST_REQUIRE(server.isParallelBatch(b));
+
+	Json::Value r = parse(server.handleBatch(b));
+	BOOST_REQUIRE(r.isArray());
+	BOOST_REQUIRE_EQUAL(r.size(), c_calls);
+	for (unsigned i = 0; i < c_calls; ++i)
+	{
+		if (i % 2)
+			BOOST_CHECK_EQUAL(r[i]["id"].asString(), toString(i));
+		else
+			BOOST_CHECK_EQUAL(r[i]["id"].asUInt(), i);
+		BOOST_CHECK_EQUAL(r[i]["jsonrpc"].asString(), "2.0");
+		BOOST_CHECK_EQUAL(r[i]["result"].asString(), toJS(sha3(bytes(1, i))));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(batchOmitsNotifications)
+{
+	TestServer server;
+	server.setBatchWorkers(2);
+	Json::Value b(Json::arrayValue);
+	b.append(call("web3_sha3", params("0x01")));
+	b.append(call("web3_sha3", params("0x02"), 7));
+	b.append(call("web3_clientVersion", Json::Value(Json::arrayValue)));
+	BOOST_REQUIRE(server.isParallelBatch(b));
+
+	Json::Value r = parse(server.handleBatch(b));
+	BOOST_REQUIRE_EQUAL(r.size(), 1u);
+	BOOST_CHECK_EQUAL(r[0u]["id"].asInt(), 7);
+	BOOST_CHECK_EQUAL(r[0u]["result"].asString(), toJS(sha3(bytes(1, 2))));
+
+	// Notifications are still executed.
+	BOOST_CHECK_EQUAL(server.stats().latency("web3_sha3").count, 2u);
+	BOOST_CHECK_EQUAL(server.stats().latency("web3_clientVersion").count, 1u);
+
+	Json::Value notifications(Json::arrayValue);
+	notifications.append(b[0u]);
+	notifications.append(b[2u]);
+	BOOST_CHECK_EQUAL(server.handleBatch(notifications), "");
+}
+
+BOOST_AUTO_TEST_CASE(batchRejectsBadParams)
+{
+	TestServer server;
+	Json::Value two(Json::arrayValue);
+	two.append("0x01");
+	two.append("0x02");
+	Json::Value hashAndString(Json::arrayValue);
+	hashAndString.append(toJS(h256()));
+	hashAndString.append("true");
+
+	Json::Value b(Json::arrayValue);
+	b.append(call("web3_sha3", Json::Value(Json::arrayValue), 0));
+	b.append(call("web3_sha3", params(1), 1));
+	b.append(call("web3_sha3", two, 2));
+	b.append(call("net_version", params("0x01"), 3));
+	b.append(call("eth_getBlockByHash", params(toJS(h256())), 4));
+	b.append(call("eth_getBlockByHash", hashAndString, 5));
+	b.append(call("web3_sha3", params("0x01"), 6));
+	BOOST_REQUIRE(server.isParallelBatch(b));
+
+	Json::Value r = parse(server.handleBatch(b));
+	BOOST_REQUIRE_EQUAL(r.size(), b.size());
+	for (unsigned i = 0; i < 6; ++i)
+	{
+		BOOST_CHECK_EQUAL(r[i]["id"].asUInt(), i);
+		BOOST_CHECK(!r[i].isMember("result"));
+		BOOST_CHECK_EQUAL(r[i]["error"]["code"].asInt(), jsonrpc::Errors::ERROR_RPC_INVALID_PARAMS);
+	}
+	// A bad entry doesn't spoil the rest of the batch.
+	BOOST_CHECK_EQUAL(r[6u]["result"].asString(), toJS(sha3(bytes(1, 1))));
+}
+
+BOOST_AUTO_TEST_CASE(batchCallsAreTimed)
+{
+	TestServer server;
+	server.setBatchWorkers(3);
+	Json::Value b(Json::arrayValue);
+	for (unsigned i = 0; i < 10; ++i)
+		b.append(call("web3_sha3", params("0x01"), i));
+	server.handleBatch(b);
+	MethodLatency l = server.stats().latency("web3_sha3");
+	BOOST_CHECK_EQUAL(l.count, 10u);
+	BOOST_CHECK_EQUAL(l.failures, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(streamedCallsUseOverrides)
+{
+	OverridingServer server;
+	Json::Value p(Json::arrayValue);
+	p.append(toJS(h256(1)));
+	p.append(true);
+	Json::Value c = call("eth_getBlockByHash", p, 1);
+	BOOST_REQUIRE(server.isStreamable(c));
+
+	Json::Value r = parse(server.handleStreamed(c));
+	BOOST_CHECK_EQUAL(r["id"].asInt(), 1);
+	BOOST_CHECK_EQUAL(r["result"]["hash"].asString(), toJS(h256(1)));
+	BOOST_CHECK(r["result"]["full"].asBool());
+	BOOST_CHECK_EQUAL(server.stats().latency("eth_getBlockByHash").count, 1u);
+
+	// Within a batch too.
+	Json::Value b(Json::arrayValue);
+	b.append(c);
+	r = parse(server.handleBatch(b));
+	BOOST_REQUIRE_EQUAL(r.size(), 1u);
+	BOOST_CHECK_EQUAL(r[0u]["result"]["hash"].asString(), toJS(h256(1)));
+}
+
+BOOST_AUTO_TEST_CASE(streamedCallsRejectBadParams)
+{
+	OverridingServer server;
+	Json::Value p(Json::arrayValue);
+	p.append(toJS(h256(1)));
+	for (Json::Value const& bad: { p, params(true), Json::Value(Json::arrayValue) })
+	{
+		Json::Value r = parse(server.handleStreamed(call("eth_getBlockByHash", bad, 1)));
+		BOOST_CHECK(!r.isMember("result"));
+		BOOST_CHECK_EQUAL(r["error"]["code"].asInt(), jsonrpc::Errors::ERROR_RPC_INVALID_PARAMS);
+	}
+	Json::Value r = parse(server.handleStreamed(call("eth_getLogs", params("latest"), 1)));
+	BOOST_CHECK_EQUAL(r["error"]["code"].asInt(), jsonrpc::Errors::ERROR_RPC_INVALID_PARAMS);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
@@ -0,0 +1,150 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file jsonHelper.cpp
+ * @date 2015
+ * Checks that streamed JSON matches the jsoncpp-built form, and compares their speed (--performance).
+ */
+
+#if ETH_JSONRPC || !ETH_TRUE
+
+#include <chrono>
+#include <boost/test/unit_test.hpp>
+#include <libdevcore/Log.h>
+#include <libdevcrypto/Common.h>
+#include <libweb3jsonrpc/JsonHelper.h>
+#include "../TestHelper.h"
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+
+namespace
+{
+
+string compact(Json::Value const& _v)
+{
+	string ret = Json::FastWriter().write(_v);
+	if (!ret.empty() && ret.back() == '\n')
+		ret.pop_back();
+	return ret;
+}
+
+BlockInfo testBlock()
+{
+	BlockInfo bi;
+	bi.parentHash = sha3("parent");
+	bi.sha3Uncles = sha3("uncles");
+	bi.coinbaseAddress = Address(0x1234);
+	bi.stateRoot = sha3("state");
+	bi.transactionsRoot = sha3("transactions");
+	bi.difficulty = 131072;
+	bi.number = 0x10;
+	bi.gasLimit = 3141592;
+	bi.gasUsed = 0;
+	bi.timestamp = 1438269988;
+	bi.extraData = bytes{0x0f, 0x42};
+	bi.nonce = Nonce(0x42);
+	return bi;
+}
+
+Transactions testTransactions(unsigned _n)
+{
+	KeyPair k = KeyPair::create();
+	Transactions ret;
+	for (unsigned i = 0; i < _n; ++i)
+		if (i % 3)
+			ret.push_back(Transaction(i * 1000, 50 * szabo, 21000, Address(i), bytes(i % 64, 0xab), i, k.secret()));
+		else
+			ret.push_back(Transaction(0, 50 * szabo, 90000, bytes(32, 0x60), i, k.secret()));
+	return ret;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(jsonHelper)
+
+BOOST_AUTO_TEST_CASE(streamedMatchesTree)
+{
+	BlockInfo bi = testBlock();
+	UncleHashes us = { sha3("u1"), sha3("u2") };
+	Transactions ts = testTransactions(10);
+	TransactionHashes hs;
+	for (auto const& t: ts)
+		hs.push_back(t.sha3());
+
+	JsonStream s;
+	toJson(s, bi);
+	BOOST_CHECK_EQUAL(s.str(), compact(toJson(bi)));
+
+	s.clear();
+	toJson(s, bi, us, ts);
+	BOOST_CHECK_EQUAL(s.str(), compact(toJson(bi, us, ts)));
+
+	s.clear();
+	toJson(s, bi, us, hs);
+	BOOST_CHECK_EQUAL(s.str(), compact(toJson(bi, us, hs)));
+
+	s.clear();
+	toJson(s, BlockInfo(), us, ts);
+	BOOST_CHECK_EQUAL(s.str(), compact(toJson(BlockInfo(), us, ts)));
+
+	LocalisedLogEntries logs;
+	logs.push_back(LocalisedLogEntry(LogEntry(Address(7), h256s{sha3("a"), sha3("b")}, bytes{1, 2, 3}), 12, sha3("tx")));
+	logs.push_back(LocalisedLogEntry(LogEntry(Address(8), h256s(), bytes()), 0));
+	s.clear();
+	toJson(s, logs);
+	BOOST_CHECK_EQUAL(s.str(), compact(toJson(logs)));
+}
+
+BOOST_AUTO_TEST_CASE(streamedBlockPerformance)
+{
+	if (!test::Options::get().performance)
+		return;
+
+	BlockInfo bi = testBlock();
+	UncleHashes us = { sha3("u1") };
+	Transactions ts = testTransactions(200);
+	for (auto const& t: ts)
+		t.safeSender();
+	unsigned const c_rounds = 200;
+
+	auto start = chrono::steady_clock::now();
+	size_t treeBytes = 0;
+	for (unsigned i = 0; i < c_rounds; ++i)
+		treeBytes += compact(toJson(bi, us, ts)).size();
+	auto tree = chrono::steady_clock::now() - start;
+
+	start = chrono::steady_clock::now();
+	size_t streamedBytes = 0;
+	JsonStream s;
+	for (unsigned i = 0; i < c_rounds; ++i)
+	{
+		s.clear();
+		toJson(s, bi, us, ts);
+		streamedBytes += s.size();
+	}
+	auto streamed = chrono::steady_clock::now() - start;
+
+	BOOST_CHECK_EQUAL(treeBytes, streamedBytes);
+	cnote << "Block with" << ts.size() << "transactions, x" << c_rounds << ": Json::Value"
+		<< chrono::duration_cast<chrono::milliseconds>(tree).count() << "ms, JsonStream"
+		<< chrono::duration_cast<chrono::milliseconds>(streamed).count() << "ms";
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
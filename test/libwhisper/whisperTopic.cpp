@@ -32,6 +32,30 @@ using namespace dev::shh;
 
 BOOST_AUTO_TEST_SUITE(whisper)
 
+BOOST_AUTO_TEST_CASE(topicFilterIndex)
+{
+	auto envelope = [](CollapsedTopic const& _t) { RLPStream s(5); s << (unsigned)time(0) + 50 << 50 << _t << bytes() << 0; return Envelope(RLP(s.out())); };
+	CollapsedTopic oddTwo = BuildTopic("odd")("two");
+	CollapsedTopic even = BuildTopic("even");
+
+	TopicFilter odd = TopicFilter(TopicMask(BuildTopicMask("odd")));
+	BOOST_CHECK(odd.matches(envelope(oddTwo)));
+	BOOST_CHECK(!odd.matches(envelope(even)));
+	BOOST_REQUIRE_EQUAL(odd.requiredParts().size(), 1);
+	BOOST_CHECK(odd.requiredParts()[0] == oddTwo[0]);
+
+	// A null part of a full topic is a wildcard, so a filter on it alone can't be indexed.
+	TopicFilter any = TopicFilter(FullTopic{h256()});
+	BOOST_CHECK(any.matches(envelope(even)));
+	BOOST_CHECK(any.requiredParts().empty());
+
+	// Either mask may match, so one part is needed from each.
+	TopicFilter either = TopicFilter(TopicMasks{BuildTopicMask("two"), BuildTopicMask("even")("other")});
+	BOOST_CHECK(either.matches(envelope(oddTwo)));
+	BOOST_CHECK(!either.matches(envelope(even)));
+	BOOST_CHECK_EQUAL(either.requiredParts().size(), 2);
+}
+
 #if ALEX_HASH_FIXED_NETWORKING
 BOOST_AUTO_TEST_CASE(topic)
 {